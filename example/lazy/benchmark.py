@@ -0,0 +1,49 @@
+"""Compare the speed of imperative NDArray code in eager and in lazy mode.
+
+In lazy mode (mx.nd.LazyMode or MXNET_IMPERATIVE_LAZY=1) the operations are
+recorded and run as a graph by a cached executor when a result is used. The
+loop body below is a chain of small elementwise operations and reductions,
+where the cost of pushing every operation to the engine dominates.
+"""
+import argparse
+import time
+import numpy as np
+import mxnet as mx
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Benchmark lazy imperative mode.')
+    parser.add_argument('--size', type=int, default=1024)
+    parser.add_argument('--depth', type=int, default=16)
+    parser.add_argument('--repeat', type=int, default=200)
+    return parser.parse_args()
+
+
+def step(a, b, depth):
+    """one iteration of the loop, returns the value read back"""
+    x = a
+    for _ in range(depth):
+        x = mx.nd.tanh(x * b + 1)
+    return mx.nd.sum(x, axis=1)
+
+
+def run(lazy, args):
+    a = mx.nd.array(np.random.uniform(-1, 1, (args.size, 64)))
+    b = mx.nd.array(np.random.uniform(-1, 1, (args.size, 64)))
+    with mx.nd.LazyMode(lazy):
+        step(a, b, args.depth).wait_to_read()
+        tic = time.time()
+        for _ in range(args.repeat):
+            # the result is read every iteration, as a loss would be
+            out = step(a, b, args.depth)
+            out.wait_to_read()
+    return (time.time() - tic) / args.repeat, out.asnumpy()
+
+
+if __name__ == '__main__':
+    args = parse_args()
+    eager_time, ref = run(False, args)
+    lazy_time, out = run(True, args)
+    print('size %d depth %d: eager %.3f ms, lazy %.3f ms, speedup %.2fx, max error %.2g'
+          % (args.size, args.depth, eager_time * 1e3, lazy_time * 1e3,
+             eager_time / lazy_time, np.abs(out - ref).max()))
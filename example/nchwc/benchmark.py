@@ -0,0 +1,88 @@
+"""Compare the speed of CPU inference in NCHW and in the blocked NCHWc layout.
+
+The executor converts chains of Convolution, Pooling, BatchNorm and
+elementwise operators to the NCHWc layout when it is bound on CPU without
+gradients and MXNET_EXEC_NCHWC_LAYOUT=1. The networks are randomly
+initialized and fed with random data.
+"""
+import argparse
+import os
+import time
+import numpy as np
+import mxnet as mx
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Benchmark the NCHWc layout on CPU.')
+    parser.add_argument('--network', type=str, default='all', choices=['all', 'conv', 'vgg'])
+    parser.add_argument('--batch_size', type=int, default=1)
+    parser.add_argument('--repeat', type=int, default=20)
+    return parser.parse_args()
+
+
+def get_conv():
+    """a single 3x3 convolution, reports GFLOPS"""
+    data = mx.sym.Variable('data')
+    net = mx.sym.Convolution(data=data, name='conv', kernel=(3, 3), pad=(1, 1), num_filter=128)
+    return net, (128, 28, 28), 2.0 * 128 * 128 * 9 * 28 * 28
+
+
+def get_vgg():
+    """a small VGG style network"""
+    data = mx.sym.Variable('data')
+    net = data
+    flops = 0
+    channels, size = 3, 64
+    for i, num_filter in enumerate([32, 64, 128, 256]):
+        for j in range(2):
+            net = mx.sym.Convolution(data=net, name='conv%d_%d' % (i, j), kernel=(3, 3),
+                                     pad=(1, 1), num_filter=num_filter)
+            net = mx.sym.BatchNorm(data=net, name='bn%d_%d' % (i, j))
+            net = mx.sym.Activation(data=net, name='relu%d_%d' % (i, j), act_type='relu')
+            flops += 2.0 * channels * num_filter * 9 * size * size
+            channels = num_filter
+        net = mx.sym.Pooling(data=net, name='pool%d' % i, kernel=(2, 2), stride=(2, 2),
+                             pool_type='max')
+        size //= 2
+    return net, (3, 64, 64), flops
+
+
+def bind(sym, data_shape, nchwc):
+    os.environ['MXNET_EXEC_NCHWC_LAYOUT'] = '1' if nchwc else '0'
+    exe = sym.simple_bind(mx.cpu(), grad_req='null', data=data_shape)
+    for name, arr in exe.arg_dict.items():
+        arr[:] = np.random.uniform(-1, 1, arr.shape)
+    for name, arr in exe.aux_dict.items():
+        arr[:] = np.random.uniform(0.5, 1, arr.shape)
+    return exe
+
+
+def run(name, get_net, args):
+    sym, shape, flops = get_net()
+    data_shape = (args.batch_size,) + shape
+    data = np.random.uniform(-1, 1, data_shape)
+    results = []
+    for nchwc in [False, True]:
+        exe = bind(sym, data_shape, nchwc)
+        exe.arg_dict['data'][:] = data
+        exe.forward(is_train=False)[0].wait_to_read()
+        tic = time.time()
+        for _ in range(args.repeat):
+            exe.forward(is_train=False)
+        exe.outputs[0].wait_to_read()
+        results.append(((time.time() - tic) / args.repeat, exe.outputs[0].asnumpy()))
+    (nchw_time, ref), (nchwc_time, out) = results
+    rel_err = np.linalg.norm(out - ref) / np.linalg.norm(ref)
+    print('%s: NCHW %.2f ms %.1f GFLOPS, NCHWc %.2f ms %.1f GFLOPS, speedup %.2fx, '
+          'relative error %.2g'
+          % (name, nchw_time * 1e3, flops * args.batch_size / nchw_time * 1e-9,
+             nchwc_time * 1e3, flops * args.batch_size / nchwc_time * 1e-9,
+             nchw_time / nchwc_time, rel_err))
+
+
+if __name__ == '__main__':
+    args = parse_args()
+    if args.network in ('all', 'conv'):
+        run('conv', get_conv, args)
+    if args.network in ('all', 'vgg'):
+        run('vgg', get_vgg, args)
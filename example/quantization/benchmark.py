@@ -0,0 +1,119 @@
+"""Compare accuracy and speed of float32 and 8-bit quantized inference on CPU.
+
+The networks are randomly initialized and fed with random data, so the
+accuracy is reported as the agreement of the quantized model with the float
+model: the fraction of samples with the same top-1 class, and the relative
+error of the outputs.
+"""
+import argparse
+import time
+import numpy as np
+import mxnet as mx
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Benchmark 8-bit quantized inference.')
+    parser.add_argument('--network', type=str, default='all', choices=['all', 'mlp', 'cnn'])
+    parser.add_argument('--batch_size', type=int, default=32)
+    parser.add_argument('--calib_batches', type=int, default=10)
+    parser.add_argument('--test_batches', type=int, default=20)
+    parser.add_argument('--repeat', type=int, default=20)
+    return parser.parse_args()
+
+
+def get_mlp():
+    data = mx.sym.Variable('data')
+    net = mx.sym.Flatten(data=data)
+    for i, num_hidden in enumerate([1024, 1024, 512]):
+        net = mx.sym.FullyConnected(data=net, name='fc%d' % i, num_hidden=num_hidden)
+        net = mx.sym.Activation(data=net, name='relu%d' % i, act_type='relu')
+    net = mx.sym.FullyConnected(data=net, name='fc_out', num_hidden=10)
+    return mx.sym.SoftmaxOutput(data=net, name='softmax'), (3, 32, 32)
+
+
+def get_cnn():
+    data = mx.sym.Variable('data')
+    net = data
+    for i, num_filter in enumerate([32, 64, 128]):
+        net = mx.sym.Convolution(data=net, name='conv%d' % i, kernel=(3, 3), pad=(1, 1),
+                                 num_filter=num_filter)
+        net = mx.sym.BatchNorm(data=net, name='bn%d' % i)
+        net = mx.sym.Activation(data=net, name='relu%d' % i, act_type='relu')
+        net = mx.sym.Pooling(data=net, name='pool%d' % i, kernel=(2, 2), stride=(2, 2),
+                             pool_type='max')
+    net = mx.sym.Flatten(data=net)
+    net = mx.sym.FullyConnected(data=net, name='fc_out', num_hidden=10)
+    return mx.sym.SoftmaxOutput(data=net, name='softmax'), (3, 32, 32)
+
+
+def init_params(sym, data_shape):
+    arg_shapes, _, aux_shapes = sym.infer_shape(data=data_shape)
+    init = mx.init.Xavier(magnitude=2.)
+    arg_params, aux_params = {}, {}
+    for name, shape in zip(sym.list_arguments(), arg_shapes):
+        if name in ('data', 'softmax_label'):
+            continue
+        arg_params[name] = mx.nd.zeros(shape)
+        init(name, arg_params[name])
+    for name, shape in zip(sym.list_auxiliary_states(), aux_shapes):
+        aux_params[name] = mx.nd.zeros(shape)
+        init(name, aux_params[name])
+    return arg_params, aux_params
+
+
+def predict(sym, arg_params, aux_params, batches):
+    exe = sym.simple_bind(mx.cpu(), grad_req='null', data=batches[0].shape)
+    exe.copy_params_from(arg_params, aux_params, allow_extra_params=True)
+    outputs = []
+    for batch in batches:
+        exe.arg_dict['data'][:] = batch
+        outputs.append(exe.forward(is_train=False)[0].asnumpy())
+    return exe, np.concatenate(outputs)
+
+
+def throughput(exe, batch, repeat):
+    exe.arg_dict['data'][:] = batch
+    exe.forward(is_train=False)[0].wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        exe.forward(is_train=False)
+    exe.outputs[0].wait_to_read()
+    return repeat * batch.shape[0] / (time.time() - tic)
+
+
+def run(name, get_net, args):
+    sym, shape = get_net()
+    data_shape = (args.batch_size,) + shape
+    arg_params, aux_params = init_params(sym, data_shape)
+    params = dict(arg_params)
+    params.update(aux_params)
+    sym, params = sym.optimize_for_inference(['data', 'softmax_label'], params)
+    aux_names = set(sym.list_auxiliary_states())
+    arg_params = {k: v for k, v in params.items() if k not in aux_names}
+    aux_params = {k: v for k, v in params.items() if k in aux_names}
+
+    calib_data = np.random.uniform(-1, 1, (args.calib_batches * args.batch_size,) + shape)
+    calib_iter = mx.io.NDArrayIter(calib_data, batch_size=args.batch_size)
+    calib = mx.quantization.calibrate(sym, arg_params, aux_params, calib_iter)
+    qsym, qarg_params, qaux_params = mx.quantization.quantize_model(
+        sym, arg_params, aux_params, calib)
+
+    batches = [mx.nd.array(np.random.uniform(-1, 1, data_shape))
+               for _ in range(args.test_batches)]
+    exe, ref = predict(sym, arg_params, aux_params, batches)
+    qexe, out = predict(qsym, qarg_params, qaux_params, batches)
+    agree = np.mean(np.argmax(ref, axis=1) == np.argmax(out, axis=1))
+    rel_err = np.linalg.norm(out - ref) / np.linalg.norm(ref)
+    fp32 = throughput(exe, batches[0], args.repeat)
+    int8 = throughput(qexe, batches[0], args.repeat)
+    print('%s: top-1 agreement %.4f, relative error %.5f, '
+          'float32 %.1f samples/sec, quantized %.1f samples/sec, speedup %.2fx'
+          % (name, agree, rel_err, fp32, int8, int8 / fp32))
+
+
+if __name__ == '__main__':
+    args = parse_args()
+    if args.network in ('all', 'mlp'):
+        run('mlp', get_mlp, args)
+    if args.network in ('all', 'cnn'):
+        run('cnn', get_cnn, args)
@@ -64,11 +64,22 @@ typedef void *KVStoreHandle;
 typedef void *RecordIOHandle;
 /*! \brief handle to MXRtc*/
 typedef void *RtcHandle;
+/*! \brief handle to a parameter file being written */
+typedef void *ParamFileWriterHandle;
+/*! \brief handle to a parameter file opened for reading */
+typedef void *ParamFileHandle;
 
 typedef void (*ExecutorMonitorCallback)(const char*,
                                         NDArrayHandle,
                                         void *);
 
+typedef void (*ExecutorGradReadyCallback)(int,
+                                          NDArrayHandle,
+                                          void *);
+
+typedef void (*NDArrayBufferDeleter)(void *,
+                                     void *);
+
 struct NativeOpInfo {
   void (*forward)(int, float**, int*, unsigned**, int*, void*);
   void (*backward)(int, float**, int*, unsigned**, int*, void*);
@@ -236,6 +247,58 @@ MXNET_DLL int MXNDArrayCreateEx(const mx_uint *shape,
                               int delay_alloc,
                               int dtype,
                               NDArrayHandle *out);
+/*!
+ * \brief create a sparse NDArray, on CPU
+ * \param storage_type 1 for row sparse, 2 for csr
+ * \param shape the pointer to the shape
+ * \param ndim the dimension of the shape
+ * \param dev_type device type, specify device we want to take
+ * \param dev_id the device id of the specific device
+ * \param dtype data type of created array
+ * \param data the stored values, or NULL to create an array of zeros
+ * \param num_aux the number of index arrays, 1 for row sparse and 2 for csr
+ * \param aux the int32 index arrays: the row indices for row sparse,
+ *  the row pointers and the column indices for csr
+ * \param out the returning handle
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCreateSparse(int storage_type,
+                                    const mx_uint *shape,
+                                    mx_uint ndim,
+                                    int dev_type,
+                                    int dev_id,
+                                    int dtype,
+                                    NDArrayHandle data,
+                                    mx_uint num_aux,
+                                    NDArrayHandle *aux,
+                                    NDArrayHandle *out);
+/*!
+ * \brief create a NDArray that uses an existing buffer without copying it.
+ *  The NDArray tracks the dependencies of the operations on the buffer like
+ *  any other NDArray, and the deleter is called, possibly from another thread,
+ *  once the NDArray and all its copies are freed and these operations are done.
+ * \param data the buffer, contiguous, holding shape[0] * ... * shape[ndim-1] elements
+ * \param shape the pointer to the shape
+ * \param ndim the dimension of the shape
+ * \param dev_type device type of the buffer
+ * \param dev_id the device id of the buffer
+ * \param dtype data type of the buffer
+ * \param deleter called with data and deleter_arg to release the buffer, can be NULL.
+ *  It may run on an engine thread, also during the shutdown of the process, so it
+ *  must not wait for the engine nor call into an interpreter that may be finalized.
+ * \param deleter_arg the argument of the deleter
+ * \param out the returning handle
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCreateFromBuffer(void *data,
+                                        const mx_uint *shape,
+                                        mx_uint ndim,
+                                        int dev_type,
+                                        int dev_id,
+                                        int dtype,
+                                        NDArrayBufferDeleter deleter,
+                                        void *deleter_arg,
+                                        NDArrayHandle *out);
 /*!
  * \brief create a NDArray handle that is loaded from raw bytes.
  * \param buf the head of the raw bytes
@@ -269,7 +332,7 @@ MXNET_DLL int MXNDArraySave(const char* fname,
                             NDArrayHandle* args,
                             const char** keys);
 /*!
- * \brief Load list of narray from the file.
+ * \brief Load list of narray from the file, saved by MXNDArraySave or MXNDArraySaveAsync.
  * \param fname name of the file.
  * \param out_size number of narray loaded.
  * \param out_arr head of the returning narray handles.
@@ -282,6 +345,78 @@ MXNET_DLL int MXNDArrayLoad(const char* fname,
                             NDArrayHandle** out_arr,
                             mx_uint *out_name_size,
                             const char*** out_names);
+/*!
+ * \brief Start saving a list of narray into a parameter file, with an index, aligned
+ *  payloads and a CRC32 per array. The arrays are snapshotted by the engine, so they
+ *  can be modified as soon as this returns, and the file is written by a thread.
+ * \param fname name of the file.
+ * \param num_args number of arguments to save.
+ * \param args the array of NDArrayHandles to be saved.
+ * \param keys the name of the NDArray, optional, can be NULL
+ * \param out handle to wait for the file, freed with MXNDArraySaveAsyncFree
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveAsync(const char* fname,
+                                 mx_uint num_args,
+                                 NDArrayHandle* args,
+                                 const char** keys,
+                                 ParamFileWriterHandle *out);
+/*!
+ * \brief Wait until a parameter file is written.
+ * \param handle the handle returned by MXNDArraySaveAsync
+ * \return 0 when success, -1 when writing the file failed
+ */
+MXNET_DLL int MXNDArraySaveAsyncWait(ParamFileWriterHandle handle);
+/*!
+ * \brief Wait until a parameter file is written and free the handle.
+ * \param handle the handle returned by MXNDArraySaveAsync
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveAsyncFree(ParamFileWriterHandle handle);
+/*!
+ * \brief Open a parameter file written by MXNDArraySaveAsync. Only its index is read.
+ * \param fname name of the file.
+ * \param out the returning handle
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXParamFileOpen(const char* fname,
+                              ParamFileHandle *out);
+/*!
+ * \brief List the arrays of a parameter file.
+ * \param handle the parameter file
+ * \param out_size number of arrays
+ * \param out_name_size number of names, 0 if the arrays were saved without names
+ * \param out_names the names of the arrays
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXParamFileList(ParamFileHandle handle,
+                              mx_uint *out_size,
+                              mx_uint *out_name_size,
+                              const char*** out_names);
+/*!
+ * \brief Load arrays of a parameter file in parallel, checking their checksums.
+ * \param handle the parameter file
+ * \param num_names number of arrays to load
+ * \param names names of the arrays to load, or NULL to load all of them
+ * \param dev_type device type of the loaded arrays, 0 for the saved ones
+ * \param dev_id device id of the loaded arrays
+ * \param out_size number of loaded arrays
+ * \param out_arr head of the returning narray handles
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXParamFileLoad(ParamFileHandle handle,
+                              mx_uint num_names,
+                              const char** names,
+                              int dev_type,
+                              int dev_id,
+                              mx_uint *out_size,
+                              NDArrayHandle** out_arr);
+/*!
+ * \brief Free a parameter file handle.
+ * \param handle the parameter file
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXParamFileFree(ParamFileHandle handle);
 /*!
  * \brief Perform a synchronize copy from a continugous CPU memory region.
  *
@@ -330,12 +465,81 @@ MXNET_DLL int MXNDArrayWaitToWrite(NDArrayHandle handle);
  * \return 0 when success, -1 when failure happens
  */
 MXNET_DLL int MXNDArrayWaitAll();
+/*!
+ * \brief set whether imperative operations are recorded and executed lazily
+ *  as a graph. Disabling lazy mode executes the recorded operations.
+ * \param lazy 1 to enable lazy mode, 0 to disable it
+ * \param prev returns the previous state
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySetLazyMode(int lazy, int* prev);
 /*!
  * \brief free the narray handle
  * \param handle the handle to be freed
  * \return 0 when success, -1 when failure happens
  */
 MXNET_DLL int MXNDArrayFree(NDArrayHandle handle);
+/*!
+ * \brief Slice the NDArray along any axis without copying. Slices along other
+ *  axes than 0 are strided views: operators and copies accept them, their data
+ *  pointer cannot be used directly.
+ * \param handle the handle to the NDArray
+ * \param axis the axis
+ * \param slice_begin The beginning index of slice
+ * \param slice_end The ending index of slice
+ * \param out The NDArrayHandle of sliced NDArray
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySliceAxis(NDArrayHandle handle,
+                                 mx_uint axis,
+                                 mx_uint slice_begin,
+                                 mx_uint slice_end,
+                                 NDArrayHandle *out);
+/*!
+ * \brief Permute the axes of the NDArray without copying.
+ * \param handle the handle to the NDArray
+ * \param ndim number of axes
+ * \param axes the axes of the NDArray in the order of the view
+ * \param out The NDArrayHandle of the strided view
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayTransposeView(NDArrayHandle handle,
+                                     mx_uint ndim,
+                                     const mx_uint *axes,
+                                     NDArrayHandle *out);
+/*!
+ * \brief Broadcast the axes of size 1 of the NDArray without copying.
+ *  The view is read only.
+ * \param handle the handle to the NDArray
+ * \param ndim number of axes, the same as the NDArray
+ * \param shape the shape of the view
+ * \param out The NDArrayHandle of the strided view
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayBroadcastView(NDArrayHandle handle,
+                                     mx_uint ndim,
+                                     const mx_uint *shape,
+                                     NDArrayHandle *out);
+/*!
+ * \brief Get a contiguous NDArray with the content of a strided view.
+ * \param handle the handle to the NDArray
+ * \param out a new handle, to a copy if the NDArray is a strided view
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayCompact(NDArrayHandle handle,
+                               NDArrayHandle *out);
+/*!
+ * \brief Get the strides of the NDArray in elements.
+ * \param handle the handle to the NDArray
+ * \param out_contiguous whether the NDArray is contiguous
+ * \param out_dim the number of strides
+ * \param out_pdata the strides
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayGetStrides(NDArrayHandle handle,
+                                  int *out_contiguous,
+                                  mx_uint *out_dim,
+                                  const mx_uint **out_pdata);
 /*!
  * \brief Slice the NDArray along axis 0.
  * \param handle the handle to the NDArray
@@ -388,6 +592,20 @@ MXNET_DLL int MXNDArrayGetShape(NDArrayHandle handle,
  */
 MXNET_DLL int MXNDArrayGetData(NDArrayHandle handle,
                                mx_float **out_pdata);
+/*!
+ * \brief get the pointer to the data of a NDArray of any type and device,
+ *  without copying it. The pending operations on the NDArray are waited for,
+ *  so the data can be read and written until an operation is pushed on the
+ *  NDArray again.
+ * \param handle the handle to the narray
+ * \param out_pdata pointer holder to get pointer of data
+ * \param out_keep_alive returns a new handle to the NDArray, the data stays
+ *  valid until it is freed with MXNDArrayFree
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayGetDataPtr(NDArrayHandle handle,
+                                  void **out_pdata,
+                                  NDArrayHandle *out_keep_alive);
 /*!
  * \brief get the type of the data in NDArray
  * \param handle the handle to the narray
@@ -396,6 +614,24 @@ MXNET_DLL int MXNDArrayGetData(NDArrayHandle handle,
  */
 MXNET_DLL int MXNDArrayGetDType(NDArrayHandle handle,
                                int *out_dtype);
+/*!
+ * \brief get the storage type of the NDArray
+ * \param handle the handle to the narray
+ * \param out_storage_type 0 for dense, 1 for row sparse, 2 for csr, -1 for none
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayGetStorageType(NDArrayHandle handle,
+                                      int *out_storage_type);
+/*!
+ * \brief get a dense copy of a component of a sparse NDArray
+ * \param handle the handle to the narray
+ * \param i -1 for the stored values, otherwise the index of the index array
+ * \param out the returning handle
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArrayGetSparseData(NDArrayHandle handle,
+                                     int i,
+                                     NDArrayHandle *out);
 /*!
  * \brief get the context of the NDArray
  * \param handle the handle to the narray
@@ -895,6 +1131,63 @@ MXNET_DLL int MXSymbolInferType(SymbolHandle sym,
                                 mx_uint *aux_type_size,
                                 const int **aux_type_data,
                                 int *complete);
+/*!
+ * \brief Optimize a symbol and its parameters for inference.
+ *  BatchNorm is folded into the preceding Convolution or FullyConnected,
+ *  subgraphs that only depend on parameters are precomputed and Dropout is removed.
+ *
+ * \param sym symbol handle
+ * \param num_data number of data inputs
+ * \param data_names names of the inputs that change between forward calls
+ * \param num_params number of parameters
+ * \param param_names names of the parameters, both arguments and auxiliary states
+ * \param param_handles values of the parameters
+ * \param out the optimized symbol
+ * \param out_num_params number of parameters of the optimized symbol
+ * \param out_param_names names of the parameters of the optimized symbol
+ * \param out_param_handles values of the parameters of the optimized symbol
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXSymbolOptimizeForInference(SymbolHandle sym,
+                                           mx_uint num_data,
+                                           const char** data_names,
+                                           mx_uint num_params,
+                                           const char** param_names,
+                                           NDArrayHandle* param_handles,
+                                           SymbolHandle* out,
+                                           mx_uint* out_num_params,
+                                           const char*** out_param_names,
+                                           NDArrayHandle** out_param_handles);
+/*!
+ * \brief Quantize the 2D Convolution and FullyConnected layers of a symbol
+ *  to 8 bits for CPU inference.
+ *
+ * \param sym symbol handle
+ * \param num_calib number of calibrated ranges
+ * \param calib_names names of the data entries, as given by the executor monitor
+ * \param calib_min calibrated minimum of each entry
+ * \param calib_max calibrated maximum of each entry
+ * \param num_params number of parameters
+ * \param param_names names of the parameters, both arguments and auxiliary states
+ * \param param_handles values of the parameters
+ * \param out the quantized symbol
+ * \param out_num_params number of parameters of the quantized symbol
+ * \param out_param_names names of the parameters of the quantized symbol
+ * \param out_param_handles values of the parameters of the quantized symbol
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXSymbolQuantize(SymbolHandle sym,
+                               mx_uint num_calib,
+                               const char** calib_names,
+                               const mx_float* calib_min,
+                               const mx_float* calib_max,
+                               mx_uint num_params,
+                               const char** param_names,
+                               NDArrayHandle* param_handles,
+                               SymbolHandle* out,
+                               mx_uint* out_num_params,
+                               const char*** out_param_names,
+                               NDArrayHandle** out_param_handles);
 //--------------------------------------------
 // Part 4: Executor interface
 //--------------------------------------------
@@ -1047,6 +1340,64 @@ MXNET_DLL int MXExecutorBindEX(SymbolHandle symbol_handle,
 MXNET_DLL int MXExecutorSetMonitorCallback(ExecutorHandle handle,
                                            ExecutorMonitorCallback callback,
                                            void* callback_handle);
+/*!
+ * \brief set a call back to notify that the gradient of an argument is final.
+ *  The call back is invoked from an engine thread during backward, with the
+ *  index of the argument and a new handle to its gradient. It may push more
+ *  operations but must not wait on the engine, which would deadlock.
+ * \param handle the executor handle
+ * \param callback the call back
+ * \param callback_handle the handle passed back to the call back
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXExecutorSetGradReadyCallback(ExecutorHandle handle,
+                                             ExecutorGradReadyCallback callback,
+                                             void* callback_handle);
+/*!
+ * \brief compute statistics of every node output inside the engine
+ * \param handle the executor handle
+ * \param stat_mask bitwise or of the statistics: 1 L2 norm, 2 min, 4 max,
+ *  8 NaN count, 16 Inf count, 32 mean absolute value. 0 to disable.
+ * \param interval collect statistics every interval calls to forward
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXExecutorSetMonitorStats(ExecutorHandle handle,
+                                        int stat_mask,
+                                        int interval);
+/*!
+ * \brief wait for and fetch the statistics collected since the last call
+ * \param handle the executor handle
+ * \param num_records number of records
+ * \param iterations iteration of each record
+ * \param names output name of each record
+ * \param values statistics of each record, in the order of the mask bits
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXExecutorGetMonitorStats(ExecutorHandle handle,
+                                        mx_uint *num_records,
+                                        const mx_uint **iterations,
+                                        const char ***names,
+                                        const mx_float **values);
+/*!
+ * \brief enable or disable the per node execution time recording
+ * \param handle the executor handle
+ * \param enable 1 to record the execution time of every node, 0 to stop
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXExecutorSetNodeProfiling(ExecutorHandle handle, int enable);
+/*!
+ * \brief wait for all operations and get the per node profile as a JSON list,
+ *  sorted by decreasing total time. Each item holds the name, op, in_shapes,
+ *  out_shapes, count, total_us, min_us, max_us, in_bytes, out_bytes,
+ *  num_inplace and flops of a node.
+ * \param handle the executor handle
+ * \param reset 1 to clear the recorded times after reading them
+ * \param out_json the profile in JSON
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXExecutorGetNodeProfile(ExecutorHandle handle,
+                                       int reset,
+                                       const char **out_json);
 //--------------------------------------------
 // Part 5: IO Interface
 //--------------------------------------------
@@ -1216,6 +1567,22 @@ MXNET_DLL int MXKVStorePull(KVStoreHandle handle,
                             const int* keys,
                             NDArrayHandle* vals,
                             int priority);
+/*!
+ * \brief pull some rows of a list of values into row sparse arrays
+ * \param handle handle to the kvstore
+ * \param num the number of key-value pairs
+ * \param keys the list of keys
+ * \param vals the list of row sparse values
+ * \param row_ids the rows to pull for each key
+ * \param priority the priority of the action
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXKVStorePullRowSparse(KVStoreHandle handle,
+                                     mx_uint num,
+                                     const int* keys,
+                                     NDArrayHandle* vals,
+                                     NDArrayHandle* row_ids,
+                                     int priority);
 /*!
  * \brief user-defined updater for the kvstore
  * It's this updater's responsibility to delete \a recv and \a local
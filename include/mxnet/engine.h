@@ -170,6 +170,17 @@ class MXNET_API Engine {
    *            variable is ready.
    */
   virtual void WaitForVar(VarHandle var) = 0;
+  /*!
+   * \brief Get the version of a variable. The version changes every time an
+   *  operation that writes the variable completes, and is never shared with
+   *  another variable, so that what is derived from the content of a variable
+   *  can be cached by its version.
+   * \param var The variable, read by the calling operation.
+   * \return The version, or 0 when the engine does not track versions.
+   */
+  virtual size_t VarVersion(VarHandle var) {
+    return 0;
+  }
   /*!
    * \brief Wait until all the activity of engine finishes.
    */
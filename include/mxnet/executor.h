@@ -12,6 +12,7 @@
 #include <memory>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include "./base.h"
 #include "./c_api.h"
@@ -91,6 +92,41 @@ class Executor {
                         const std::vector<OpReqType> &grad_req_type,
                         const std::vector<NDArray> &aux_states,
                         Executor* shared_exec = NULL);
+  /*!
+   * \brief Optimize a symbol and its parameters for inference.
+   *  BatchNorm is folded into the preceding Convolution or FullyConnected,
+   *  subgraphs that only depend on parameters are precomputed and Dropout is
+   *  removed. The returned symbol can be bound with Bind in place of the
+   *  original one; the outputs are the same up to floating point rounding.
+   *
+   * \param symbol the symbol to optimize.
+   * \param data_names names of the inputs that change between forward calls.
+   *  Any other input with a value in params is treated as constant.
+   * \param params values of the arguments and auxiliary states. Replaced by
+   *  the parameters of the optimized symbol.
+   * \return the optimized symbol.
+   */
+  static nnvm::Symbol OptimizeForInference(
+      const nnvm::Symbol& symbol,
+      const std::vector<std::string>& data_names,
+      std::unordered_map<std::string, NDArray>* params);
+  /*!
+   * \brief Quantize the 2D Convolution and FullyConnected layers of an
+   *  inference symbol to 8 bits for CPU execution. The data of each layer is
+   *  quantized with its calibrated range, the weight with its own range, and
+   *  the layer accumulates in int32 and outputs float32.
+   *
+   * \param symbol the symbol to quantize.
+   * \param calib calibrated (min, max) of the data of the layers, named as
+   *  in the executor monitor. Layers without a range are not quantized.
+   * \param params values of the arguments and auxiliary states. Replaced by
+   *  the parameters of the quantized symbol.
+   * \return the quantized symbol.
+   */
+  static nnvm::Symbol QuantizeForInference(
+      const nnvm::Symbol& symbol,
+      const std::unordered_map<std::string, std::pair<float, float> >& calib,
+      std::unordered_map<std::string, NDArray>* params);
   /*!
    * \brief the prototype of user-defined monitor callback
    */
@@ -99,6 +135,81 @@ class Executor {
    * \brief Install a callback to notify the completion of operation.
    */
   virtual void SetMonitorCallback(const MonitorCallback& callback) {}
+  /*!
+   * \brief the prototype of gradient ready callback, called with the index of
+   *  the argument in the argument list and a new NDArray handle of its gradient.
+   */
+  typedef std::function<void(int, void*)> GradientReadyCallback;
+  /*!
+   * \brief Install a callback to notify that the gradient of an argument is final.
+   *  The callback is pushed to the engine right after the operator that writes
+   *  the gradient, so it runs in an engine thread as soon as that operator
+   *  completes, while backward of the earlier layers is still running.
+   *  The callback can push more operations, such as kvstore push or updates,
+   *  but must not wait for the result of any operation.
+   */
+  virtual void SetGradientReadyCallback(const GradientReadyCallback& callback) {}
+  /*! \brief statistics that the executor monitor can compute in the engine */
+  enum MonitorStatType {
+    kMonitorL2Norm = 1,
+    kMonitorMin = 2,
+    kMonitorMax = 4,
+    kMonitorNaNCount = 8,
+    kMonitorInfCount = 16,
+    kMonitorMeanAbs = 32
+  };
+  /*!
+   * \brief Compute statistics of every node output in the engine, right
+   *  after the node, instead of handing each output to a callback.
+   *  Statistics are collected in the forward and backward pass of every
+   *  interval-th call to Forward, and fetched with GetMonitorStats.
+   * \param stat_mask bitwise or of MonitorStatType, 0 to disable.
+   * \param interval collect statistics every interval iterations.
+   */
+  virtual void SetMonitorStats(int stat_mask, int interval) {}
+  /*!
+   * \brief Wait for the pending statistics and move out all the records
+   *  collected since the last call.
+   * \param iterations the iteration of each record, counted by calls to Forward.
+   * \param names name of the output of each record.
+   * \param values the selected statistics of each record, in the order of
+   *  the bits in the mask, row major.
+   */
+  virtual void GetMonitorStats(std::vector<uint32_t>* iterations,
+                               std::vector<std::string>* names,
+                               std::vector<float>* values) {}
+  /*! \brief execution profile of one node of the graph */
+  struct NodeProfile {
+    /*! \brief name of the node */
+    std::string name;
+    /*! \brief name of the operator */
+    std::string op;
+    /*! \brief shapes of the inputs and outputs */
+    std::vector<TShape> in_shapes, out_shapes;
+    /*! \brief number of timed executions */
+    uint64_t count;
+    /*! \brief total, minimum and maximum execution time in microseconds */
+    uint64_t total_us, min_us, max_us;
+    /*! \brief bytes of the inputs and of the outputs */
+    size_t in_bytes, out_bytes;
+    /*! \brief number of outputs written in place of an input */
+    int num_inplace;
+    /*! \brief estimated floating point operations of one execution */
+    uint64_t flops;
+  };
+  /*!
+   * \brief Time every operator of the graph as it runs in the engine.
+   *  Asynchronous operators and cross device copies are not timed.
+   * \param enable whether to record the execution time.
+   */
+  virtual void SetNodeProfiling(bool enable) {}
+  /*!
+   * \brief Wait for all pending operations and get the profile of each node,
+   *  sorted by decreasing total execution time.
+   * \param reset clear the recorded times after reading them.
+   * \param profile the profile of each operator node.
+   */
+  virtual void GetNodeProfile(bool reset, std::vector<NodeProfile>* profile) {}
 };  // class executor
 }  // namespace mxnet
 #endif  // MXNET_EXECUTOR_H_
@@ -128,6 +128,23 @@ class KVStore {
   virtual void Pull(const std::vector<int>& keys,
                     const std::vector<NDArray*>& values,
                     int priority = 0) = 0;
+  /*!
+   * \brief pull the given rows of a list of values into row sparse arrays
+   *
+   * Only the rows in \a row_ids are copied, the other rows of the stored
+   * value are not transferred. It is supported by the local kvstore.
+   *
+   * \param keys the list of keys
+   * \param values the row sparse buffers for the pulled rows
+   * \param row_ids the indices of the rows to pull for each key
+   * \param priority Priority of the action.
+   */
+  virtual void PullRowSparse(const std::vector<int>& keys,
+                             const std::vector<NDArray*>& values,
+                             const std::vector<NDArray>& row_ids,
+                             int priority = 0) {
+    LOG(FATAL) << "The kvstore type " << type_ << " does not support PullRowSparse";
+  }
 
   /**
    * \brief the prototype of user-defined updater
@@ -11,6 +11,9 @@
 #include <dmlc/io.h>
 #include <dmlc/type_traits.h>
 #include <dmlc/registry.h>
+#include <atomic>
+#include <cstring>
+#include <functional>
 #include <vector>
 #include <map>
 #include <string>
@@ -27,6 +30,30 @@
 #endif
 
 namespace mxnet {
+class LazyImperative;
+/*! \brief storage type of an NDArray */
+enum NDArrayStorageType {
+  kUndefinedStorage = -1,  // undefined storage
+  kDefaultStorage,         // dense
+  kRowSparseStorage,       // row sparse
+  kCSRStorage,             // csr
+};
+
+namespace rowsparse {
+/*! \brief indices of a row sparse array: the sorted indices of the stored rows */
+enum RowSparseAuxType {kIdx};
+}  // namespace rowsparse
+
+namespace csr {
+/*! \brief indices of a csr matrix: the row pointers and the column of every value */
+enum CSRAuxType {kIndPtr, kIdx};
+}  // namespace csr
+
+/*! \brief type of the indices of the sparse storage types */
+typedef int32_t sparse_index_t;
+/*! \brief type flag of the indices of the sparse storage types */
+const int kSparseIndexTypeFlag = mshadow::kInt32;
+
 /*!
  * \brief ndarray interface
  */
@@ -51,6 +78,23 @@ class NDArray {
         shape_(shape), offset_(0), dtype_(dtype) {
 #if MKL_EXPERIMENTAL == 1
       Mkl_mem_ = std::make_shared<MKLMemHolder>();
+#endif
+  }
+  /*!
+   * \brief constructing an empty sparse NDArray, without stored elements.
+   *  The operations writing the array allocate its storage.
+   *  Sparse storage is only supported on CPU.
+   * \param stype the storage type, kRowSparseStorage or kCSRStorage
+   * \param shape the shape of array
+   * \param ctx context of NDArray
+   * \param dtype data type of the stored values
+   */
+  NDArray(NDArrayStorageType stype, const TShape &shape, Context ctx,
+          int dtype = mshadow::default_type_flag)
+      : ptr_(std::make_shared<Chunk>(stype, shape, ctx)),
+        shape_(shape), offset_(0), dtype_(dtype) {
+#if MKL_EXPERIMENTAL == 1
+      Mkl_mem_ = std::make_shared<MKLMemHolder>();
 #endif
   }
   /*!
@@ -65,6 +109,21 @@ class NDArray {
         dtype_(data.type_flag_) {
 #if MKL_EXPERIMENTAL == 1
       Mkl_mem_ = std::make_shared<MKLMemHolder>();
+#endif
+  }
+  /*!
+   * \brief constructing a static NDArray that takes over external memory
+   *  The deleter is called once the NDArray and all its copies are destroyed
+   *  and all the operations using its data are finished.
+   * \param data the memory content of static data
+   * \param dev_id the device id this tensor sits at
+   * \param deleter function releasing the memory
+   */
+  NDArray(const TBlob &data, int dev_id, const std::function<void()>& deleter)
+      : ptr_(std::make_shared<Chunk>(data, dev_id, deleter)), shape_(data.shape_),
+        offset_(0), dtype_(data.type_flag_) {
+#if MKL_EXPERIMENTAL == 1
+      Mkl_mem_ = std::make_shared<MKLMemHolder>();
 #endif
   }
   /*!
@@ -73,14 +132,69 @@ class NDArray {
   inline const TShape &shape() const {
     return shape_;
   }
+  /*! \return the storage type, kUndefinedStorage if the NDArray is not initialized */
+  inline NDArrayStorageType storage_type() const {
+    return is_none() ? kUndefinedStorage : ptr_->storage_type;
+  }
+  /*!
+   * \return the shape of the stored values: the shape of the array for dense
+   *  storage, (number of stored rows, row shape...) for row sparse storage
+   *  and (number of non-zeros,) for csr.
+   */
+  inline const TShape &storage_shape() const {
+    return storage_type() == kDefaultStorage ? shape_ : ptr_->storage_shape;
+  }
+  /*! \return the number of index arrays of the storage type */
+  inline size_t num_aux() const {
+    return is_none() ? 0 : ptr_->aux_handles.size();
+  }
+  /*! \return the shape of the i-th index array of a sparse NDArray */
+  inline const TShape &aux_shape(size_t i) const {
+    return ptr_->aux_shapes.at(i);
+  }
+  /*! \return the i-th index array of a sparse NDArray, of type sparse_index_t */
+  inline TBlob aux_data(size_t i) const {
+    return TBlob(static_cast<sparse_index_t*>(ptr_->aux_handles.at(i).dptr),
+                 ptr_->aux_shapes[i], ptr_->shandle.ctx.dev_mask());
+  }
+  /*!
+   * \return whether the elements are stored in row-major order without gaps,
+   *  which is false for the strided views
+   */
+  inline bool is_contiguous() const {
+    return strides_.ndim() == 0;
+  }
+  /*!
+   * \return the distance in elements between consecutive indices of every axis,
+   *  the row-major strides of the shape for contiguous arrays
+   */
+  inline TShape strides() const {
+    if (!is_contiguous()) return strides_;
+    TShape ret(shape_.ndim());
+    index_t stride = 1;
+    for (index_t i = shape_.ndim(); i != 0; --i) {
+      ret[i - 1] = stride;
+      stride *= shape_[i - 1];
+    }
+    return ret;
+  }
+  /*!
+   * \return pointer to the first element, also valid for strided views.
+   *  The memory must have been allocated.
+   */
+  inline void* dptr() const {
+    return static_cast<char*>(ptr_->shandle.dptr) + offset_ * mshadow::mshadow_sizeof(dtype_);
+  }
   /*!
-   * \return the data TBlob
+   * \return the data TBlob, the stored values with storage_shape() for sparse arrays
    */
   inline TBlob data() const {
+    CHECK(is_contiguous())
+      << "The data of a strided NDArray view cannot be used directly, use Compact()";
     TBlob res;
     MSHADOW_TYPE_SWITCH(dtype_, DType, {
       res = TBlob(static_cast<DType*>(ptr_->shandle.dptr)
-        + offset_, shape_, ptr_->shandle.ctx.dev_mask());
+        + offset_, storage_shape(), ptr_->shandle.ctx.dev_mask());
     });
 #if MKL_EXPERIMENTAL == 1
     res.Mkl_mem_ = Mkl_mem_;
@@ -125,7 +239,7 @@ class NDArray {
    */
   inline void WaitToRead() const {
     if (is_none()) return;
-    Engine::Get()->WaitForVar(ptr_->var);
+    Engine::Get()->WaitForVar(this->var());
   }
   /*!
    * \brief Block until all the pending read/write operations with respect
@@ -137,13 +251,22 @@ class NDArray {
      * Push an empty mutable function to flush all preceding reads to the
      * variable.
      */
-    Engine::Get()->PushSync([](RunContext) {}, Context{}, {}, {ptr_->var});
+    Engine::Get()->PushSync([](RunContext) {}, Context{}, {}, {this->var()});
     Engine::Get()->WaitForVar(ptr_->var);
   }
-  /*! \return the associated variable of the ndarray.*/
+  /*!
+   * \return the associated variable of the ndarray.
+   *  Every operation on the ndarray is scheduled with its variable, so the
+   *  deferred imperative operations on the ndarray are pushed first.
+   */
   inline Engine::VarHandle var() const {
+    if (ptr_->lazy_pending.load(std::memory_order_relaxed)) FlushLazy();
     return ptr_->var;
   }
+  /*!
+   * \brief Push the imperative operations deferred in lazy mode to the engine.
+   */
+  static void FlushLazy();
   /*!
    * \brief save the content into binary stream
    * \param strm the output stream
@@ -257,8 +380,10 @@ class NDArray {
    * \return sliced NDArray
    */
   inline NDArray Slice(index_t begin, index_t end) const {
+    if (!is_contiguous()) return SliceAxis(0, begin, end);
     NDArray ret = *this;
     CHECK(!is_none()) << "NDArray is not initialized";
+    CHECK_EQ(storage_type(), kDefaultStorage) << "Cannot slice a sparse NDArray";
     CHECK_GE(shape_[0], end) << "Slice end index out of range";
     size_t length = shape_.ProdShape(1, shape_.ndim());
     ret.offset_ += begin * length;
@@ -273,6 +398,8 @@ class NDArray {
   inline NDArray At(index_t idx) const {
     NDArray ret = *this;
     CHECK(!is_none()) << "NDArray is not initialized";
+    CHECK(is_contiguous()) << "Cannot index a strided NDArray view, use Compact()";
+    CHECK_EQ(storage_type(), kDefaultStorage) << "Cannot index a sparse NDArray";
     CHECK_GT(shape_[0], idx) << "index out of range";
     size_t length = shape_.ProdShape(1, shape_.ndim());
     ret.offset_ += idx * length;
@@ -294,6 +421,8 @@ class NDArray {
     CHECK_GE(shape_.Size() * mshadow::mshadow_sizeof(dtype_),
              shape.Size() * mshadow::mshadow_sizeof(dtype))
         << "NDArray.AsArray: target memory size is bigger";
+    CHECK(is_contiguous()) << "NDArray.AsArray: the array is a strided view";
+    CHECK_EQ(storage_type(), kDefaultStorage) << "NDArray.AsArray: the array is sparse";
 #if MKL_EXPERIMENTAL == 1
     if (Mkl_mem_ != nullptr) {
       // convert prv to cpu
@@ -313,10 +442,40 @@ class NDArray {
   inline NDArray Reshape(const TShape &shape) const {
     CHECK_GE(shape_.Size(), shape.Size())
         << "NDArray.Reshape: target shape size is different from current shape";
+    CHECK(is_contiguous()) << "NDArray.Reshape: the array is a strided view, use Compact()";
+    CHECK_EQ(storage_type(), kDefaultStorage) << "NDArray.Reshape: the array is sparse";
     NDArray ret = *this;
     ret.shape_ = shape;
     return ret;
   }
+  /*!
+   * \brief Slice a NDArray along any axis without copying it.
+   *  Slices of contiguous arrays along the first axis stay contiguous,
+   *  the others are strided views.
+   * \param axis the axis
+   * \param begin begin index in the axis
+   * \param end end index in the axis
+   * \return sliced NDArray
+   */
+  NDArray SliceAxis(index_t axis, index_t begin, index_t end) const;
+  /*!
+   * \brief Permute the axes of a NDArray without copying it.
+   * \param axes the axes of the current array, in the order of the new one
+   * \return the transposed view
+   */
+  NDArray Transpose(const TShape& axes) const;
+  /*!
+   * \brief Broadcast the axes of size 1 without copying, they get a stride of 0.
+   *  The view cannot be written.
+   * \param shape the new shape, with the same number of dimensions
+   * \return the broadcast view
+   */
+  NDArray BroadcastTo(const TShape& shape) const;
+  /*!
+   * \brief Get a contiguous array with the content of a strided view.
+   * \return the array itself if it is contiguous, a new copy otherwise
+   */
+  NDArray Compact() const;
   /*!
    * \brief Allocate the space if it is delayed allocated.
    * This is an internal function used by system that normal user should not use
@@ -324,6 +483,37 @@ class NDArray {
   inline void CheckAndAlloc() const {
     ptr_->CheckAndAlloc();
   }
+  /*!
+   * \brief Allocate the storage of a sparse array for new stored values and
+   *  indices. The previous content is lost. This is an internal function
+   *  for the operations writing sparse arrays.
+   * \param storage_shape the shape of the stored values
+   * \param aux_shapes the shapes of the index arrays
+   */
+  inline void CheckAndAlloc(const TShape &storage_shape,
+                            const std::vector<TShape> &aux_shapes) const {
+    CHECK_NE(storage_type(), kDefaultStorage);
+    CHECK_EQ(aux_shapes.size(), num_aux());
+    ptr_->CheckAndAllocData(storage_shape, dtype_);
+    for (size_t i = 0; i < aux_shapes.size(); ++i) {
+      ptr_->CheckAndAllocAuxData(i, aux_shapes[i]);
+    }
+  }
+  /*!
+   * \brief Copy the stored values and the indices into a sparse array.
+   *  The indices must be valid for the storage type: sorted row indices for
+   *  row sparse arrays, row pointers and sorted column indices in every row
+   *  for csr matrices.
+   * \param data the stored values
+   * \param aux the index arrays, of type sparse_index_t
+   */
+  void SetSparseData(const NDArray &data, const std::vector<NDArray> &aux) const;
+  /*!
+   * \brief Get a dense copy of a component of a sparse array, waiting for
+   *  the pending writes to the array.
+   * \param i the index array, or -1 for the stored values
+   */
+  NDArray GetSparseData(int i) const;
   /*!
    * \brief Save list of narray into the Stream.x
    * \param fo The stream of output.
@@ -357,14 +547,28 @@ class NDArray {
     bool static_data;
     /*! \brief whether allocation is delayed */
     bool delay_alloc;
+    /*! \brief releases the static data, if it is owned by the chunk */
+    std::function<void()> deleter;
+    /*! \brief whether a deferred imperative operation reads or writes the chunk */
+    std::atomic<bool> lazy_pending{false};
+    /*! \brief storage type of the chunk */
+    NDArrayStorageType storage_type{kDefaultStorage};
+    /*! \brief shape of the stored values of a sparse chunk */
+    TShape storage_shape;
+    /*! \brief storage of the index arrays of a sparse chunk */
+    std::vector<Storage::Handle> aux_handles;
+    /*! \brief shapes of the index arrays of a sparse chunk */
+    std::vector<TShape> aux_shapes;
     /*! \brief default cosntructor */
     Chunk() : static_data(true), delay_alloc(false) {
       var  = Engine::Get()->NewVariable();
     }
     /*! \brief construct from static data */
-    Chunk(const TBlob &data, int dev_id)
+    Chunk(const TBlob &data, int dev_id,
+          const std::function<void()>& deleter = std::function<void()>())
         : static_data(true),
-          delay_alloc(false) {
+          delay_alloc(false),
+          deleter(deleter) {
       var = Engine::Get()->NewVariable();
       if (data.dev_mask_ == cpu::kDevMask) {
         shandle.ctx = Context::CPU();
@@ -383,6 +587,29 @@ class NDArray {
       shandle.ctx = ctx;
       if (!delay_alloc_) this->CheckAndAlloc();
     }
+    /*! \brief construct an empty sparse chunk */
+    Chunk(NDArrayStorageType stype, const TShape &shape, Context ctx)
+        : static_data(false), delay_alloc(false), storage_type(stype) {
+      CHECK(stype == kRowSparseStorage || stype == kCSRStorage)
+        << "Unknown sparse storage type " << stype;
+      CHECK_EQ(ctx.dev_mask(), cpu::kDevMask)
+        << "Sparse storage is only supported on CPU";
+      var = Engine::Get()->NewVariable();
+      shandle.dptr = nullptr;
+      shandle.size = 0;
+      shandle.ctx = ctx;
+      aux_handles.resize(stype == kRowSparseStorage ? 1 : 2, shandle);
+      aux_shapes.resize(aux_handles.size(), TShape(mshadow::Shape1(0)));
+      storage_shape = shape;
+      storage_shape[0] = 0;
+      if (stype == kCSRStorage) {
+        CHECK_EQ(shape.ndim(), 2U) << "CSR storage is only supported for matrices";
+        storage_shape = TShape(mshadow::Shape1(0));
+        // the row pointers of a matrix without non-zeros are all 0
+        CheckAndAllocAuxData(csr::kIndPtr, mshadow::Shape1(shape[0] + 1));
+        memset(aux_handles[csr::kIndPtr].dptr, 0, aux_handles[csr::kIndPtr].size);
+      }
+    }
     /*! \brief check if delay alloc is on, do alloc if not yet done */
     inline void CheckAndAlloc(void) {
       if (delay_alloc) {
@@ -390,9 +617,38 @@ class NDArray {
         delay_alloc = false;
       }
     }
+    /*! \brief make room for the stored values of a sparse chunk, keeping larger buffers */
+    inline void CheckAndAllocData(const TShape &shape, int dtype) {
+      Reserve(&shandle, shape.Size() * mshadow::mshadow_sizeof(dtype));
+      storage_shape = shape;
+    }
+    /*! \brief make room for an index array of a sparse chunk, keeping larger buffers */
+    inline void CheckAndAllocAuxData(size_t i, const TShape &shape) {
+      Reserve(&aux_handles[i], shape.Size() * sizeof(sparse_index_t));
+      aux_shapes[i] = shape;
+    }
+    /*! \brief grow a buffer of a sparse chunk to at least size bytes */
+    inline static void Reserve(Storage::Handle *h, size_t size) {
+      if (h->size >= size) return;
+      if (h->dptr != nullptr) Storage::Get()->Free(*h);
+      *h = Storage::Get()->Alloc(size, h->ctx);
+    }
     /*! \brief destructor */
     ~Chunk() {
-      if (static_data || delay_alloc) {
+      if (storage_type != kDefaultStorage) {
+        std::vector<Storage::Handle> handles = aux_handles;
+        handles.push_back(shandle);
+        Engine::Get()->DeleteVariable([handles](RunContext s) {
+            for (const Storage::Handle& h : handles) {
+              if (h.dptr != nullptr) Storage::Get()->Free(h);
+            }
+          }, shandle.ctx, var);
+      } else if (deleter) {
+        std::function<void()> release = deleter;
+        Engine::Get()->DeleteVariable([release](RunContext s) {
+            release();
+          }, shandle.ctx, var);
+      } else if (static_data || delay_alloc) {
         Engine::Get()->DeleteVariable([](RunContext s) {}, shandle.ctx, var);
       } else {
         Storage::Handle h = this->shandle;
@@ -402,6 +658,10 @@ class NDArray {
       }
     }
   };
+  // records the deferred operations on the chunks
+  friend class LazyImperative;
+  // drop the strides if they describe a contiguous layout
+  void NormalizeStrides();
 
 #if MKL_EXPERIMENTAL == 1
   std::shared_ptr<MKLMemHolder> Mkl_mem_;
@@ -414,6 +674,8 @@ class NDArray {
   size_t offset_;
   /*! \brief type of data */
   int dtype_ = -1;
+  /*! \brief strides of a strided view in elements, empty for contiguous arrays */
+  TShape strides_;
 };
 
 /*!
@@ -61,6 +61,26 @@ using FCompute = std::function<void (const nnvm::NodeAttrs& attrs,
                                      const std::vector<TBlob>& inputs,
                                      const std::vector<OpReqType>& req,
                                      const std::vector<TBlob>& outputs)>;
+/*!
+ * \brief Register a compute function taking NDArrays, for the operators
+ *  supporting sparse storage types. It is used instead of FCompute when one
+ *  of the arrays is sparse, and must allocate the sparse outputs.
+ *
+ * \note Register under "FComputeEx<cpu>"
+ */
+using FComputeEx = std::function<void (const nnvm::NodeAttrs& attrs,
+                                       const OpContext& ctx,
+                                       const std::vector<NDArray>& inputs,
+                                       const std::vector<OpReqType>& req,
+                                       const std::vector<NDArray>& outputs)>;
+/*!
+ * \brief Infer the storage types of the outputs from the storage types of
+ *  the inputs. Returns false when FComputeEx does not support them, then
+ *  the sparse arrays are converted to dense ones for FCompute.
+ *
+ * \note Register under "FInferStorageType"
+ */
+using FInferStorageType = nnvm::FInferNodeEntryAttr<int>;
 }  // namespace mxnet
 
 #endif  // MXNET_OP_ATTR_TYPES_H_
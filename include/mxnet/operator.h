@@ -51,6 +51,12 @@ struct OpContext {
   engine::CallbackOnComplete async_on_complete;
   /*! \brief Resources requested by the operator */
   std::vector<Resource> requested;
+  /*!
+   * \brief engine version of each input, in the order of the input blobs of
+   *  Forward or FCompute, see Engine::VarVersion. Filled by the graph
+   *  executor, empty when the versions are not known.
+   */
+  std::vector<size_t> in_versions;
   /*!
    * \brief get mshadow stream from Context
    * \return the mshadow stream
@@ -47,6 +47,8 @@ from . import torch as th
 
 from . import profiler
 
+from . import quantization
+
 from . import module
 from . import module as mod
 
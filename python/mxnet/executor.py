@@ -5,9 +5,10 @@ from __future__ import absolute_import
 
 import ctypes
 import copy
+import json
 import numpy as np
 from .base import _LIB
-from .base import mx_uint, NDArrayHandle, ExecutorHandle
+from .base import mx_uint, mx_float, NDArrayHandle, ExecutorHandle
 from .base import check_call, c_array, py_str
 from .ndarray import NDArray
 from . import ndarray as nd
@@ -24,6 +25,16 @@ def _monitor_callback_wrapper(callback):
         callback(name, array)
     return callback_handle
 
+def _grad_ready_callback_wrapper(callback):
+    """ a wrapper for the user-defined gradient ready handle """
+    def callback_handle(index, array, _):
+        """ ctypes function """
+        callback(index, NDArray(NDArrayHandle(array)))
+    return callback_handle
+
+# bit of each statistic computed by the in-engine monitor
+_MONITOR_STATS = ['l2_norm', 'min', 'max', 'nan_count', 'inf_count', 'mean_abs']
+
 class Executor(object):
     """ Executor is the actual executing object of MXNet."""
     def __init__(self, handle, symbol, ctx, grad_req, group2ctx):
@@ -51,6 +62,8 @@ class Executor(object):
         self._aux_dict = None
         self._output_dict = None
         self._monitor_callback = None
+        self._grad_ready_callback = None
+        self._monitor_stats = []
         self._ctx = copy.deepcopy(ctx)
         self._grad_req = copy.deepcopy(grad_req)
         self._group2ctx = copy.deepcopy(group2ctx)
@@ -161,6 +174,167 @@ class Executor(object):
             self._monitor_callback,
             None))
 
+    def set_grad_ready_callback(self, callback):
+        """Install a callback that is called as soon as the gradient of an argument is final.
+
+        The callback runs in an engine thread while backward is still running,
+        so that communication of the gradients of the late layers can overlap
+        with backward of the earlier layers. ``Module`` uses it to push each
+        gradient to the kvstore.
+
+        The callback takes the GIL in that engine thread. It may issue more
+        operations, such as ``KVStore.push``, but must never block on the
+        engine, e.g. by calling ``asnumpy``, ``wait_to_read`` or
+        ``nd.waitall``: the engine thread would wait for itself, and a main
+        thread waiting in the engine would never see backward finish.
+        Exceptions raised by the callback are printed and dropped.
+
+        Parameters
+        ----------
+        callback : function
+            Takes the index of the argument in ``arg_arrays`` and its gradient
+            as an NDArray.
+
+        Examples
+        --------
+        >>> ready = []
+        >>> texec.set_grad_ready_callback(lambda i, grad: ready.append(i))
+        >>> texec.forward(is_train=True)
+        >>> texec.backward()
+        >>> mx.nd.waitall()
+        """
+        cb_type = ctypes.CFUNCTYPE(None, ctypes.c_int, NDArrayHandle, ctypes.c_void_p)
+        self._grad_ready_callback = cb_type(_grad_ready_callback_wrapper(callback))
+        check_call(_LIB.MXExecutorSetGradReadyCallback(
+            self.handle,
+            self._grad_ready_callback,
+            None))
+
+    def set_monitor_stats(self, stats, interval=1):
+        """Compute statistics of every operator output inside the engine.
+
+        Unlike ``set_monitor_callback``, no array is handed to the frontend:
+        the statistics are computed right after each operator and kept as
+        scalars in the executor until ``get_monitor_stats`` is called.
+
+        Parameters
+        ----------
+        stats : list of str
+            Statistics to compute, any of 'l2_norm', 'min', 'max', 'nan_count',
+            'inf_count' and 'mean_abs'. NaN and Inf are left out of 'min', 'max'
+            and 'mean_abs'. An empty list disables the monitor.
+        interval : int
+            Collect statistics in every interval-th call to forward, and in the
+            backward that follows it.
+        """
+        mask = 0
+        for stat in stats:
+            if stat not in _MONITOR_STATS:
+                raise ValueError('unknown statistic %s, must be one of %s'
+                                 % (stat, str(_MONITOR_STATS)))
+            mask |= 1 << _MONITOR_STATS.index(stat)
+        self._monitor_stats = [s for s in _MONITOR_STATS if mask & (1 << _MONITOR_STATS.index(s))]
+        check_call(_LIB.MXExecutorSetMonitorStats(
+            self.handle, ctypes.c_int(mask), ctypes.c_int(interval)))
+
+    def get_monitor_stats(self):
+        """Wait for and return the statistics collected since the last call.
+
+        Returns
+        -------
+        list of (int, str, dict of str to float)
+            The iteration, the output name and the statistics of each record.
+        """
+        num = mx_uint()
+        iters = ctypes.POINTER(mx_uint)()
+        names = ctypes.POINTER(ctypes.c_char_p)()
+        values = ctypes.POINTER(mx_float)()
+        check_call(_LIB.MXExecutorGetMonitorStats(
+            self.handle, ctypes.byref(num), ctypes.byref(iters),
+            ctypes.byref(names), ctypes.byref(values)))
+        nstat = len(self._monitor_stats)
+        res = []
+        for i in range(num.value):
+            stat = {k: values[i * nstat + j] for j, k in enumerate(self._monitor_stats)}
+            res.append((iters[i], py_str(names[i]), stat))
+        return res
+
+    def set_node_profiling(self, enable=True):
+        """Record the execution time of every operator of the graph.
+
+        Unlike the engine profiler, the times are kept per graph node, so that
+        each layer can be told apart from the others of the same type.
+
+        Parameters
+        ----------
+        enable : bool
+            Whether to record the times.
+        """
+        check_call(_LIB.MXExecutorSetNodeProfiling(self.handle, ctypes.c_int(int(enable))))
+
+    def get_node_profile(self, reset=False):
+        """Wait for all operations and return the profile of each node.
+
+        Parameters
+        ----------
+        reset : bool
+            Clear the recorded times after reading them.
+
+        Returns
+        -------
+        list of dict
+            One dict per operator node, sorted by decreasing total time, with keys
+            'name', 'op', 'in_shapes', 'out_shapes', 'count', 'total_us', 'min_us',
+            'max_us', 'in_bytes', 'out_bytes', 'num_inplace', 'flops' (estimated
+            floating point operations of one run) and 'gflops' (achieved GFLOP/s).
+        """
+        out = ctypes.c_char_p()
+        check_call(_LIB.MXExecutorGetNodeProfile(
+            self.handle, ctypes.c_int(int(reset)), ctypes.byref(out)))
+        profile = json.loads(py_str(out.value))
+        for node in profile:
+            node['gflops'] = (node['flops'] * node['count'] / node['total_us'] / 1e3
+                              if node['total_us'] > 0 else 0.0)
+        return profile
+
+    def node_profile_str(self, reset=False, top=None):
+        """Format the node profile as a timing table and a memory table.
+
+        Parameters
+        ----------
+        reset : bool
+            Clear the recorded times after reading them.
+        top : int, optional
+            Only show the nodes with the largest total time.
+
+        Returns
+        -------
+        str
+            The tables.
+        """
+        profile = self.get_node_profile(reset)
+        total = sum(node['total_us'] for node in profile)
+        nodes = profile[:top] if top is not None else profile
+        shape_str = lambda shapes: ','.join('(%s)' % ','.join(str(d) for d in s) for s in shapes)
+        lines = ['%-32s %-20s %8s %12s %6s %10s %10s %10s %10s' % (
+            'Node', 'Op', 'Count', 'Total(ms)', '%', 'Avg(ms)', 'Min(ms)', 'Max(ms)', 'GFLOP/s')]
+        for node in nodes:
+            count = max(node['count'], 1)
+            lines.append('%-32s %-20s %8d %12.3f %6.2f %10.3f %10.3f %10.3f %10.2f' % (
+                node['name'], node['op'], node['count'], node['total_us'] / 1e3,
+                100.0 * node['total_us'] / total if total > 0 else 0.0,
+                node['total_us'] / 1e3 / count, node['min_us'] / 1e3,
+                node['max_us'] / 1e3, node['gflops']))
+        lines.append('')
+        lines.append('%-32s %12s %12s %8s  %s' % (
+            'Node', 'Input(MB)', 'Output(MB)', 'Inplace', 'Shapes'))
+        for node in nodes:
+            lines.append('%-32s %12.3f %12.3f %8d  %s -> %s' % (
+                node['name'], node['in_bytes'] / 1e6, node['out_bytes'] / 1e6,
+                node['num_inplace'], shape_str(node['in_shapes']),
+                shape_str(node['out_shapes'])))
+        return '\n'.join(lines)
+
     @property
     def arg_dict(self):
         """Get dictionary representation of argument arrrays.
@@ -229,6 +229,41 @@ class KVStore(object):
             self.handle, mx_uint(len(ckeys)), ckeys, cvals,
             ctypes.c_int(priority)))
 
+    def row_sparse_pull(self, key, out=None, row_ids=None, priority=0):
+        """ Pull some rows of a single value or a sequence of values from the
+        store into row sparse arrays. Only the local kvstore supports it.
+
+        Parameters
+        ----------
+        key : int or list of int
+            Keys
+
+        out: NDArray or list of NDArray or list of list of NDArray
+            According row sparse values
+
+        row_ids: NDArray or list of NDArray or list of list of NDArray
+            The indices of the rows to pull into each value, with the same
+            structure as `out`. They can be unsorted and repeated.
+
+        priority : int, optional
+            The priority of the pull operation.
+
+        Examples
+        --------
+        >>> a = mx.nd.zeros(shape, stype='row_sparse')
+        >>> kv.row_sparse_pull(3, out=a, row_ids=mx.nd.array([0, 2]))
+        >>> print a.indices.asnumpy()
+        [0 2]
+        """
+        assert(out is not None)
+        assert(row_ids is not None)
+        ckeys, cvals = _ctype_key_value(key, out)
+        _, crow_ids = _ctype_key_value(key, row_ids)
+        assert(len(crow_ids) == len(cvals))
+        check_call(_LIB.MXKVStorePullRowSparse(
+            self.handle, mx_uint(len(ckeys)), ckeys, cvals, crow_ids,
+            ctypes.c_int(priority)))
+
     def set_optimizer(self, optimizer):
         """Register an optimizer to the store
 
@@ -5,6 +5,7 @@ from __future__ import absolute_import, print_function
 
 import time
 import logging
+import threading
 import warnings
 from collections import namedtuple
 import numpy as np
@@ -85,27 +86,31 @@ def _initialize_kvstore(kvstore, param_arrays, arg_params, param_names,
         if update_on_kvstore:
             kvstore.pull(idx, param_on_devs, priority=-idx)
 
-def _update_params_on_kvstore(param_arrays, grad_arrays, kvstore):
-    """ Perform update of param_arrays from grad_arrays on kvstore."""
+def _update_params_on_kvstore(param_arrays, grad_arrays, kvstore, pushed=()):
+    """ Perform update of param_arrays from grad_arrays on kvstore.
+    The gradients whose index is in pushed were already pushed."""
     for index, pair in enumerate(zip(param_arrays, grad_arrays)):
         arg_list, grad_list = pair
         if grad_list[0] is None:
             continue
         # push gradient, priority is negative index
-        kvstore.push(index, grad_list, priority=-index)
+        if index not in pushed:
+            kvstore.push(index, grad_list, priority=-index)
         # pull back the weights
         kvstore.pull(index, arg_list, priority=-index)
 
 def _update_params(param_arrays, grad_arrays, updater, num_device,
-                   kvstore=None):
-    """ Perform update of param_arrays from grad_arrays not on kvstore."""
+                   kvstore=None, pushed=()):
+    """ Perform update of param_arrays from grad_arrays not on kvstore.
+    The gradients whose index is in pushed were already pushed."""
     for index, pair in enumerate(zip(param_arrays, grad_arrays)):
         arg_list, grad_list = pair
         if grad_list[0] is None:
             continue
         if kvstore:
             # push gradient, priority is negative index
-            kvstore.push(index, grad_list, priority=-index)
+            if index not in pushed:
+                kvstore.push(index, grad_list, priority=-index)
             # pull back the sum gradients, to the same locations.
             kvstore.pull(index, grad_list, priority=-index)
         for k, p in enumerate(zip(arg_list, grad_list)):
@@ -116,6 +121,74 @@ def _update_params(param_arrays, grad_arrays, updater, num_device,
             updater(index*num_device+k, g, w)
 
 
+class _GradientPusher(object):
+    """Push each gradient to the kvstore from the gradient ready callbacks of
+    the executors, as soon as backward has finished it on every device, so
+    that the communication overlaps with the rest of backward.
+
+    ``start`` is called before each backward and ``finish`` before the
+    update, which returns the indices of the gradients that were pushed. The
+    pushes are issued from engine threads, they are serialized here because
+    the kvstore is not thread safe.
+    """
+    def __init__(self, kvstore):
+        self._kvstore = kvstore
+        self._cond = threading.Condition()
+        self._grad_arrays = []
+        self._pending = []
+        self._num_pending = 0
+        self._pushed = set()
+        self._error = None
+
+    def start(self, grad_arrays):
+        """Expect the gradients of grad_arrays from the coming backward."""
+        self.finish()
+        with self._cond:
+            self._grad_arrays = grad_arrays
+            self._pending = [0 if grads[0] is None else len(grads) for grads in grad_arrays]
+            self._num_pending = sum(1 for count in self._pending if count > 0)
+
+    def ready(self, index, device):
+        """Gradient ready callback, for gradient index on the given device."""
+        # pylint: disable=unused-argument, broad-except
+        # it runs on an engine thread, an exception would leave finish waiting
+        with self._cond:
+            if index >= len(self._pending) or self._pending[index] == 0:
+                return
+            self._pending[index] -= 1
+            if self._pending[index] > 0:
+                return
+            try:
+                self._kvstore.push(index, self._grad_arrays[index], priority=-index)
+                self._pushed.add(index)
+            except Exception as err:
+                self._error = err
+            self._num_pending -= 1
+            self._cond.notify_all()
+
+    def cancel(self):
+        """Stop expecting the gradients of the last backward, when it failed."""
+        with self._cond:
+            self._pending = []
+            self._num_pending = 0
+            self._pushed = set()
+            self._error = None
+
+    def finish(self):
+        """Wait for the gradients of the last backward, and return the
+        indices of those that were pushed."""
+        with self._cond:
+            while self._num_pending > 0:
+                self._cond.wait()
+            pushed, error = self._pushed, self._error
+            self._pending = []
+            self._pushed = set()
+            self._error = None
+        if error is not None:
+            raise error
+        return pushed
+
+
 def _multiple_callbacks(callbacks, *args, **kwargs):
     """Sends args and kwargs to any configured callbacks.
     This handles the cases where the 'callbacks' variable
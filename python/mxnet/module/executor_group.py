@@ -176,6 +176,7 @@ class DataParallelExecutorGroup(object):
         self.grad_arrays = None
         self.aux_arrays = None
         self.input_grad_arrays = None
+        self._grad_ready_callback = None
 
         self.data_shapes = None
         self.label_shapes = None
@@ -281,6 +282,9 @@ class DataParallelExecutorGroup(object):
         self.data_shapes = data_shapes
         self.label_shapes = label_shapes
         self._collect_arrays()
+        # reshaped executors are new ones
+        if self._grad_ready_callback is not None:
+            self.set_grad_ready_callback(self._grad_ready_callback)
 
     def reshape(self, data_shapes, label_shapes):
         """Reshape executors.
@@ -294,6 +298,28 @@ class DataParallelExecutorGroup(object):
             return
         self.bind_exec(data_shapes, label_shapes, reshape=True)
 
+    def set_grad_ready_callback(self, callback):
+        """Install a callback that is called during backward as soon as the
+        gradient of a parameter is final on one device.
+
+        Parameters
+        ----------
+        callback : function
+            Takes the index of the parameter in `param_arrays` and the index of the
+            device. It runs in an engine thread, see `Executor.set_grad_ready_callback`.
+        """
+        self._grad_ready_callback = callback
+        param_index = [i for i, name in enumerate(self.arg_names) if name in self.param_names]
+        param_index = dict((j, i) for i, j in enumerate(param_index))
+        def _device_callback(k):
+            """callback of the k-th executor"""
+            def _ready(index, _):
+                if index in param_index:
+                    callback(param_index[index], k)
+            return _ready
+        for k, exec_ in enumerate(self.execs):
+            exec_.set_grad_ready_callback(_device_callback(k))
+
     def set_params(self, arg_params, aux_params):
         """Assign, i.e. copy parameters to all the executors.
 
@@ -12,6 +12,7 @@ from .. import optimizer as opt
 
 from .executor_group import DataParallelExecutorGroup
 from ..model import _create_kvstore, _initialize_kvstore, _update_params, _update_params_on_kvstore
+from ..model import _GradientPusher
 from ..model import load_checkpoint
 from ..initializer import Uniform, InitDesc
 
@@ -72,6 +73,7 @@ class Module(BaseModule):
         self._optimizer = None
         self._kvstore = None
         self._update_on_kvstore = None
+        self._grad_pusher = None
         self._updater = None
         self._preload_opt_states = None
         self._grad_req = None
@@ -145,6 +147,7 @@ class Module(BaseModule):
         """Internal function to reset binded state."""
         self.binded = False
         self._exec_group = None
+        self._grad_pusher = None
         self._data_shapes = None
         self._label_shapes = None
 
@@ -354,6 +357,8 @@ class Module(BaseModule):
 
         if shared_module is not None and shared_module.optimizer_initialized:
             self.borrow_optimizer(shared_module)
+        elif self.optimizer_initialized:
+            self._install_grad_pusher()
 
     def reshape(self, data_shapes, label_shapes=None):
         """Reshape the module for new input shapes.
@@ -438,6 +443,7 @@ class Module(BaseModule):
             kvstore.set_optimizer(self._optimizer)
         else:
             self._updater = opt.get_updater(optimizer)
+        self._install_grad_pusher()
 
         self.optimizer_initialized = True
 
@@ -459,6 +465,18 @@ class Module(BaseModule):
         self._update_on_kvstore = shared_module._update_on_kvstore
         self._updater = shared_module._updater
         self.optimizer_initialized = True
+        self._install_grad_pusher()
+
+    def _install_grad_pusher(self):
+        """Push each gradient to the kvstore as soon as backward has computed it
+        on every device, instead of all of them in `update`. Gradients that are
+        accumulated with grad_req 'add' are only pushed by `update`."""
+        self._grad_pusher = None
+        if not self._kvstore or not self.for_training or \
+                'add' in self._exec_group.grad_req.values():
+            return
+        self._grad_pusher = _GradientPusher(self._kvstore)
+        self._exec_group.set_grad_ready_callback(self._grad_pusher.ready)
 
     def forward(self, data_batch, is_train=None):
         """Forward computation.
@@ -482,9 +500,22 @@ class Module(BaseModule):
             Gradient on the outputs to be propagated back.
             This parameter is only needed when bind is called
             on outputs that are not a loss function.
+
+        Notes
+        -----
+        With a kvstore, each gradient is pushed as soon as it is computed, so
+        every call is expected to be followed by `update`.
         """
         assert self.binded and self.params_initialized
-        self._exec_group.backward(out_grads=out_grads)
+        if self._grad_pusher is None:
+            self._exec_group.backward(out_grads=out_grads)
+            return
+        self._grad_pusher.start(self._exec_group.grad_arrays)
+        try:
+            self._exec_group.backward(out_grads=out_grads)
+        except Exception:
+            self._grad_pusher.cancel()
+            raise
 
     def update(self):
         """Update parameters according to the installed optimizer and the gradients computed
@@ -493,16 +524,17 @@ class Module(BaseModule):
         assert self.binded and self.params_initialized and self.optimizer_initialized
 
         self._params_dirty = True
+        pushed = self._grad_pusher.finish() if self._grad_pusher is not None else ()
         if self._update_on_kvstore:
             _update_params_on_kvstore(self._exec_group.param_arrays,
                                       self._exec_group.grad_arrays,
-                                      self._kvstore)
+                                      self._kvstore, pushed=pushed)
         else:
             _update_params(self._exec_group.param_arrays,
                            self._exec_group.grad_arrays,
                            updater=self._updater,
                            num_device=len(self._context),
-                           kvstore=self._kvstore)
+                           kvstore=self._kvstore, pushed=pushed)
 
     def get_outputs(self, merge_multi_context=True):
         """Get outputs of the previous forward computation.
@@ -57,6 +57,19 @@ _DTYPE_MX_TO_NP = {
 }
 # pylint: enable= no-member
 
+_STORAGE_TYPE_STR_TO_ID = {
+    'default'    : 0,
+    'row_sparse' : 1,
+    'csr'        : 2
+}
+
+_STORAGE_TYPE_ID_TO_STR = {
+    -1 : 'undefined',
+    0  : 'default',
+    1  : 'row_sparse',
+    2  : 'csr'
+}
+
 def _new_empty_handle():
     """Return a new empty handle.
 
@@ -90,6 +103,27 @@ def _new_alloc_handle(shape, ctx, delay_alloc, dtype=mx_real_t):
         ctypes.byref(hdl)))
     return hdl
 
+def _new_sparse_handle(stype, shape, ctx, dtype=mx_real_t, data=None, aux=()):
+    """Return a new handle to a sparse NDArray, of zeros when `data` is None.
+
+    Returns
+    -------
+    a new sparse ndarray handle
+    """
+    hdl = NDArrayHandle()
+    check_call(_LIB.MXNDArrayCreateSparse(
+        ctypes.c_int(_STORAGE_TYPE_STR_TO_ID[stype]),
+        c_array(mx_uint, shape),
+        mx_uint(len(shape)),
+        ctypes.c_int(ctx.device_typeid),
+        ctypes.c_int(ctx.device_id),
+        ctypes.c_int(int(_DTYPE_NP_TO_MX[np.dtype(dtype).type])),
+        data.handle if data is not None else None,
+        mx_uint(len(aux)),
+        c_array(NDArrayHandle, [a.handle for a in aux]),
+        ctypes.byref(hdl)))
+    return hdl
+
 def waitall():
     """Wait all async operation to finish in MXNet
 
@@ -97,6 +131,48 @@ def waitall():
     """
     check_call(_LIB.MXNDArrayWaitAll())
 
+def set_lazy_mode(lazy):
+    """Set whether imperative operations are recorded and executed lazily.
+
+    In lazy mode, the operations are recorded into a graph, which is run by a
+    cached executor when one of its results is used, so that the memory
+    planning and the cached operators of the executor are used. Disabling lazy
+    mode runs the recorded operations.
+
+    Parameters
+    ----------
+    lazy : bool
+        Whether to enable lazy mode.
+
+    Returns
+    -------
+    bool
+        The previous state.
+    """
+    prev = ctypes.c_int()
+    check_call(_LIB.MXNDArraySetLazyMode(ctypes.c_int(lazy), ctypes.byref(prev)))
+    return bool(prev.value)
+
+class LazyMode(object):
+    """Scope in which imperative operations are executed lazily.
+
+    Example
+    -------
+    >>> with mx.nd.LazyMode():
+    ...     c = a * b + 1
+    ...     print(c.asnumpy())
+    """
+    def __init__(self, lazy=True):
+        self._lazy = lazy
+        self._prev = None
+
+    def __enter__(self):
+        self._prev = set_lazy_mode(self._lazy)
+        return self
+
+    def __exit__(self, ptype, value, trace):
+        set_lazy_mode(self._prev)
+
 class NDArray(NDArrayBase):
     """NDArray object in mxnet.
 
@@ -362,7 +438,7 @@ class NDArray(NDArrayBase):
         stop = mx_uint(stop) if stop else mx_uint(self.shape[0])
         check_call(_LIB.MXNDArraySlice(
             self.handle, start, stop, ctypes.byref(handle)))
-        return NDArray(handle=handle, writable=self.writable)
+        return self._view(handle, self.writable)
 
     def _at(self, idx):
         """Return a sub NDArray that shares memory with current one.
@@ -376,7 +452,7 @@ class NDArray(NDArrayBase):
         idx = mx_uint(idx)
         check_call(_LIB.MXNDArrayAt(
             self.handle, idx, ctypes.byref(handle)))
-        return NDArray(handle=handle, writable=self.writable)
+        return self._view(handle, self.writable)
 
     def reshape(self, new_shape):
         """Return a reshaped NDArray that shares memory with current one.
@@ -391,7 +467,7 @@ class NDArray(NDArrayBase):
                                          len(new_shape),
                                          c_array(ctypes.c_int, new_shape),
                                          ctypes.byref(handle)))
-        return NDArray(handle=handle, writable=self.writable)
+        return self._view(handle, self.writable)
 
     # pylint: disable= undefined-variable
     def broadcast_to(self, shape):
@@ -419,6 +495,10 @@ class NDArray(NDArrayBase):
             return broadcast_to(self, shape=tuple(shape))
     # pylint: enable= undefined-variable
 
+    def _view(self, handle, writable):
+        """Return an NDArray for a handle sharing memory with current one."""
+        return NDArray(handle=handle, writable=writable)
+
     def wait_to_read(self):
         """Block until all pending writes operations on current NDArray are finished.
 
@@ -480,6 +560,46 @@ class NDArray(NDArrayBase):
             self.handle, ctypes.byref(mx_dtype)))
         return _DTYPE_MX_TO_NP[mx_dtype.value]
 
+    @property
+    def stype(self):
+        """Get the storage type of current NDArray: 'default' for dense arrays,
+        'row_sparse' or 'csr' for sparse ones.
+        """
+        stype = ctypes.c_int()
+        check_call(_LIB.MXNDArrayGetStorageType(self.handle, ctypes.byref(stype)))
+        return _STORAGE_TYPE_ID_TO_STR[stype.value]
+
+    def _sparse_data(self, i):
+        """Return a dense copy of the values (-1) or of the i-th index array."""
+        handle = NDArrayHandle()
+        check_call(_LIB.MXNDArrayGetSparseData(self.handle, ctypes.c_int(i), ctypes.byref(handle)))
+        return NDArray(handle=handle)
+
+    @property
+    def data(self):
+        """The stored values of a sparse NDArray, as a dense copy."""
+        return self._sparse_data(-1)
+
+    @property
+    def indices(self):
+        """The int32 row indices of a row sparse NDArray, or the column indices
+        of a csr NDArray, as a dense copy."""
+        return self._sparse_data(0 if self.stype == 'row_sparse' else 1)
+
+    @property
+    def indptr(self):
+        """The int32 row pointers of a csr NDArray, as a dense copy."""
+        if self.stype != 'csr':
+            raise ValueError('indptr is only defined for csr arrays')
+        return self._sparse_data(0)
+
+    def tostype(self, stype):
+        """Return a copy of the array with storage type `stype`: 'default',
+        'row_sparse' or 'csr'. Sparse storage is only supported on CPU."""
+        # pylint: disable= undefined-variable
+        return cast_storage(self, stype=stype)
+        # pylint: enable= undefined-variable
+
     @property
     # pylint: disable= invalid-name, undefined-variable
     def T(self):
@@ -489,6 +609,77 @@ class NDArray(NDArrayBase):
         return transpose(self)
     # pylint: enable= invalid-name, undefined-variable
 
+    @property
+    def is_contiguous(self):
+        """Whether the array is laid out contiguously in row-major order.
+
+        Views created by `slice_axis_view`, `transpose_view` and `broadcast_view`
+        can be strided. They are accepted by operators and copies, which read
+        them through a compacted copy.
+        """
+        contiguous = ctypes.c_int()
+        ndim = mx_uint()
+        pdata = ctypes.POINTER(mx_uint)()
+        check_call(_LIB.MXNDArrayGetStrides(
+            self.handle, ctypes.byref(contiguous), ctypes.byref(ndim), ctypes.byref(pdata)))
+        return bool(contiguous.value)
+
+    def slice_axis_view(self, axis, begin, end):
+        """Return a sliced NDArray along `axis` that shares memory with current one.
+
+        Parameters
+        ----------
+        axis : int
+            The axis to slice.
+        begin : int
+            Beginning index of the slice.
+        end : int
+            Ending index of the slice.
+        """
+        if axis < 0:
+            axis += len(self.shape)
+        handle = NDArrayHandle()
+        check_call(_LIB.MXNDArraySliceAxis(
+            self.handle, mx_uint(axis), mx_uint(begin), mx_uint(end), ctypes.byref(handle)))
+        return self._view(handle, self.writable)
+
+    def transpose_view(self, axes=None):
+        """Return a transposed NDArray that shares memory with current one.
+
+        Parameters
+        ----------
+        axes : iterable of int, optional
+            The permutation of the axes, reverses them by default.
+        """
+        if axes is None:
+            axes = tuple(reversed(range(len(self.shape))))
+        axes = [a + len(self.shape) if a < 0 else a for a in axes]
+        handle = NDArrayHandle()
+        check_call(_LIB.MXNDArrayTransposeView(
+            self.handle, mx_uint(len(axes)), c_array(mx_uint, axes), ctypes.byref(handle)))
+        return self._view(handle, self.writable)
+
+    def broadcast_view(self, shape):
+        """Return a read only NDArray broadcasting the axes of size 1 to `shape`
+        that shares memory with current one.
+
+        Parameters
+        ----------
+        shape : tuple of int
+            The shape of the view, with as many axes as the array.
+        """
+        handle = NDArrayHandle()
+        check_call(_LIB.MXNDArrayBroadcastView(
+            self.handle, mx_uint(len(shape)), c_array(mx_uint, shape), ctypes.byref(handle)))
+        return self._view(handle, False)
+
+    def compact(self):
+        """Return a contiguous NDArray with the same content, the array itself if
+        it is already contiguous."""
+        handle = NDArrayHandle()
+        check_call(_LIB.MXNDArrayCompact(self.handle, ctypes.byref(handle)))
+        return self._view(handle, self.writable)
+
     def asnumpy(self):
         """Return a copied numpy array of current array.
 
@@ -504,6 +695,33 @@ class NDArray(NDArrayBase):
             ctypes.c_size_t(data.size)))
         return data
 
+    def asnumpy_view(self):
+        """Return a numpy array sharing memory with current CPU array.
+
+        The pending operations on the array are waited for. The returned
+        array keeps the memory alive, but it must not be used while
+        operations on the array are running.
+
+        Returns
+        -------
+        array : numpy.ndarray
+            A view of array content.
+        """
+        if self.context.device_type not in ('cpu', 'cpu_pinned'):
+            raise ValueError('asnumpy_view requires an array on cpu')
+        pdata = ctypes.c_void_p()
+        keep_alive = NDArrayHandle()
+        check_call(_LIB.MXNDArrayGetDataPtr(
+            self.handle, ctypes.byref(pdata), ctypes.byref(keep_alive)))
+        dtype = np.dtype(self.dtype)
+        size = int(np.prod(self.shape)) * dtype.itemsize
+        if size == 0:
+            return np.empty(self.shape, dtype=dtype)
+        buf = (ctypes.c_char * size).from_address(pdata.value)
+        # freed with the numpy array, which keeps the buffer as its base
+        buf.keep_alive = self._view(keep_alive, self.writable)
+        return np.frombuffer(buf, dtype=dtype).reshape(self.shape)
+
     def asscalar(self):
         """Return a CPU scalar(float) of current ndarray.
 
@@ -559,7 +777,11 @@ class NDArray(NDArrayBase):
                 return
             return _internal._copyto(self, out=other)
         elif isinstance(other, Context):
-            hret = NDArray(_new_alloc_handle(self.shape, other, True, self.dtype))
+            stype = self.stype
+            if stype in ('row_sparse', 'csr'):
+                hret = NDArray(_new_sparse_handle(stype, self.shape, other, self.dtype))
+            else:
+                hret = NDArray(_new_alloc_handle(self.shape, other, True, self.dtype))
             return _internal._copyto(self, out=hret)
         else:
             raise TypeError('copyto do not support type ' + str(type(other)))
@@ -598,6 +820,27 @@ class NDArray(NDArrayBase):
 _init_ndarray_module(NDArray, "mxnet")
 
 
+class _SharedNDArray(NDArray):
+    """NDArray using the memory of a numpy array, see `from_numpy`.
+
+    The numpy array is referenced by the NDArray and by its views, and released
+    with them from Python, so that no Python code runs on the engine threads.
+    """
+    __slots__ = ['_source']
+
+    def _view(self, handle, writable):
+        out = _SharedNDArray(handle=handle, writable=writable)
+        out._source = self._source
+        return out
+
+    def __del__(self):
+        # the memory is released after this, once the operations using it are done
+        check_call(_LIB.MXNDArrayWaitToWrite(self.handle))
+        base_del = getattr(NDArrayBase, '__del__', None)
+        if base_del is not None:
+            base_del(self)
+
+
 def onehot_encode(indices, out):
     """One hot encoding indices into matrix out.
 
@@ -1043,7 +1286,7 @@ def negative(arr):
     """ Return the negation of array values """
     return multiply(arr, -1.0)
 
-def zeros(shape, ctx=None, dtype=None):
+def zeros(shape, ctx=None, dtype=None, stype=None):
     """Create a new NDArray filled with 0, with specified shape.
 
     Parameters
@@ -1054,6 +1297,9 @@ def zeros(shape, ctx=None, dtype=None):
         The context of the NDArray, default to current default context.
     dtype : str or numpy.dtype, optional
         The value type of the NDArray, default to np.float32
+    stype : str, optional
+        The storage type, 'default', 'row_sparse' or 'csr'. A sparse array
+        stores no value.
 
     Returns
     -------
@@ -1064,6 +1310,10 @@ def zeros(shape, ctx=None, dtype=None):
         ctx = Context.default_ctx
     if dtype is None:
         dtype = mx_real_t
+    if stype is not None and stype != 'default':
+        if isinstance(shape, int):
+            shape = (shape, )
+        return NDArray(_new_sparse_handle(stype, shape, ctx, dtype))
     # pylint: disable= no-member, protected-access
     return _internal._zeros(shape=shape, ctx=ctx, dtype=dtype)
     # pylint: enable= no-member, protected-access
@@ -1146,6 +1396,126 @@ def array(source_array, ctx=None, dtype=None):
     arr[:] = source_array
     return arr
 
+def _sparse_component(source, dtype, ctx):
+    """A dense NDArray on `ctx` holding a component of a sparse array."""
+    if isinstance(source, NDArray):
+        source = source.asnumpy()
+    return array(np.asarray(source, dtype=dtype), ctx=ctx, dtype=dtype)
+
+def row_sparse_array(arg1, shape, ctx=None, dtype=None):
+    """Create a row sparse NDArray from the stored rows and their indices.
+
+    Row sparse storage is only supported on CPU.
+
+    Parameters
+    ----------
+    arg1 : tuple of (data, indices)
+        `data` holds the stored rows, of shape (len(indices), shape[1], ...),
+        `indices` the sorted and unique indices of these rows.
+    shape : tuple of int
+        The shape of the array.
+    ctx : Context, optional
+        The context of the NDArray, default to current default context.
+    dtype : str or numpy.dtype, optional
+        The value type of the NDArray, default to np.float32
+
+    Returns
+    -------
+    out: NDArray
+        The created row sparse NDArray.
+    """
+    if ctx is None:
+        ctx = Context.default_ctx
+    if dtype is None:
+        dtype = mx_real_t
+    data, indices = arg1
+    data = _sparse_component(data, dtype, ctx)
+    indices = _sparse_component(indices, np.int32, ctx)
+    idx = indices.asnumpy()
+    if len(idx) and (np.any(np.diff(idx) <= 0) or idx[0] < 0 or idx[-1] >= shape[0]):
+        raise ValueError('The row indices must be sorted, unique and in [0, %d)' % shape[0])
+    return NDArray(_new_sparse_handle('row_sparse', shape, ctx, dtype, data, [indices]))
+
+def csr_matrix(arg1, shape, ctx=None, dtype=None):
+    """Create a csr NDArray from the non-zero values, their column indices and
+    the row pointers.
+
+    CSR storage is only supported on CPU.
+
+    Parameters
+    ----------
+    arg1 : tuple of (data, indices, indptr)
+        The values and column indices of the row `i` are
+        `data[indptr[i]:indptr[i+1]]` and `indices[indptr[i]:indptr[i+1]]`.
+    shape : tuple of int
+        The shape of the matrix.
+    ctx : Context, optional
+        The context of the NDArray, default to current default context.
+    dtype : str or numpy.dtype, optional
+        The value type of the NDArray, default to np.float32
+
+    Returns
+    -------
+    out: NDArray
+        The created csr NDArray.
+    """
+    if ctx is None:
+        ctx = Context.default_ctx
+    if dtype is None:
+        dtype = mx_real_t
+    data, indices, indptr = arg1
+    data = _sparse_component(data, dtype, ctx)
+    indices = _sparse_component(indices, np.int32, ctx)
+    indptr = _sparse_component(indptr, np.int32, ctx)
+    ptr, idx = indptr.asnumpy(), indices.asnumpy()
+    if len(shape) != 2 or len(ptr) != shape[0] + 1 or ptr[0] != 0 or \
+            np.any(np.diff(ptr) < 0) or ptr[-1] != len(idx):
+        raise ValueError('Invalid row pointers for a csr matrix of shape %s' % str(shape))
+    if len(idx) and (idx.min() < 0 or idx.max() >= shape[1]):
+        raise ValueError('The column indices must be in [0, %d)' % shape[1])
+    return NDArray(_new_sparse_handle('csr', shape, ctx, dtype, data, [indptr, indices]))
+
+def from_numpy(source_array):
+    """Create a CPU NDArray that shares memory with a numpy array, without copying it.
+
+    The numpy array is kept alive by the returned NDArray and by the views
+    created from it, and released once they are freed and the operations using
+    it are done. Writes to either array are visible to the other, so the numpy
+    array must not be changed while operations on the NDArray are running.
+
+    Parameters
+    ----------
+    source_array : numpy.ndarray
+        A writeable C-contiguous array of a type supported by NDArray. Read-only
+        arrays are rejected, since operations can write the NDArray in place;
+        copy them with `array` instead.
+
+    Returns
+    -------
+    out: NDArray
+        The created NDArray.
+    """
+    if not isinstance(source_array, np.ndarray):
+        raise TypeError('source_array must be a numpy.ndarray')
+    if not source_array.flags['C_CONTIGUOUS'] or source_array.dtype.type not in _DTYPE_NP_TO_MX:
+        raise ValueError('source_array must be C-contiguous with a type in %s'
+                         % str(list(_DTYPE_NP_TO_MX.keys())))
+    if not source_array.flags['WRITEABLE']:
+        raise ValueError('source_array is read-only, copy it with mx.nd.array instead')
+    hdl = NDArrayHandle()
+    check_call(_LIB.MXNDArrayCreateFromBuffer(
+        source_array.ctypes.data_as(ctypes.c_void_p),
+        c_array(mx_uint, source_array.shape),
+        mx_uint(source_array.ndim),
+        ctypes.c_int(Context.devstr2type['cpu']),
+        ctypes.c_int(0),
+        ctypes.c_int(_DTYPE_NP_TO_MX[source_array.dtype.type]),
+        None, None,
+        ctypes.byref(hdl)))
+    out = _SharedNDArray(handle=hdl)
+    out._source = source_array
+    return out
+
 def concatenate(arrays, axis=0, always_copy=True):
     """Concatenate a list of NDArrays along the first dimension.
 
@@ -1321,6 +1691,141 @@ def save(fname, data):
                                   c_array(NDArrayHandle, handles),
                                   keys))
 
+class AsyncSave(object):
+    """A parameter file being written in the background, returned by `save_async`."""
+    def __init__(self, handle):
+        self.handle = handle
+
+    def __del__(self):
+        check_call(_LIB.MXNDArraySaveAsyncFree(self.handle))
+
+    def wait(self):
+        """Wait until the file is written, raises MXNetError if writing failed."""
+        check_call(_LIB.MXNDArraySaveAsyncWait(self.handle))
+
+def save_async(fname, data):
+    """Save list of NDArray or dict of str->NDArray to a parameter file in the background.
+
+    The arrays are snapshotted when this function returns, so training can
+    continue and update them while the file is written. The file has an index,
+    aligned payloads and a CRC32 per array. It can be read with `load`, or
+    with `ParamFile` to load arrays by name.
+
+    Parameters
+    ----------
+    fname : str
+        The name of the file.
+    data : list of NDArray or dict of str to NDArray
+        The data to be saved.
+
+    Returns
+    -------
+    AsyncSave
+        Call its ``wait`` method to wait for the file to be written.
+
+    Example
+    -------
+    >>> pending = mx.nd.save_async('model-0001.params', arg_params)
+    >>> # ... keep training ...
+    >>> pending.wait()
+    """
+    handles = []
+    keys = None
+    if isinstance(data, dict):
+        keys = []
+        for key, val in data.items():
+            if not isinstance(key, string_types) or not isinstance(val, NDArray):
+                raise TypeError('save_async only accept dict str->NDArray or list of NDArray')
+            keys.append(c_str(key))
+            handles.append(val.handle)
+        keys = c_array(ctypes.c_char_p, keys)
+    else:
+        for val in data:
+            if not isinstance(val, NDArray):
+                raise TypeError('save_async only accept dict str->NDArray or list of NDArray')
+            handles.append(val.handle)
+    handle = ctypes.c_void_p()
+    check_call(_LIB.MXNDArraySaveAsync(c_str(fname),
+                                       mx_uint(len(handles)),
+                                       c_array(NDArrayHandle, handles),
+                                       keys,
+                                       ctypes.byref(handle)))
+    return AsyncSave(handle)
+
+class ParamFile(object):
+    """A parameter file written by `save_async`, opened for random access.
+
+    Only the index is read when the file is opened. Arrays are read when they
+    are requested, in parallel, and their checksums are verified.
+
+    Example
+    -------
+    >>> params = mx.nd.ParamFile('model-0001.params')
+    >>> weight = params['fc1_weight']
+    >>> subset = params.load(['fc1_weight', 'fc1_bias'], ctx=mx.gpu(0))
+    """
+    def __init__(self, fname):
+        self.handle = ctypes.c_void_p()
+        check_call(_LIB.MXParamFileOpen(c_str(fname), ctypes.byref(self.handle)))
+
+    def __del__(self):
+        check_call(_LIB.MXParamFileFree(self.handle))
+
+    def keys(self):
+        """Return the names of the arrays, empty if they were saved as a list."""
+        out_size = mx_uint()
+        out_name_size = mx_uint()
+        names = ctypes.POINTER(ctypes.c_char_p)()
+        check_call(_LIB.MXParamFileList(self.handle,
+                                        ctypes.byref(out_size),
+                                        ctypes.byref(out_name_size),
+                                        ctypes.byref(names)))
+        return [py_str(names[i]) for i in range(out_name_size.value)]
+
+    def __contains__(self, name):
+        return name in self.keys()
+
+    def __getitem__(self, name):
+        return self.load([name])[name]
+
+    def load(self, names=None, ctx=None):
+        """Load arrays.
+
+        Parameters
+        ----------
+        names : list of str, optional
+            The arrays to load, all of them by default.
+        ctx : Context, optional
+            The context of the loaded arrays, the saved one by default.
+
+        Returns
+        -------
+        out : list of NDArray or dict of str to NDArray
+            A list if the arrays were saved as a list and names is not given.
+        """
+        if names is None:
+            keys = self.keys()
+            c_names = None
+            num_names = 0
+        else:
+            keys = list(names)
+            c_names = c_array(ctypes.c_char_p, [c_str(n) for n in keys])
+            num_names = len(keys)
+        dev_type, dev_id = (0, 0) if ctx is None else (ctx.device_typeid, ctx.device_id)
+        out_size = mx_uint()
+        handles = ctypes.POINTER(NDArrayHandle)()
+        check_call(_LIB.MXParamFileLoad(self.handle,
+                                        mx_uint(num_names),
+                                        c_names,
+                                        ctypes.c_int(dev_type),
+                                        ctypes.c_int(dev_id),
+                                        ctypes.byref(out_size),
+                                        ctypes.byref(handles)))
+        arrays = [NDArray(NDArrayHandle(handles[i])) for i in range(out_size.value)]
+        if not keys:
+            return arrays
+        return dict(zip(keys, arrays))
+
 def imdecode(str_img, clip_rect=(0, 0, 0, 0), out=None, index=0, channels=3, mean=None):
     """Decode an image from string. Requires OpenCV to work.
 
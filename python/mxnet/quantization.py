@@ -0,0 +1,133 @@
+# coding: utf-8
+# pylint: disable=too-many-locals
+"""8-bit quantization of trained models for CPU inference.
+
+The Convolution and FullyConnected layers of a quantized model multiply uint8
+data with uint8 weights, accumulate in int32 and output float32. The range
+used to quantize the data of each layer is calibrated by running the float
+model on a few representative batches.
+
+Example
+-------
+>>> calib = mx.quantization.calibrate(sym, arg_params, aux_params, val_iter, num_batches=10)
+>>> qsym, qarg_params, qaux_params = mx.quantization.quantize_model(
+...     sym, arg_params, aux_params, calib)
+"""
+from __future__ import absolute_import
+
+import ctypes
+from .base import _LIB, check_call, c_array, c_str, py_str
+from .base import mx_uint, mx_float, SymbolHandle, NDArrayHandle
+from .context import cpu
+from .ndarray import NDArray
+from .symbol import Symbol
+
+
+def calibrate(sym, arg_params, aux_params, data_iter, num_batches=None):
+    """Collect the range of every data entry of a float model.
+
+    Parameters
+    ----------
+    sym : Symbol
+        The float model.
+    arg_params : dict of str to NDArray
+        The arguments of the model.
+    aux_params : dict of str to NDArray
+        The auxiliary states of the model.
+    data_iter : DataIter
+        Representative input batches. Labels are ignored.
+    num_batches : int, optional
+        Number of batches to run, all of them by default.
+
+    Returns
+    -------
+    dict of str to (float, float)
+        The minimum and maximum of each entry, keyed by the names of the inputs
+        and of the operator outputs given by the executor monitor.
+    """
+    data_names = [desc[0] for desc in data_iter.provide_data]
+    exe = sym.simple_bind(cpu(), grad_req='null', **dict(data_iter.provide_data))
+    exe.copy_params_from(arg_params, aux_params, allow_extra_params=True)
+    exe.set_monitor_stats(['min', 'max'])
+    ranges = {}
+
+    def _update(name, lo, hi):
+        if name in ranges:
+            lo = min(lo, ranges[name][0])
+            hi = max(hi, ranges[name][1])
+        ranges[name] = (lo, hi)
+
+    data_iter.reset()
+    for nbatch, batch in enumerate(data_iter):
+        if num_batches is not None and nbatch >= num_batches:
+            break
+        for name, data in zip(data_names, batch.data):
+            data.copyto(exe.arg_dict[name])
+            value = data.asnumpy()
+            _update(name, float(value.min()), float(value.max()))
+        exe.forward(is_train=False)
+        for _, name, stat in exe.get_monitor_stats():
+            _update(name, stat['min'], stat['max'])
+    exe.set_monitor_stats([])
+    return ranges
+
+
+def quantize_model(sym, arg_params, aux_params, calib):
+    """Quantize the 2D Convolution and FullyConnected layers of a model to 8 bits.
+
+    Layers whose data has no range in `calib`, and grouped or non-NCHW
+    convolutions, are kept in float32. The quantized model only runs on CPU.
+
+    Parameters
+    ----------
+    sym : Symbol
+        The float model, usually optimized with ``Symbol.optimize_for_inference``
+        first so that BatchNorm is folded into the weights.
+    arg_params : dict of str to NDArray
+        The arguments of the model.
+    aux_params : dict of str to NDArray
+        The auxiliary states of the model.
+    calib : dict of str to (float, float)
+        The ranges returned by ``calibrate``.
+
+    Returns
+    -------
+    qsym : Symbol
+        The quantized model.
+    qarg_params : dict of str to NDArray
+        Its arguments, with uint8 weights.
+    qaux_params : dict of str to NDArray
+        Its auxiliary states.
+    """
+    params = dict(arg_params)
+    params.update(aux_params)
+    keys = list(params.keys())
+    calib_names = list(calib.keys())
+    handle = SymbolHandle()
+    num_out = mx_uint()
+    out_names = ctypes.POINTER(ctypes.c_char_p)()
+    out_handles = ctypes.POINTER(NDArrayHandle)()
+    check_call(_LIB.MXSymbolQuantize(
+        sym.handle,
+        mx_uint(len(calib_names)),
+        c_array(ctypes.c_char_p, [c_str(n) for n in calib_names]),
+        c_array(mx_float, [calib[n][0] for n in calib_names]),
+        c_array(mx_float, [calib[n][1] for n in calib_names]),
+        mx_uint(len(keys)),
+        c_array(ctypes.c_char_p, [c_str(k) for k in keys]),
+        c_array(NDArrayHandle, [params[k].handle for k in keys]),
+        ctypes.byref(handle),
+        ctypes.byref(num_out),
+        ctypes.byref(out_names),
+        ctypes.byref(out_handles)))
+    qsym = Symbol(handle)
+    aux_names = set(qsym.list_auxiliary_states())
+    qarg_params, qaux_params = {}, {}
+    for i in range(num_out.value):
+        name = py_str(out_names[i])
+        value = NDArray(NDArrayHandle(out_handles[i]))
+        if name in aux_names:
+            qaux_params[name] = value
+        else:
+            qarg_params[name] = value
+    return qsym, qarg_params, qaux_params
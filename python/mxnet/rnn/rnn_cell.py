@@ -435,8 +435,8 @@ class LSTMCell(BaseRNNCell):
 
 class FusedRNNCell(BaseRNNCell):
     """Fusing RNN layers across time step into one kernel.
-    Improves speed but is less flexible. Currently only
-    supported if using cuDNN on GPU.
+    Improves speed but is less flexible. Uses cuDNN on GPU
+    and a fused implementation on CPU.
 
     Parameters
     ----------
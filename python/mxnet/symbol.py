@@ -619,6 +619,49 @@ class Symbol(SymbolBase):
             return (None, None, None)
         # pylint: enable=too-many-locals
 
+    def optimize_for_inference(self, data_names, params):
+        """Optimize the symbol and its parameters for inference.
+
+        BatchNorm following a Convolution or FullyConnected is folded into its weight
+        and bias, subgraphs that only depend on parameters are computed once, and
+        Dropout is removed. The optimized symbol gives the same outputs as the original
+        one up to floating point rounding, but only in inference mode.
+
+        Parameters
+        ----------
+        data_names : list of str
+            Names of the inputs that change between forward calls.
+        params : dict of str to NDArray
+            Values of the arguments and auxiliary states. Inputs in `params` and not in
+            `data_names` are treated as constants.
+
+        Returns
+        -------
+        sym : Symbol
+            The optimized symbol.
+        new_params : dict of str to NDArray
+            The parameters of the optimized symbol.
+        """
+        keys = list(params.keys())
+        handle = SymbolHandle()
+        num_out = mx_uint()
+        out_names = ctypes.POINTER(ctypes.c_char_p)()
+        out_handles = ctypes.POINTER(NDArrayHandle)()
+        check_call(_LIB.MXSymbolOptimizeForInference(
+            self.handle,
+            mx_uint(len(data_names)),
+            c_array(ctypes.c_char_p, [c_str(n) for n in data_names]),
+            mx_uint(len(keys)),
+            c_array(ctypes.c_char_p, [c_str(k) for k in keys]),
+            c_array(NDArrayHandle, [params[k].handle for k in keys]),
+            ctypes.byref(handle),
+            ctypes.byref(num_out),
+            ctypes.byref(out_names),
+            ctypes.byref(out_handles)))
+        new_params = {py_str(out_names[i]): NDArray(NDArrayHandle(out_handles[i]))
+                      for i in range(num_out.value)}
+        return Symbol(handle), new_params
+
     def debug_str(self):
         """Get a debug string.
 
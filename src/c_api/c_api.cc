@@ -25,6 +25,7 @@
 #include "./c_api_common.h"
 #include "../operator/custom-inl.h"
 #include "../engine/profiler.h"
+#include "../ndarray/param_file.h"
 
 using namespace mxnet;
 
@@ -147,6 +148,57 @@ int MXNDArrayCreateEx(const mx_uint *shape,
   API_END();
 }
 
+int MXNDArrayCreateSparse(int storage_type,
+                          const mx_uint *shape,
+                          mx_uint ndim,
+                          int dev_type,
+                          int dev_id,
+                          int dtype,
+                          NDArrayHandle data,
+                          mx_uint num_aux,
+                          NDArrayHandle *aux,
+                          NDArrayHandle *out) {
+  NDArray *ptr = nullptr;
+  API_BEGIN();
+  CHECK(storage_type == kRowSparseStorage || storage_type == kCSRStorage)
+    << "Invalid sparse storage type " << storage_type;
+  ptr = new NDArray(static_cast<NDArrayStorageType>(storage_type),
+                    TShape(shape, shape + ndim),
+                    Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id),
+                    dtype);
+  if (data != nullptr) {
+    std::vector<NDArray> v_aux;
+    for (mx_uint i = 0; i < num_aux; ++i) {
+      v_aux.push_back(*static_cast<NDArray*>(aux[i]));
+    }
+    ptr->SetSparseData(*static_cast<NDArray*>(data), v_aux);
+  }
+  *out = ptr;
+  API_END_HANDLE_ERROR(delete ptr);
+}
+
+int MXNDArrayCreateFromBuffer(void *data,
+                              const mx_uint *shape,
+                              mx_uint ndim,
+                              int dev_type,
+                              int dev_id,
+                              int dtype,
+                              NDArrayBufferDeleter deleter,
+                              void *deleter_arg,
+                              NDArrayHandle *out) {
+  API_BEGIN();
+  const Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  CHECK(ctx.dev_mask() == cpu::kDevMask || ctx.dev_mask() == gpu::kDevMask)
+    << "Unknown device type " << dev_type;
+  TBlob blob(data, TShape(shape, shape + ndim), ctx.dev_mask(), dtype);
+  std::function<void()> release;
+  if (deleter != nullptr) {
+    release = [deleter, data, deleter_arg]() { deleter(data, deleter_arg); };
+  }
+  *out = new NDArray(blob, dev_id, release);
+  API_END();
+}
+
 int MXNDArrayLoadFromRawBytes(const void *buf,
                               size_t size,
                               NDArrayHandle *out) {
@@ -204,6 +256,7 @@ int MXNDArrayWaitToWrite(NDArrayHandle handle) {
 
 int MXNDArrayWaitAll() {
   API_BEGIN();
+  NDArray::FlushLazy();
   Engine::Get()->WaitForAll();
   API_END();
 }
@@ -241,7 +294,13 @@ int MXNDArrayLoad(const char* fname,
   API_BEGIN();
   std::vector<NDArray> data;
   std::vector<std::string> &names = ret->ret_vec_str;
-  {
+  if (ParamFile::Probe(fname)) {
+    ParamFile file(fname);
+    std::vector<size_t> idx(file.size());
+    for (size_t i = 0; i < idx.size(); ++i) idx[i] = i;
+    data = file.Load(idx, nullptr);
+    names = file.names();
+  } else {
     std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname, "r"));
     mxnet::NDArray::Load(fi.get(), &data, &names);
   }
@@ -262,6 +321,99 @@ int MXNDArrayLoad(const char* fname,
   API_END();
 }
 
+int MXNDArraySaveAsync(const char* fname,
+                       mx_uint num_args,
+                       NDArrayHandle* args,
+                       const char** keys,
+                       ParamFileWriterHandle *out) {
+  API_BEGIN();
+  std::vector<NDArray> data(num_args);
+  std::vector<std::string> names;
+  for (mx_uint i = 0; i < num_args; ++i) {
+    data[i] = *static_cast<NDArray*>(args[i]);
+  }
+  if (keys != nullptr) {
+    names.resize(num_args);
+    for (mx_uint i = 0; i < num_args; ++i) {
+      names[i] = keys[i];
+    }
+  }
+  *out = new ParamFileWriter(fname, data, names);
+  API_END();
+}
+
+int MXNDArraySaveAsyncWait(ParamFileWriterHandle handle) {
+  API_BEGIN();
+  static_cast<ParamFileWriter*>(handle)->Wait();
+  API_END();
+}
+
+int MXNDArraySaveAsyncFree(ParamFileWriterHandle handle) {
+  API_BEGIN();
+  delete static_cast<ParamFileWriter*>(handle);
+  API_END();
+}
+
+int MXParamFileOpen(const char* fname,
+                    ParamFileHandle *out) {
+  API_BEGIN();
+  *out = new ParamFile(fname);
+  API_END();
+}
+
+int MXParamFileList(ParamFileHandle handle,
+                    mx_uint *out_size,
+                    mx_uint *out_name_size,
+                    const char*** out_names) {
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  const ParamFile* file = static_cast<ParamFile*>(handle);
+  ret->ret_vec_charp.clear();
+  for (const std::string& name : file->names()) {
+    ret->ret_vec_charp.push_back(name.c_str());
+  }
+  *out_size = static_cast<mx_uint>(file->size());
+  *out_name_size = static_cast<mx_uint>(ret->ret_vec_charp.size());
+  *out_names = dmlc::BeginPtr(ret->ret_vec_charp);
+  API_END();
+}
+
+int MXParamFileLoad(ParamFileHandle handle,
+                    mx_uint num_names,
+                    const char** names,
+                    int dev_type,
+                    int dev_id,
+                    mx_uint *out_size,
+                    NDArrayHandle** out_arr) {
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  const ParamFile* file = static_cast<ParamFile*>(handle);
+  std::vector<size_t> idx;
+  if (names == nullptr) {
+    for (size_t i = 0; i < file->size(); ++i) idx.push_back(i);
+  } else {
+    for (mx_uint i = 0; i < num_names; ++i) idx.push_back(file->Find(names[i]));
+  }
+  Context ctx;
+  if (dev_type != 0) {
+    ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
+  }
+  std::vector<NDArray> data = file->Load(idx, dev_type != 0 ? &ctx : nullptr);
+  ret->ret_handles.resize(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    ret->ret_handles[i] = new NDArray(std::move(data[i]));
+  }
+  *out_size = static_cast<mx_uint>(data.size());
+  *out_arr = dmlc::BeginPtr(ret->ret_handles);
+  API_END();
+}
+
+int MXParamFileFree(ParamFileHandle handle) {
+  API_BEGIN();
+  delete static_cast<ParamFile*>(handle);
+  API_END();
+}
+
 int MXNDArrayFree(NDArrayHandle handle) {
   API_BEGIN();
   delete static_cast<NDArray*>(handle);
@@ -280,6 +432,67 @@ int MXNDArraySlice(NDArrayHandle handle,
   API_END_HANDLE_ERROR(delete ptr);
 }
 
+int MXNDArraySliceAxis(NDArrayHandle handle,
+                       mx_uint axis,
+                       mx_uint slice_begin,
+                       mx_uint slice_end,
+                       NDArrayHandle *out) {
+  NDArray *ptr = new NDArray();
+  API_BEGIN();
+  *ptr = static_cast<NDArray*>(handle)->SliceAxis(axis, slice_begin, slice_end);
+  *out = ptr;
+  API_END_HANDLE_ERROR(delete ptr);
+}
+
+int MXNDArrayTransposeView(NDArrayHandle handle,
+                           mx_uint ndim,
+                           const mx_uint *axes,
+                           NDArrayHandle *out) {
+  NDArray *ptr = new NDArray();
+  API_BEGIN();
+  *ptr = static_cast<NDArray*>(handle)->Transpose(TShape(axes, axes + ndim));
+  *out = ptr;
+  API_END_HANDLE_ERROR(delete ptr);
+}
+
+int MXNDArrayBroadcastView(NDArrayHandle handle,
+                           mx_uint ndim,
+                           const mx_uint *shape,
+                           NDArrayHandle *out) {
+  NDArray *ptr = new NDArray();
+  API_BEGIN();
+  *ptr = static_cast<NDArray*>(handle)->BroadcastTo(TShape(shape, shape + ndim));
+  *out = ptr;
+  API_END_HANDLE_ERROR(delete ptr);
+}
+
+int MXNDArrayCompact(NDArrayHandle handle,
+                     NDArrayHandle *out) {
+  NDArray *ptr = new NDArray();
+  API_BEGIN();
+  *ptr = static_cast<NDArray*>(handle)->Compact();
+  *out = ptr;
+  API_END_HANDLE_ERROR(delete ptr);
+}
+
+int MXNDArrayGetStrides(NDArrayHandle handle,
+                        int *out_contiguous,
+                        mx_uint *out_dim,
+                        const mx_uint **out_pdata) {
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  NDArray *arr = static_cast<NDArray*>(handle);
+  ret->ret_vec_uint.clear();
+  if (!arr->is_none()) {
+    const TShape strides = arr->strides();
+    ret->ret_vec_uint.assign(strides.begin(), strides.end());
+  }
+  *out_contiguous = arr->is_none() || arr->is_contiguous();
+  *out_dim = static_cast<mx_uint>(ret->ret_vec_uint.size());
+  *out_pdata = dmlc::BeginPtr(ret->ret_vec_uint);
+  API_END();
+}
+
 int MXNDArrayAt(NDArrayHandle handle,
                 mx_uint idx,
                 NDArrayHandle *out) {
@@ -333,6 +546,22 @@ int MXNDArrayGetData(NDArrayHandle handle,
   API_END();
 }
 
+int MXNDArrayGetDataPtr(NDArrayHandle handle,
+                        void **out_pdata,
+                        NDArrayHandle *out_keep_alive) {
+  API_BEGIN();
+  NDArray *arr = static_cast<NDArray*>(handle);
+  if (!arr->is_none()) {
+    arr->WaitToWrite();
+    arr->CheckAndAlloc();
+    *out_pdata = arr->data().dptr_;
+  } else {
+    *out_pdata = nullptr;
+  }
+  *out_keep_alive = new NDArray(*arr);
+  API_END();
+}
+
 int MXNDArrayGetDType(NDArrayHandle handle,
                      int *out_dtype) {
   API_BEGIN();
@@ -345,6 +574,28 @@ int MXNDArrayGetDType(NDArrayHandle handle,
   API_END();
 }
 
+int MXNDArrayGetStorageType(NDArrayHandle handle,
+                            int *out_storage_type) {
+  API_BEGIN();
+  NDArray *arr = static_cast<NDArray*>(handle);
+  if (!arr->is_none()) {
+    *out_storage_type = arr->storage_type();
+  } else {
+    *out_storage_type = kUndefinedStorage;
+  }
+  API_END();
+}
+
+int MXNDArrayGetSparseData(NDArrayHandle handle,
+                           int i,
+                           NDArrayHandle *out) {
+  NDArray *ptr = nullptr;
+  API_BEGIN();
+  ptr = new NDArray(static_cast<NDArray*>(handle)->GetSparseData(i));
+  *out = ptr;
+  API_END_HANDLE_ERROR(delete ptr);
+}
+
 int MXNDArrayGetContext(NDArrayHandle handle,
                         int *out_dev_type,
                         int *out_dev_id) {
@@ -599,6 +850,25 @@ int MXKVStorePull(KVStoreHandle handle,
   API_END();
 }
 
+int MXKVStorePullRowSparse(KVStoreHandle handle,
+                           mx_uint num,
+                           const int* keys,
+                           NDArrayHandle* vals,
+                           NDArrayHandle* row_ids,
+                           int priority) {
+  API_BEGIN();
+  std::vector<int> v_keys(num);
+  std::vector<NDArray*> v_vals(num);
+  std::vector<NDArray> v_row_ids(num);
+  for (mx_uint i = 0; i < num; ++i) {
+    v_keys[i] = keys[i];
+    v_vals[i] = static_cast<NDArray*>(vals[i]);
+    v_row_ids[i] = *static_cast<NDArray*>(row_ids[i]);
+  }
+  static_cast<KVStore*>(handle)->PullRowSparse(v_keys, v_vals, v_row_ids, priority);
+  API_END();
+}
+
 int MXKVStoreSetUpdater(KVStoreHandle handle,
                         MXKVStoreUpdater updater,
                         void* updater_handle) {
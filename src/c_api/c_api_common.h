@@ -62,6 +62,10 @@ struct MXAPIThreadLocalEntry {
   std::vector<mx_uint> arg_shape_ndim, out_shape_ndim, aux_shape_ndim;
   /*! \brief result holder for returning shape pointer */
   std::vector<const mx_uint*> arg_shape_data, out_shape_data, aux_shape_data;
+  /*! \brief result holder for returning unsigned integers */
+  std::vector<mx_uint> ret_vec_uint;
+  /*! \brief result holder for returning floats */
+  std::vector<mx_float> ret_vec_float;
   // helper function to setup return value of shape array
   inline static void SetupShapeArrayReturn(
       const std::vector<TShape> &shapes,
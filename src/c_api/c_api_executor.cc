@@ -6,6 +6,8 @@
 #include <mxnet/base.h>
 #include <mxnet/c_api.h>
 #include <mxnet/executor.h>
+#include <dmlc/json.h>
+#include <sstream>
 #include "./c_api_common.h"
 
 int MXExecutorPrint(ExecutorHandle handle, const char **out_str) {
@@ -168,3 +170,95 @@ int MXExecutorSetMonitorCallback(ExecutorHandle handle,
   exec->SetMonitorCallback(clbk);
   API_END();
 }
+
+int MXExecutorSetGradReadyCallback(ExecutorHandle handle,
+                                   ExecutorGradReadyCallback callback,
+                                   void* callback_handle) {
+  API_BEGIN();
+  ExecutorGradReadyCallback callback_temp = callback;
+  void* callback_handle_temp = callback_handle;
+  std::function<void(int, void*)> clbk
+  = [callback_temp, callback_handle_temp](int index, void* handle) {
+    callback_temp(index, handle, callback_handle_temp);
+  };
+  Executor *exec = static_cast<Executor*>(handle);
+  exec->SetGradientReadyCallback(clbk);
+  API_END();
+}
+
+int MXExecutorSetMonitorStats(ExecutorHandle handle,
+                              int stat_mask,
+                              int interval) {
+  API_BEGIN();
+  Executor *exec = static_cast<Executor*>(handle);
+  exec->SetMonitorStats(stat_mask, interval);
+  API_END();
+}
+
+int MXExecutorGetMonitorStats(ExecutorHandle handle,
+                              mx_uint *num_records,
+                              const mx_uint **iterations,
+                              const char ***names,
+                              const mx_float **values) {
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  Executor *exec = static_cast<Executor*>(handle);
+  std::vector<uint32_t> iters;
+  exec->GetMonitorStats(&iters, &(ret->ret_vec_str), &(ret->ret_vec_float));
+  ret->ret_vec_uint.assign(iters.begin(), iters.end());
+  ret->ret_vec_charp.clear();
+  for (const auto& name : ret->ret_vec_str) {
+    ret->ret_vec_charp.push_back(name.c_str());
+  }
+  *num_records = static_cast<mx_uint>(iters.size());
+  *iterations = dmlc::BeginPtr(ret->ret_vec_uint);
+  *names = dmlc::BeginPtr(ret->ret_vec_charp);
+  *values = dmlc::BeginPtr(ret->ret_vec_float);
+  API_END();
+}
+
+int MXExecutorSetNodeProfiling(ExecutorHandle handle, int enable) {
+  API_BEGIN();
+  Executor *exec = static_cast<Executor*>(handle);
+  exec->SetNodeProfiling(enable != 0);
+  API_END();
+}
+
+int MXExecutorGetNodeProfile(ExecutorHandle handle,
+                             int reset,
+                             const char **out_json) {
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  Executor *exec = static_cast<Executor*>(handle);
+  std::vector<Executor::NodeProfile> profile;
+  exec->GetNodeProfile(reset != 0, &profile);
+  auto shapes = [](const std::vector<TShape>& v) {
+    std::vector<std::vector<index_t> > ret;
+    for (const auto& s : v) ret.emplace_back(s.begin(), s.end());
+    return ret;
+  };
+  std::ostringstream os;
+  dmlc::JSONWriter writer(&os);
+  writer.BeginArray();
+  for (const auto& p : profile) {
+    writer.WriteArraySeperator();
+    writer.BeginObject();
+    writer.WriteObjectKeyValue("name", p.name);
+    writer.WriteObjectKeyValue("op", p.op);
+    writer.WriteObjectKeyValue("in_shapes", shapes(p.in_shapes));
+    writer.WriteObjectKeyValue("out_shapes", shapes(p.out_shapes));
+    writer.WriteObjectKeyValue("count", p.count);
+    writer.WriteObjectKeyValue("total_us", p.total_us);
+    writer.WriteObjectKeyValue("min_us", p.min_us);
+    writer.WriteObjectKeyValue("max_us", p.max_us);
+    writer.WriteObjectKeyValue("in_bytes", p.in_bytes);
+    writer.WriteObjectKeyValue("out_bytes", p.out_bytes);
+    writer.WriteObjectKeyValue("num_inplace", p.num_inplace);
+    writer.WriteObjectKeyValue("flops", p.flops);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  ret->ret_str = os.str();
+  *out_json = ret->ret_str.c_str();
+  API_END();
+}
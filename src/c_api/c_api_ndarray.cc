@@ -11,35 +11,99 @@
 #include <mxnet/op_attr_types.h>
 #include <nnvm/node.h>
 #include <nnvm/op_attr_types.h>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "./c_api_common.h"
 #include "../common/utils.h"
+#include "../ndarray/lazy_imperative.h"
 
 using namespace mxnet;
 
-int MXImperativeInvoke(AtomicSymbolCreator creator,
-                       int num_inputs,
-                       NDArrayHandle *inputs,
-                       int *num_outputs,
-                       NDArrayHandle **outputs,
-                       int num_params,
-                       const char **param_keys,
-                       const char **param_vals) {
+/*!
+ * \brief what an imperative call computes from the operator, its parameters
+ *  and the shapes, types and context of its arrays. It is cached so that a
+ *  repeated call only allocates its outputs and pushes.
+ */
+struct ImperativeDispatch {
+  nnvm::NodeAttrs attrs;
+  int num_outputs;
+  int num_visible_outputs;
+  /*! \brief whether the operator is a FNDArrayFunction, nothing below is set then */
+  bool ndfunc{false};
+  Context ctx;
+  std::vector<TShape> in_shapes, out_shapes;
+  std::vector<int> in_types, out_types;
+  std::vector<Resource> requested;
+  std::vector<uint32_t> auxidx;
+  FCompute fn;
+  /*! \brief the compute function on NDArrays, set when one of the arrays is sparse */
+  FComputeEx fn_ex;
+  /*! \brief storage types of the outputs, set with fn_ex */
+  std::vector<int> out_stypes;
+  /*! \brief the legacy operator */
+  std::shared_ptr<Operator> opr;
+  /*! \brief serializes the calls sharing the operator once it is cached */
+  engine::VarHandle opr_var{nullptr};
+
+  ~ImperativeDispatch() {
+    if (opr_var != nullptr) {
+      Engine::Get()->DeleteVariable([](RunContext) {}, ctx, opr_var);
+    }
+  }
+};
+
+template<typename T>
+inline void AppendKey(std::string* key, const T& value) {
+  key->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+inline void AppendKey(std::string* key, const char* str) {
+  const size_t len = strlen(str);
+  AppendKey(key, len);
+  key->append(str, len);
+}
+
+inline void AppendKey(std::string* key, const NDArray& arr) {
+  if (arr.is_none()) {
+    AppendKey(key, -1);
+    return;
+  }
+  AppendKey(key, arr.shape().ndim());
+  for (index_t i = 0; i < arr.shape().ndim(); ++i) AppendKey(key, arr.shape()[i]);
+  AppendKey(key, arr.dtype());
+  AppendKey(key, static_cast<int>(arr.storage_type()));
+  AppendKey(key, arr.ctx().dev_type);
+  AppendKey(key, arr.ctx().dev_id);
+}
+
+// parse the parameters and infer the outputs of an imperative call
+std::shared_ptr<ImperativeDispatch> CreateDispatch(const nnvm::Op* op,
+                                                   int num_inputs,
+                                                   NDArrayHandle *inputs,
+                                                   int num_outputs,
+                                                   NDArray** outarray,
+                                                   int num_params,
+                                                   const char **param_keys,
+                                                   const char **param_vals) {
   static auto& num_args = nnvm::Op::GetAttr<std::string>("key_var_num_args");
   static auto& infershape = nnvm::Op::GetAttr<nnvm::FInferShape>("FInferShape");
   static auto& infertype = nnvm::Op::GetAttr<nnvm::FInferType>("FInferType");
   static auto& visible_out = nnvm::Op::GetAttr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs");
   static auto& fcpu = nnvm::Op::GetAttr<FCompute>("FCompute<cpu>");
   static auto& fgpu = nnvm::Op::GetAttr<FCompute>("FCompute<gpu>");
+  static auto& fcpu_ex = nnvm::Op::GetAttr<FComputeEx>("FComputeEx<cpu>");
+  static auto& inferstorage = nnvm::Op::GetAttr<FInferStorageType>("FInferStorageType");
   static auto& ndfunc = nnvm::Op::GetAttr<FNDArrayFunction>("FNDArrayFunction");
   static auto& createop = nnvm::Op::GetAttr<FCreateLayerOp>("FCreateLayerOp");
   static auto& mutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
   static auto& tmp_resource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
-  const nnvm::Op* op = static_cast<nnvm::Op*>(creator);
-  NDArray** outarray = *reinterpret_cast<NDArray***>(outputs);
-  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
-
-  API_BEGIN();
-  nnvm::NodeAttrs attrs;
+  std::shared_ptr<ImperativeDispatch> d = std::make_shared<ImperativeDispatch>();
+  nnvm::NodeAttrs& attrs = d->attrs;
   attrs.op = op;
   for (int i = 0; i < num_params; ++i) {
     attrs.dict.emplace(param_keys[i], param_vals[i]);
@@ -60,227 +124,411 @@ int MXImperativeInvoke(AtomicSymbolCreator creator,
   CHECK_EQ(num_inputs, infered_num_inputs)
     << "Expecting " << infered_num_inputs << " inputs, got "
     << num_inputs << " in operator " << op->name;
-  int infered_num_outputs;
   if (op->get_num_outputs != nullptr) {
-    infered_num_outputs = op->get_num_outputs(attrs);
+    d->num_outputs = op->get_num_outputs(attrs);
   } else {
-    infered_num_outputs = op->num_outputs;
+    d->num_outputs = op->num_outputs;
   }
-  int num_visible_outputs = infered_num_outputs;
+  d->num_visible_outputs = d->num_outputs;
   if (visible_out.count(op)) {
-    num_visible_outputs = visible_out[op](attrs);
-    CHECK_LE(num_visible_outputs, infered_num_outputs);
+    d->num_visible_outputs = visible_out[op](attrs);
+    CHECK_LE(d->num_visible_outputs, d->num_outputs);
+  }
+  if (outarray != nullptr) {
+    CHECK(num_outputs == d->num_outputs || num_outputs == d->num_visible_outputs)
+      << "Expecting " << d->num_outputs << " (all) or "
+      << d->num_visible_outputs << " (visible only) outputs, got "
+      << num_outputs << " in operator " << op->name;
+  }
+  if (ndfunc.count(op)) {
+    d->ndfunc = true;
+    return d;
   }
 
-  std::vector<NDArray> ndinputs, ndoutputs;
-  ndinputs.reserve(num_inputs);
+  // only the visible outputs given by the caller are used
+  std::vector<const NDArray*> ndinputs, ndoutputs(d->num_outputs, nullptr);
   for (int i = 0; i < num_inputs; ++i) {
-    ndinputs.emplace_back(*reinterpret_cast<NDArray*>(inputs[i]));
+    ndinputs.push_back(reinterpret_cast<NDArray*>(inputs[i]));
   }
-  if (outarray == nullptr) {
-    *num_outputs = num_visible_outputs;
-    ndoutputs.resize(infered_num_outputs);
-  } else {
-    CHECK(*num_outputs == infered_num_outputs || *num_outputs == num_visible_outputs)
-      << "Expecting " << infered_num_outputs << " (all) or "
-      << num_visible_outputs << " (visible only) outputs, got "
-      << *num_outputs << " in operator " << op->name;
-    ndoutputs.reserve(infered_num_outputs);
-    for (int i = 0; i < num_visible_outputs; ++i) {
-      ndoutputs.emplace_back(std::move(*outarray[i]));
+  if (outarray != nullptr) {
+    for (int i = 0; i < d->num_visible_outputs; ++i) {
+      if (!outarray[i]->is_none()) ndoutputs[i] = outarray[i];
     }
-    ndoutputs.resize(infered_num_outputs);
   }
 
-  if (ndfunc.count(op)) {
-    ndfunc[op](attrs, ndinputs, &ndoutputs);
+  // TODO(piiswrong): infer ctx
+  Context& ctx = d->ctx;
+  if (num_inputs) {
+    ctx = ndinputs[0]->ctx();
+  } else if (d->num_outputs && ndoutputs[0] != nullptr) {
+    ctx = ndoutputs[0]->ctx();
+  } else if (attrs.dict.find("ctx") != attrs.dict.end()) {
+    ctx = Context::FromString(attrs.dict["ctx"]);
   } else {
-    // TODO(piiswrong): infer ctx
-    Context ctx;
-    if (num_inputs) {
-      ctx = ndinputs[0].ctx();
-    } else if (infered_num_outputs && !ndoutputs[0].is_none()) {
-      ctx = ndoutputs[0].ctx();
-    } else if (attrs.dict.find("ctx") != attrs.dict.end()) {
-      ctx = Context::FromString(attrs.dict["ctx"]);
-    } else {
-      ctx = Context::CPU();
-    }
-    // Pinned context doesn't propagate
-    if (ctx.dev_type == Context::kCPUPinned) {
-      ctx = Context::CPU();
-    }
-
-    std::vector<TShape>& in_shapes = ret->arg_shapes;
-    std::vector<TShape>& out_shapes = ret->out_shapes;
-    in_shapes.clear();
-    out_shapes.clear();
-
-    for (auto& i : ndinputs) {
-      in_shapes.emplace_back(i.shape());
-    }
-    for (auto& i : ndoutputs) {
-      out_shapes.emplace_back(i.shape());
-    }
-    CHECK(infershape.count(op))
-      << "Operator " << op->name << " is missing FInferShape attribute";
-    CHECK(infershape[op](attrs, &in_shapes, &out_shapes));
-    CHECK_EQ(out_shapes.size(), static_cast<size_t>(infered_num_outputs));
+    ctx = Context::CPU();
+  }
+  // Pinned context doesn't propagate
+  if (ctx.dev_type == Context::kCPUPinned) {
+    ctx = Context::CPU();
+  }
 
-    std::vector<int>& in_types = ret->arg_types;
-    std::vector<int>& out_types = ret->out_types;
-    in_types.clear();
-    out_types.clear();
+  std::vector<TShape>& in_shapes = d->in_shapes;
+  std::vector<TShape>& out_shapes = d->out_shapes;
+  for (auto i : ndinputs) {
+    in_shapes.emplace_back(i->shape());
+  }
+  for (auto i : ndoutputs) {
+    out_shapes.emplace_back(i == nullptr ? TShape() : i->shape());
+  }
+  CHECK(infershape.count(op))
+    << "Operator " << op->name << " is missing FInferShape attribute";
+  CHECK(infershape[op](attrs, &in_shapes, &out_shapes));
+  CHECK_EQ(out_shapes.size(), static_cast<size_t>(d->num_outputs));
 
-    for (auto& i : ndinputs) {
-      in_types.push_back(i.dtype());
-    }
-    for (auto& i : ndoutputs) {
-      out_types.push_back(i.dtype());
-    }
-    CHECK(infertype.count(op))
-      << "Operator " << op->name << " is missing FInferType attribute";
-    CHECK(infertype[op](attrs, &in_types, &out_types));
-    CHECK_EQ(out_types.size(), static_cast<size_t>(infered_num_outputs));
+  std::vector<int>& in_types = d->in_types;
+  std::vector<int>& out_types = d->out_types;
+  for (auto i : ndinputs) {
+    in_types.push_back(i->dtype());
+  }
+  for (auto i : ndoutputs) {
+    out_types.push_back(i == nullptr ? -1 : i->dtype());
+  }
+  CHECK(infertype.count(op))
+    << "Operator " << op->name << " is missing FInferType attribute";
+  CHECK(infertype[op](attrs, &in_types, &out_types));
+  CHECK_EQ(out_types.size(), static_cast<size_t>(d->num_outputs));
 
-    for (int i = 0; i < infered_num_outputs; ++i) {
-      if (ndoutputs[i].is_none()) {
-        ndoutputs[i] = NDArray(out_shapes[i], ctx, true, out_types[i]);
-      } else {
-        CHECK_EQ(ndoutputs[i].shape(), out_shapes[i])
-          << i << "th output has invalid shape. "
-          << "Expecting " << out_shapes[i] << " got "
-          << ndoutputs[i].shape() << " in operator " << op->name;
-        CHECK_EQ(ndoutputs[i].dtype(), out_types[i])
-          << i << "th output has invalid shape. "
-          << "Expecting " << out_types[i] << " got "
-          << ndoutputs[i].dtype()  << " in operator " << op->name;
-      }
-    }
+  for (int i = 0; i < d->num_outputs; ++i) {
+    if (ndoutputs[i] == nullptr) continue;
+    CHECK_EQ(ndoutputs[i]->shape(), out_shapes[i])
+      << i << "th output has invalid shape. "
+      << "Expecting " << out_shapes[i] << " got "
+      << ndoutputs[i]->shape() << " in operator " << op->name;
+    CHECK_EQ(ndoutputs[i]->dtype(), out_types[i])
+      << i << "th output has invalid shape. "
+      << "Expecting " << out_types[i] << " got "
+      << ndoutputs[i]->dtype()  << " in operator " << op->name;
+  }
 
-    std::vector<engine::VarHandle> read_vars, write_vars;
-    // request resources
-    std::vector<Resource> requested;
-    if (tmp_resource.count(op)) {
-      int ntmp = 0;
-      for (const auto& req : tmp_resource[op](attrs)) {
-        switch (req.type) {
-         case ResourceRequest::kTempSpace:
-          ++ntmp;
-         case ResourceRequest::kRandom:
-          requested.push_back(ResourceManager::Get()->Request(ctx, req));
-          write_vars.push_back(requested.back().var);
-          break;
-         default:
-          LOG(FATAL) << "resource type not yet supported";
-        }
+  // request resources
+  if (tmp_resource.count(op)) {
+    int ntmp = 0;
+    for (const auto& req : tmp_resource[op](attrs)) {
+      switch (req.type) {
+       case ResourceRequest::kTempSpace:
+        ++ntmp;
+       case ResourceRequest::kRandom:
+        d->requested.push_back(ResourceManager::Get()->Request(ctx, req));
+        break;
+       default:
+        LOG(FATAL) << "resource type not yet supported";
       }
-      CHECK_LE(ntmp, 1) << "Only support 1 temp space request";
     }
+    CHECK_LE(ntmp, 1) << "Only support 1 temp space request";
+  }
+  if (mutate.count(op)) {
+    d->auxidx = mutate[op](attrs);
+    std::sort(d->auxidx.begin(), d->auxidx.end());
+  }
 
-    std::vector<uint32_t> auxidx;
-    for (auto& i : ndinputs) {
-      read_vars.push_back(i.var());
+  // sparse arrays go to FComputeEx when the operator supports their storage
+  // types, otherwise they are converted to dense arrays
+  if (ctx.dev_mask() == cpu::kDevMask && fcpu_ex.count(op) && inferstorage.count(op)) {
+    std::vector<int> in_stypes;
+    std::vector<int>& out_stypes = d->out_stypes;
+    for (auto i : ndinputs) {
+      in_stypes.push_back(i->storage_type());
     }
-    for (auto& i : ndoutputs) {
-      write_vars.push_back(i.var());
+    for (auto i : ndoutputs) {
+      out_stypes.push_back(i == nullptr ? kUndefinedStorage : i->storage_type());
     }
-    if (mutate.count(op)) {
-      auxidx = mutate[op](attrs);
-      std::sort(auxidx.begin(), auxidx.end());
-      for (auto & i : auxidx) {
-        write_vars.push_back(ndinputs[i].var());
+    bool sparse = false;
+    if (inferstorage[op](attrs, &in_stypes, &out_stypes)) {
+      for (int& stype : out_stypes) {
+        if (stype == kUndefinedStorage) stype = kDefaultStorage;
+        sparse = sparse || stype != kDefaultStorage;
+      }
+      for (int stype : in_stypes) {
+        sparse = sparse || stype != kDefaultStorage;
       }
     }
-    common::DeduplicateVarHandle(&read_vars, &write_vars);
-
-    FCompute fn;
-    if (ctx.dev_mask() == cpu::kDevMask && fcpu.count(op)) {
-      fn = fcpu[op];
-    } else if (ctx.dev_mask() == gpu::kDevMask && fgpu.count(op)) {
-      fn = fgpu[op];
+    if (sparse) {
+      d->fn_ex = fcpu_ex[op];
+    } else {
+      out_stypes.clear();
     }
-    if (fn) {
-      Engine::Get()->PushAsync(
-        [ctx, attrs, fn, ndinputs, ndoutputs, requested](
-            RunContext rctx,
-            engine::CallbackOnComplete on_complete) {
-          std::vector<TBlob> input_blobs, output_blobs;
-          for (auto& i : ndinputs) {
-            input_blobs.push_back(i.data());
-          }
-          for (auto& i : ndoutputs) {
-            i.CheckAndAlloc();
-            output_blobs.push_back(i.data());
+  }
+  if (ctx.dev_mask() == cpu::kDevMask && fcpu.count(op)) {
+    d->fn = fcpu[op];
+  } else if (ctx.dev_mask() == gpu::kDevMask && fgpu.count(op)) {
+    d->fn = fgpu[op];
+  } else if (createop.count(op)) {
+    d->opr.reset(createop[op](attrs, ctx, in_shapes, in_types));
+  } else if (!d->fn_ex) {
+    LOG(FATAL)
+      << "Operator " << op->name
+      << " cannot be run; requires at least one of"
+      << " FCompute<xpu>, NDArrayFunction, FCreateOperator be registered";
+  }
+  return d;
+}
+
+// the dispatch of a call, taken from the cache when possible
+std::shared_ptr<ImperativeDispatch> GetDispatch(const nnvm::Op* op,
+                                                int num_inputs,
+                                                NDArrayHandle *inputs,
+                                                int num_outputs,
+                                                NDArray** outarray,
+                                                int num_params,
+                                                const char **param_keys,
+                                                const char **param_vals) {
+  static const size_t capacity = dmlc::GetEnv("MXNET_IMPERATIVE_DISPATCH_CACHE", 4096);
+  // never destructed, the cached operators must not outlive the engine
+  static auto* cache = new std::unordered_map<std::string,
+                                              std::shared_ptr<ImperativeDispatch> >();
+  static std::mutex mutex;
+  if (capacity == 0) {
+    return CreateDispatch(op, num_inputs, inputs, num_outputs, outarray,
+                          num_params, param_keys, param_vals);
+  }
+  std::string key;
+  AppendKey(&key, op);
+  AppendKey(&key, num_params);
+  for (int i = 0; i < num_params; ++i) {
+    AppendKey(&key, param_keys[i]);
+    AppendKey(&key, param_vals[i]);
+  }
+  AppendKey(&key, num_inputs);
+  for (int i = 0; i < num_inputs; ++i) {
+    AppendKey(&key, *reinterpret_cast<NDArray*>(inputs[i]));
+  }
+  AppendKey(&key, outarray == nullptr ? -1 : num_outputs);
+  for (int i = 0; outarray != nullptr && i < num_outputs; ++i) {
+    AppendKey(&key, *outarray[i]);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache->find(key);
+    if (it != cache->end()) return it->second;
+  }
+  std::shared_ptr<ImperativeDispatch> d =
+      CreateDispatch(op, num_inputs, inputs, num_outputs, outarray,
+                     num_params, param_keys, param_vals);
+  if (d->opr != nullptr) {
+    d->opr_var = Engine::Get()->NewVariable();
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  if (cache->size() >= capacity) cache->clear();
+  cache->emplace(key, d);
+  return d;
+}
+
+// push the operator to the engine, with outputs already allocated
+void PushOperator(const ImperativeDispatch& d,
+                  const std::vector<NDArray>& ndinputs,
+                  const std::vector<NDArray>& ndoutputs) {
+  const nnvm::Op* op = d.attrs.op;
+  const Context ctx = d.ctx;
+  const std::vector<Resource>& requested = d.requested;
+  const std::vector<uint32_t>& auxidx = d.auxidx;
+  std::vector<engine::VarHandle> read_vars, write_vars;
+  for (const auto& r : requested) {
+    write_vars.push_back(r.var);
+  }
+  if (d.opr_var != nullptr) {
+    write_vars.push_back(d.opr_var);
+  }
+  for (auto& i : ndinputs) {
+    read_vars.push_back(i.var());
+  }
+  for (auto& i : ndoutputs) {
+    write_vars.push_back(i.var());
+  }
+  for (auto & i : auxidx) {
+    write_vars.push_back(ndinputs[i].var());
+  }
+  common::DeduplicateVarHandle(&read_vars, &write_vars);
+
+  if (d.fn_ex) {
+    const nnvm::NodeAttrs& attrs = d.attrs;
+    const FComputeEx& fn = d.fn_ex;
+    Engine::Get()->PushSync(
+      [attrs, fn, ndinputs, ndoutputs, requested](RunContext rctx) {
+        for (auto& i : ndoutputs) {
+          i.CheckAndAlloc();
+        }
+        OpContext opctx{false, rctx,
+                        engine::CallbackOnComplete(),
+                        requested};
+        std::vector<OpReqType> req(ndoutputs.size(), kWriteTo);
+        fn(attrs, opctx, ndinputs, req, ndoutputs);
+      }, ctx, read_vars, write_vars, FnProperty::kNormal,
+      0, PROFILER_MESSAGE(op->name.c_str()));
+  } else if (d.fn) {
+    const nnvm::NodeAttrs& attrs = d.attrs;
+    const FCompute& fn = d.fn;
+    Engine::Get()->PushAsync(
+      [ctx, attrs, fn, ndinputs, ndoutputs, requested](
+          RunContext rctx,
+          engine::CallbackOnComplete on_complete) {
+        std::vector<TBlob> input_blobs, output_blobs;
+        for (auto& i : ndinputs) {
+          input_blobs.push_back(i.data());
+        }
+        for (auto& i : ndoutputs) {
+          i.CheckAndAlloc();
+          output_blobs.push_back(i.data());
+        }
+        OpContext opctx{false, rctx,
+                        engine::CallbackOnComplete(),
+                        requested};
+        std::vector<OpReqType> req(output_blobs.size(), kWriteTo);
+        fn(attrs, opctx, input_blobs, req, output_blobs);
+        if (ctx.dev_mask() == gpu::kDevMask) {
+          rctx.get_stream<gpu>()->Wait();
+        }
+        on_complete();
+      }, ctx, read_vars, write_vars, FnProperty::kNormal,
+      0, PROFILER_MESSAGE(op->name.c_str()));
+  } else {
+    std::shared_ptr<Operator> opr = d.opr;
+    struct Capture {
+      engine::CallbackOnComplete on_complete;
+      std::shared_ptr<Operator> opr;
+    };
+    Engine::Get()->PushAsync(
+      [ctx, opr, auxidx, ndinputs, ndoutputs, requested](
+          RunContext rctx,
+          engine::CallbackOnComplete on_complete) {
+        std::vector<TBlob> input_blobs, aux_blobs, output_blobs;
+        auto atop = auxidx.begin();
+        for (size_t i = 0; i < ndinputs.size(); ++i) {
+          if (atop != auxidx.end() && i == *atop) {
+            aux_blobs.push_back(ndinputs[i].data());
+            ++atop;
+          } else {
+            input_blobs.push_back(ndinputs[i].data());
           }
-          OpContext opctx{false, rctx,
-                          engine::CallbackOnComplete(),
-                          requested};
-          std::vector<OpReqType> req(output_blobs.size(), kWriteTo);
-          fn(attrs, opctx, input_blobs, req, output_blobs);
+        }
+        for (auto& i : ndoutputs) {
+          i.CheckAndAlloc();
+          output_blobs.push_back(i.data());
+        }
+        Capture* capture = new Capture({on_complete, opr});
+        OpContext opctx{false, rctx,
+                        Engine::Get()->CreateCallback(
+                          [](Engine* engine, void *cpt_handle) {
+                              Capture* cpt = static_cast<Capture*>(cpt_handle);
+                              cpt->on_complete();
+                              delete cpt;
+                            }, static_cast<void*>(capture)),
+                        requested};
+        std::vector<OpReqType> req(output_blobs.size(), kWriteTo);
+        opr->Forward(opctx, input_blobs, req, output_blobs, aux_blobs);
+        if (opr->exec_type() != Operator::kAsync) {
           if (ctx.dev_mask() == gpu::kDevMask) {
             rctx.get_stream<gpu>()->Wait();
           }
+          delete capture;
           on_complete();
-        }, ctx, read_vars, write_vars, FnProperty::kNormal,
-        0, PROFILER_MESSAGE(op->name.c_str()));
-    } else if (createop.count(op)) {
-      Operator* opr = createop[op](attrs, ctx, in_shapes, in_types);
-      struct Capture {
-        engine::CallbackOnComplete on_complete;
-        Operator *opr;
-      };
-      Engine::Get()->PushAsync(
-        [ctx, opr, auxidx, ndinputs, ndoutputs, requested](
-            RunContext rctx,
-            engine::CallbackOnComplete on_complete) {
-          std::vector<TBlob> input_blobs, aux_blobs, output_blobs;
-          auto atop = auxidx.begin();
-          for (size_t i = 0; i < ndinputs.size(); ++i) {
-            if (atop != auxidx.end() && i == *atop) {
-              aux_blobs.push_back(ndinputs[i].data());
-              ++atop;
-            } else {
-              input_blobs.push_back(ndinputs[i].data());
-            }
-          }
-          for (auto& i : ndoutputs) {
-            i.CheckAndAlloc();
-            output_blobs.push_back(i.data());
-          }
-          Capture* capture = new Capture({on_complete, opr});
-          OpContext opctx{false, rctx,
-                          Engine::Get()->CreateCallback(
-                            [](Engine* engine, void *cpt_handle) {
-                                Capture* cpt = static_cast<Capture*>(cpt_handle);
-                                cpt->on_complete();
-                                delete cpt->opr;
-                                delete cpt;
-                              }, static_cast<void*>(capture)),
-                          requested};
-          std::vector<OpReqType> req(output_blobs.size(), kWriteTo);
-          opr->Forward(opctx, input_blobs, req, output_blobs, aux_blobs);
-          if (opr->exec_type() != Operator::kAsync) {
-            if (ctx.dev_mask() == gpu::kDevMask) {
-              rctx.get_stream<gpu>()->Wait();
-            }
-            delete opr;
-            delete capture;
-            on_complete();
-          }
-        }, ctx, read_vars, write_vars, FnProperty::kNormal,
-        0, PROFILER_MESSAGE(op->name.c_str()));
-    } else {
-      LOG(FATAL)
-        << "Operator " << op->name
-        << " cannot be run; requires at least one of"
-        << " FCompute<xpu>, NDArrayFunction, FCreateOperator be registered";
+        }
+      }, ctx, read_vars, write_vars, FnProperty::kNormal,
+      0, PROFILER_MESSAGE(op->name.c_str()));
+  }
+}
+
+// whether an array is given to the operator as a dense and contiguous copy
+inline bool NeedsDenseCopy(const NDArray& arr, const ImperativeDispatch& d) {
+  return !arr.is_contiguous() || (!d.fn_ex && arr.storage_type() != kDefaultStorage);
+}
+
+// a dense and contiguous copy of a strided view or of a sparse array
+inline NDArray DenseCopy(const NDArray& arr) {
+  if (arr.storage_type() == kDefaultStorage) return arr.Compact();
+  NDArray ret(arr.shape(), arr.ctx(), true, arr.dtype());
+  CopyFromTo(arr, &ret);
+  return ret;
+}
+
+int MXImperativeInvoke(AtomicSymbolCreator creator,
+                       int num_inputs,
+                       NDArrayHandle *inputs,
+                       int *num_outputs,
+                       NDArrayHandle **outputs,
+                       int num_params,
+                       const char **param_keys,
+                       const char **param_vals) {
+  static auto& ndfunc = nnvm::Op::GetAttr<FNDArrayFunction>("FNDArrayFunction");
+  const nnvm::Op* op = static_cast<nnvm::Op*>(creator);
+  NDArray** outarray = *reinterpret_cast<NDArray***>(outputs);
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+
+  API_BEGIN();
+  std::shared_ptr<ImperativeDispatch> d =
+      GetDispatch(op, num_inputs, inputs, outarray == nullptr ? 0 : *num_outputs,
+                  outarray, num_params, param_keys, param_vals);
+
+  std::vector<NDArray> ndinputs, ndoutputs;
+  ndinputs.reserve(num_inputs);
+  for (int i = 0; i < num_inputs; ++i) {
+    ndinputs.emplace_back(*reinterpret_cast<NDArray*>(inputs[i]));
+  }
+  ndoutputs.reserve(d->num_outputs);
+  if (outarray == nullptr) {
+    *num_outputs = d->num_visible_outputs;
+  } else {
+    for (int i = 0; i < d->num_visible_outputs; ++i) {
+      ndoutputs.emplace_back(std::move(*outarray[i]));
     }
   }
+  ndoutputs.resize(d->num_outputs);
+
+  // operators only take contiguous arrays: strided views are compacted, and the
+  // strided outputs are computed in new arrays and copied into the views.
+  // Sparse arrays are converted the same way when the operator has no FComputeEx
+  // for them. NDArray functions update their outputs, so they get a copy.
+  for (uint32_t i : d->auxidx) {
+    CHECK(ndinputs[i].is_contiguous())
+      << "Operator " << op->name << " cannot update a strided NDArray view";
+    CHECK(!NeedsDenseCopy(ndinputs[i], *d))
+      << "Operator " << op->name << " cannot update a sparse NDArray";
+  }
+  for (NDArray& arr : ndinputs) {
+    if (NeedsDenseCopy(arr, *d)) arr = DenseCopy(arr);
+  }
+  std::vector<std::pair<size_t, NDArray> > converted_outputs;
+  for (size_t i = 0; i < ndoutputs.size(); ++i) {
+    if (!ndoutputs[i].is_none() && NeedsDenseCopy(ndoutputs[i], *d)) {
+      NDArray view = std::move(ndoutputs[i]);
+      ndoutputs[i] = d->ndfunc ? DenseCopy(view) : NDArray();
+      converted_outputs.emplace_back(i, std::move(view));
+    }
+  }
+
+  if (d->ndfunc) {
+    ndfunc[op](d->attrs, ndinputs, &ndoutputs);
+  } else {
+    for (int i = 0; i < d->num_outputs; ++i) {
+      if (ndoutputs[i].is_none() && d->fn_ex && d->out_stypes[i] != kDefaultStorage) {
+        ndoutputs[i] = NDArray(static_cast<NDArrayStorageType>(d->out_stypes[i]),
+                               d->out_shapes[i], d->ctx, d->out_types[i]);
+      } else if (ndoutputs[i].is_none()) {
+        ndoutputs[i] = NDArray(d->out_shapes[i], d->ctx, true, d->out_types[i]);
+      }
+    }
+    // in lazy mode, the operation is only recorded
+    if (!LazyImperative::Get()->Record(d->attrs, d->ctx, ndinputs, ndoutputs)) {
+      PushOperator(*d, ndinputs, ndoutputs);
+    }
+  }
+  for (auto& out : converted_outputs) {
+    CopyFromTo(ndoutputs[out.first], &out.second);
+    ndoutputs[out.first] = std::move(out.second);
+  }
 
   if (outarray == nullptr) {
     ret->ret_handles.clear();
-    for (int i = 0; i < num_visible_outputs; ++i) {
+    for (int i = 0; i < d->num_visible_outputs; ++i) {
       ret->ret_handles.push_back(
         reinterpret_cast<NDArrayHandle>(new NDArray(std::move(ndoutputs[i]))));
     }
@@ -292,3 +540,9 @@ int MXImperativeInvoke(AtomicSymbolCreator creator,
   }
   API_END();
 }
+
+int MXNDArraySetLazyMode(int lazy, int* prev) {
+  API_BEGIN();
+  *prev = LazyImperative::Get()->SetEnabled(lazy != 0);
+  API_END();
+}
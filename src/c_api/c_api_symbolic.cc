@@ -5,6 +5,7 @@
  */
 #include <mxnet/base.h>
 #include <mxnet/c_api.h>
+#include <mxnet/executor.h>
 #include <nnvm/c_api.h>
 #include <nnvm/pass.h>
 #include <nnvm/pass_functions.h>
@@ -529,6 +530,80 @@ int MXSymbolInferType(SymbolHandle sym,
   API_END();
 }
 
+// store parameters in the thread local return buffers.
+void ReturnParams(const std::unordered_map<std::string, NDArray>& params,
+                  MXAPIThreadLocalEntry *ret) {
+  ret->ret_vec_str.clear();
+  ret->ret_vec_charp.clear();
+  ret->ret_handles.clear();
+  for (const auto& kv : params) {
+    ret->ret_vec_str.push_back(kv.first);
+    ret->ret_handles.push_back(new NDArray(kv.second));
+  }
+  for (const auto& name : ret->ret_vec_str) {
+    ret->ret_vec_charp.push_back(name.c_str());
+  }
+}
+
+int MXSymbolOptimizeForInference(SymbolHandle sym,
+                                 mx_uint num_data,
+                                 const char** data_names,
+                                 mx_uint num_params,
+                                 const char** param_names,
+                                 NDArrayHandle* param_handles,
+                                 SymbolHandle* out,
+                                 mx_uint* out_num_params,
+                                 const char*** out_param_names,
+                                 NDArrayHandle** out_param_handles) {
+  nnvm::Symbol *s = new nnvm::Symbol();
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  std::vector<std::string> data(data_names, data_names + num_data);
+  std::unordered_map<std::string, NDArray> params;
+  for (mx_uint i = 0; i < num_params; ++i) {
+    params[param_names[i]] = *static_cast<NDArray*>(param_handles[i]);
+  }
+  *s = Executor::OptimizeForInference(*static_cast<nnvm::Symbol*>(sym), data, &params);
+  ReturnParams(params, ret);
+  *out = s;
+  *out_num_params = static_cast<mx_uint>(params.size());
+  *out_param_names = dmlc::BeginPtr(ret->ret_vec_charp);
+  *out_param_handles = dmlc::BeginPtr(ret->ret_handles);
+  API_END_HANDLE_ERROR(delete s);
+}
+
+int MXSymbolQuantize(SymbolHandle sym,
+                     mx_uint num_calib,
+                     const char** calib_names,
+                     const mx_float* calib_min,
+                     const mx_float* calib_max,
+                     mx_uint num_params,
+                     const char** param_names,
+                     NDArrayHandle* param_handles,
+                     SymbolHandle* out,
+                     mx_uint* out_num_params,
+                     const char*** out_param_names,
+                     NDArrayHandle** out_param_handles) {
+  nnvm::Symbol *s = new nnvm::Symbol();
+  MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+  API_BEGIN();
+  std::unordered_map<std::string, std::pair<float, float> > calib;
+  for (mx_uint i = 0; i < num_calib; ++i) {
+    calib[calib_names[i]] = std::make_pair(calib_min[i], calib_max[i]);
+  }
+  std::unordered_map<std::string, NDArray> params;
+  for (mx_uint i = 0; i < num_params; ++i) {
+    params[param_names[i]] = *static_cast<NDArray*>(param_handles[i]);
+  }
+  *s = Executor::QuantizeForInference(*static_cast<nnvm::Symbol*>(sym), calib, &params);
+  ReturnParams(params, ret);
+  *out = s;
+  *out_num_params = static_cast<mx_uint>(params.size());
+  *out_param_names = dmlc::BeginPtr(ret->ret_vec_charp);
+  *out_param_handles = dmlc::BeginPtr(ret->ret_handles);
+  API_END_HANDLE_ERROR(delete s);
+}
+
 int MXSymbolGrad(SymbolHandle sym, mx_uint num_wrt, const char** wrt, SymbolHandle* out) {
   API_BEGIN();
   LOG(FATAL) << "not implemented";
@@ -146,6 +146,22 @@ int MXPredCreatePartialOut(const char* symbol_json_str,
     }
   }
 
+  // fold BatchNorm and parameter-only subgraphs into new parameters
+  if (dmlc::GetEnv("MXNET_PREDICT_OPTIMIZE", false)) {
+    std::unordered_map<std::string, NDArray> params(arg_params);
+    params.insert(aux_params.begin(), aux_params.end());
+    std::vector<std::string> data_names(input_keys, input_keys + num_input_nodes);
+    sym = Executor::OptimizeForInference(sym, data_names, &params);
+    arg_params.clear();
+    aux_params.clear();
+    for (const auto& name : sym.ListInputNames(Symbol::kReadOnlyArgs)) {
+      if (params.count(name) != 0) arg_params[name] = params.at(name);
+    }
+    for (const auto& name : sym.ListInputNames(Symbol::kAuxiliaryStates)) {
+      if (params.count(name) != 0) aux_params[name] = params.at(name);
+    }
+  }
+
   // shape inference and bind
   std::unordered_map<std::string, TShape> known_shape;
   for (mx_uint i = 0; i < num_input_nodes; ++i) {
@@ -186,18 +202,28 @@ int MXPredCreatePartialOut(const char* symbol_json_str,
 
   Context ctx = Context::Create(static_cast<Context::DeviceType>(dev_type), dev_id);
 
+  // uint8 quantized weights keep their dtype, every other array is float32,
+  // the loaded parameters are cast.
+  auto param_dtype = [](const std::unordered_map<std::string, NDArray>& params,
+                        const std::string& name) {
+    auto it = params.find(name);
+    return it != params.end() && it->second.dtype() == mshadow::kUint8 ?
+        mshadow::kUint8 : mshadow::kFloat32;
+  };
   std::vector<NDArray> arg_arrays, aux_arrays;
   for (size_t i = 0; i < arg_shapes.size(); ++i) {
-    NDArray nd = NDArray(arg_shapes[i], ctx);
-    if (arg_params.count(arg_names[i]) != 0) {
-      CopyFromTo(arg_params[arg_names[i]], &nd);
+    auto it = arg_params.find(arg_names[i]);
+    NDArray nd = NDArray(arg_shapes[i], ctx, false, param_dtype(arg_params, arg_names[i]));
+    if (it != arg_params.end()) {
+      CopyFromTo(it->second, &nd);
     }
     arg_arrays.push_back(nd);
   }
   for (size_t i = 0; i < aux_shapes.size(); ++i) {
-    NDArray nd = NDArray(aux_shapes[i], ctx);
-    if (aux_params.count(aux_names[i]) != 0) {
-      CopyFromTo(aux_params[aux_names[i]], &nd);
+    auto it = aux_params.find(aux_names[i]);
+    NDArray nd = NDArray(aux_shapes[i], ctx, false, param_dtype(aux_params, aux_names[i]));
+    if (it != aux_params.end()) {
+      CopyFromTo(it->second, &nd);
     }
     aux_arrays.push_back(nd);
   }
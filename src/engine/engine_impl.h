@@ -7,6 +7,7 @@
 #define MXNET_ENGINE_ENGINE_IMPL_H_
 
 #include <mxnet/engine.h>
+#include <atomic>
 
 /*! \brief MACRO on whether or not enable debug option*/
 #define ENGINE_DEBUG 0
@@ -28,6 +29,12 @@ struct Var {
   inline T* Cast();
 };  // struct Var
 
+/*! \return a new variable version, unique among all the variables */
+inline size_t NewVarVersion() {
+  static std::atomic<size_t> counter{0};
+  return ++counter;
+}
+
 /*! \brief base class of engine operators, used for type checking */
 struct Opr {
 #if ENGINE_DEBUG
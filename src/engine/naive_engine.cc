@@ -26,6 +26,10 @@ class NaiveEngine final : public Engine {
     /*! \brief operator execution statistics */
     OprExecStat *opr_stat;
   };
+  /*! \brief a variable only holds its version, the operations run in order */
+  struct NaiveVar : public Var {
+    size_t version{NewVarVersion()};
+  };
 
   NaiveEngine() {
   }
@@ -52,8 +56,7 @@ class NaiveEngine final : public Engine {
 
   // new variables
   VarHandle NewVariable() override {
-    size_t v = ++counter_;
-    return reinterpret_cast<VarHandle>(v);
+    return new NaiveVar();
   }
 
   OprHandle NewOperator(AsyncFn fn,
@@ -156,6 +159,9 @@ class NaiveEngine final : public Engine {
     }
     CHECK(this->req_completed_)
         << "NaiveEngine only support synchronize Push so far";
+    for (VarHandle var : mutable_vars) {
+      var->Cast<NaiveVar>()->version = NewVarVersion();
+    }
 #if MXNET_USE_PROFILER
     if (profiling) {
       SetOprEnd(opr->opr_stat);
@@ -166,11 +172,16 @@ class NaiveEngine final : public Engine {
   void DeleteVariable(SyncFn delete_fn, Context exec_ctx, VarHandle var) override {
     this->PushSync(delete_fn, exec_ctx, {}, {var},
                    FnProperty::kNormal, 0, PROFILER_MESSAGE("DeleteVariable"));
+    delete var->Cast<NaiveVar>();
   }
 
   void WaitForVar(VarHandle var) override {
   }
 
+  size_t VarVersion(VarHandle var) override {
+    return var->Cast<NaiveVar>()->version;
+  }
+
   void WaitForAll() override {
   }
 
@@ -187,8 +198,6 @@ class NaiveEngine final : public Engine {
   RunContext ctx_;
   // whether action is completed
   bool req_completed_;
-  // counter
-  std::atomic<size_t> counter_{0};
   /*! \brief whether it is during shutdown phase*/
   std::atomic<bool> shutdown_phase_{false};
   // CPU stream
@@ -9,6 +9,7 @@
 #include <map>
 #include <mutex>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include "./profiler.h"
@@ -101,11 +102,30 @@ OprExecStat *Profiler::AddOprStat(int dev_type, uint32_t dev_id) {
   return opr_stat;
 }
 
+// the name as the contents of a JSON string, node names are chosen by the user
+inline std::string JSONEscape(const std::string& name) {
+  std::string ret;
+  ret.reserve(name.size());
+  for (char c : name) {
+    if (c == '"' || c == '\\') {
+      ret += '\\';
+      ret += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      ret += buf;
+    } else {
+      ret += c;
+    }
+  }
+  return ret;
+}
+
 void Profiler::EmitPid(std::ostream *os, const std::string& name, uint32_t pid) {
   (*os) << "        {\n"
         << "            \"ph\": \"M\",\n"
         << "            \"args\": {\n"
-        << "                \"name\": \"" << name << "\"\n"
+        << "                \"name\": \"" << JSONEscape(name) << "\"\n"
         << "            },\n"
         << "            \"pid\": " << pid << ",\n"
         << "            \"name\": \"process_name\"\n"
@@ -116,7 +136,7 @@ void Profiler::EmitEvent(std::ostream *os, const std::string& name,
                        const std::string& category, const std::string& ph,
                        uint64_t ts, uint32_t pid, uint32_t tid) {
   (*os) << "        {\n"
-        << "            \"name\": \""  << name << "\",\n"
+        << "            \"name\": \""  << JSONEscape(name) << "\",\n"
         << "            \"cat\": " << "\"" << category << "\",\n"
         << "            \"ph\": \""<< ph << "\",\n"
         << "            \"ts\": "  << ts << ",\n"
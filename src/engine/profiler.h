@@ -18,8 +18,8 @@ namespace engine {
  * \brief Operation execution statistics
  */
 struct OprExecStat {
-  /*! \brief operation name */
-  char opr_name[32];
+  /*! \brief operation name, or node and operation name for graph operators */
+  char opr_name[128];
   /*!
    * \brief operation execution start relative timestamp
    *        time unit is microsecond (10^-6 s)
@@ -119,6 +119,7 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
       VersionedVarBlock::Delete(head);
       return true;
     }
+    version_.store(NewVarVersion(), std::memory_order_relaxed);
     // detach pending write
     old_pending_write = pending_write_;
     // search for chains to trigger
@@ -140,6 +140,10 @@ class ThreadedVar final : public Var,
   inline void SetToDelete();
   /*! \return whether this variable is ready to read. */
   inline bool ready_to_read();
+  /*! \return the version, see Engine::VarVersion */
+  inline size_t version() const {
+    return version_.load(std::memory_order_relaxed);
+  }
   /*!
    * \brief Cast a Var pointer to ThreadedVar pointer
    * \param ptr pointer from base.
@@ -183,6 +187,8 @@ class ThreadedVar final : public Var,
    * \brief If true, delete after operation completes.
    */
   bool to_delete_{false};
+  /*! \brief renewed when a write completes */
+  std::atomic<size_t> version_{NewVarVersion()};
   /*! \brief special const on num_pending_reads_ to mark write being triggered */
   static constexpr int kWriteTriggered = -1;
   /*!
@@ -254,6 +260,9 @@ class ThreadedEngine : public Engine {
                  const char* opr_name = nullptr) override;
   void DeleteVariable(SyncFn delete_fn, Context exec_ctx, VarHandle var) override;
   void WaitForVar(VarHandle var) override;
+  size_t VarVersion(VarHandle var) override {
+    return ThreadedVar::CastFromBase(var)->version();
+  }
   void WaitForAll() override;
   void NotifyShutdown() override {
     shutdown_phase_.store(true);
@@ -17,27 +17,44 @@ const OperatorProperty* OpPropGetOpProperty(const NodeAttrs& attrs);
 
 namespace exec {
 
+// the data of an array given to an operator without sparse support
+inline TBlob DenseData(const NDArray& nd) {
+  CHECK_EQ(nd.storage_type(), kDefaultStorage)
+    << "This operator does not support sparse arrays in a graph, "
+    << "convert them with cast_storage before binding";
+  return nd.data();
+}
+
+// the engine versions of the inputs, read when the operator runs
+inline void GetVersions(const std::vector<Engine::VarHandle>& vars,
+                        std::vector<size_t>* versions) {
+  versions->resize(vars.size());
+  for (size_t i = 0; i < vars.size(); ++i) {
+    (*versions)[i] = Engine::Get()->VarVersion(vars[i]);
+  }
+}
+
 // forward executor
 class ForwardOpExecutor : public OpExecutor {
  public:
   void Run(RunContext rctx) override {
     op_ctx.run_ctx = rctx;
+    GetVersions(in_vars_, &op_ctx.in_versions);
     op_->Forward(op_ctx, in_data_, req, out_data_, aux_data_);
   }
 
   void Setup() override {
-    in_data_.clear(); aux_data_.clear();
+    in_data_.clear(); aux_data_.clear(); in_vars_.clear();
     for (size_t i = 0; i < in_array.size(); ++i) {
       if (!std::binary_search(aux_index_.begin(), aux_index_.end(), i)) {
-        in_data_.push_back(in_array[i].data());
+        in_data_.push_back(DenseData(in_array[i]));
+        in_vars_.push_back(in_array[i].var());
       } else {
-        aux_data_.push_back(in_array[i].data());
+        aux_data_.push_back(DenseData(in_array[i]));
       }
     }
     out_data_.resize(out_array.size());
-    std::transform(out_array.begin(), out_array.end(), out_data_.begin(), [](const NDArray& nd) {
-        return nd.data();
-      });
+    std::transform(out_array.begin(), out_array.end(), out_data_.begin(), DenseData);
   }
   Operator::ExecType exec_type() const override {
     return op_->exec_type();
@@ -52,6 +69,7 @@ class ForwardOpExecutor : public OpExecutor {
   std::shared_ptr<Operator> op_;
   std::vector<uint32_t> aux_index_;
   std::vector<TBlob> in_data_, out_data_, aux_data_;
+  std::vector<Engine::VarHandle> in_vars_;
 };
 
 // backward executor
@@ -68,16 +86,13 @@ class BackwardOpExecutor : public OpExecutor {
     for (size_t i = 0; i < in_array.size(); ++i) {
       if (!std::binary_search(aux_index_.begin(), aux_index_.end(), i)) {
         CHECK_GT(arg_data_ptr_.size(), arg_top);
-        *arg_data_ptr_[arg_top++] = in_array[i].data();
+        *arg_data_ptr_[arg_top++] = DenseData(in_array[i]);
       } else {
-        aux_data_.at(aux_top++) = in_array[i].data();
+        aux_data_.at(aux_top++) = DenseData(in_array[i]);
       }
     }
     CHECK_EQ(out_array.size(), in_grad_.size());
-    std::transform(out_array.begin(), out_array.end(),
-                   in_grad_.begin(), [](const NDArray& nd) {
-        return nd.data();
-      });
+    std::transform(out_array.begin(), out_array.end(), in_grad_.begin(), DenseData);
   }
   Operator::ExecType exec_type() const override {
     return op_->exec_type();
@@ -120,9 +135,36 @@ class FComputeExecutor : public OpExecutor {
  public:
   void Run(RunContext rctx) override {
     op_ctx.run_ctx = rctx;
-    fcompute_(attrs_, op_ctx, in_data_, req, out_data_);
+    GetVersions(in_vars_, &op_ctx.in_versions);
+    if (use_ex_) {
+      fcompute_ex_(attrs_, op_ctx, in_array, req, out_array);
+    } else {
+      fcompute_(attrs_, op_ctx, in_data_, req, out_data_);
+    }
   }
   void Setup() override {
+    // sparse arrays bound to the graph are given to FComputeEx
+    static auto& inferstorage = nnvm::Op::GetAttr<FInferStorageType>("FInferStorageType");
+    std::vector<int> in_stypes, out_stypes;
+    bool sparse = false;
+    for (const NDArray& nd : in_array) {
+      in_stypes.push_back(nd.storage_type());
+      sparse = sparse || nd.storage_type() != kDefaultStorage;
+    }
+    for (const NDArray& nd : out_array) {
+      out_stypes.push_back(nd.storage_type());
+      sparse = sparse || nd.storage_type() != kDefaultStorage;
+    }
+    use_ex_ = sparse;
+    in_vars_.resize(in_array.size());
+    for (size_t i = 0; i < in_array.size(); ++i) in_vars_[i] = in_array[i].var();
+    if (sparse) {
+      CHECK(fcompute_ex_ != nullptr && inferstorage.count(attrs_.op) &&
+            inferstorage[attrs_.op](attrs_, &in_stypes, &out_stypes))
+        << "Operator " << attrs_.op->name << " does not support the storage types "
+        << "of its arrays in a graph, convert them with cast_storage before binding";
+      return;
+    }
     in_data_.resize(in_array.size());
     out_data_.resize(out_array.size());
     auto get_blob =  [](const NDArray& nd) {
@@ -134,8 +176,13 @@ class FComputeExecutor : public OpExecutor {
   Operator::ExecType exec_type() const override {
     return Operator::kSync;
   }
-  explicit FComputeExecutor(FCompute fcompute, const NodeAttrs& attrs)
-      : fcompute_(fcompute), attrs_(attrs) {
+  explicit FComputeExecutor(FCompute fcompute, FComputeEx fcompute_ex, const NodeAttrs& attrs)
+      : fcompute_(fcompute), fcompute_ex_(fcompute_ex), attrs_(attrs) {
+  }
+
+  static FComputeEx GetFComputeEx(const Op* op, Context ctx) {
+    static auto& fcompute_ex_cpu = nnvm::Op::GetAttr<FComputeEx>("FComputeEx<cpu>");
+    return ctx.dev_mask() == cpu::kDevMask ? fcompute_ex_cpu.get(op, nullptr) : nullptr;
   }
 
   static FCompute GetFCompute(const Op* op, Context ctx) {
@@ -153,8 +200,11 @@ class FComputeExecutor : public OpExecutor {
 
  private:
   FCompute fcompute_;
+  FComputeEx fcompute_ex_;
+  bool use_ex_{false};
   NodeAttrs attrs_;
   std::vector<TBlob> in_data_, out_data_;
+  std::vector<Engine::VarHandle> in_vars_;
 };
 
 // pass to attach operator executors
@@ -204,7 +254,9 @@ Graph AttachOpExecs(Graph g) {
           mxnet::op::OpPropGetOpProperty(inode.source->attrs),
           mutate_index);
     } else if (fcompute != nullptr) {
-      ret[i] = std::make_shared<FComputeExecutor>(fcompute, inode.source->attrs);
+      ret[i] = std::make_shared<FComputeExecutor>(
+          fcompute, FComputeExecutor::GetFComputeEx(inode.source->op(), vctx[i]),
+          inode.source->attrs);
     } else {
       LOG(INFO) << "FCompute not registered " << inode.source->op()->name;
     }
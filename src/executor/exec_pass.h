@@ -10,8 +10,12 @@
 #include <mxnet/ndarray.h>
 #include <mxnet/operator.h>
 #include <nnvm/graph.h>
+#include <utility>
 #include <vector>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace mxnet {
 namespace exec {
@@ -101,6 +105,114 @@ Graph AttachOpResources(Graph g);
  */
 Graph DetectInplaceAddTo(Graph g);
 
+/*!
+ * \brief Fuse chains and DAGs of elementwise operators into _FusedElemwise nodes.
+ *
+ * A node joins a group when all consumers of its output are in that group,
+ * so only the sink of each group is materialized. The fused node evaluates
+ * the composed expression in one pass over memory, and its gradient is a
+ * single fused backward node that recomputes the intermediates in registers.
+ * A _mul_scalar or _div_scalar that is the only consumer of a batch_dot is
+ * first folded into the alpha of the batch_dot.
+ *
+ * Must run on the forward graph before the gradient is taken.
+ * Variable nodes are shared with the input graph so the inputs keep their order.
+ *
+ * \param g input forward graph.
+ * \return graph with the fusable groups replaced.
+ */
+Graph FuseElemwise(Graph g);
+
+/*!
+ * \brief Remove the Dropout, identity and BlockGrad nodes of a forward graph
+ *  that only runs for inference. The inputs of the graph are kept, in the
+ *  same order, so it can be bound to the same arrays.
+ *
+ * \param g input forward graph.
+ * \return graph without the nodes that are no-ops at inference.
+ */
+Graph RemoveInferenceIdentity(const Graph& g);
+
+/*!
+ * \brief Optimize a forward graph for inference.
+ *
+ *  - Dropout, identity and BlockGrad nodes are removed.
+ *  - BatchNorm following a Convolution or FullyConnected is folded into its
+ *    weight and bias, using the moving statistics.
+ *  - Subgraphs that only depend on parameters are evaluated once on CPU and
+ *    replaced by new parameters.
+ *
+ * \param g input forward graph.
+ * \param data_names names of the inputs that change between calls.
+ *  Every other input that has a value in params is treated as a constant.
+ * \param params values of the parameters. Updated to hold exactly the
+ *  parameters referenced by the returned graph.
+ * \return the optimized graph.
+ */
+Graph OptimizeInference(Graph g,
+                        const std::unordered_set<std::string>& data_names,
+                        std::unordered_map<std::string, NDArray>* params);
+
+/*!
+ * \brief Quantize the 2D Convolution and FullyConnected layers of an
+ *  inference graph to 8 bits. The data of each layer is quantized with its
+ *  calibrated range, the weight with its own range, and the layer runs with
+ *  int32 accumulation and float32 output. Layers whose data has no calibrated
+ *  range, or whose weight is not a float32 parameter, are kept.
+ *
+ * \param g input forward graph.
+ * \param calib calibrated (min, max) of the data entries, named as in the
+ *  executor monitor.
+ * \param params values of the parameters. Updated to hold exactly the
+ *  parameters referenced by the returned graph.
+ * \return the quantized graph.
+ */
+Graph QuantizeGraph(Graph g,
+                    const std::unordered_map<std::string, std::pair<float, float> >& calib,
+                    std::unordered_map<std::string, NDArray>* params);
+
+/*!
+ * \brief Run chains of 2D Convolution, Pooling, BatchNorm and elementwise
+ *  operators in the blocked NCHWc layout, converting the data only at the
+ *  boundaries of the chains. The new operators are forward only and CPU only.
+ *
+ * \param g forward graph, need to contain "shape" and "dtype" attributes.
+ * \return the converted graph, g itself if no convolution can be converted.
+ */
+Graph ConvertLayoutNCHWc(Graph g);
+
+/*!
+ * \brief Plan which forward nodes to recompute during backward (mirror),
+ *  so that the forward activations kept for backward fit in a memory budget.
+ *
+ *  An activation is kept while backward reads it, or while the recomputation
+ *  of a mirrored node reads it. Mirroring a node whose inputs are not kept
+ *  otherwise only saves memory together with its producers, so chains of
+ *  producers are mirrored with it. The plan greedily picks the fewest
+ *  estimated extra FLOPs per byte saved. Nodes that produce graph outputs,
+ *  use random resources or mutate their inputs are never mirrored.
+ *
+ * \param g forward graph, need to contain "shape" and "dtype" attributes.
+ * \param backward_inputs per entry flag of the indexed graph, true for the
+ *  entries read by the backward graph when nothing is mirrored.
+ * \param budget_bytes memory budget of the kept forward activations.
+ * \param planned_bytes if not null, set to the bytes kept with the plan.
+ * \return per node flag of the indexed graph, 1 if the node should be mirrored.
+ */
+std::vector<int> PlanMirror(const Graph& g, const std::vector<bool>& backward_inputs,
+                            size_t budget_bytes, size_t* planned_bytes);
+
+/*!
+ * \brief Rough estimate of the floating point operations of one node.
+ * \param attrs attributes of the node.
+ * \param in_shapes shapes of the inputs.
+ * \param out_shapes shapes of the outputs.
+ * \return estimated number of floating point operations.
+ */
+uint64_t EstimateFLOPs(const nnvm::NodeAttrs& attrs,
+                       const std::vector<TShape>& in_shapes,
+                       const std::vector<TShape>& out_shapes);
+
 }  // namespace exec
 }  // namespace mxnet
 
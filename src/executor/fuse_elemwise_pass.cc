@@ -0,0 +1,257 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file fuse_elemwise_pass.cc
+ * \brief Fuse chains and DAGs of elementwise operators into single nodes.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <nnvm/graph.h>
+#include <nnvm/graph_attr_types.h>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./exec_pass.h"
+#include "../operator/tensor/elemwise_fused_op.h"
+#include "../operator/tensor/matrix_op-inl.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+using nnvm::NodePtr;
+using nnvm::NodeEntry;
+using op::fused::FusedInstr;
+
+// build the fused node that replaces the group whose sink is root.
+NodePtr CreateFusedNode(const nnvm::IndexedGraph& idx,
+                        const std::vector<int>& group,
+                        const std::vector<int>& opcode,
+                        const std::vector<NodePtr>& new_nodes,
+                        uint32_t root) {
+  const int gid = group[root];
+  // Order the external inputs the same way a DFS over the original graph
+  // would reach them, so that the list of graph inputs keeps its order.
+  std::vector<bool> visited(root + 1, false);
+  std::unordered_map<uint32_t, int> ext_reg;
+  std::vector<nnvm::IndexedGraph::NodeEntry> externals;
+  std::function<void(uint32_t)> visit = [&](uint32_t nid) {
+    if (visited[nid]) return;
+    visited[nid] = true;
+    for (const auto& e : idx[nid].inputs) {
+      if (group[e.node_id] == gid) {
+        visit(e.node_id);
+      } else if (ext_reg.count(idx.entry_id(e)) == 0) {
+        ext_reg[idx.entry_id(e)] = static_cast<int>(externals.size());
+        externals.push_back(e);
+      }
+    }
+  };
+  visit(root);
+
+  const int num_inputs = static_cast<int>(externals.size());
+  std::unordered_map<uint32_t, int> member_reg;
+  std::vector<FusedInstr> instrs;
+  for (uint32_t nid = 0; nid <= root; ++nid) {
+    if (group[nid] != gid) continue;
+    const auto& inode = idx[nid];
+    auto reg_of = [&](const nnvm::IndexedGraph::NodeEntry& e) {
+      auto it = member_reg.find(e.node_id);
+      return it != member_reg.end() ? it->second : ext_reg.at(idx.entry_id(e));
+    };
+    FusedInstr instr;
+    instr.opcode = opcode[nid];
+    instr.lhs = reg_of(inode.inputs[0]);
+    instr.rhs = -1;
+    instr.scalar = 0.0;
+    if (op::fused::NumOperands(instr.opcode) == 2) {
+      CHECK_EQ(inode.inputs.size(), 2U);
+      instr.rhs = reg_of(inode.inputs[1]);
+    }
+    if (op::fused::HasScalar(instr.opcode)) {
+      instr.scalar = std::stod(inode.source->attrs.dict.at("scalar"));
+    }
+    member_reg[nid] = num_inputs + static_cast<int>(instrs.size());
+    instrs.push_back(instr);
+  }
+
+  NodePtr fused = nnvm::Node::Create();
+  fused->attrs.op = nnvm::Op::Get("_FusedElemwise");
+  fused->attrs.name = idx[root].source->attrs.name;
+  fused->attrs.dict["num_inputs"] = std::to_string(num_inputs);
+  fused->attrs.dict["program"] = op::fused::SerializeProgram(instrs);
+  fused->op()->attr_parser(&(fused->attrs));
+  for (const auto& e : externals) {
+    fused->inputs.emplace_back(NodeEntry{new_nodes[e.node_id], e.index, e.version});
+  }
+  return fused;
+}
+
+// fold x * s and x / s into the alpha of the batch_dot x when it has no other use
+Graph FoldBatchDotScale(Graph g) {
+  static const nnvm::Op* batch_dot = nnvm::Op::Get("batch_dot");
+  const auto& idx = g.indexed_graph();
+  const uint32_t num_nodes = idx.num_nodes();
+  std::vector<NodePtr> nodes;
+  nodes.reserve(num_nodes);
+  nnvm::DFSVisit(g.outputs, [&nodes](const NodePtr& n) {
+      nodes.push_back(n);
+    });
+  CHECK_EQ(nodes.size(), num_nodes);
+  std::vector<int> uses(num_nodes, 0);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (const auto& e : idx[nid].inputs) ++uses[e.node_id];
+    for (uint32_t c : idx[nid].control_deps) ++uses[c];
+  }
+  for (const auto& e : idx.outputs()) ++uses[e.node_id];
+
+  std::vector<NodePtr> new_nodes(num_nodes);
+  size_t num_folded = 0;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) {
+      new_nodes[nid] = nodes[nid];
+      continue;
+    }
+    const std::string& name = inode.source->op()->name;
+    if ((name == "_mul_scalar" || name == "_div_scalar") && inode.control_deps.empty()) {
+      const uint32_t src = inode.inputs[0].node_id;
+      const nnvm::Node* dot = idx[src].source;
+      if (!dot->is_variable() && dot->op() == batch_dot && uses[src] == 1 &&
+          dot->control_deps.empty()) {
+        const double scalar = std::stod(inode.source->attrs.dict.at("scalar"));
+        const double alpha = nnvm::get<op::BatchDotParam>(dot->attrs.parsed).alpha;
+        std::ostringstream os;
+        os.precision(9);
+        os << (name == "_mul_scalar" ? alpha * scalar : alpha / scalar);
+        // the copy of the batch_dot has no other consumer, it takes the place of the scale
+        NodePtr n = new_nodes[src];
+        n->attrs.name = inode.source->attrs.name;
+        n->attrs.dict["alpha"] = os.str();
+        n->op()->attr_parser(&(n->attrs));
+        new_nodes[nid] = n;
+        ++num_folded;
+        continue;
+      }
+    }
+    NodePtr n = nnvm::Node::Create();
+    n->attrs = inode.source->attrs;
+    for (const auto& e : inode.inputs) {
+      n->inputs.emplace_back(NodeEntry{new_nodes[e.node_id], e.index, e.version});
+    }
+    for (uint32_t c : inode.control_deps) {
+      n->control_deps.push_back(new_nodes[c]);
+    }
+    new_nodes[nid] = n;
+  }
+  if (num_folded == 0) return g;
+
+  Graph ret;
+  for (const auto& e : idx.outputs()) {
+    ret.outputs.emplace_back(NodeEntry{new_nodes[e.node_id], e.index, e.version});
+  }
+  return ret;
+}
+}  // namespace
+
+Graph FuseElemwise(Graph g) {
+  g = FoldBatchDotScale(g);
+  const auto& idx = g.indexed_graph();
+  const uint32_t num_nodes = idx.num_nodes();
+  // the indexed graph is built with the same DFS order.
+  std::vector<NodePtr> nodes;
+  nodes.reserve(num_nodes);
+  nnvm::DFSVisit(g.outputs, [&nodes](const NodePtr& n) {
+      nodes.push_back(n);
+    });
+  CHECK_EQ(nodes.size(), num_nodes);
+
+  std::vector<int> opcode(num_nodes, -1);
+  std::vector<std::vector<uint32_t> > consumers(num_nodes);
+  // pinned nodes must keep their output materialized.
+  std::vector<bool> pinned(num_nodes, false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    for (const auto& e : inode.inputs) {
+      consumers[e.node_id].push_back(nid);
+    }
+    for (uint32_t c : inode.control_deps) {
+      pinned[c] = true;
+    }
+    if (inode.source->is_variable() || inode.control_deps.size() != 0) continue;
+    if (inode.source->num_outputs() != 1) continue;
+    opcode[nid] = op::fused::GetOpCode(inode.source->op()->name,
+                                       inode.source->attrs.dict);
+  }
+  for (const auto& e : idx.outputs()) {
+    pinned[e.node_id] = true;
+  }
+
+  // Assign groups in reverse topological order: a node joins the group of its
+  // consumers when all of them belong to the same group, which guarantees the
+  // group has a single sink and that fusing it cannot create a cycle.
+  std::vector<int> group(num_nodes, -1);
+  std::vector<uint32_t> group_root;
+  std::vector<int> group_size;
+  for (uint32_t i = num_nodes; i != 0; --i) {
+    const uint32_t nid = i - 1;
+    if (opcode[nid] < 0) continue;
+    int gid = -1;
+    if (!pinned[nid] && consumers[nid].size() != 0) {
+      gid = group[consumers[nid][0]];
+      for (uint32_t c : consumers[nid]) {
+        if (group[c] != gid) {
+          gid = -1; break;
+        }
+      }
+      if (gid >= 0 && group_size[gid] >= op::fused::kMaxFusedInstr) gid = -1;
+    }
+    if (gid < 0) {
+      gid = static_cast<int>(group_root.size());
+      group_root.push_back(nid);
+      group_size.push_back(0);
+    }
+    group[nid] = gid;
+    ++group_size[gid];
+  }
+
+  // rebuild the graph, keeping variable nodes so that the inputs are shared.
+  std::vector<NodePtr> new_nodes(num_nodes);
+  size_t num_fused = 0;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) {
+      new_nodes[nid] = nodes[nid];
+      continue;
+    }
+    const int gid = group[nid];
+    if (gid >= 0 && group_size[gid] > 1) {
+      if (group_root[gid] == nid) {
+        new_nodes[nid] = CreateFusedNode(idx, group, opcode, new_nodes, nid);
+        ++num_fused;
+      }
+      continue;
+    }
+    NodePtr n = nnvm::Node::Create();
+    n->attrs = inode.source->attrs;
+    for (const auto& e : inode.inputs) {
+      n->inputs.emplace_back(NodeEntry{new_nodes[e.node_id], e.index, e.version});
+    }
+    for (uint32_t c : inode.control_deps) {
+      n->control_deps.push_back(new_nodes[c]);
+    }
+    new_nodes[nid] = n;
+  }
+  if (num_fused == 0) return g;
+
+  Graph ret;
+  for (const auto& e : idx.outputs()) {
+    ret.outputs.emplace_back(NodeEntry{new_nodes[e.node_id], e.index, e.version});
+  }
+  return ret;
+}
+
+}  // namespace exec
+}  // namespace mxnet
@@ -0,0 +1,58 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file graph_cost.cc
+ * \brief Rough cost model of the operators in a graph.
+ */
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "./exec_pass.h"
+#include "../operator/convolution-inl.h"
+#include "../operator/deconvolution-inl.h"
+#include "../operator/pooling-inl.h"
+
+namespace mxnet {
+namespace exec {
+
+uint64_t EstimateFLOPs(const nnvm::NodeAttrs& attrs,
+                       const std::vector<TShape>& in_shapes,
+                       const std::vector<TShape>& out_shapes) {
+  static const nnvm::Op* conv_op = nnvm::Op::Get("Convolution");
+  static const nnvm::Op* deconv_op = nnvm::Op::Get("Deconvolution");
+  static const nnvm::Op* fc_op = nnvm::Op::Get("FullyConnected");
+  static const nnvm::Op* pool_op = nnvm::Op::Get("Pooling");
+  static const nnvm::Op* dot_op = nnvm::Op::Get("dot");
+  static const nnvm::Op* batch_dot_op = nnvm::Op::Get("batch_dot");
+  if (attrs.op == nullptr || out_shapes.size() == 0) return 0;
+  const uint64_t out_size = out_shapes[0].Size();
+  const TShape& data = in_shapes.size() != 0 ? in_shapes[0] : TShape();
+  if (data.ndim() == 0) return out_size;
+  if (attrs.op == conv_op) {
+    op::ConvolutionParam param;
+    param.InitAllowUnknown(attrs.dict);
+    // one multiply-add per output element, input channel in group and kernel tap
+    return 2 * out_size * (data[1] / param.num_group) * param.kernel.Size();
+  } else if (attrs.op == deconv_op) {
+    op::DeconvolutionParam param;
+    param.InitAllowUnknown(attrs.dict);
+    return 2 * data.Size() * (param.num_filter / param.num_group) * param.kernel.Size();
+  } else if (attrs.op == fc_op) {
+    return 2 * out_size * (data.Size() / data[0]);
+  } else if (attrs.op == dot_op || attrs.op == batch_dot_op) {
+    // the reduced dimension is the one of lhs that does not appear in the output
+    uint64_t k = data.Size() * in_shapes[1].Size() / std::max<uint64_t>(out_size, 1);
+    if (attrs.op == batch_dot_op) k /= data[0];
+    k = static_cast<uint64_t>(std::sqrt(static_cast<double>(k)));
+    return 2 * out_size * std::max<uint64_t>(k, 1);
+  } else if (attrs.op == pool_op) {
+    op::PoolingParam param;
+    param.InitAllowUnknown(attrs.dict);
+    return param.global_pool ? data.Size() : out_size * param.kernel.Size();
+  }
+  // elementwise and data movement ops touch every element about once.
+  return std::max<uint64_t>(out_size, data.Size());
+}
+
+}  // namespace exec
+}  // namespace mxnet
@@ -8,9 +8,12 @@
 #include <nnvm/pass_functions.h>
 #include <vector>
 #include <algorithm>
+#include <chrono>
+#include <unordered_set>
 
 #include "./exec_pass.h"
 #include "./graph_executor.h"
+#include "./tensor_stats.h"
 #include "../engine/profiler.h"
 
 namespace mxnet {
@@ -21,9 +24,16 @@ GraphExecutor::~GraphExecutor() {
       Engine::Get()->DeleteOperator(n.cached_opr);
     }
   }
+  if (monitor_var_ != nullptr) {
+    // pending statistics write to this executor.
+    Engine::Get()->WaitForVar(monitor_var_);
+    Engine::Get()->DeleteVariable([](RunContext ctx) {}, Context::CPU(), monitor_var_);
+  }
 }
 
 void GraphExecutor::Forward(bool is_train) {
+  BeginMonitorIter();
+  CompactStridedArgs();
   RunOps(is_train, 0, num_forward_nodes_);
 }
 
@@ -32,10 +42,20 @@ void GraphExecutor::PartialForward(bool is_train, int step, int *step_left) {
   if (sstep >= num_forward_nodes_) {
     *step_left = 0; return;
   }
+  if (sstep == 0) {
+    BeginMonitorIter();
+    CompactStridedArgs();
+  }
   RunOps(is_train, sstep, sstep + 1);
   *step_left = static_cast<int>(num_forward_nodes_ - sstep - 1);
 }
 
+void GraphExecutor::CompactStridedArgs() {
+  for (auto& kv : strided_args_) {
+    CopyFromTo(kv.first, &kv.second);
+  }
+}
+
 void GraphExecutor::Backward(const std::vector<NDArray>& head_grads) {
   const auto& idx = graph_.indexed_graph();
   if (num_forward_inputs_ != idx.input_nodes().size()) {
@@ -49,6 +69,9 @@ void GraphExecutor::Backward(const std::vector<NDArray>& head_grads) {
     }
   }
   RunOps(true, num_forward_nodes_, idx.num_nodes());
+  if (grad_ready_callback_) {
+    for (size_t j : grad_ready_passed_) PushGradientReady(j);
+  }
 }
 
 void GraphExecutor::Print(std::ostream &os) const {  // NOLINT(*)
@@ -58,6 +81,10 @@ void GraphExecutor::Print(std::ostream &os) const {  // NOLINT(*)
   size_t total_bytes = graph_.GetAttr<size_t>("storage_allocated_bytes");
   os << "Total " << (total_bytes >> 20UL) <<" MB allocated\n";
   os << "Total " << 11 << " TempSpace resource requested\n";
+  if (mirror_budget_ != 0) {
+    os << "Total " << (mirror_planned_bytes_ >> 20UL) << " MB of activations kept for backward"
+       << " with a mirror budget of " << (mirror_budget_ >> 20UL) << " MB\n";
+  }
 }
 
 void GraphExecutor::SetMonitorCallback(const MonitorCallback& callback) {
@@ -65,6 +92,162 @@ void GraphExecutor::SetMonitorCallback(const MonitorCallback& callback) {
   monitor_callback_ = callback;
 }
 
+void GraphExecutor::SetGradientReadyCallback(const GradientReadyCallback& callback) {
+  CHECK(callback) << "invalid callback";
+  grad_ready_callback_ = callback;
+  const auto& idx = graph_.indexed_graph();
+  grad_ready_nodes_.assign(idx.num_nodes(), std::vector<size_t>());
+  grad_ready_passed_.clear();
+  for (size_t j = num_forward_outputs_; j < idx.outputs().size(); ++j) {
+    const uint32_t nid = idx.outputs()[j].node_id;
+    // a forward node or a head gradient would call back in Forward, or never
+    if (nid < num_forward_nodes_ || idx[nid].source->is_variable()) {
+      grad_ready_passed_.push_back(j - num_forward_outputs_);
+    } else {
+      grad_ready_nodes_[nid].push_back(j - num_forward_outputs_);
+    }
+  }
+}
+
+void GraphExecutor::PushGradientReady(size_t j) {
+  const NDArray& grad = grad_store_[j].second;
+  GradientReadyCallback callback = grad_ready_callback_;
+  const int index = grad_arg_index_[j];
+  // only reads the gradient, so it runs once every pending write has finished.
+  Engine::Get()->PushSync([callback, index, grad](RunContext ctx) {
+      callback(index, reinterpret_cast<void*>(new NDArray(grad)));
+    }, Context::CPU(), {grad.var()}, {}, FnProperty::kNormal, 0, "GradientReady");
+}
+
+void GraphExecutor::SetMonitorStats(int stat_mask, int interval) {
+  CHECK_GT(interval, 0) << "monitor interval must be positive";
+  CHECK_EQ(stat_mask & ~((kMonitorMeanAbs << 1) - 1), 0)
+      << "unknown monitor statistics in mask " << stat_mask;
+  static const auto& flist_outputs =
+      nnvm::Op::GetAttr<nnvm::FListOutputNames>("FListOutputNames");
+  monitor_stat_mask_ = stat_mask;
+  monitor_interval_ = interval;
+  monitor_iter_ = 0;
+  monitor_active_ = false;
+  if (monitor_var_ == nullptr) monitor_var_ = Engine::Get()->NewVariable();
+  const auto& idx = graph_.indexed_graph();
+  monitor_names_.assign(idx.num_node_entries(), std::string());
+  monitor_copies_.assign(idx.num_node_entries(), NDArray());
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& node = idx[nid].source;
+    if (node->is_variable()) continue;
+    std::vector<std::string> output_names;
+    if (flist_outputs.count(node->op())) {
+      output_names = flist_outputs[node->op()](node->attrs);
+    }
+    for (uint32_t i = 0; i < node->num_outputs(); ++i) {
+      monitor_names_[idx.entry_id(nid, i)] = node->attrs.name + "_" +
+          (i < output_names.size() ? output_names[i] : std::to_string(i));
+    }
+  }
+}
+
+void GraphExecutor::GetMonitorStats(std::vector<uint32_t>* iterations,
+                                    std::vector<std::string>* names,
+                                    std::vector<float>* values) {
+  iterations->clear();
+  names->clear();
+  values->clear();
+  if (monitor_var_ == nullptr) return;
+  Engine::Get()->WaitForVar(monitor_var_);
+  iterations->swap(monitor_rec_iter_);
+  values->swap(monitor_rec_values_);
+  for (uint32_t eid : monitor_rec_entry_) {
+    names->push_back(monitor_names_[eid]);
+  }
+  monitor_rec_entry_.clear();
+}
+
+void GraphExecutor::BeginMonitorIter() {
+  if (monitor_stat_mask_ == 0) return;
+  monitor_active_ = monitor_iter_ % monitor_interval_ == 0;
+  ++monitor_iter_;
+}
+
+void GraphExecutor::PushMonitorStats(uint32_t nid) {
+  const auto& idx = graph_.indexed_graph();
+  const int stat_mask = monitor_stat_mask_;
+  const uint32_t iter = monitor_iter_ - 1;
+  const auto& out_array = op_nodes_[nid].exec->out_array;
+  const auto& req = op_nodes_[nid].exec->req;
+  for (uint32_t i = 0; i < out_array.size(); ++i) {
+    // outputs that are not written hold stale or unallocated data
+    if (req[i] == kNullOp) continue;
+    NDArray arr = out_array[i];
+    const uint32_t eid = idx.entry_id(nid, i);
+    if (arr.ctx().dev_mask() != cpu::kDevMask) {
+      NDArray& cpy = monitor_copies_[eid];
+      if (cpy.is_none() || cpy.shape() != arr.shape() || cpy.dtype() != arr.dtype()) {
+        cpy = NDArray(arr.shape(), Context::CPU(), false, arr.dtype());
+      }
+      CopyFromTo(arr, &cpy);
+      arr = cpy;
+    }
+    Engine::Get()->PushSync([this, arr, stat_mask, iter, eid](RunContext ctx) {
+        const TBlob blob = arr.data();
+        const size_t offset = monitor_rec_values_.size();
+        monitor_rec_values_.resize(offset + NumMonitorStats(stat_mask));
+        MSHADOW_TYPE_SWITCH(blob.type_flag_, DType, {
+          TensorStatsCPU(blob.dptr<DType>(), blob.Size(), stat_mask,
+                         monitor_rec_values_.data() + offset);
+        });
+        monitor_rec_iter_.push_back(iter);
+        monitor_rec_entry_.push_back(eid);
+      }, Context::CPU(), {arr.var()}, {monitor_var_},
+      FnProperty::kNormal, 0, "MonitorStats");
+  }
+}
+
+void GraphExecutor::SetNodeProfiling(bool enable) {
+  node_profiling_ = enable;
+}
+
+void GraphExecutor::GetNodeProfile(bool reset, std::vector<NodeProfile>* profile) {
+  const auto& idx = graph_.indexed_graph();
+  const auto& vshape = graph_.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& vdtype = graph_.GetAttr<nnvm::DTypeVector>("dtype");
+  // the cached operators update the timing while they run
+  Engine::Get()->WaitForAll();
+  profile->clear();
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable() || op_nodes_[nid].skip_exec_node) continue;
+    NodeProfile p;
+    p.name = inode.source->attrs.name;
+    p.op = inode.source->op()->name;
+    p.in_bytes = p.out_bytes = 0;
+    p.num_inplace = 0;
+    for (const auto& e : inode.inputs) {
+      const uint32_t eid = idx.entry_id(e);
+      p.in_shapes.push_back(vshape[eid]);
+      p.in_bytes += vshape[eid].Size() * mshadow::mshadow_sizeof(vdtype[eid]);
+    }
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      p.out_shapes.push_back(vshape[eid]);
+      p.out_bytes += vshape[eid].Size() * mshadow::mshadow_sizeof(vdtype[eid]);
+      if (op_nodes_[nid].exec->req[i] == kWriteInplace) ++p.num_inplace;
+    }
+    p.flops = EstimateFLOPs(inode.source->attrs, p.in_shapes, p.out_shapes);
+    const NodeTiming& t = node_timing_[nid];
+    p.count = t.count;
+    p.total_us = t.total_us;
+    p.min_us = t.min_us;
+    p.max_us = t.max_us;
+    profile->push_back(std::move(p));
+    if (reset) node_timing_[nid] = NodeTiming();
+  }
+  std::stable_sort(profile->begin(), profile->end(),
+                   [](const NodeProfile& a, const NodeProfile& b) {
+                     return a.total_us > b.total_us;
+                   });
+}
+
 const std::vector<NDArray>& GraphExecutor::outputs() const {
   return output_arrays_;
 }
@@ -164,10 +347,37 @@ inline ValueType get_node_attr(
   }
 }
 
+// infer the shapes and types of a forward graph from the bound arrays.
+nnvm::Graph InferForwardAttrs(const std::vector<nnvm::NodeEntry>& outputs,
+                              const std::vector<NDArray>& in_args,
+                              const std::vector<NDArray>& aux_states) {
+  nnvm::Graph g;
+  g.outputs = outputs;
+  const auto& idx = g.indexed_graph();
+  const auto& mutable_nodes = idx.mutable_input_nodes();
+  nnvm::ShapeVector arg_shapes;
+  nnvm::DTypeVector arg_types;
+  size_t arg_top = 0, aux_top = 0;
+  for (uint32_t nid : idx.input_nodes()) {
+    const NDArray& nd = mutable_nodes.count(nid) ?
+        aux_states.at(aux_top++) : in_args.at(arg_top++);
+    arg_shapes.push_back(nd.shape());
+    arg_types.push_back(nd.dtype());
+  }
+  g = nnvm::pass::InferShape(g, arg_shapes, "__shape__");
+  g = nnvm::pass::InferType(g, arg_types, "__dtype__");
+  return g;
+}
+
 nnvm::Graph GraphExecutor::InitFullGraph(
     nnvm::Symbol symbol,
     const std::vector<OpReqType>& grad_req_type,
-    const std::vector<NDArray>& arg_grad_store) {
+    const std::vector<NDArray>& arg_grad_store,
+    const std::vector<NDArray>& in_args,
+    const std::vector<NDArray>& aux_states,
+    bool fuse_elemwise,
+    bool nchwc_layout,
+    bool inference_optimize) {
   using nnvm::NodePtr;
   using nnvm::NodeEntry;
   // initial information
@@ -180,7 +390,17 @@ nnvm::Graph GraphExecutor::InitFullGraph(
   for (OpReqType req : grad_req_type) {
     if (req != kNullOp) need_grad = true;
   }
-  if (!need_grad) return g;
+  // the inputs are kept in order, so the graph still binds to in_args.
+  if (!need_grad && inference_optimize) g = RemoveInferenceIdentity(g);
+  // fuse before taking gradient, so the backward of each fused node is fused too.
+  if (fuse_elemwise) g = FuseElemwise(g);
+  if (!need_grad) {
+    // the blocked kernels are forward only
+    if (nchwc_layout) {
+      g = ConvertLayoutNCHWc(InferForwardAttrs(g.outputs, in_args, aux_states));
+    }
+    return g;
+  }
   for (size_t i = 0; i < g.outputs.size(); ++i) {
     NodeEntry ngrad{nnvm::Node::Create(), 0, 0};
     head_grad_entry_.emplace_back(AttrHint(ngrad, g.outputs[i]));
@@ -192,16 +412,46 @@ nnvm::Graph GraphExecutor::InitFullGraph(
     if (grad_req_type[i] != kNullOp) {
       grad_store_.emplace_back(
           std::make_pair(grad_req_type[i], arg_grad_store[i]));
+      grad_arg_index_.push_back(static_cast<int>(i));
       xs.emplace_back(NodeEntry{args[i], 0, 0});
     }
   }
 
   int do_mirror = dmlc::GetEnv("MXNET_BACKWARD_DO_MIRROR", 0);
-  auto need_mirror = [do_mirror](const nnvm::Node& node) -> int {
+  size_t mirror_budget = dmlc::GetEnv("MXNET_BACKWARD_MIRROR_BUDGET_MB", size_t(0)) << 20;
+  // nodes picked by the budgeted planner, replaces the fixed heuristic.
+  std::unordered_set<const nnvm::Node*> planned_mirror;
+  mirror_budget_ = mirror_budget;
+  if (mirror_budget != 0) {
+    // plan on a separate graph, the outputs of g change once gradients are added.
+    nnvm::Graph fwd = InferForwardAttrs(g.outputs, in_args, aux_states);
+    const auto& fidx = fwd.indexed_graph();
+    std::unordered_map<const nnvm::Node*, uint32_t> fwd_nid;
+    for (uint32_t nid = 0; nid < fidx.num_nodes(); ++nid) fwd_nid[fidx[nid].source] = nid;
+    // the forward entries read by backward when nothing is mirrored
+    nnvm::Graph plain = nnvm::pass::Gradient(
+        fwd, fwd.outputs, xs, head_grad_entry_, AggregateGradient, nullptr);
+    std::vector<bool> backward_inputs(fidx.num_node_entries(), false);
+    nnvm::DFSVisit(plain.outputs, [&](const NodePtr& n) {
+        if (fwd_nid.count(n.get()) != 0) return;
+        for (const auto& e : n->inputs) {
+          auto it = fwd_nid.find(e.node.get());
+          if (it != fwd_nid.end()) backward_inputs[fidx.entry_id(it->second, e.index)] = true;
+        }
+      });
+    std::vector<int> mirror = PlanMirror(fwd, backward_inputs, mirror_budget,
+                                         &mirror_planned_bytes_);
+    for (uint32_t nid = 0; nid < fidx.num_nodes(); ++nid) {
+      if (mirror[nid]) planned_mirror.insert(fidx[nid].source);
+    }
+  }
+  auto need_mirror = [do_mirror, mirror_budget, &planned_mirror](
+      const nnvm::Node& node) -> int {
     if (node.is_variable()) return 0;
     const std::string& type = node.attrs.op->name;
     if (type == "Dropout") return false;
     if (get_node_attr(node, "__force_mirroring__", false)) return true;
+    if (mirror_budget != 0) return planned_mirror.count(&node) != 0;
     if (do_mirror == 0) return false;
     if (type == "Convolution") return false;
     if (type == "FullyConnected") return false;
@@ -212,7 +462,7 @@ nnvm::Graph GraphExecutor::InitFullGraph(
   };
   // take gradient
   nnvm::Graph g_grad = nnvm::pass::Gradient(
-      g, symbol.outputs, xs, head_grad_entry_,
+      g, g.outputs, xs, head_grad_entry_,
       AggregateGradient, need_mirror);
   CHECK_EQ(g_grad.outputs.size(), xs.size());
   for (const auto &e : g_grad.outputs) {
@@ -320,10 +570,32 @@ void GraphExecutor::Init(nnvm::Symbol symbol,
                          const std::vector<NDArray>& arg_grad_store,
                          const std::vector<OpReqType>& grad_req_type,
                          const std::vector<NDArray>& aux_states,
-                         Executor* shared_exec) {
+                         Executor* shared_exec,
+                         const std::vector<NDArray>& out_arrays) {
+  outputs_bound_ = !out_arrays.empty();
+  // the operators take contiguous arrays, the strided views bound as
+  // arguments are compacted into arrays of the executor before every forward
+  std::vector<NDArray> args(in_args);
+  for (NDArray& arg : args) {
+    if (arg.is_contiguous()) continue;
+    NDArray compact(arg.shape(), arg.ctx(), true, arg.dtype());
+    strided_args_.emplace_back(arg, compact);
+    arg = compact;
+  }
+  for (const NDArray& nd : aux_states) {
+    CHECK(nd.is_contiguous())
+        << "Cannot bind a strided NDArray view as an auxiliary state, use Compact()";
+  }
+  for (const NDArray& nd : arg_grad_store) {
+    CHECK(nd.is_none() || nd.is_contiguous())
+        << "Cannot bind a strided NDArray view as a gradient, use Compact()";
+  }
+  for (const NDArray& nd : out_arrays) {
+    CHECK(nd.is_contiguous()) << "Cannot bind a strided NDArray view as an output";
+  }
   nnvm::Graph g = InitGraph(symbol, default_ctx,
-                            ctx_map, in_args, arg_grad_store,
-                            grad_req_type, aux_states);
+                            ctx_map, args, arg_grad_store,
+                            grad_req_type, aux_states, out_arrays);
   g = AttachOpExecs(g);
   g = AttachOpResources(g);
   graph_ = std::move(g);
@@ -356,9 +628,19 @@ Graph GraphExecutor::InitGraph(nnvm::Symbol symbol,
                                const std::vector<NDArray>& in_args,
                                const std::vector<NDArray>& arg_grad_store,
                                const std::vector<OpReqType>& grad_req_type,
-                               const std::vector<NDArray>& aux_states) {
+                               const std::vector<NDArray>& aux_states,
+                               const std::vector<NDArray>& out_arrays) {
+  // elementwise fusion and the blocked layout only have CPU kernels
+  const bool cpu_only = ctx_map.size() == 0 && default_ctx.dev_mask() == cpu::kDevMask;
+  bool fuse_elemwise = dmlc::GetEnv("MXNET_EXEC_FUSE_ELEMWISE", false) && cpu_only;
+  bool nchwc_layout = dmlc::GetEnv("MXNET_EXEC_NCHWC_LAYOUT", false) && cpu_only;
+  // a removed identity would make two bound outputs the same entry
+  bool inference_optimize = dmlc::GetEnv("MXNET_EXEC_INFERENCE_OPTIMIZE", false) &&
+      out_arrays.empty();
   // setup gradient
-  nnvm::Graph g = InitFullGraph(symbol, grad_req_type, arg_grad_store);
+  nnvm::Graph g = InitFullGraph(symbol, grad_req_type, arg_grad_store,
+                                in_args, aux_states, fuse_elemwise, nchwc_layout,
+                                inference_optimize);
   g = AssignContext(g, default_ctx, ctx_map,
                     in_args,
                     grad_store_,
@@ -398,6 +680,14 @@ Graph GraphExecutor::InitGraph(nnvm::Symbol symbol,
     data_entry_[idx.entry_id(idx.outputs()[j])]
         = grad_store_[j - num_forward_outputs_].second;
   }
+  if (outputs_bound_) {
+    CHECK_EQ(out_arrays.size(), num_forward_outputs_);
+    for (size_t j = 0; j < num_forward_outputs_; ++j) {
+      const uint32_t eid = idx.entry_id(idx.outputs()[j]);
+      CHECK(data_entry_[eid].is_none()) << "a bound output must be computed by an operator";
+      data_entry_[eid] = out_arrays[j];
+    }
+  }
   arg_shapes.resize(idx.input_nodes().size(), TShape());
   arg_types.resize(idx.input_nodes().size(), -1);
   // other initializations
@@ -409,7 +699,7 @@ Graph GraphExecutor::InitGraph(nnvm::Symbol symbol,
     const int kBadStorageID = -1;
     const int kExternalStorageID = -2;
     nnvm::StorageVector arg_storage_id(idx.num_node_entries(), kBadStorageID);
-    for (size_t j = num_forward_outputs_; j < idx.outputs().size(); ++j) {
+    for (size_t j = outputs_bound_ ? 0 : num_forward_outputs_; j < idx.outputs().size(); ++j) {
       arg_storage_id[idx.entry_id(idx.outputs()[j])] = kExternalStorageID;
     }
     g.attrs["storage"] = std::make_shared<dmlc::any>(std::move(arg_storage_id));
@@ -527,14 +817,14 @@ void GraphExecutor::InitCachedOps() {
   const auto& skip_plus_node = graph_.GetAttr<std::vector<int> >("skip_plus_node");
 
   op_nodes_.resize(idx.num_nodes());
+  node_timing_.assign(idx.num_nodes(), NodeTiming());
   // setup the array and requirements.
   for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
     const auto& inode = idx[nid];
     if (inode.source->is_variable()) continue;
 #if MXNET_USE_PROFILER
-    op_nodes_[nid].opr_name = inode.source->op()->name.c_str();
-#else
-    op_nodes_[nid].opr_name = nullptr;
+    // tag the engine profile with the node, not only the operator type
+    op_nodes_[nid].opr_name = inode.source->attrs.name + " (" + inode.source->op()->name + ")";
 #endif
     if (skip_plus_node.at(nid)) {
       op_nodes_[nid].skip_exec_node = true; continue;
@@ -610,22 +900,36 @@ void GraphExecutor::InitCachedOps() {
       vars.resize(std::unique(vars.begin(), vars.end()) - vars.begin());
     };
     dedup(use_vars);
+    dedup(mutate_vars);
+    if (outputs_bound_) {
+      // a bound output can also be an argument, written in place as by an
+      // imperative operation on one of its inputs
+      use_vars.erase(std::remove_if(use_vars.begin(), use_vars.end(),
+          [&mutate_vars](Engine::VarHandle v) {
+            return std::binary_search(mutate_vars.begin(), mutate_vars.end(), v);
+          }), use_vars.end());
+    }
     for (auto v : use_vars) {
       if (std::binary_search(mutate_vars.begin(), mutate_vars.end(), v)) {
         LOG(FATAL) << "var duplication happens for op " << inode.source->attrs.name;
       }
     }
-    dedup(mutate_vars);
     dedup(all_vars);
     Engine::Get()->PushSync([exec](RunContext rctx) {
         exec->Setup();
       }, Context::CPU(), {}, all_vars, FnProperty::kNormal, 0,
       PROFILER_MESSAGE("SetupExec"));
-    auto exec_fun = [exec, is_async, is_gpu] (
+    NodeTiming* timing = &node_timing_[nid];
+    const std::atomic<bool>* profiling = &node_profiling_;
+    auto exec_fun = [exec, is_async, is_gpu, timing, profiling] (
         RunContext ctx, Engine::CallbackOnComplete on_complete) {
       if (is_async) {
         exec->op_ctx.async_on_complete = on_complete;
       }
+      // the node never runs concurrently with itself as it writes its outputs
+      const bool timed = !is_async && profiling->load(std::memory_order_relaxed);
+      const auto start = timed ? std::chrono::steady_clock::now() :
+          std::chrono::steady_clock::time_point();
       exec->Run(ctx);
       // call on complete only if it is async op
       if (!is_async) {
@@ -637,25 +941,82 @@ void GraphExecutor::InitCachedOps() {
           LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
         #endif
         }
+        if (timed) {
+          const uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - start).count();
+          timing->min_us = timing->count == 0 ? us : std::min(timing->min_us, us);
+          timing->max_us = std::max(timing->max_us, us);
+          timing->total_us += us;
+          ++timing->count;
+        }
         on_complete();
       }
     };
     // setup the vars
     op_nodes_[nid].cached_opr = Engine::Get()->NewOperator(
         exec_fun, use_vars, mutate_vars, FnProperty::kNormal,
-        PROFILER_MESSAGE(op_nodes_[nid].opr_name));
+        PROFILER_MESSAGE(op_nodes_[nid].opr_name.c_str()));
+  }
+}
+
+void GraphExecutor::Rebind(const std::vector<NDArray>& in_args,
+                           const std::vector<NDArray>& out_arrays) {
+  const auto& idx = graph_.indexed_graph();
+  const auto& vshape = graph_.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& vdtype = graph_.GetAttr<nnvm::DTypeVector>("dtype");
+  CHECK(outputs_bound_ && grad_store_.empty() && idx.mutable_input_nodes().empty())
+      << "only forward executors with bound outputs and no auxiliary states can be rebound";
+  CHECK_EQ(in_args.size(), num_forward_inputs_);
+  CHECK_EQ(out_arrays.size(), num_forward_outputs_);
+  auto assign = [&](uint32_t eid, const NDArray& nd) {
+    CHECK(nd.is_contiguous()) << "Rebind: strided views cannot be bound";
+    CHECK_EQ(nd.shape(), vshape[eid]) << "Rebind: shape mismatch";
+    CHECK_EQ(nd.dtype(), vdtype[eid]) << "Rebind: dtype mismatch";
+    data_entry_[eid] = nd;
+  };
+  // the executors of the nodes are about to be set up again, every node is
+  // an ancestor of an output so the previous run is done once they are written
+  for (const NDArray& nd : output_arrays_) {
+    Engine::Get()->WaitForVar(nd.var());
+  }
+  for (size_t i = 0; i < num_forward_inputs_; ++i) {
+    assign(idx.entry_id(idx.input_nodes()[i], 0), in_args[i]);
+  }
+  for (size_t j = 0; j < num_forward_outputs_; ++j) {
+    assign(idx.entry_id(idx.outputs()[j]), out_arrays[j]);
+    output_arrays_[j] = out_arrays[j];
+  }
+  for (auto& n : op_nodes_) {
+    if (n.cached_opr != nullptr) {
+      Engine::Get()->DeleteOperator(n.cached_opr);
+      n.cached_opr = nullptr;
+    }
+    if (n.exec != nullptr) {
+      n.exec->in_array.clear();
+      n.exec->out_array.clear();
+      n.exec->req.clear();
+    }
   }
+  this->InitCachedOps();
 }
 
 void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
   static const auto& flist_outputs =
       nnvm::Op::GetAttr<nnvm::FListOutputNames>("FListOutputNames");
   const auto& idx = graph_.indexed_graph();
+  // the cached operators use the variables of the arrays directly
+  NDArray::FlushLazy();
   for (size_t nid = topo_start; nid < topo_end; ++nid) {
     const auto& inode = idx[nid];
     if (inode.source->is_variable()) continue;
     OpNode& opnode = op_nodes_[nid];
-    if (op_nodes_[nid].skip_exec_node) continue;
+    if (op_nodes_[nid].skip_exec_node) {
+      // the gradient was already added in place by the input of this node
+      if (grad_ready_callback_) {
+        for (size_t j : grad_ready_nodes_[nid]) PushGradientReady(j);
+      }
+      continue;
+    }
     opnode.exec->op_ctx.is_train = is_train;
     if (opnode.exec->exec_type() == Operator::kCrossDeviceCopy) {
       CHECK_EQ(inode.inputs.size(), 1);
@@ -672,6 +1033,9 @@ void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
     } else {
       LOG(FATAL) << "Not accessed";
     }
+    if (grad_ready_callback_) {
+      for (size_t j : grad_ready_nodes_[nid]) PushGradientReady(j);
+    }
 
     if (monitor_callback_) {
       std::vector<std::string> output_names;
@@ -689,6 +1053,7 @@ void GraphExecutor::RunOps(bool is_train, size_t topo_start, size_t topo_end) {
         this->monitor_callback_(name.c_str(), reinterpret_cast<void*>(cpy));
       }
     }
+    if (monitor_active_) PushMonitorStats(nid);
   }
 }
 
@@ -708,4 +1073,29 @@ Executor *Executor::Bind(nnvm::Symbol symbol,
              reinterpret_cast<Executor*>(shared_exec));
   return exec;
 }
+
+nnvm::Symbol Executor::OptimizeForInference(
+    const nnvm::Symbol& symbol,
+    const std::vector<std::string>& data_names,
+    std::unordered_map<std::string, NDArray>* params) {
+  nnvm::Graph g;
+  g.outputs = symbol.outputs;
+  g = exec::OptimizeInference(
+      g, std::unordered_set<std::string>(data_names.begin(), data_names.end()), params);
+  nnvm::Symbol ret;
+  ret.outputs = g.outputs;
+  return ret;
+}
+
+nnvm::Symbol Executor::QuantizeForInference(
+    const nnvm::Symbol& symbol,
+    const std::unordered_map<std::string, std::pair<float, float> >& calib,
+    std::unordered_map<std::string, NDArray>* params) {
+  nnvm::Graph g;
+  g.outputs = symbol.outputs;
+  g = exec::QuantizeGraph(g, calib, params);
+  nnvm::Symbol ret;
+  ret.outputs = g.outputs;
+  return ret;
+}
 }  // namespace mxnet
@@ -13,6 +13,7 @@
 #include <nnvm/graph.h>
 #include <nnvm/op_attr_types.h>
 #include <nnvm/graph_attr_types.h>
+#include <atomic>
 #include <map>
 #include <string>
 #include <utility>
@@ -28,6 +29,7 @@ using nnvm::Graph;
 class GraphExecutor : public Executor {
  public:
   using Executor::MonitorCallback;
+  using Executor::GradientReadyCallback;
   virtual ~GraphExecutor();
   void Forward(bool is_train) override;
   void PartialForward(bool is_train, int step, int *step_left) override;
@@ -35,6 +37,13 @@ class GraphExecutor : public Executor {
   const std::vector<NDArray>& outputs() const override;
   void Print(std::ostream &os) const override; // NOLINT(*)
   void SetMonitorCallback(const MonitorCallback& callback) override;
+  void SetGradientReadyCallback(const GradientReadyCallback& callback) override;
+  void SetMonitorStats(int stat_mask, int interval) override;
+  void GetMonitorStats(std::vector<uint32_t>* iterations,
+                       std::vector<std::string>* names,
+                       std::vector<float>* values) override;
+  void SetNodeProfiling(bool enable) override;
+  void GetNodeProfile(bool reset, std::vector<NodeProfile>* profile) override;
   // initialized the executor
   void Init(nnvm::Symbol symbol,
             const Context& default_ctx,
@@ -43,13 +52,21 @@ class GraphExecutor : public Executor {
             const std::vector<NDArray>& arg_grad_store,
             const std::vector<OpReqType>& grad_req_type,
             const std::vector<NDArray>& aux_states,
-            Executor* shared_exec = nullptr);
+            Executor* shared_exec = nullptr,
+            const std::vector<NDArray>& out_arrays = std::vector<NDArray>());
+  /*!
+   * \brief bind a forward only executor initialized with out_arrays to other
+   *  arrays of the same shapes and types. The graph, its memory plan and the
+   *  operators are kept, only the cached engine operators are recreated.
+   *  Waits for the previous run, the executors of the nodes are shared.
+   */
+  void Rebind(const std::vector<NDArray>& in_args, const std::vector<NDArray>& out_arrays);
 
  protected:
   // Information about operational node
   struct OpNode {
     // The name of the operator
-    const char* opr_name;
+    std::string opr_name;
     // the context of the node
     Context ctx;
     // The executor
@@ -59,6 +76,13 @@ class GraphExecutor : public Executor {
     // cached operator handle
     Engine::OprHandle cached_opr{nullptr};
   };
+  // execution time of a node, in microseconds
+  struct NodeTiming {
+    uint64_t count{0};
+    uint64_t total_us{0};
+    uint64_t min_us{0};
+    uint64_t max_us{0};
+  };
   // internal initialization of the graph.
   Graph InitGraph(nnvm::Symbol symbol,
                   const Context& default_ctx,
@@ -66,11 +90,17 @@ class GraphExecutor : public Executor {
                   const std::vector<NDArray>& in_args,
                   const std::vector<NDArray>& arg_grad_store,
                   const std::vector<OpReqType>& grad_req_type,
-                  const std::vector<NDArray>& aux_states);
+                  const std::vector<NDArray>& aux_states,
+                  const std::vector<NDArray>& out_arrays);
   // initialize the full graph, including gradient.
   Graph InitFullGraph(nnvm::Symbol symbol,
                       const std::vector<OpReqType>& grad_req_type,
-                      const std::vector<NDArray>& arg_grad_store);
+                      const std::vector<NDArray>& arg_grad_store,
+                      const std::vector<NDArray>& in_args,
+                      const std::vector<NDArray>& aux_states,
+                      bool fuse_elemwise,
+                      bool nchwc_layout,
+                      bool inference_optimize);
   // initialize the cached operator
   void InitCachedOps();
   // initialize the resources in the graph
@@ -79,6 +109,14 @@ class GraphExecutor : public Executor {
   void InitDataEntryMemory(const std::vector<NDArray>& shared_pool);
   // run ops from topo order start to end
   void RunOps(bool is_train, size_t topo_start, size_t topo_end);
+  // copy the strided views bound as arguments into their compact arrays
+  void CompactStridedArgs();
+  // push the gradient ready callback of the j-th gradient in grad_store_
+  void PushGradientReady(size_t j);
+  // start a new iteration of the in-engine monitor
+  void BeginMonitorIter();
+  // push the statistics of the outputs of node nid
+  void PushMonitorStats(uint32_t nid);
   // internal graph
   nnvm::Graph graph_;
   // operator node
@@ -89,8 +127,14 @@ class GraphExecutor : public Executor {
   std::vector<NDArray> data_pool_;
   // output arrays
   std::vector<NDArray> output_arrays_;
+  // strided views bound as arguments and the compact arrays bound instead
+  std::vector<std::pair<NDArray, NDArray> > strided_args_;
+  // whether the forward outputs are arrays given at Init instead of planned memory
+  bool outputs_bound_{false};
   // gradient store
   std::vector<std::pair<OpReqType, NDArray> > grad_store_;
+  // index of the argument of each gradient in grad_store_
+  std::vector<int> grad_arg_index_;
   // array to hold head gradient.
   std::vector<NDArray> head_grad_array_;
   // entry to hold head gradient
@@ -103,8 +147,41 @@ class GraphExecutor : public Executor {
   size_t num_forward_inputs_{0};
   // number of forward nodes
   size_t num_forward_nodes_{0};
+  // memory budget of the mirror planner, 0 if disabled
+  size_t mirror_budget_{0};
+  // forward activations kept for backward with the planned mirroring
+  size_t mirror_planned_bytes_{0};
   // monitor call back
   std::function<void(const char*, void*)> monitor_callback_{nullptr};
+  // gradient ready call back
+  GradientReadyCallback grad_ready_callback_{nullptr};
+  // indices in grad_store_ of the gradients written by each backward node
+  std::vector<std::vector<size_t> > grad_ready_nodes_;
+  // indices in grad_store_ of the gradients not written by a backward node,
+  // e.g. passed through from a forward node or a head gradient
+  std::vector<size_t> grad_ready_passed_;
+  // statistics computed by the in-engine monitor, 0 if disabled
+  int monitor_stat_mask_{0};
+  // collect statistics every monitor_interval_ iterations
+  int monitor_interval_{1};
+  // number of calls to Forward since the monitor was set
+  uint32_t monitor_iter_{0};
+  // whether statistics are collected in the current iteration
+  bool monitor_active_{false};
+  // serializes the statistics operations, which append to the records
+  Engine::VarHandle monitor_var_{nullptr};
+  // name of each data entry
+  std::vector<std::string> monitor_names_;
+  // CPU copy of each monitored entry on another device, reused every iteration
+  std::vector<NDArray> monitor_copies_;
+  // collected records: iteration, entry id and values of each record
+  std::vector<uint32_t> monitor_rec_iter_;
+  std::vector<uint32_t> monitor_rec_entry_;
+  std::vector<float> monitor_rec_values_;
+  // whether the cached operators record their execution time
+  std::atomic<bool> node_profiling_{false};
+  // execution time of each node, written by the cached operators
+  std::vector<NodeTiming> node_timing_;
 };
 
 }  // namespace exec
@@ -0,0 +1,479 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file inference_optimize_pass.cc
+ * \brief Graph rewrites that are only valid when the graph runs for inference.
+ */
+#include <mxnet/base.h>
+#include <mxnet/executor.h>
+#include <mxnet/operator.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph.h>
+#include <nnvm/graph_attr_types.h>
+#include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "./exec_pass.h"
+#include "../operator/batch_norm-inl.h"
+#include "../operator/convolution-inl.h"
+#include "../operator/fully_connected-inl.h"
+#include "../operator/quantized_op-inl.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+using nnvm::NodePtr;
+using nnvm::NodeEntry;
+using ParamMap = std::unordered_map<std::string, NDArray>;
+
+/*!
+ * \brief rewrite function of RewriteGraph.
+ * \param nid node id in the source graph.
+ * \param inputs the already rewritten inputs of the node.
+ * \param outputs set to the replacement of each output of the node.
+ * \return false to keep the node (with rewritten inputs) instead.
+ */
+using FRewrite = std::function<bool(uint32_t nid,
+                                    const std::vector<NodeEntry>& inputs,
+                                    std::vector<NodeEntry>* outputs)>;
+
+// Rebuild the graph bottom-up, replacing the nodes accepted by frewrite.
+// Nodes of the source graph are never modified, variables are shared.
+// A control dependency on a replaced node moves to that node's own control
+// dependencies.
+Graph RewriteGraph(const Graph& src, FRewrite frewrite) {
+  const auto& idx = src.indexed_graph();
+  std::vector<NodePtr> nodes;
+  nnvm::DFSVisit(src.outputs, [&nodes](const NodePtr& n) {
+      nodes.push_back(n);
+    });
+  CHECK_EQ(nodes.size(), idx.num_nodes());
+  std::vector<NodeEntry> new_entry(idx.num_node_entries());
+  // the kept nodes a control dependency on each source node stands for
+  std::vector<std::vector<NodePtr> > dep_nodes(idx.num_nodes());
+  auto add_deps = [&](const std::vector<uint32_t>& deps, std::vector<NodePtr>* out) {
+    for (uint32_t c : deps) {
+      for (const NodePtr& d : dep_nodes[c]) {
+        if (std::find(out->begin(), out->end(), d) == out->end()) out->push_back(d);
+      }
+    }
+  };
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    std::vector<NodeEntry> inputs;
+    for (const auto& e : inode.inputs) {
+      inputs.push_back(new_entry[idx.entry_id(e)]);
+    }
+    std::vector<NodeEntry> outputs;
+    if (frewrite(nid, inputs, &outputs)) {
+      CHECK_EQ(outputs.size(), inode.source->num_outputs());
+      add_deps(inode.control_deps, &dep_nodes[nid]);
+    } else if (inode.source->is_variable()) {
+      outputs.push_back(NodeEntry{nodes[nid], 0, 0});
+      dep_nodes[nid].push_back(nodes[nid]);
+    } else {
+      NodePtr n = nnvm::Node::Create();
+      n->attrs = inode.source->attrs;
+      n->inputs = std::move(inputs);
+      add_deps(inode.control_deps, &n->control_deps);
+      for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+        outputs.push_back(NodeEntry{n, i, 0});
+      }
+      dep_nodes[nid].push_back(n);
+    }
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      new_entry[idx.entry_id(nid, i)] = outputs[i];
+    }
+  }
+  Graph ret;
+  for (const auto& e : idx.outputs()) {
+    ret.outputs.push_back(new_entry[idx.entry_id(e)]);
+  }
+  return ret;
+}
+
+inline NodePtr CreateVariable(const std::string& name) {
+  NodePtr n = nnvm::Node::Create();
+  n->attrs.op = nullptr;
+  n->attrs.name = name;
+  return n;
+}
+
+// pick a name that collides with neither the graph inputs nor the parameters.
+std::string UniqueName(const std::string& base,
+                       const std::unordered_set<std::string>& taken,
+                       const ParamMap& params) {
+  std::string name = base;
+  for (int i = 1; taken.count(name) != 0 || params.count(name) != 0; ++i) {
+    name = base + std::to_string(i);
+  }
+  return name;
+}
+
+std::unordered_set<std::string> InputNames(const Graph& g) {
+  std::unordered_set<std::string> ret;
+  const auto& idx = g.indexed_graph();
+  for (uint32_t nid : idx.input_nodes()) {
+    ret.insert(idx[nid].source->attrs.name);
+  }
+  return ret;
+}
+
+// read a float32 parameter into host memory.
+bool GetParam(const nnvm::Node* var, const std::unordered_set<std::string>& data_names,
+              const ParamMap& params, std::vector<float>* out) {
+  if (!var->is_variable() || data_names.count(var->attrs.name) != 0) return false;
+  auto it = params.find(var->attrs.name);
+  if (it == params.end() || it->second.dtype() != mshadow::kFloat32) return false;
+  out->resize(it->second.shape().Size());
+  it->second.SyncCopyToCPU(out->data(), out->size());
+  return true;
+}
+
+// Fold BatchNorm with moving statistics into the weight and bias of the
+// preceding Convolution or FullyConnected:
+//   W' = W * gamma / sqrt(var + eps),  b' = (b - mean) * gamma / sqrt(var + eps) + beta
+Graph FoldBatchNorm(const Graph& g,
+                    const std::unordered_set<std::string>& data_names,
+                    ParamMap* params) {
+  static const nnvm::Op* conv_op = nnvm::Op::Get("Convolution");
+  static const nnvm::Op* fc_op = nnvm::Op::Get("FullyConnected");
+  static const std::unordered_set<const nnvm::Op*> bn_ops = {
+    nnvm::Op::Get("BatchNorm"), nnvm::Op::Get("CuDNNBatchNorm")
+  };
+  const auto& idx = g.indexed_graph();
+  std::vector<uint32_t> ref_count(idx.num_node_entries(), 0);
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    for (const auto& e : idx[nid].inputs) ++ref_count[idx.entry_id(e)];
+  }
+  for (const auto& e : idx.outputs()) ++ref_count[idx.entry_id(e)];
+  std::unordered_set<std::string> taken = InputNames(g);
+
+  return RewriteGraph(g, [&](uint32_t nid, const std::vector<NodeEntry>& inputs,
+                             std::vector<NodeEntry>* outputs) {
+      const nnvm::Node* bn = idx[nid].source;
+      if (bn->is_variable() || bn_ops.count(bn->op()) == 0) return false;
+      op::BatchNormParam bn_param;
+      bn_param.InitAllowUnknown(bn->attrs.dict);
+      if (bn_param.output_mean_var) return false;
+      const auto& data = idx[nid].inputs[op::batchnorm::kData];
+      const nnvm::Node* layer = idx[data.node_id].source;
+      if (layer->is_variable() || ref_count[idx.entry_id(data)] != 1) return false;
+      bool no_bias;
+      if (layer->op() == conv_op) {
+        op::ConvolutionParam param;
+        param.InitAllowUnknown(layer->attrs.dict);
+        if (param.layout.has_value() &&
+            param.layout.value() != mshadow::kNCHW &&
+            param.layout.value() != mshadow::kNCDHW) return false;
+        no_bias = param.no_bias;
+      } else if (layer->op() == fc_op) {
+        op::FullyConnectedParam param;
+        param.InitAllowUnknown(layer->attrs.dict);
+        no_bias = param.no_bias;
+      } else {
+        return false;
+      }
+      // BatchNorm inputs are data, gamma, beta, moving_mean, moving_var
+      std::vector<float> weight, bias, gamma, beta, mean, var;
+      const auto& lin = idx[data.node_id].inputs;
+      const auto& bin = idx[nid].inputs;
+      if (!GetParam(idx[lin[1].node_id].source, data_names, *params, &weight) ||
+          (!no_bias && !GetParam(idx[lin[2].node_id].source, data_names, *params, &bias)) ||
+          !GetParam(idx[bin[1].node_id].source, data_names, *params, &gamma) ||
+          !GetParam(idx[bin[2].node_id].source, data_names, *params, &beta) ||
+          !GetParam(idx[bin[3].node_id].source, data_names, *params, &mean) ||
+          !GetParam(idx[bin[4].node_id].source, data_names, *params, &var)) {
+        return false;
+      }
+      const size_t nchannel = beta.size();
+      if (nchannel == 0 || weight.size() % nchannel != 0) return false;
+      if (no_bias) bias.assign(nchannel, 0.0f);
+      const size_t stride = weight.size() / nchannel;
+      for (size_t c = 0; c < nchannel; ++c) {
+        float g = bn_param.fix_gamma ? 1.0f : gamma[c];
+        float scale = g / std::sqrt(var[c] + bn_param.eps);
+        for (size_t j = 0; j < stride; ++j) weight[c * stride + j] *= scale;
+        bias[c] = (bias[c] - mean[c]) * scale + beta[c];
+      }
+      // the folded parameters stay on the device of the weight
+      const NDArray& wsrc = params->at(idx[lin[1].node_id].source->attrs.name);
+      NDArray new_weight(wsrc.shape(), wsrc.ctx(), false, mshadow::kFloat32);
+      NDArray new_bias(TShape(mshadow::Shape1(nchannel)), wsrc.ctx(),
+                       false, mshadow::kFloat32);
+      new_weight.SyncCopyFromCPU(weight.data(), weight.size());
+      new_bias.SyncCopyFromCPU(bias.data(), bias.size());
+
+      NodePtr n = nnvm::Node::Create();
+      n->attrs = layer->attrs;
+      n->attrs.name = bn->attrs.name;
+      n->attrs.dict["no_bias"] = "False";
+      n->op()->attr_parser(&(n->attrs));
+      std::string wname = UniqueName(bn->attrs.name + "_fold_weight", taken, *params);
+      taken.insert(wname);
+      std::string bname = UniqueName(bn->attrs.name + "_fold_bias", taken, *params);
+      taken.insert(bname);
+      (*params)[wname] = new_weight;
+      (*params)[bname] = new_bias;
+      // the data input of the layer was rewritten when the layer was visited.
+      n->inputs = {inputs[op::batchnorm::kData].node->inputs[0],
+                   NodeEntry{CreateVariable(wname), 0, 0},
+                   NodeEntry{CreateVariable(bname), 0, 0}};
+      outputs->assign(bn->num_outputs(), NodeEntry{n, 0, 0});
+      return true;
+    });
+}
+
+// Evaluate every subgraph that only depends on parameters once, and replace
+// it by new parameters holding the results.
+Graph FoldConstants(const Graph& g,
+                    const std::unordered_set<std::string>& data_names,
+                    ParamMap* params) {
+  static auto& fresource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  const auto& idx = g.indexed_graph();
+  std::vector<NodePtr> nodes;
+  nnvm::DFSVisit(g.outputs, [&nodes](const NodePtr& n) {
+      nodes.push_back(n);
+    });
+  std::vector<bool> is_const(idx.num_nodes(), false);
+  // the device of the first parameter each constant node depends on
+  std::vector<Context> const_ctx(idx.num_nodes(), Context::CPU());
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    const nnvm::Node* node = inode.source;
+    if (node->is_variable()) {
+      is_const[nid] = data_names.count(node->attrs.name) == 0 &&
+          params->count(node->attrs.name) != 0;
+      if (is_const[nid]) const_ctx[nid] = params->at(node->attrs.name).ctx();
+      continue;
+    }
+    if (inode.inputs.size() == 0 || inode.control_deps.size() != 0) continue;
+    if (fmutate.count(node->op()) != 0) continue;
+    bool stateless = true;
+    if (fresource.count(node->op()) != 0) {
+      for (const auto& req : fresource[node->op()](node->attrs)) {
+        if (req.type == ResourceRequest::kRandom) stateless = false;
+      }
+    }
+    if (!stateless) continue;
+    bool all_const = true;
+    for (const auto& e : inode.inputs) {
+      all_const = all_const && is_const[e.node_id];
+    }
+    is_const[nid] = all_const;
+    if (all_const) const_ctx[nid] = const_ctx[inode.inputs[0].node_id];
+  }
+  // constant entries of op nodes that are needed by the rest of the graph
+  std::vector<bool> needed(idx.num_node_entries(), false);
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    if (is_const[nid]) continue;
+    for (const auto& e : idx[nid].inputs) {
+      if (is_const[e.node_id]) needed[idx.entry_id(e)] = true;
+    }
+  }
+  for (const auto& e : idx.outputs()) {
+    if (is_const[e.node_id]) needed[idx.entry_id(e)] = true;
+  }
+  nnvm::Symbol folded;
+  std::vector<uint32_t> folded_eid;
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    if (idx[nid].source->is_variable()) continue;
+    for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+      if (needed[idx.entry_id(nid, i)]) {
+        folded.outputs.push_back(NodeEntry{nodes[nid], i, 0});
+        folded_eid.push_back(idx.entry_id(nid, i));
+      }
+    }
+  }
+  if (folded.outputs.size() == 0) return g;
+
+  // run the constant part of the graph once on CPU, on copies of the parameters.
+  std::vector<NDArray> in_args, arg_grads, aux_states;
+  std::vector<OpReqType> grad_reqs;
+  for (const auto& name : folded.ListInputNames(nnvm::Symbol::kReadOnlyArgs)) {
+    in_args.push_back(params->at(name).Copy(Context::CPU()));
+    arg_grads.push_back(NDArray());
+    grad_reqs.push_back(kNullOp);
+  }
+  for (const auto& name : folded.ListInputNames(nnvm::Symbol::kAuxiliaryStates)) {
+    aux_states.push_back(params->at(name).Copy(Context::CPU()));
+  }
+  std::unique_ptr<Executor> exec(Executor::Bind(
+      folded, Context::CPU(), std::map<std::string, Context>(),
+      in_args, arg_grads, grad_reqs, aux_states));
+  exec->Forward(false);
+  std::unordered_set<std::string> taken = InputNames(g);
+  std::unordered_map<uint32_t, NodeEntry> replace;
+  for (size_t i = 0; i < folded_eid.size(); ++i) {
+    // each value goes back to the device of the parameters it came from
+    const NDArray& out = exec->outputs()[i];
+    const uint32_t src = idx.node_id(folded.outputs[i].node.get());
+    NDArray value(out.shape(), const_ctx[src], false, out.dtype());
+    CopyFromTo(out, &value);
+    value.WaitToRead();
+    const nnvm::Node* node = folded.outputs[i].node.get();
+    std::string base = node->attrs.name + "_const";
+    if (node->num_outputs() != 1) base += std::to_string(folded.outputs[i].index);
+    std::string name = UniqueName(base, taken, *params);
+    taken.insert(name);
+    (*params)[name] = value;
+    replace[folded_eid[i]] = NodeEntry{CreateVariable(name), 0, 0};
+  }
+  return RewriteGraph(g, [&](uint32_t nid, const std::vector<NodeEntry>& inputs,
+                             std::vector<NodeEntry>* outputs) {
+      if (!is_const[nid] || idx[nid].source->is_variable()) return false;
+      // nodes that are not needed are unreachable after the rewrite.
+      for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+        auto it = replace.find(idx.entry_id(nid, i));
+        outputs->push_back(it != replace.end() ? it->second : NodeEntry{nodes[nid], i, 0});
+      }
+      return true;
+    });
+}
+
+// drop the parameters the graph does not refer to.
+void PruneParams(const Graph& g, ParamMap* params) {
+  std::unordered_set<std::string> used = InputNames(g);
+  for (auto it = params->begin(); it != params->end();) {
+    if (used.count(it->first) == 0) {
+      it = params->erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+// name of a data entry, the same as the one given to the executor monitor.
+std::string EntryName(const nnvm::IndexedGraph& idx, const nnvm::IndexedGraph::NodeEntry& e) {
+  static const auto& flist_outputs =
+      nnvm::Op::GetAttr<nnvm::FListOutputNames>("FListOutputNames");
+  const nnvm::Node* node = idx[e.node_id].source;
+  if (node->is_variable()) return node->attrs.name;
+  std::vector<std::string> output_names;
+  if (flist_outputs.count(node->op())) {
+    output_names = flist_outputs[node->op()](node->attrs);
+  }
+  return node->attrs.name + "_" + (e.index < output_names.size() ?
+                                   output_names[e.index] : std::to_string(e.index));
+}
+
+// print a float attribute without losing precision.
+std::string FloatAttr(float v) {
+  std::ostringstream os;
+  os << std::setprecision(9) << v;
+  return os.str();
+}
+}  // namespace
+
+Graph RemoveInferenceIdentity(const Graph& g) {
+  static const std::unordered_set<const nnvm::Op*> identity_ops = {
+    nnvm::Op::Get("Dropout"), nnvm::Op::Get("_copy"), nnvm::Op::Get("BlockGrad")
+  };
+  const auto& idx = g.indexed_graph();
+  return RewriteGraph(g, [&](uint32_t nid, const std::vector<NodeEntry>& inputs,
+                             std::vector<NodeEntry>* outputs) {
+      const nnvm::Node* node = idx[nid].source;
+      if (node->is_variable() || identity_ops.count(node->op()) == 0) return false;
+      // every output (including the Dropout mask) aliases the data.
+      outputs->assign(node->num_outputs(), inputs[0]);
+      return true;
+    });
+}
+
+Graph OptimizeInference(Graph g,
+                        const std::unordered_set<std::string>& data_names,
+                        std::unordered_map<std::string, NDArray>* params) {
+  g = RemoveInferenceIdentity(g);
+  g = FoldBatchNorm(g, data_names, params);
+  g = FoldConstants(g, data_names, params);
+  PruneParams(g, params);
+  return g;
+}
+
+Graph QuantizeGraph(Graph g,
+                    const std::unordered_map<std::string, std::pair<float, float> >& calib,
+                    std::unordered_map<std::string, NDArray>* params) {
+  static const Op* fc_op = Op::Get("FullyConnected");
+  static const Op* conv_op = Op::Get("Convolution");
+  const auto& idx = g.indexed_graph();
+  const std::unordered_set<std::string> taken = InputNames(g);
+  std::unordered_map<std::string, std::pair<NodePtr, op::quantized::QuantRange> > qweights;
+  g = RewriteGraph(g, [&](uint32_t nid, const std::vector<NodeEntry>& inputs,
+                          std::vector<NodeEntry>* outputs) {
+      const nnvm::Node* node = idx[nid].source;
+      if (node->is_variable()) return false;
+      const Op* qop = nullptr;
+      if (node->op() == fc_op) {
+        qop = Op::Get("_quantized_FullyConnected");
+      } else if (node->op() == conv_op) {
+        op::ConvolutionParam param;
+        param.InitAllowUnknown(node->attrs.dict);
+        if (param.kernel.ndim() != 2 || param.num_group != 1) return false;
+        if (param.layout.has_value() && param.layout.value() != mshadow::kNCHW) return false;
+        qop = Op::Get("_quantized_Convolution");
+      } else {
+        return false;
+      }
+      // inputs without calibrated range stay in float32.
+      auto range = calib.find(EntryName(idx, idx[nid].inputs[0]));
+      if (range == calib.end()) return false;
+      const nnvm::Node* wvar = idx[idx[nid].inputs[1].node_id].source;
+      // weights shared by several layers are quantized once.
+      auto qw = qweights.find(wvar->attrs.name);
+      if (qw == qweights.end()) {
+        std::vector<float> weight;
+        if (!GetParam(wvar, {}, *params, &weight)) return false;
+        const auto wminmax = std::minmax_element(weight.begin(), weight.end());
+        const op::quantized::QuantRange wrange(*wminmax.first, *wminmax.second);
+        std::vector<uint8_t> qweight(weight.size());
+        for (size_t i = 0; i < weight.size(); ++i) qweight[i] = wrange.Quantize(weight[i]);
+        NDArray value(params->at(wvar->attrs.name).shape(), Context::CPU(),
+                      false, mshadow::kUint8);
+        value.SyncCopyFromCPU(qweight.data(), qweight.size());
+        const std::string name = UniqueName(wvar->attrs.name + "_quantized", taken, *params);
+        (*params)[name] = value;
+        qw = qweights.emplace(wvar->attrs.name,
+                              std::make_pair(CreateVariable(name), wrange)).first;
+      }
+      const op::quantized::QuantRange& wrange = qw->second.second;
+      const op::quantized::QuantRange drange(range->second.first, range->second.second);
+
+      NodePtr quantize = nnvm::Node::Create();
+      quantize->attrs.op = Op::Get("_quantize");
+      quantize->attrs.name = node->attrs.name + "_quantize_data";
+      quantize->attrs.dict["min_range"] = FloatAttr(drange.min);
+      quantize->attrs.dict["max_range"] = FloatAttr(drange.min + 255 * drange.scale);
+      quantize->op()->attr_parser(&(quantize->attrs));
+      quantize->inputs.push_back(inputs[0]);
+
+      NodePtr n = nnvm::Node::Create();
+      n->attrs = node->attrs;
+      n->attrs.op = qop;
+      n->attrs.dict["data_min"] = quantize->attrs.dict["min_range"];
+      n->attrs.dict["data_max"] = quantize->attrs.dict["max_range"];
+      n->attrs.dict["weight_min"] = FloatAttr(wrange.min);
+      n->attrs.dict["weight_max"] = FloatAttr(wrange.min + 255 * wrange.scale);
+      n->op()->attr_parser(&(n->attrs));
+      n->inputs = {NodeEntry{quantize, 0, 0}, NodeEntry{qw->second.first, 0, 0}};
+      for (size_t i = 2; i < inputs.size(); ++i) n->inputs.push_back(inputs[i]);
+      outputs->push_back(NodeEntry{n, 0, 0});
+      return true;
+    });
+  PruneParams(g, params);
+  return g;
+}
+
+}  // namespace exec
+}  // namespace mxnet
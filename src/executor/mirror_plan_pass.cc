@@ -0,0 +1,161 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file mirror_plan_pass.cc
+ * \brief Choose the forward nodes to recompute in backward under a memory budget.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <mxnet/op_attr_types.h>
+#include <nnvm/graph_attr_types.h>
+#include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <vector>
+
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+
+std::vector<int> PlanMirror(const Graph& g, const std::vector<bool>& backward_inputs,
+                            size_t budget_bytes, size_t* planned_bytes) {
+  static auto& fresource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  static const Op* dropout_op = Op::Get("Dropout");
+  // the longest chain of producers added to a node in one step
+  const int kMaxChain = 4;
+  const auto& idx = g.indexed_graph();
+  const auto& vshape = g.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& vdtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+  CHECK_EQ(backward_inputs.size(), idx.num_node_entries());
+  std::vector<int> mirror(idx.num_nodes(), 0);
+
+  std::vector<bool> is_output(idx.num_nodes(), false);
+  for (const auto& e : idx.outputs()) is_output[e.node_id] = true;
+
+  // An output of an op node is alive in backward while it is read by
+  // backward or by the recomputation of a mirrored node, and its node is not
+  // mirrored itself. Variables are always alive and cost nothing.
+  std::vector<size_t> bytes(idx.num_node_entries(), 0);
+  std::vector<uint32_t> readers(idx.num_node_entries(), 0);
+  std::vector<bool> candidate(idx.num_nodes(), false);
+  std::vector<uint64_t> flops(idx.num_nodes(), 0);
+  size_t kept_bytes = 0;
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) continue;
+    std::vector<TShape> ishape, oshape;
+    for (const auto& e : inode.inputs) ishape.push_back(vshape[idx.entry_id(e)]);
+    size_t node_bytes = 0;
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      const uint32_t eid = idx.entry_id(nid, i);
+      oshape.push_back(vshape[eid]);
+      if (vdtype[eid] != -1) {
+        bytes[eid] = vshape[eid].Size() * mshadow::mshadow_sizeof(vdtype[eid]);
+      }
+      node_bytes += bytes[eid];
+      if (backward_inputs[eid]) {
+        readers[eid] = 1;
+        kept_bytes += bytes[eid];
+      }
+    }
+    // recomputing must give the same result and must not update any state twice.
+    const Op* op = inode.source->op();
+    if (is_output[nid] || op == dropout_op || fmutate.count(op) != 0) continue;
+    bool stateless = true;
+    if (fresource.count(op) != 0) {
+      for (const auto& req : fresource[op](inode.source->attrs)) {
+        if (req.type == ResourceRequest::kRandom) stateless = false;
+      }
+    }
+    if (!stateless || node_bytes == 0) continue;
+    candidate[nid] = true;
+    flops[nid] = std::max<uint64_t>(EstimateFLOPs(inode.source->attrs, ishape, oshape), 1);
+  }
+
+  // change of the alive bytes when the nodes of step are mirrored too.
+  std::vector<uint32_t> in_step(idx.num_nodes(), 0), held(idx.num_node_entries(), 0);
+  uint32_t step_id = 0;
+  auto step_delta = [&](const std::vector<uint32_t>& step) {
+    ++step_id;
+    for (uint32_t nid : step) in_step[nid] = step_id;
+    int64_t delta = 0;
+    for (uint32_t nid : step) {
+      for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+        const uint32_t eid = idx.entry_id(nid, i);
+        if (readers[eid] != 0) delta -= static_cast<int64_t>(bytes[eid]);
+      }
+      for (const auto& e : idx[nid].inputs) {
+        const uint32_t eid = idx.entry_id(e);
+        if (idx[e.node_id].source->is_variable() || mirror[e.node_id] ||
+            in_step[e.node_id] == step_id || readers[eid] != 0 ||
+            held[eid] == step_id) continue;
+        held[eid] = step_id;
+        delta += static_cast<int64_t>(bytes[eid]);
+      }
+    }
+    return delta;
+  };
+
+  // Mirroring a node only saves memory when the inputs of its recomputation
+  // are alive anyway, otherwise its producers have to be mirrored with it.
+  // Each step mirrors a node and a chain of the producers whose outputs would
+  // be kept only for it, picking the fewest FLOPs per byte saved.
+  while (kept_bytes > budget_bytes) {
+    std::vector<uint32_t> best;
+    double best_cost = 0;
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+      if (!candidate[nid] || mirror[nid]) continue;
+      std::vector<uint32_t> step = {nid};
+      uint64_t step_flops = flops[nid];
+      size_t begin = 0;
+      for (int depth = 0; depth <= kMaxChain; ++depth) {
+        const int64_t delta = step_delta(step);
+        if (delta < 0) {
+          const double cost = static_cast<double>(step_flops) / -delta;
+          if (best.empty() || cost < best_cost) {
+            best = step;
+            best_cost = cost;
+          }
+        }
+        // the producers of the last added nodes whose outputs would be kept
+        const size_t end = step.size();
+        for (size_t k = begin; k < end; ++k) {
+          for (const auto& e : idx[step[k]].inputs) {
+            if (candidate[e.node_id] && !mirror[e.node_id] &&
+                in_step[e.node_id] != step_id && readers[idx.entry_id(e)] == 0) {
+              in_step[e.node_id] = step_id;
+              step.push_back(e.node_id);
+              step_flops += flops[e.node_id];
+            }
+          }
+        }
+        if (step.size() == end) break;
+        begin = end;
+      }
+    }
+    if (best.empty()) {
+      LOG(WARNING) << "Activation memory cannot fit in the mirror budget of "
+                   << (budget_bytes >> 20) << " MB, keeping " << (kept_bytes >> 20) << " MB";
+      break;
+    }
+    kept_bytes -= static_cast<size_t>(-step_delta(best));
+    for (uint32_t nid : best) {
+      mirror[nid] = 1;
+      for (uint32_t i = 0; i < idx[nid].source->num_outputs(); ++i) {
+        readers[idx.entry_id(nid, i)] = 0;
+      }
+    }
+    for (uint32_t nid : best) {
+      for (const auto& e : idx[nid].inputs) {
+        if (!idx[e.node_id].source->is_variable() && !mirror[e.node_id]) {
+          ++readers[idx.entry_id(e)];
+        }
+      }
+    }
+  }
+  if (planned_bytes != nullptr) *planned_bytes = kept_bytes;
+  return mirror;
+}
+
+}  // namespace exec
+}  // namespace mxnet
@@ -0,0 +1,186 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file nchwc_layout_pass.cc
+ * \brief Run chains of CPU convolution network operators in the blocked NCHWc layout.
+ */
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <nnvm/graph.h>
+#include <nnvm/graph_attr_types.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./exec_pass.h"
+#include "../operator/nchwc_op-inl.h"
+
+namespace mxnet {
+namespace exec {
+
+namespace {
+using nnvm::NodePtr;
+using nnvm::NodeEntry;
+
+// how a node is converted
+enum NCHWcKind {
+  kKeep,      // stays in NCHW
+  kReplace,   // replaced by the _nchwc_ version of the operator
+  kAgnostic   // elementwise, runs unchanged on NCHWc data
+};
+
+// elementwise operators that map finite values to finite values, so the
+// padded lanes stay finite.
+bool IsLayoutAgnostic(const std::string& name) {
+  // the registered names, aliases such as elemwise_sub or identity are not
+  // seen on the graph nodes
+  return name == "Activation" || name == "elemwise_add" || name == "_sub" ||
+      name == "_mul" || name == "_grad_add" || name == "_plus_scalar" ||
+      name == "_minus_scalar" || name == "_rminus_scalar" || name == "_mul_scalar" ||
+      name == "_copy";
+}
+}  // namespace
+
+Graph ConvertLayoutNCHWc(Graph g) {
+  static const Op* conv_op = Op::Get("Convolution");
+  static const Op* pool_op = Op::Get("Pooling");
+  static const Op* bn_op = Op::Get("BatchNorm");
+  static const std::unordered_map<const Op*, const Op*> replace_op = {
+    {conv_op, Op::Get("_nchwc_Convolution")},
+    {pool_op, Op::Get("_nchwc_Pooling")},
+    {bn_op, Op::Get("_nchwc_BatchNorm")}};
+  const int block = op::nchwc::kBlock;
+  const auto& idx = g.indexed_graph();
+  const auto& vshape = g.GetAttr<nnvm::ShapeVector>("shape");
+  const auto& vdtype = g.GetAttr<nnvm::DTypeVector>("dtype");
+  const uint32_t num_nodes = idx.num_nodes();
+  // the indexed graph is built with the same DFS order.
+  std::vector<NodePtr> nodes;
+  nodes.reserve(num_nodes);
+  nnvm::DFSVisit(g.outputs, [&nodes](const NodePtr& n) {
+      nodes.push_back(n);
+    });
+  CHECK_EQ(nodes.size(), num_nodes);
+
+  // only the first output of a converted node exists in the new graph.
+  std::vector<bool> extra_output_used(num_nodes, false);
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    for (const auto& e : idx[nid].inputs) {
+      if (e.index != 0) extra_output_used[e.node_id] = true;
+    }
+  }
+  for (const auto& e : idx.outputs()) {
+    if (e.index != 0) extra_output_used[e.node_id] = true;
+  }
+
+  auto is_nchw_float = [&](uint32_t eid) {
+    return vshape[eid].ndim() == 4 && vdtype[eid] == mshadow::kFloat32;
+  };
+  std::vector<int> kind(num_nodes, kKeep);
+  size_t num_replaced = 0;
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable() || inode.control_deps.size() != 0) continue;
+    if (extra_output_used[nid] || !is_nchw_float(idx.entry_id(nid, 0))) continue;
+    const Op* op = inode.source->op();
+    const auto& dict = inode.source->attrs.dict;
+    const auto& data = inode.inputs[0];
+    const bool data_blocked = kind[data.node_id] != kKeep;
+    if (!is_nchw_float(idx.entry_id(data))) continue;
+    if (op == conv_op) {
+      op::ConvolutionParam param;
+      param.InitAllowUnknown(dict);
+      if (param.kernel.ndim() != 2 || param.num_group != 1) continue;
+      if (param.layout.has_value() && param.layout.value() != mshadow::kNCHW) continue;
+      kind[nid] = kReplace;
+      ++num_replaced;
+    } else if (op == pool_op || op == bn_op) {
+      // not worth converting on their own
+      if (!data_blocked) continue;
+      if (op == pool_op) {
+        op::PoolingParam param;
+        param.InitAllowUnknown(dict);
+        if (param.kernel.ndim() != 2) continue;
+      }
+      kind[nid] = kReplace;
+    } else if (IsLayoutAgnostic(op->name)) {
+      bool all_blocked = true;
+      for (const auto& e : inode.inputs) {
+        all_blocked = all_blocked && kind[e.node_id] != kKeep &&
+            vshape[idx.entry_id(e)] == vshape[idx.entry_id(nid, 0)];
+      }
+      if (all_blocked) kind[nid] = kAgnostic;
+    }
+  }
+  if (num_replaced == 0) return g;
+
+  std::vector<NodePtr> new_nodes(num_nodes);
+  // conversion nodes, created once for each entry
+  std::unordered_map<uint32_t, NodePtr> to_nchwc, from_nchwc;
+  auto nchw_entry = [&](const nnvm::IndexedGraph::NodeEntry& e) {
+    if (kind[e.node_id] == kKeep) {
+      return NodeEntry{new_nodes[e.node_id], e.index, e.version};
+    }
+    NodePtr& n = from_nchwc[e.node_id];
+    if (n == nullptr) {
+      n = nnvm::Node::Create();
+      n->attrs.op = Op::Get("_from_nchwc");
+      n->attrs.name = idx[e.node_id].source->attrs.name + "_nchw";
+      n->attrs.dict["block"] = std::to_string(block);
+      n->attrs.dict["num_channel"] = std::to_string(vshape[idx.entry_id(e)][1]);
+      n->op()->attr_parser(&(n->attrs));
+      n->inputs.emplace_back(NodeEntry{new_nodes[e.node_id], 0, 0});
+    }
+    return NodeEntry{n, 0, 0};
+  };
+  auto nchwc_entry = [&](const nnvm::IndexedGraph::NodeEntry& e) {
+    if (kind[e.node_id] != kKeep) {
+      return NodeEntry{new_nodes[e.node_id], 0, 0};
+    }
+    NodePtr& n = to_nchwc[idx.entry_id(e)];
+    if (n == nullptr) {
+      n = nnvm::Node::Create();
+      n->attrs.op = Op::Get("_to_nchwc");
+      n->attrs.name = idx[e.node_id].source->attrs.name + "_nchwc";
+      n->attrs.dict["block"] = std::to_string(block);
+      n->op()->attr_parser(&(n->attrs));
+      n->inputs.emplace_back(nchw_entry(e));
+    }
+    return NodeEntry{n, 0, 0};
+  };
+
+  for (uint32_t nid = 0; nid < num_nodes; ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) {
+      new_nodes[nid] = nodes[nid];
+      continue;
+    }
+    NodePtr n = nnvm::Node::Create();
+    n->attrs = inode.source->attrs;
+    if (kind[nid] == kReplace) {
+      n->attrs.op = replace_op.at(inode.source->op());
+      n->op()->attr_parser(&(n->attrs));
+      // only the data is blocked, parameters keep their layout.
+      n->inputs.emplace_back(nchwc_entry(inode.inputs[0]));
+      for (size_t i = 1; i < inode.inputs.size(); ++i) {
+        n->inputs.emplace_back(nchw_entry(inode.inputs[i]));
+      }
+    } else {
+      for (const auto& e : inode.inputs) {
+        n->inputs.emplace_back(kind[nid] == kAgnostic ? nchwc_entry(e) : nchw_entry(e));
+      }
+    }
+    for (uint32_t c : inode.control_deps) {
+      n->control_deps.push_back(new_nodes[c]);
+    }
+    new_nodes[nid] = n;
+  }
+
+  Graph ret;
+  for (const auto& e : idx.outputs()) {
+    ret.outputs.emplace_back(nchw_entry(e));
+  }
+  return ret;
+}
+
+}  // namespace exec
+}  // namespace mxnet
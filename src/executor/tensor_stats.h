@@ -0,0 +1,88 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file tensor_stats.h
+ * \brief Scalar statistics of tensors computed by the executor monitor.
+ */
+#ifndef MXNET_EXECUTOR_TENSOR_STATS_H_
+#define MXNET_EXECUTOR_TENSOR_STATS_H_
+
+#include <dmlc/omp.h>
+#include <mxnet/base.h>
+#include <mxnet/executor.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace mxnet {
+namespace exec {
+
+/*! \brief number of statistics selected by the mask */
+inline int NumMonitorStats(int stat_mask) {
+  int n = 0;
+  for (int bit = 1; bit <= Executor::kMonitorMeanAbs; bit <<= 1) {
+    if (stat_mask & bit) ++n;
+  }
+  return n;
+}
+
+/*!
+ * \brief compute the statistics of a contiguous CPU buffer.
+ *  NaN and Inf are left out of min, max and mean_abs, which is the mean
+ *  over the finite elements.
+ * \param data the data.
+ * \param size number of elements.
+ * \param stat_mask bitwise or of Executor::MonitorStatType.
+ * \param out the selected statistics in the order of their bits.
+ */
+template<typename DType>
+inline void TensorStatsCPU(const DType* data, size_t size, int stat_mask, float* out) {
+  const int nthread = std::max(1, std::min(omp_get_max_threads(),
+                                           static_cast<int>(size >> 16)));
+  // per chunk partial results: sum of squares, min, max, nan, inf, sum of abs.
+  // the chunks do not depend on the size of the team the runtime gives.
+  std::vector<double> part(nthread * 6);
+  #pragma omp parallel for num_threads(nthread)
+  for (int chunk = 0; chunk < nthread; ++chunk) {
+    double sum_sq = 0, sum_abs = 0, nan = 0, inf = 0;
+    double vmin = std::numeric_limits<double>::infinity();
+    double vmax = -std::numeric_limits<double>::infinity();
+    const size_t begin = size * chunk / nthread, end = size * (chunk + 1) / nthread;
+    for (size_t i = begin; i < end; ++i) {
+      const double v = static_cast<float>(data[i]);
+      if (std::isnan(v)) {
+        nan += 1; continue;
+      }
+      sum_sq += v * v;
+      if (std::isinf(v)) {
+        inf += 1; continue;
+      }
+      vmin = std::min(vmin, v);
+      vmax = std::max(vmax, v);
+      sum_abs += std::abs(v);
+    }
+    double* p = &part[chunk * 6];
+    p[0] = sum_sq; p[1] = vmin; p[2] = vmax; p[3] = nan; p[4] = inf; p[5] = sum_abs;
+  }
+  double res[6] = {0, std::numeric_limits<double>::infinity(),
+                   -std::numeric_limits<double>::infinity(), 0, 0, 0};
+  for (int t = 0; t < nthread; ++t) {
+    const double* p = &part[t * 6];
+    res[0] += p[0];
+    res[1] = std::min(res[1], p[1]);
+    res[2] = std::max(res[2], p[2]);
+    res[3] += p[3];
+    res[4] += p[4];
+    res[5] += p[5];
+  }
+  res[0] = std::sqrt(res[0]);
+  const double num_finite = static_cast<double>(size) - res[3] - res[4];
+  res[5] = num_finite > 0 ? res[5] / num_finite : 0;
+  for (int k = 0; k < 6; ++k) {
+    if (stat_mask & (1 << k)) *out++ = static_cast<float>(res[k]);
+  }
+}
+
+}  // namespace exec
+}  // namespace mxnet
+#endif  // MXNET_EXECUTOR_TENSOR_STATS_H_
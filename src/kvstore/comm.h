@@ -77,9 +77,18 @@ class CommCPU : public Comm {
     if (src.size() == 1) {
       return src[0];
     }
+    auto& buf = merge_buf_[key];
+    if (src[0].storage_type() == kRowSparseStorage) {
+      // row sparse values are on CPU, the sum only stores the union of their rows
+      if (buf.merged_rsp.is_none()) {
+        buf.merged_rsp = NDArray(kRowSparseStorage, src[0].shape(), Context::CPU(),
+                                 src[0].dtype());
+      }
+      ElementwiseSum(src, &buf.merged_rsp, priority);
+      return buf.merged_rsp;
+    }
     std::vector<Engine::VarHandle> const_vars(src.size() - 1);
     std::vector<NDArray> reduce(src.size());
-    auto& buf = merge_buf_[key];
     CopyFromTo(src[0], &buf.merged, priority);
     reduce[0] = buf.merged;
 
@@ -183,6 +192,8 @@ class CommCPU : public Comm {
     NDArray merged;
     /// \brief the cpu buffer for gpu data
     std::vector<NDArray> copy_buf;
+    /// \brief the merged value of row sparse data
+    NDArray merged_rsp;
   };
   std::unordered_map<int, BufferEntry> merge_buf_;
   size_t bigarray_bound_;
@@ -213,6 +224,10 @@ class CommDevice : public Comm {
                         int priority) override {
     // avoid extra copy for single device, but it may bring problems for
     // abnormal usage of kvstore
+    for (const auto& a : src) {
+      CHECK_EQ(a.storage_type(), kDefaultStorage)
+          << "Row sparse values are only supported by the local kvstore";
+    }
     if (src.size() == 1) {
       return src[0];
     }
@@ -124,6 +124,13 @@ class KVStoreDist : public KVStoreLocal {
     }
   }
 
+  void PullRowSparse(const std::vector<int>& keys,
+                     const std::vector<NDArray*>& values,
+                     const std::vector<NDArray>& row_ids,
+                     int priority) override {
+    LOG(FATAL) << "PullRowSparse is only supported by the local kvstore";
+  }
+
   void set_updater(const Updater& updater) override {
     CHECK(updater) << "invalid updater";
     if (IsServerNode()) {
@@ -193,6 +200,10 @@ class KVStoreDist : public KVStoreLocal {
       // merge over devcies
       int key = uniq_keys[i];
       const auto& vals = grouped_vals[i];
+      for (const auto& v : vals) {
+        CHECK_EQ(v.storage_type(), kDefaultStorage)
+            << "Row sparse values are only supported by the local kvstore";
+      }
       NDArray merged = do_merge ? comm_->Reduce(key, vals, priority) : vals[0];
 
       auto& send_buf = comm_buf_[key];
@@ -13,6 +13,7 @@
 #include <utility>
 #include <algorithm>
 #include "./comm.h"
+#include "../operator/tensor/cast_storage-inl.h"
 
 namespace mxnet {
 namespace kvstore {
@@ -42,7 +43,10 @@ class KVStoreLocal : public KVStore {
     for (size_t i = 0; i < keys.size(); ++i) {
       CHECK(local_.find(keys[i]) == local_.end())
           << "duplicate init of key " << keys[i];
-      local_[keys[i]] = values[i].Copy(pinned_ctx_);
+      // the stored value is dense, the pushed values can be row sparse
+      NDArray& local = local_[keys[i]];
+      local = NDArray(values[i].shape(), pinned_ctx_, false, values[i].dtype());
+      CopyFromTo(values[i], &local);
       comm_->Init(keys[i], values[i].shape());
     }
   }
@@ -66,6 +70,8 @@ class KVStoreLocal : public KVStore {
           local = local.Copy(merged.ctx());
         }
         updater_(key, merged,  &local);
+      } else if (merged.storage_type() != kDefaultStorage) {
+        CopyFromTo(merged, &local, priority);
       } else {
         local = merged;
       }
@@ -87,6 +93,34 @@ class KVStoreLocal : public KVStore {
     }
   }
 
+  void PullRowSparse(const std::vector<int>& keys,
+                     const std::vector<NDArray*>& values,
+                     const std::vector<NDArray>& row_ids,
+                     int priority) override {
+    CHECK_EQ(keys.size(), values.size());
+    CHECK_EQ(keys.size(), row_ids.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      NDArray local = local_[keys[i]];
+      CHECK(!local.is_none()) << "key " << keys[i] << " has not been inited";
+      CHECK_EQ(values[i]->storage_type(), kRowSparseStorage)
+          << "PullRowSparse takes row sparse arrays";
+      CHECK_EQ(row_ids[i].storage_type(), kDefaultStorage);
+      // the rows are selected on CPU
+      if (local.ctx().dev_mask() != cpu::kDevMask) local = local.Copy(pinned_ctx_);
+      NDArray ids = row_ids[i];
+      if (ids.ctx().dev_mask() != cpu::kDevMask || !ids.is_contiguous()) {
+        ids = ids.Copy(Context::CPU());
+      }
+      NDArray out = *values[i];
+      std::vector<Engine::VarHandle> const_vars{local.var()};
+      if (ids.var() != local.var()) const_vars.push_back(ids.var());
+      Engine::Get()->PushSync([local, ids, out](RunContext rctx) {
+          op::RetainRows(local, ids.data(), out);
+        }, Context::CPU(), const_vars, {out.var()},
+        FnProperty::kNormal, priority, PROFILER_MESSAGE("KVStorePullRowSparse"));
+    }
+  }
+
  protected:
   /**
    * \brief group values on keys
@@ -0,0 +1,257 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file lazy_imperative.cc
+ * \brief Deferred execution of imperative operations.
+ */
+#include <dmlc/parameter.h>
+#include <mxnet/op_attr_types.h>
+#include <mxnet/operator.h>
+#include <nnvm/graph.h>
+#include <nnvm/symbolic.h>
+#include <algorithm>
+#include <map>
+#include <utility>
+#include "./lazy_imperative.h"
+#include "../executor/graph_executor.h"
+
+namespace mxnet {
+
+/*! \brief number of executors of recorded graphs kept for reuse */
+const size_t kMaxCachedGraphs = 32;
+
+void NDArray::FlushLazy() {
+  LazyImperative* lazy = LazyImperative::Get();
+  if (lazy->pending()) lazy->Flush();
+}
+
+LazyImperative* LazyImperative::Get() {
+  // never destructed, the pending arrays must not outlive the engine
+  static LazyImperative* inst = new LazyImperative();
+  return inst;
+}
+
+LazyImperative::LazyImperative()
+    : enabled_(dmlc::GetEnv("MXNET_IMPERATIVE_LAZY", false)),
+      max_nodes_(dmlc::GetEnv("MXNET_IMPERATIVE_LAZY_MAX_NODES", 128)) {}
+
+bool LazyImperative::SetEnabled(bool enabled) {
+  const bool prev = enabled_.exchange(enabled);
+  if (!enabled) Flush();
+  return prev;
+}
+
+// name of the variable holding the value of the i-th array before the segment
+inline std::string InputName(size_t i) {
+  return "lazy_in" + std::to_string(i);
+}
+
+bool LazyImperative::IsWholeChunk(const NDArray& arr) {
+  return arr.offset_ == 0 && arr.is_contiguous() &&
+      arr.storage_type() == kDefaultStorage &&
+      arr.shape_.Size() * mshadow::mshadow_sizeof(arr.dtype_) == arr.ptr_->shandle.size;
+}
+
+LazyImperative::ArrayRecord& LazyImperative::GetRecord(const NDArray& arr) {
+  auto it = segment_.index.find(arr.ptr_.get());
+  if (it != segment_.index.end()) return segment_.arrays[it->second];
+  // first use: the array is an input of the segment until it is written
+  ArrayRecord rec;
+  rec.array = arr;
+  nnvm::NodePtr var = nnvm::Node::Create();
+  var->attrs.op = nullptr;
+  var->attrs.name = InputName(segment_.arrays.size());
+  rec.entry = nnvm::NodeEntry{var, 0, 0};
+  arr.ptr_->lazy_pending = true;
+  segment_.index[arr.ptr_.get()] = segment_.arrays.size();
+  segment_.arrays.push_back(std::move(rec));
+  return segment_.arrays.back();
+}
+
+bool LazyImperative::Record(const nnvm::NodeAttrs& attrs, const Context& ctx,
+                            const std::vector<NDArray>& inputs,
+                            const std::vector<NDArray>& outputs) {
+  static auto& mutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+  static auto& fcpu = nnvm::Op::GetAttr<FCompute>("FCompute<cpu>");
+  static auto& fgpu = nnvm::Op::GetAttr<FCompute>("FCompute<gpu>");
+  static auto& createop = nnvm::Op::GetAttr<FCreateLayerOp>("FCreateLayerOp");
+  if (!enabled()) return false;
+  const nnvm::Op* op = attrs.op;
+  // operators writing their inputs would need them as auxiliary states
+  if (mutate.count(op)) return false;
+  const auto& fcompute = ctx.dev_mask() == cpu::kDevMask ? fcpu : fgpu;
+  if (!fcompute.count(op) && !createop.count(op)) return false;
+
+  bool full;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (const auto* arrays : {&inputs, &outputs}) {
+      for (const NDArray& arr : *arrays) {
+        if (!IsWholeChunk(arr) || arr.ctx() != ctx) return false;
+        // the graph cannot represent an array used with different shapes
+        auto it = segment_.index.find(arr.ptr_.get());
+        if (it != segment_.index.end()) {
+          const NDArray& rec = segment_.arrays[it->second].array;
+          if (rec.shape() != arr.shape() || rec.dtype() != arr.dtype()) return false;
+        }
+      }
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      for (size_t j = 0; j < i; ++j) {
+        if (outputs[i].ptr_ == outputs[j].ptr_) return false;
+      }
+    }
+    if (segment_.num_nodes != 0 && segment_.ctx != ctx) {
+      Segment seg;
+      std::swap(seg, segment_);
+      pending_ = false;
+      lock.unlock();
+      Run(std::move(seg));
+      lock.lock();
+    }
+    segment_.ctx = ctx;
+    nnvm::NodePtr node = nnvm::Node::Create();
+    node->attrs = attrs;
+    node->attrs.name = "lazy_op" + std::to_string(segment_.num_nodes++);
+    for (const NDArray& arr : inputs) {
+      ArrayRecord& rec = GetRecord(arr);
+      if (!rec.written) rec.readers.push_back(node);
+      node->inputs.push_back(rec.entry);
+    }
+    for (uint32_t i = 0; i < outputs.size(); ++i) {
+      ArrayRecord& rec = GetRecord(outputs[i]);
+      rec.entry = nnvm::NodeEntry{node, i, 0};
+      rec.written = true;
+    }
+    pending_ = true;
+    full = segment_.num_nodes >= max_nodes_;
+  }
+  if (full) Flush();
+  return true;
+}
+
+void LazyImperative::Flush() {
+  Segment seg;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segment_.num_nodes == 0) return;
+    std::swap(seg, segment_);
+    pending_ = false;
+  }
+  Run(std::move(seg));
+}
+
+// append the raw bytes of a value to a cache key
+template<typename T>
+inline void AppendKey(std::string* key, const T& value) {
+  key->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void AppendKey(std::string* key, const std::string& value) {
+  AppendKey(key, value.size());
+  key->append(value);
+}
+
+/*!
+ * \brief the structure of the recorded graph: the operators, their
+ *  attributes and how they are connected, without the names, and the shapes
+ *  and types of the inputs, which determine the other ones.
+ */
+std::string StructureKey(const nnvm::Symbol& sym, const Context& ctx,
+                         const std::vector<NDArray>& args) {
+  std::string key;
+  std::unordered_map<const nnvm::Node*, uint32_t> nid;
+  std::vector<std::pair<std::string, std::string> > dict;
+  nnvm::DFSVisit(sym.outputs, [&](const nnvm::NodePtr& n) {
+      nid[n.get()] = static_cast<uint32_t>(nid.size());
+      AppendKey(&key, n->op());
+      dict.assign(n->attrs.dict.begin(), n->attrs.dict.end());
+      std::sort(dict.begin(), dict.end());
+      AppendKey(&key, dict.size());
+      for (const auto& kv : dict) {
+        AppendKey(&key, kv.first);
+        AppendKey(&key, kv.second);
+      }
+      AppendKey(&key, n->inputs.size());
+      for (const auto& e : n->inputs) {
+        AppendKey(&key, nid.at(e.node.get()));
+        AppendKey(&key, e.index);
+      }
+      AppendKey(&key, n->control_deps.size());
+      for (const auto& dep : n->control_deps) AppendKey(&key, nid.at(dep.get()));
+    });
+  for (const auto& e : sym.outputs) {
+    AppendKey(&key, nid.at(e.node.get()));
+    AppendKey(&key, e.index);
+  }
+  AppendKey(&key, ctx.dev_type);
+  AppendKey(&key, ctx.dev_id);
+  for (const NDArray& arr : args) {
+    AppendKey(&key, arr.dtype());
+    AppendKey(&key, arr.shape().ndim());
+    for (index_t d : arr.shape()) AppendKey(&key, d);
+  }
+  return key;
+}
+
+void LazyImperative::Run(Segment&& seg) {
+  for (auto& rec : seg.arrays) {
+    rec.array.ptr_->lazy_pending = false;
+  }
+  // only the arrays still referenced outside the segment are computed, the
+  // executor writes them directly
+  nnvm::Symbol sym;
+  std::vector<NDArray> dst;
+  for (auto& rec : seg.arrays) {
+    if (rec.written && rec.array.ptr_.use_count() > 1) {
+      sym.outputs.push_back(rec.entry);
+      dst.push_back(rec.array);
+      // the array is overwritten after its value before the segment is read
+      const nnvm::NodePtr& writer = rec.entry.node;
+      for (const nnvm::NodePtr& reader : rec.readers) {
+        if (reader != writer) writer->control_deps.push_back(reader);
+      }
+    }
+  }
+  if (dst.size() == 0) return;
+  const std::vector<std::string> arg_names = sym.ListInputNames(nnvm::Symbol::kReadOnlyArgs);
+  CHECK_EQ(sym.ListInputNames(nnvm::Symbol::kAuxiliaryStates).size(), 0U);
+  // the inputs are the values of the arrays before the segment
+  std::vector<NDArray> args;
+  {
+    std::unordered_map<std::string, const NDArray*> inputs;
+    for (size_t i = 0; i < seg.arrays.size(); ++i) {
+      inputs[InputName(i)] = &seg.arrays[i].array;
+    }
+    for (const auto& name : arg_names) args.push_back(*inputs.at(name));
+  }
+  for (const NDArray& arr : dst) arr.CheckAndAlloc();
+
+  // the same segment is recorded in every iteration of a loop, its shapes and
+  // types are only inferred again by the executor when it is not cached
+  const std::string key = StructureKey(sym, seg.ctx, args);
+  std::shared_ptr<CachedGraph> cached;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+      cached = it->second;
+    } else {
+      if (cache_.size() >= kMaxCachedGraphs) cache_.clear();
+      cached = std::make_shared<CachedGraph>();
+      cache_[key] = cached;
+    }
+  }
+  std::lock_guard<std::mutex> lock(cached->mutex);
+  if (cached->exec == nullptr) {
+    std::vector<NDArray> grads(args.size());
+    std::vector<OpReqType> grad_reqs(args.size(), kNullOp);
+    cached->exec.reset(new exec::GraphExecutor());
+    cached->exec->Init(sym, seg.ctx, std::map<std::string, Context>(), args, grads, grad_reqs,
+                       std::vector<NDArray>(), nullptr, dst);
+  } else {
+    cached->exec->Rebind(args, dst);
+  }
+  cached->exec->Forward(false);
+}
+
+}  // namespace mxnet
@@ -0,0 +1,105 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file lazy_imperative.h
+ * \brief Deferred execution of imperative operations.
+ *
+ *  In lazy mode, imperative operations are recorded into a graph instead of
+ *  being pushed to the engine one by one. The recorded segment runs through
+ *  a graph executor, with its memory planning and cached operators, when
+ *  one of its arrays is used by anything else (waits, copies, executors,
+ *  non recorded operations all go through NDArray::var), when the segment
+ *  reaches its size limit, or when an operation on another device comes.
+ */
+#ifndef MXNET_NDARRAY_LAZY_IMPERATIVE_H_
+#define MXNET_NDARRAY_LAZY_IMPERATIVE_H_
+
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <nnvm/node.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+namespace exec {
+class GraphExecutor;
+}  // namespace exec
+
+/*! \brief recorder and runner of the deferred imperative operations */
+class LazyImperative {
+ public:
+  /*! \return the singleton */
+  static LazyImperative* Get();
+  /*! \return whether operations are deferred */
+  inline bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+  /*!
+   * \brief enable or disable lazy mode. Disabling it runs the pending operations.
+   * \return the previous state.
+   */
+  bool SetEnabled(bool enabled);
+  /*!
+   * \brief record an imperative operation whose outputs are already created
+   *  with their inferred shapes and types.
+   * \return false if the operation cannot be deferred and must be pushed now.
+   */
+  bool Record(const nnvm::NodeAttrs& attrs, const Context& ctx,
+              const std::vector<NDArray>& inputs,
+              const std::vector<NDArray>& outputs);
+  /*! \brief push the pending operations to the engine */
+  void Flush();
+  /*! \return whether there are pending operations */
+  inline bool pending() const {
+    return pending_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  /*! \brief an array used by the segment */
+  struct ArrayRecord {
+    /*! \brief reference to the array, keeps the chunk alive */
+    NDArray array;
+    /*! \brief the current value of the array in the graph */
+    nnvm::NodeEntry entry;
+    /*! \brief the nodes reading the value of the array before the segment */
+    std::vector<nnvm::NodePtr> readers;
+    /*! \brief whether the segment writes the array */
+    bool written{false};
+  };
+  /*! \brief the recorded operations */
+  struct Segment {
+    Context ctx;
+    size_t num_nodes{0};
+    std::vector<ArrayRecord> arrays;
+    std::unordered_map<const NDArray::Chunk*, size_t> index;
+  };
+  /*!
+   * \brief executor of a segment, bound to the arrays of its last run, which
+   *  it keeps alive until the next one
+   */
+  struct CachedGraph {
+    /*! \brief one run at a time binds and runs the executor */
+    std::mutex mutex;
+    std::unique_ptr<exec::GraphExecutor> exec;
+  };
+  LazyImperative();
+  // whether the array is a whole chunk, views are not recorded
+  static bool IsWholeChunk(const NDArray& arr);
+  // the record of an array, created on first use
+  ArrayRecord& GetRecord(const NDArray& arr);
+  // run a segment taken out of the recorder
+  void Run(Segment&& seg);
+
+  std::atomic<bool> enabled_;
+  std::atomic<bool> pending_{false};
+  size_t max_nodes_;
+  std::mutex mutex_;
+  Segment segment_;
+  std::unordered_map<std::string, std::shared_ptr<CachedGraph> > cache_;
+};
+
+}  // namespace mxnet
+#endif  // MXNET_NDARRAY_LAZY_IMPERATIVE_H_
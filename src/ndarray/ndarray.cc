@@ -11,6 +11,8 @@
 #include <mxnet/resource.h>
 #include <mshadow/tensor.h>
 #include "./ndarray_function.h"
+#include "../operator/tensor/cast_storage-inl.h"
+#include "../operator/tensor/elemwise_sum.h"
 
 #if MXNET_USE_OPENCV
 #include <opencv2/opencv.hpp>
@@ -231,7 +233,101 @@ void ScalarOp(const NDArray &lhs,
   }
 }
 
+// copy when at least one of the arrays is a strided view
+void StridedCopyFromTo(const NDArray &from, NDArray *to, int priority) {
+  CHECK(from.shape() == to->shape())
+      << "operands shape mismatch"
+      << "from.shape = " << from.shape() << " to.shape=" << to->shape();
+  if (from.ctx().dev_mask() != to->ctx().dev_mask() || from.dtype() != to->dtype()) {
+    // the conversion is done by the contiguous copy
+    NDArray src = from.Compact();
+    if (to->is_contiguous()) {
+      CopyFromTo(src, to, priority);
+    } else {
+      NDArray tmp(to->shape(), to->ctx(), true, to->dtype());
+      CopyFromTo(src, &tmp, priority);
+      StridedCopyFromTo(tmp, to, priority);
+    }
+    return;
+  }
+  if (from.var() == to->var()) {
+    // views of the same chunk may overlap
+    NDArray tmp(from.shape(), from.ctx(), true, from.dtype());
+    CopyFromTo(from, &tmp, priority);
+    StridedCopyFromTo(tmp, to, priority);
+    return;
+  }
+  const TShape to_strides = to->strides();
+  for (index_t i = 0; i < to_strides.ndim(); ++i) {
+    CHECK(to_strides[i] != 0 || to->shape()[i] == 1)
+        << "Cannot write to a broadcast NDArray view";
+  }
+  // important: callback must always capture by value
+  NDArray ret = *to;
+  switch (ret.ctx().dev_mask()) {
+    case cpu::kDevMask: {
+      Engine::Get()->PushSync([from, ret](RunContext ctx) {
+          ret.CheckAndAlloc();
+          ndarray::StridedCopy<cpu>(from.dptr(), from.strides(), ret.dptr(), ret.strides(),
+                                    ret.shape(), ret.dtype(), ctx);
+        }, from.ctx(), {from.var()}, {ret.var()},
+        FnProperty::kNormal, priority, PROFILER_MESSAGE("StridedCopyCPU"));
+      break;
+    }
+#if MXNET_USE_CUDA
+    case gpu::kDevMask: {
+      Engine::Get()->PushSync([from, ret](RunContext ctx) {
+          ret.CheckAndAlloc();
+          ndarray::StridedCopy<gpu>(from.dptr(), from.strides(), ret.dptr(), ret.strides(),
+                                    ret.shape(), ret.dtype(), ctx);
+          // Wait GPU kernel to complete
+          ctx.get_stream<gpu>()->Wait();
+        }, from.ctx(), {from.var()}, {ret.var()},
+        FnProperty::kNormal, priority, PROFILER_MESSAGE("StridedCopyGPU"));
+      break;
+    }
+#endif
+    default: LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
+  }
+}
+
+// copy when at least one of the arrays is sparse, converting the storage type
+void SparseCopyFromTo(const NDArray &from, NDArray *to, int priority) {
+  CHECK(from.shape() == to->shape())
+      << "operands shape mismatch"
+      << "from.shape = " << from.shape() << " to.shape=" << to->shape();
+  // the sparse arrays are on CPU, dense arrays elsewhere go through a CPU copy
+  if (from.ctx().dev_mask() != cpu::kDevMask || !from.is_contiguous() ||
+      from.dtype() != to->dtype()) {
+    NDArray tmp(from.shape(), Context::CPU(), true, to->dtype());
+    CopyFromTo(from, &tmp, priority);
+    SparseCopyFromTo(tmp, to, priority);
+    return;
+  }
+  if (to->ctx().dev_mask() != cpu::kDevMask || !to->is_contiguous()) {
+    NDArray tmp(to->shape(), Context::CPU(), true, to->dtype());
+    SparseCopyFromTo(from, &tmp, priority);
+    CopyFromTo(tmp, to, priority);
+    return;
+  }
+  if (from.var() == to->var()) return;
+  // important: callback must always capture by value
+  NDArray ret = *to;
+  Engine::Get()->PushSync([from, ret](RunContext ctx) {
+      op::CastStorageComputeImpl(from, ret);
+    }, from.ctx(), {from.var()}, {ret.var()},
+    FnProperty::kNormal, priority, PROFILER_MESSAGE("SparseCopyCPU"));
+}
+
 void CopyFromTo(const NDArray &from, NDArray *to, int priority) {
+  if (from.storage_type() != kDefaultStorage || to->storage_type() != kDefaultStorage) {
+    SparseCopyFromTo(from, to, priority);
+    return;
+  }
+  if (!from.is_contiguous() || !to->is_contiguous()) {
+    StridedCopyFromTo(from, to, priority);
+    return;
+  }
   if (from.var() == to->var()) {
     // skip to copy to itself
     return;
@@ -300,6 +396,21 @@ void CopyFromTo(const NDArray &from, NDArray *to, int priority) {
 }
 
 void ElementwiseSum(const std::vector<NDArray> &source, NDArray *out, int priority) {
+  if (out->storage_type() == kRowSparseStorage) {
+    std::vector<Engine::VarHandle> const_vars;
+    for (const NDArray& src : source) {
+      CHECK_EQ(src.storage_type(), kRowSparseStorage)
+          << "The sum into a row sparse array takes row sparse arrays";
+      CHECK_EQ(src.shape(), out->shape()) << "operands shape mismatch";
+      if (src.var() != out->var()) const_vars.push_back(src.var());
+    }
+    NDArray ret = *out;
+    Engine::Get()->PushSync([source, ret](RunContext ctx) {
+        op::ElementWiseSumRowSparse(source, ret);
+      }, out->ctx(), const_vars, {ret.var()},
+      FnProperty::kNormal, priority, PROFILER_MESSAGE("RowSparseElementwiseSum"));
+    return;
+  }
   std::vector<Engine::VarHandle> const_vars;
   const_vars.reserve(source.size());
   for (size_t i = 0; i < source.size(); ++i) {
@@ -591,6 +702,13 @@ void Broadcast(const NDArray& src, int dim, int size, NDArray *out) {
 }
 
 void NDArray::Save(dmlc::Stream *strm) const {
+  // sparse arrays are saved dense
+  if (!is_contiguous() || (!is_none() && storage_type() != kDefaultStorage)) {
+    NDArray dense(shape_, ctx(), true, dtype_);
+    CopyFromTo(*this, &dense);
+    dense.Save(strm);
+    return;
+  }
   // save shape
   shape_.Save(strm);
   if (is_none()) return;
@@ -677,18 +795,151 @@ void NDArray::Load(dmlc::Stream* fi,
       << "Invalid NDArray file format";
 }
 
+void NDArray::NormalizeStrides() {
+  index_t stride = 1;
+  for (index_t i = shape_.ndim(); i != 0; --i) {
+    if (shape_[i - 1] != 1 && strides_[i - 1] != stride) return;
+    stride *= shape_[i - 1];
+  }
+  strides_ = TShape();
+}
+
+NDArray NDArray::SliceAxis(index_t axis, index_t begin, index_t end) const {
+  CHECK(!is_none()) << "NDArray is not initialized";
+  CHECK_EQ(storage_type(), kDefaultStorage) << "Cannot slice a sparse NDArray";
+  CHECK_LT(axis, shape_.ndim()) << "Slice axis out of range";
+  CHECK(begin < end && end <= shape_[axis]) << "Slice index out of range";
+  if (axis == 0 && is_contiguous()) return Slice(begin, end);
+  NDArray ret = *this;
+  ret.strides_ = strides();
+  ret.offset_ += begin * ret.strides_[axis];
+  ret.shape_[axis] = end - begin;
+  ret.NormalizeStrides();
+  return ret;
+}
+
+NDArray NDArray::Transpose(const TShape& axes) const {
+  CHECK(!is_none()) << "NDArray is not initialized";
+  CHECK_EQ(storage_type(), kDefaultStorage) << "Cannot transpose a sparse NDArray view";
+  CHECK_EQ(axes.ndim(), shape_.ndim()) << "Transpose axes must cover all the axes";
+  const TShape old_strides = strides();
+  std::vector<bool> seen(axes.ndim(), false);
+  NDArray ret = *this;
+  ret.strides_ = old_strides;
+  for (index_t i = 0; i < axes.ndim(); ++i) {
+    CHECK(axes[i] < axes.ndim() && !seen[axes[i]])
+      << "Transpose axes must be a permutation, got " << axes;
+    seen[axes[i]] = true;
+    ret.shape_[i] = shape_[axes[i]];
+    ret.strides_[i] = old_strides[axes[i]];
+  }
+  ret.NormalizeStrides();
+  return ret;
+}
+
+NDArray NDArray::BroadcastTo(const TShape& shape) const {
+  CHECK(!is_none()) << "NDArray is not initialized";
+  CHECK_EQ(storage_type(), kDefaultStorage) << "Cannot broadcast a sparse NDArray view";
+  CHECK_EQ(shape.ndim(), shape_.ndim()) << "BroadcastTo keeps the number of dimensions";
+  NDArray ret = *this;
+  ret.strides_ = strides();
+  for (index_t i = 0; i < shape.ndim(); ++i) {
+    if (shape_[i] == shape[i]) continue;
+    CHECK_EQ(shape_[i], 1U) << "Cannot broadcast " << shape_ << " to " << shape;
+    ret.strides_[i] = 0;
+  }
+  ret.shape_ = shape;
+  ret.NormalizeStrides();
+  return ret;
+}
+
+NDArray NDArray::Compact() const {
+  if (is_contiguous()) return *this;
+  NDArray ret(shape_, ctx(), true, dtype_);
+  CopyFromTo(*this, &ret);
+  return ret;
+}
+
 NDArray NDArray::Copy(Context ctx) const {
-  NDArray ret(shape(), ctx, true, dtype_);
+  NDArray ret = storage_type() == kDefaultStorage ?
+      NDArray(shape(), ctx, true, dtype_) : NDArray(storage_type(), shape(), ctx, dtype_);
   CopyFromTo(*this, &ret);
   return ret;
 }
 
+void NDArray::SetSparseData(const NDArray &data, const std::vector<NDArray> &aux) const {
+  CHECK_NE(storage_type(), kDefaultStorage) << "SetSparseData takes a sparse NDArray";
+  CHECK_EQ(aux.size(), num_aux()) << "Wrong number of index arrays";
+  CHECK_EQ(data.dtype(), dtype_) << "The stored values must have the data type of the array";
+  const TShape& dshape = data.shape();
+  if (storage_type() == kRowSparseStorage) {
+    CHECK_EQ(dshape.ndim(), shape_.ndim()) << "The stored rows must have the row shape";
+    for (index_t i = 1; i < dshape.ndim(); ++i) {
+      CHECK_EQ(dshape[i], shape_[i]) << "The stored rows must have the row shape";
+    }
+    CHECK_EQ(aux[rowsparse::kIdx].shape().Size(), dshape[0])
+        << "There must be one index for every stored row";
+  } else {
+    CHECK_EQ(dshape.ndim(), 1U) << "The stored values of a csr matrix are a vector";
+    CHECK_EQ(aux[csr::kIndPtr].shape().Size(), shape_[0] + 1)
+        << "The row pointers of a csr matrix must have num_rows + 1 elements";
+    CHECK_EQ(aux[csr::kIdx].shape().Size(), dshape[0])
+        << "There must be one column index for every stored value";
+  }
+  std::vector<NDArray> src{data};
+  std::vector<Engine::VarHandle> const_vars{data.var()};
+  for (const NDArray& idx : aux) {
+    CHECK_EQ(idx.dtype(), kSparseIndexTypeFlag) << "The indices must be int32";
+    CHECK_EQ(idx.ctx().dev_mask(), cpu::kDevMask) << "The indices must be on CPU";
+    src.push_back(idx);
+    const_vars.push_back(idx.var());
+  }
+  CHECK_EQ(data.ctx().dev_mask(), cpu::kDevMask) << "The stored values must be on CPU";
+  NDArray ret = *this;
+  Engine::Get()->PushSync([src, ret](RunContext ctx) {
+      std::vector<TShape> aux_shapes;
+      for (size_t i = 1; i < src.size(); ++i) {
+        aux_shapes.emplace_back(mshadow::Shape1(src[i].shape().Size()));
+      }
+      ret.CheckAndAlloc(src[0].shape(), aux_shapes);
+      for (size_t i = 0; i < src.size(); ++i) {
+        TBlob to = i == 0 ? ret.data() : ret.aux_data(i - 1);
+        std::memcpy(to.dptr_, src[i].data().dptr_,
+                    src[i].shape().Size() * mshadow::mshadow_sizeof(src[i].dtype()));
+      }
+    }, ctx(), const_vars, {ret.var()},
+    FnProperty::kNormal, 0, PROFILER_MESSAGE("SetSparseData"));
+}
+
+NDArray NDArray::GetSparseData(int i) const {
+  CHECK_NE(storage_type(), kDefaultStorage) << "GetSparseData takes a sparse NDArray";
+  CHECK_LT(i, static_cast<int>(num_aux()));
+  this->WaitToRead();
+  const TBlob src = i < 0 ? data() : aux_data(i);
+  NDArray ret(src.shape_, ctx(), src.shape_.Size() == 0, src.type_flag_);
+  if (src.shape_.Size() != 0) {
+    std::memcpy(ret.data().dptr_, src.dptr_,
+                src.shape_.Size() * mshadow::mshadow_sizeof(src.type_flag_));
+  }
+  return ret;
+}
+
 void NDArray::SyncCopyFromCPU(const void *data, size_t size) const {
   TShape dshape = this->shape();
   CHECK_EQ(dshape.Size(), size)
       << "Memory size do not match";
   TBlob src((void*)data, dshape, cpu::kDevMask, this->dtype_); // NOLINT(*)
 
+  CHECK_EQ(storage_type(), kDefaultStorage)
+      << "Cannot copy dense data into a sparse NDArray, use SetSparseData";
+  if (!is_contiguous()) {
+    NDArray tmp(dshape, this->ctx(), false, this->dtype_);
+    tmp.SyncCopyFromCPU(data, size);
+    NDArray dst = *this;
+    CopyFromTo(tmp, &dst);
+    dst.WaitToRead();
+    return;
+  }
   if (this->ctx().dev_mask() == cpu::kDevMask) {
     this->WaitToWrite();
     this->CheckAndAlloc();
@@ -720,6 +971,16 @@ void NDArray::SyncCopyToCPU(void *data, size_t size) const {
       << "Memory size do not match";
   TBlob dst(data, dshape, cpu::kDevMask, this->dtype_); // NOLINT(*)
 
+  if (storage_type() != kDefaultStorage) {
+    NDArray dense(dshape, ctx(), true, dtype_);
+    CopyFromTo(*this, &dense);
+    dense.SyncCopyToCPU(data, size);
+    return;
+  }
+  if (!is_contiguous()) {
+    this->Compact().SyncCopyToCPU(data, size);
+    return;
+  }
   if (this->ctx().dev_mask() == cpu::kDevMask) {
     this->WaitToRead();
     RunContext rctx;
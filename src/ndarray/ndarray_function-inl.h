@@ -8,6 +8,7 @@
 
 #include <vector>
 #include "./ndarray_function.h"
+#include "../operator/mxnet_op.h"
 // this file will be included twice by CPU and GPU
 // macro to help specialize evaluation function
 
@@ -210,6 +211,7 @@ void Eval<DEVICE>(const real_t &rhs, TBlob *ret, RunContext ctx) {
   });
 }
 
+#if defined(__CUDACC__)
 template<>
 void ElementwiseSum<DEVICE>(const std::vector<TBlob> source,
                             TBlob *dst,
@@ -258,6 +260,46 @@ void ElementwiseSum<DEVICE>(const std::vector<TBlob> source,
     }
   });
 }
+#endif  // defined(__CUDACC__)
+
+/*! \brief copy of the i-th element in row-major order of a strided array */
+struct strided_copy {
+  template<typename DType>
+  MSHADOW_XINLINE static void Map(int i, DType *to, const DType *from, int ndim,
+                                  mshadow::Shape<kStridedCopyMaxDim> shape,
+                                  mshadow::Shape<kStridedCopyMaxDim> from_strides,
+                                  mshadow::Shape<kStridedCopyMaxDim> to_strides) {
+    index_t idx = i, src = 0, dst = 0;
+    for (int k = ndim - 1; k >= 0; --k) {
+      const index_t j = idx % shape[k];
+      idx /= shape[k];
+      src += j * from_strides[k];
+      dst += j * to_strides[k];
+    }
+    to[dst] = from[src];
+  }
+};
+
+template<>
+void StridedCopy<DEVICE>(const void *from, const TShape &from_strides,
+                         void *to, const TShape &to_strides,
+                         const TShape &shape, int dtype, RunContext ctx) {
+  using namespace mxnet::op::mxnet_op;
+  CHECK_LE(shape.ndim(), kStridedCopyMaxDim)
+    << "Strided copies support up to " << kStridedCopyMaxDim << " dimensions";
+  mshadow::Shape<kStridedCopyMaxDim> s, fs, ts;
+  for (index_t k = 0; k < shape.ndim(); ++k) {
+    s[k] = shape[k];
+    fs[k] = from_strides[k];
+    ts[k] = to_strides[k];
+  }
+  mshadow::Stream<DEVICE> *stream = ctx.get_stream<DEVICE>();
+  MSHADOW_TYPE_SWITCH(dtype, DType, {
+    Kernel<strided_copy, DEVICE>::Launch(stream, shape.Size(), static_cast<DType*>(to),
+                                         static_cast<const DType*>(from),
+                                         static_cast<int>(shape.ndim()), s, fs, ts);
+  });
+}
 
 template <>
 void EvalBroadcast<DEVICE>(TBlob const& src, TBlob* ret, int size, RunContext ctx) {
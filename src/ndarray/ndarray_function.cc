@@ -7,6 +7,7 @@
 // this will be invoked by gcc and compile CPU version
 #include "./ndarray_function.h"
 #include "./ndarray_function-inl.h"
+#include "../operator/tensor/elemwise_sum.h"
 
 namespace mxnet {
 namespace ndarray {
@@ -26,5 +27,14 @@ void Copy<cpu, cpu>(const TBlob &from, TBlob *to,
     }
   })
 }
+
+template<>
+void ElementwiseSum<cpu>(const std::vector<TBlob> source,
+                         TBlob *dst,
+                         RunContext ctx) {
+  MSHADOW_TYPE_SWITCH(dst->type_flag_, DType, {
+    op::ElementWiseSumCPU<DType>(source, kWriteTo, *dst);
+  });
+}
 }  // namespace ndarray
 }  // namespace mxnet
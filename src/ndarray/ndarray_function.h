@@ -136,6 +136,15 @@ void ElementwiseSum(const std::vector<TBlob> source,
                     TBlob *out,
                     RunContext ctx);
 
+/*! \brief maximum number of dimensions of a strided copy */
+const int kStridedCopyMaxDim = 6;
+
+// copy between arrays of the same device and type, with any strides in elements
+template<typename Device>
+void StridedCopy(const void *from, const TShape &from_strides,
+                 void *to, const TShape &to_strides,
+                 const TShape &shape, int dtype, RunContext ctx);
+
 // broadcasting
 template <typename Device>
 void EvalBroadcast(TBlob const& src, TBlob* ret, int size, RunContext ctx);
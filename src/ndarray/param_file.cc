@@ -0,0 +1,277 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file param_file.cc
+ * \brief Chunked parameter file with an index and per tensor checksums.
+ */
+#include <dmlc/logging.h>
+#include <dmlc/memory_io.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include "./param_file.h"
+
+namespace mxnet {
+
+namespace {
+/*! \brief tables of the slicing-by-4 CRC32 */
+struct CRC32Table {
+  uint32_t t[4][256];
+  CRC32Table() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+      }
+      t[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (int k = 1; k < 4; ++k) {
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+      }
+    }
+  }
+};
+
+inline uint64_t AlignUp(uint64_t size) {
+  return (size + kParamFileAlign - 1) / kParamFileAlign * kParamFileAlign;
+}
+
+/*! \brief magic, reserved, number of tensors and size of the index */
+const size_t kHeaderSize = 4 * sizeof(uint64_t);
+
+// the path of a local file name, empty for the other streams
+inline std::string LocalPath(const std::string& fname) {
+  const size_t pos = fname.find("://");
+  if (pos == std::string::npos) return fname;
+  if (fname.compare(0, pos, "file") == 0) return fname.substr(pos + 3);
+  return std::string();
+}
+}  // namespace
+
+uint32_t ParamFileCRC32(const void* data, size_t size, uint32_t crc) {
+  static const CRC32Table table;
+  const uint32_t (&t)[4][256] = table.t;
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  for (; size >= 4; size -= 4, p += 4) {
+    crc ^= static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+        static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+    crc = t[3][crc & 0xFF] ^ t[2][(crc >> 8) & 0xFF] ^
+        t[1][(crc >> 16) & 0xFF] ^ t[0][crc >> 24];
+  }
+  for (; size != 0; --size, ++p) {
+    crc = t[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+ParamFileWriter::ParamFileWriter(const std::string& fname,
+                                 const std::vector<NDArray>& data,
+                                 const std::vector<std::string>& names)
+    : fname_(fname), names_(names) {
+  CHECK(names.size() == 0 || names.size() == data.size())
+    << "The number of names must match the number of arrays";
+  names_.resize(data.size());
+  for (const NDArray& arr : data) {
+    // the engine runs the copy before any later write to the array
+    if (arr.is_none()) {
+      snapshot_.emplace_back();
+      ctx_.emplace_back(Context::CPU());
+    } else {
+      // sparse arrays are written dense
+      NDArray snapshot(arr.shape(), Context::CPU(), true, arr.dtype());
+      CopyFromTo(arr, &snapshot);
+      snapshot_.push_back(snapshot);
+      ctx_.push_back(arr.ctx());
+    }
+  }
+  thread_ = std::thread([this]() {
+      try {
+        this->Write();
+      } catch (...) {
+        error_ = std::current_exception();
+      }
+    });
+}
+
+ParamFileWriter::~ParamFileWriter() {
+  if (thread_.joinable()) thread_.join();
+  if (error_) {
+    try {
+      std::rethrow_exception(error_);
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "Failed to save " << fname_ << ": " << e.what();
+    } catch (...) {
+      LOG(WARNING) << "Failed to save " << fname_;
+    }
+  }
+}
+
+void ParamFileWriter::Wait() {
+  if (thread_.joinable()) thread_.join();
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void ParamFileWriter::Write() {
+  const size_t num = snapshot_.size();
+  std::vector<uint64_t> sizes(num, 0);
+  for (size_t i = 0; i < num; ++i) {
+    if (snapshot_[i].is_none()) continue;
+    snapshot_[i].WaitToRead();
+    sizes[i] = snapshot_[i].shape().Size() * mshadow::mshadow_sizeof(snapshot_[i].dtype());
+  }
+  std::vector<uint32_t> crc(num, 0);
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < static_cast<int>(num); ++i) {
+    if (sizes[i] != 0) crc[i] = ParamFileCRC32(snapshot_[i].data().dptr_, sizes[i]);
+  }
+
+  std::string index;
+  {
+    dmlc::MemoryStringStream strm(&index);
+    uint64_t offset = 0;
+    for (size_t i = 0; i < num; ++i) {
+      strm.Write(names_[i]);
+      snapshot_[i].shape().Save(&strm);
+      int32_t dtype = snapshot_[i].is_none() ? -1 : snapshot_[i].dtype();
+      strm.Write(&dtype, sizeof(dtype));
+      ctx_[i].Save(&strm);
+      strm.Write(&offset, sizeof(offset));
+      strm.Write(&sizes[i], sizeof(sizes[i]));
+      strm.Write(&crc[i], sizeof(crc[i]));
+      offset += AlignUp(sizes[i]);
+    }
+  }
+  // remote streams have no rename, they are written in place
+  const std::string local = LocalPath(fname_);
+  const std::string tmp = local.empty() ? fname_ : local + ".tmp";
+  try {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(tmp.c_str(), "w"));
+    const uint64_t header[4] = {kParamFileMagic, 0, num, index.size()};
+    fo->Write(header, sizeof(header));
+    fo->Write(index.data(), index.size());
+    const std::string padding(kParamFileAlign, '\0');
+    size_t written = kHeaderSize + index.size();
+    for (size_t i = 0; i < num; ++i) {
+      fo->Write(padding.data(), AlignUp(written) - written);
+      written = AlignUp(written);
+      if (sizes[i] == 0) continue;
+      fo->Write(snapshot_[i].data().dptr_, sizes[i]);
+      written += sizes[i];
+      // release the snapshot as soon as it is written
+      snapshot_[i] = NDArray();
+    }
+  } catch (...) {
+    if (!local.empty()) std::remove(tmp.c_str());
+    throw;
+  }
+  if (!local.empty()) {
+#ifdef _WIN32
+    // rename does not replace an existing file on windows
+    std::remove(local.c_str());
+#endif
+    CHECK_EQ(std::rename(tmp.c_str(), local.c_str()), 0)
+      << "Cannot rename " << tmp << " to " << local << ": " << strerror(errno);
+  }
+}
+
+bool ParamFile::Probe(const std::string& fname) {
+  std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname.c_str(), "r", true));
+  if (fi == nullptr) return false;
+  uint64_t magic;
+  return fi->Read(&magic, sizeof(magic)) == sizeof(magic) && magic == kParamFileMagic;
+}
+
+ParamFile::ParamFile(const std::string& fname) : fname_(fname) {
+  std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname.c_str(), "r"));
+  uint64_t header[4];
+  CHECK_EQ(fi->Read(header, sizeof(header)), sizeof(header))
+    << "Invalid parameter file " << fname;
+  CHECK_EQ(header[0], kParamFileMagic)
+    << "Invalid parameter file " << fname;
+  std::string index(header[3], '\0');
+  CHECK_EQ(fi->Read(&index[0], index.size()), index.size())
+    << "Invalid parameter file " << fname;
+  data_offset_ = AlignUp(kHeaderSize + index.size());
+
+  dmlc::MemoryStringStream strm(&index);
+  entries_.resize(header[2]);
+  names_.resize(header[2]);
+  bool named = false;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    Entry& e = entries_[i];
+    CHECK(strm.Read(&names_[i]) && e.shape.Load(&strm) &&
+          strm.Read(&e.dtype, sizeof(e.dtype)) == sizeof(e.dtype) &&
+          e.ctx.Load(&strm) &&
+          strm.Read(&e.offset, sizeof(e.offset)) == sizeof(e.offset) &&
+          strm.Read(&e.size, sizeof(e.size)) == sizeof(e.size) &&
+          strm.Read(&e.crc, sizeof(e.crc)) == sizeof(e.crc))
+      << "Invalid parameter file " << fname;
+    if (e.shape.ndim() != 0) {
+      CHECK_EQ(e.size, e.shape.Size() * mshadow::mshadow_sizeof(e.dtype))
+        << "Invalid parameter file " << fname;
+    }
+    named = named || !names_[i].empty();
+    index_[names_[i]] = i;
+  }
+  if (!named) {
+    names_.clear();
+    index_.clear();
+  }
+}
+
+size_t ParamFile::Find(const std::string& name) const {
+  auto it = index_.find(name);
+  CHECK(it != index_.end())
+    << "Cannot find " << name << " in parameter file " << fname_;
+  return it->second;
+}
+
+NDArray ParamFile::Read(size_t i) const {
+  CHECK_LT(i, entries_.size());
+  const Entry& e = entries_[i];
+  if (e.shape.ndim() == 0) return NDArray();
+  // the array is new, so it is written without going through the engine
+  NDArray arr(e.shape, Context::CPU(), false, e.dtype);
+  void* dptr = arr.data().dptr_;
+  std::unique_ptr<dmlc::SeekStream> fi(dmlc::SeekStream::CreateForRead(fname_.c_str()));
+  fi->Seek(data_offset_ + e.offset);
+  CHECK_EQ(fi->Read(dptr, e.size), e.size)
+    << "Truncated parameter file " << fname_;
+  CHECK_EQ(ParamFileCRC32(dptr, e.size), e.crc)
+    << "Checksum mismatch of tensor " << (names_.empty() ? std::to_string(i) : names_[i])
+    << " in parameter file " << fname_;
+  return arr;
+}
+
+std::vector<NDArray> ParamFile::Load(const std::vector<size_t>& idx, const Context* ctx) const {
+  std::vector<NDArray> ret(idx.size());
+  std::vector<std::string> errors(idx.size());
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < static_cast<int>(idx.size()); ++i) {
+    try {
+      ret[i] = Read(idx[i]);
+    } catch (const dmlc::Error& e) {
+      errors[i] = e.what();
+    }
+  }
+  for (const std::string& error : errors) {
+    if (!error.empty()) LOG(FATAL) << error;
+  }
+  for (size_t i = 0; i < idx.size(); ++i) {
+    const Context target = ctx != nullptr ? *ctx : entries_[idx[i]].ctx;
+    if (ret[i].is_none() || target.dev_mask() == cpu::kDevMask) continue;
+#if MXNET_USE_CUDA
+    ret[i] = ret[i].Copy(target);
+#endif
+  }
+  return ret;
+}
+
+}  // namespace mxnet
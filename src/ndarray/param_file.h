@@ -0,0 +1,115 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file param_file.h
+ * \brief Chunked parameter file with an index and per tensor checksums.
+ *
+ *  Layout of the file:
+ *   - magic and reserved words, number of tensors and size of the index
+ *   - the index: for every tensor its name, shape, type, context, offset of
+ *     its payload relative to the first payload, size and CRC32
+ *   - the payloads, each aligned to kParamFileAlign bytes
+ *  The index is read when the file is opened, so the tensors can be loaded
+ *  by name, in any order and in parallel.
+ */
+#ifndef MXNET_NDARRAY_PARAM_FILE_H_
+#define MXNET_NDARRAY_PARAM_FILE_H_
+
+#include <dmlc/io.h>
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <exception>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+
+/*! \brief magic number of the parameter file, the list format uses 0x112 */
+const uint64_t kParamFileMagic = 0x113;
+/*! \brief alignment of the payloads in the file */
+const size_t kParamFileAlign = 64;
+
+/*! \brief CRC32 (IEEE) of a buffer, continuing from crc */
+uint32_t ParamFileCRC32(const void* data, size_t size, uint32_t crc = 0);
+
+/*!
+ * \brief saves a snapshot of arrays in the background.
+ *  The arrays are copied to CPU by the engine when the writer is created, so
+ *  they can be modified right after, and the file is written by a thread.
+ *  Local files are written to fname.tmp and renamed when complete, so the
+ *  previous file stays intact if the save fails.
+ */
+class ParamFileWriter {
+ public:
+  /*!
+   * \brief start saving.
+   * \param fname the file name
+   * \param data the arrays
+   * \param names the names of the arrays, or empty
+   */
+  ParamFileWriter(const std::string& fname,
+                  const std::vector<NDArray>& data,
+                  const std::vector<std::string>& names);
+  /*! \brief waits for the file to be written, logs the error if Wait was not called */
+  ~ParamFileWriter();
+  /*! \brief wait for the file to be written, throws the error of the writer if any */
+  void Wait();
+
+ private:
+  void Write();
+
+  std::string fname_;
+  std::vector<NDArray> snapshot_;
+  std::vector<Context> ctx_;
+  std::vector<std::string> names_;
+  std::thread thread_;
+  std::exception_ptr error_;
+};
+
+/*! \brief reader of a parameter file */
+class ParamFile {
+ public:
+  /*! \brief open the file and read its index */
+  explicit ParamFile(const std::string& fname);
+  /*! \return whether the file is a parameter file */
+  static bool Probe(const std::string& fname);
+  /*! \return the names of the tensors, empty if they were saved without names */
+  inline const std::vector<std::string>& names() const {
+    return names_;
+  }
+  /*! \return the number of tensors */
+  inline size_t size() const {
+    return entries_.size();
+  }
+  /*! \return the position of a tensor, CHECK fails if there is none */
+  size_t Find(const std::string& name) const;
+  /*!
+   * \brief read tensors in parallel and check their checksums.
+   * \param idx the positions of the tensors
+   * \param ctx the context of the returned arrays, or nullptr for the saved ones
+   */
+  std::vector<NDArray> Load(const std::vector<size_t>& idx, const Context* ctx) const;
+
+ private:
+  // read a tensor into a new CPU array
+  NDArray Read(size_t i) const;
+
+  /*! \brief an index entry */
+  struct Entry {
+    TShape shape;
+    int32_t dtype;
+    Context ctx;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t crc;
+  };
+  std::string fname_;
+  uint64_t data_offset_;
+  std::vector<Entry> entries_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, size_t> index_;
+};
+
+}  // namespace mxnet
+#endif  // MXNET_NDARRAY_PARAM_FILE_H_
@@ -16,6 +16,7 @@
 #include <vector>
 #include <utility>
 #include "./operator_common.h"
+#include "./vector_math.h"
 
 namespace mxnet {
 namespace op {
@@ -57,6 +58,10 @@ class ActivationOp : public Operator {
     CHECK_EQ(in_data.size(), 1);
     CHECK_EQ(out_data.size(), 1);
     Stream<xpu> *s = ctx.get_stream<xpu>();
+    if (VectorMap<ForwardOp>(s, in_data[activation::kData], req[activation::kOut],
+                             out_data[activation::kOut])) {
+      return;
+    }
     Tensor<xpu, 2, DType> data = in_data[activation::kData].FlatTo2D<xpu, DType>(s);
     Tensor<xpu, 2, DType> out = out_data[activation::kOut].FlatTo2D<xpu, DType>(s);
     Assign(out, req[activation::kOut], F<ForwardOp>(data));
@@ -0,0 +1,138 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file batch_gemm_cpu.cc
+ * \brief Batches of small matrix products, one clone per instruction set.
+ */
+#include <dmlc/omp.h>
+#include <algorithm>
+#include <vector>
+#include "./batch_gemm_cpu.h"
+
+// gcc resolves the clones with an ifunc when the library is loaded
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 && \
+    defined(__x86_64__) && defined(__linux__)
+#define MXNET_GEMM_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#define MXNET_GEMM_INLINE inline __attribute__((always_inline))
+#else
+#define MXNET_GEMM_CLONES
+#define MXNET_GEMM_INLINE inline
+#endif
+
+namespace mxnet {
+namespace op {
+namespace {
+
+// rows of a block, the accumulators of a block must stay in registers
+const int kGemmRows = 2;
+
+/*!
+ * \brief rows [i0, i1) of c = alpha * op(a) op(b) + beta * c for one product,
+ *  pa and pb hold the packed rows of op(a) and op(b). The panels of op(b)
+ *  are cols wide.
+ */
+template<int cols>
+MXNET_GEMM_INLINE void GemmPacked(int m, int i0, int i1, int n, int k, float alpha,
+                                  const float* a, bool trans_a, const float* b, bool trans_b,
+                                  float beta, float* c, float* pa, float* pb) {
+  const int num_panels = (n + cols - 1) / cols;
+  const int num_blocks = (i1 - i0 + kGemmRows - 1) / kGemmRows;
+  // op(b) by panels of cols columns, zero padded, each one k x cols
+  for (int q = 0; q < num_panels; ++q) {
+    const int j0 = q * cols, nj = std::min(cols, n - j0);
+    float* dst = pb + static_cast<size_t>(q) * k * cols;
+    if (nj < cols) std::fill(dst, dst + k * cols, 0.0f);
+    if (trans_b) {
+      for (int j = 0; j < nj; ++j) {
+        const float* src = b + static_cast<size_t>(j0 + j) * k;
+        for (int p = 0; p < k; ++p) dst[p * cols + j] = src[p];
+      }
+    } else {
+      for (int p = 0; p < k; ++p) {
+        const float* src = b + static_cast<size_t>(p) * n + j0;
+        for (int j = 0; j < nj; ++j) dst[p * cols + j] = src[j];
+      }
+    }
+  }
+  // op(a) by blocks of rows, interleaved, each one k x kGemmRows
+  for (int r = 0; r < num_blocks; ++r) {
+    float* dst = pa + static_cast<size_t>(r) * k * kGemmRows;
+    for (int i = 0; i < kGemmRows; ++i) {
+      const int row = i0 + r * kGemmRows + i;
+      for (int p = 0; p < k; ++p) {
+        dst[p * kGemmRows + i] = row >= i1 ? 0.0f :
+            (trans_a ? a[static_cast<size_t>(p) * m + row] : a[static_cast<size_t>(row) * k + p]);
+      }
+    }
+  }
+  for (int r = 0; r < num_blocks; ++r) {
+    const float* ap = pa + static_cast<size_t>(r) * k * kGemmRows;
+    for (int q = 0; q < num_panels; ++q) {
+      const float* bp = pb + static_cast<size_t>(q) * k * cols;
+      float acc0[cols] = {}, acc1[cols] = {};
+      for (int p = 0; p < k; ++p) {
+        const float a0 = ap[p * kGemmRows], a1 = ap[p * kGemmRows + 1];
+        for (int j = 0; j < cols; ++j) {
+          acc0[j] += a0 * bp[p * cols + j];
+          acc1[j] += a1 * bp[p * cols + j];
+        }
+      }
+      const int r0 = i0 + r * kGemmRows, j0 = q * cols, nj = std::min(cols, n - j0);
+      for (int i = 0; i < std::min(kGemmRows, i1 - r0); ++i) {
+        const float* acc = i == 0 ? acc0 : acc1;
+        float* y = c + static_cast<size_t>(r0 + i) * n + j0;
+        if (beta == 0.0f) {
+          for (int j = 0; j < nj; ++j) y[j] = alpha * acc[j];
+        } else {
+          for (int j = 0; j < nj; ++j) y[j] = alpha * acc[j] + beta * y[j];
+        }
+      }
+    }
+  }
+}
+
+// the panels are 64 columns wide, or 32 for narrow products
+MXNET_GEMM_CLONES
+void Gemm(int m, int i0, int i1, int n, int k, float alpha, const float* a, bool trans_a,
+          const float* b, bool trans_b, float beta, float* c, float* pa, float* pb) {
+  if (n > 32) {
+    GemmPacked<64>(m, i0, i1, n, k, alpha, a, trans_a, b, trans_b, beta, c, pa, pb);
+  } else {
+    GemmPacked<32>(m, i0, i1, n, k, alpha, a, trans_a, b, trans_b, beta, c, pa, pb);
+  }
+}
+
+}  // namespace
+
+void BatchGemmCPU(index_t batch, index_t m, index_t n, index_t k, float alpha,
+                  const float* a, bool trans_a, const float* b, bool trans_b,
+                  float beta, float* c) {
+  if (batch == 0 || m == 0 || n == 0) return;
+  const size_t size_a = static_cast<size_t>(m) * k, size_b = static_cast<size_t>(k) * n;
+  const size_t size_c = static_cast<size_t>(m) * n;
+  // with fewer products than threads the rows of each one are split too,
+  // every part packs the whole of op(b)
+  const int num_blocks = (m + kGemmRows - 1) / kGemmRows;
+  const int nbatch = static_cast<int>(batch);
+  const int nsplit = std::max(1, std::min(num_blocks,
+                                          (omp_get_max_threads() + nbatch - 1) / nbatch));
+  const int split_rows = (num_blocks + nsplit - 1) / nsplit * kGemmRows;
+  const size_t packed_a = static_cast<size_t>(split_rows) * k;
+  const size_t packed_b = static_cast<size_t>((n + 63) / 64) * 64 * k;
+  const int ntask = nbatch * nsplit;
+  #pragma omp parallel if (ntask > 1)
+  {
+    std::vector<float> pa(packed_a), pb(packed_b);
+    #pragma omp for
+    for (int t = 0; t < ntask; ++t) {
+      const int i = t / nsplit, i0 = t % nsplit * split_rows;
+      const int i1 = std::min(static_cast<int>(m), i0 + split_rows);
+      if (i0 >= i1) continue;
+      Gemm(m, i0, i1, n, k, alpha, a + i * size_a, trans_a, b + i * size_b, trans_b, beta,
+           c + i * size_c, pa.data(), pb.data());
+    }
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,38 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file batch_gemm_cpu.h
+ * \brief Batches of small single precision matrix products on CPU.
+ */
+#ifndef MXNET_OPERATOR_BATCH_GEMM_CPU_H_
+#define MXNET_OPERATOR_BATCH_GEMM_CPU_H_
+
+#include <mxnet/base.h>
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief the largest m * n * k of the products BatchGemmCPU is used for,
+ *  larger ones go to BLAS one at a time
+ */
+const size_t kBatchGemmMaxSize = 1 << 21;
+
+/*!
+ * \brief c[i] = alpha * op(a[i]) op(b[i]) + beta * c[i] for i < batch on
+ *  CPU, where op(x) is x^T when the transpose flag is set. op(a[i]) is
+ *  m x k and op(b[i]) is k x n, all matrices are row major and follow each
+ *  other. c is not read when beta is 0.
+ *
+ *  The products are split over the threads, and so are the rows of each
+ *  product when there are fewer products than threads. Each part packs
+ *  op(b[i]) into panels of columns and its rows of op(a[i]) into pairs, so
+ *  the transposes are read once and never materialized, then a block of two
+ *  rows of a panel is accumulated in registers over k.
+ */
+void BatchGemmCPU(index_t batch, index_t m, index_t n, index_t k, float alpha,
+                  const float* a, bool trans_a, const float* b, bool trans_b,
+                  float beta, float* c);
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_BATCH_GEMM_CPU_H_
@@ -7,6 +7,7 @@
 
 #include "./batch_norm-inl.h"
 #include <nnvm/op_attr_types.h>
+#include "./fused_batch_norm-inl.h"
 #if MXNET_USE_MKL2017 == 1
 #include <mkl_memory.h>
 #include "./mkl/mkl_memory-inl.h"
@@ -25,7 +26,7 @@ Operator *CreateOp<cpu>(BatchNormParam param, int dtype) {
       LOG(INFO) << MKLBatchNormOp<cpu, float>::getName() << " Skip MKL optimization";
   }
 #endif
-  return new BatchNormOp<cpu>(param);
+  return new FusedBatchNormOp(param);
 }
 
 // DO_BIND_DISPATCH comes from operator_common.h
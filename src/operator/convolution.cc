@@ -6,6 +6,7 @@
 */
 
 #include "./convolution-inl.h"
+#include "./winograd_convolution-inl.h"
 #if MXNET_USE_MKL2017 == 1
 #include <mkl_memory.h>
 #include "./mkl/mkl_memory-inl.h"
@@ -54,6 +55,18 @@ Operator* CreateOp<cpu>(ConvolutionParam param, int dtype,
     }
   }
 #endif
+  if (dmlc::GetEnv("MXNET_CPU_WINOGRAD_CONV", true) &&
+      WinogradConvolutionSupported(param, *in_shape)) {
+    const int tile = WinogradTileSize((*out_shape)[conv::kOut]);
+    switch (dtype) {
+    case mshadow::kFloat32:
+      return new WinogradConvolutionOp<float>(param, tile);
+    case mshadow::kFloat64:
+      return new WinogradConvolutionOp<double>(param, tile);
+    default:
+      break;
+    }
+  }
   MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
     op = new ConvolutionOp<cpu, DType>(param);
   })
@@ -0,0 +1,238 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file fused_batch_norm-inl.h
+ * \brief Batch normalization on CPU with fused passes over the data
+*/
+#ifndef MXNET_OPERATOR_FUSED_BATCH_NORM_INL_H_
+#define MXNET_OPERATOR_FUSED_BATCH_NORM_INL_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/operator.h>
+#include <cmath>
+#include <vector>
+#include "./batch_norm-inl.h"
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief BatchNorm on CPU. The data is seen as rows of the spatial positions
+ *  of one sample and one channel. Training forward computes the mean and the
+ *  sum of squared deviations of every row in parallel, merges them per
+ *  channel like Welford's algorithm does, then normalizes in one pass with a
+ *  per channel scale and shift. Inference uses the moving statistics for
+ *  the scale and shift. Backward computes the per channel sums in one pass
+ *  and the data gradient in a second one.
+ */
+class FusedBatchNormOp : public Operator {
+ public:
+  explicit FusedBatchNormOp(BatchNormParam param) : param_(param) {}
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_states) {
+    CHECK_EQ(in_data.size(), 3U);
+    CHECK_EQ(aux_states.size(), 2U);
+    if (ctx.is_train) {
+      CHECK_EQ(out_data.size(), 3U);
+      CHECK_EQ(req.size(), 3U);
+    } else {
+      CHECK_GE(out_data.size(), 1U);
+      CHECK_GE(req.size(), 1U);
+      CHECK_EQ(req[batchnorm::kOut], kWriteTo);
+    }
+    this->SetDims(in_data[batchnorm::kData].shape_);
+    const real_t* data = in_data[batchnorm::kData].dptr<real_t>();
+    real_t* out = out_data[batchnorm::kOut].dptr<real_t>();
+    real_t* slope = in_data[batchnorm::kGamma].dptr<real_t>();
+    const real_t* bias = in_data[batchnorm::kBeta].dptr<real_t>();
+    const real_t* moving_mean = aux_states[batchnorm::kMovingMean].dptr<real_t>();
+    const real_t* moving_var = aux_states[batchnorm::kMovingVar].dptr<real_t>();
+    const int N = num_, C = channels_;
+    const index_t S = spatial_;
+
+    if (param_.fix_gamma) std::fill(slope, slope + C, 1.0f);
+    scale_.resize(C);
+    shift_.resize(C);
+    if (ctx.is_train && !param_.use_global_stats) {
+      CHECK(req[batchnorm::kMean] == kNullOp || req[batchnorm::kMean] == kWriteTo);
+      CHECK(req[batchnorm::kVar] == kNullOp || req[batchnorm::kVar] == kWriteTo);
+      real_t* mean = out_data[batchnorm::kMean].dptr<real_t>();
+      real_t* var = out_data[batchnorm::kVar].dptr<real_t>();
+      // mean and sum of squared deviations of every row
+      row_.resize(static_cast<size_t>(N) * C * 2);
+      #pragma omp parallel for
+      for (int r = 0; r < N * C; ++r) {
+        const real_t* x = data + r * S;
+        real_t sum = 0;
+        for (index_t i = 0; i < S; ++i) sum += x[i];
+        const real_t m = sum / S;
+        real_t m2 = 0;
+        for (index_t i = 0; i < S; ++i) m2 += (x[i] - m) * (x[i] - m);
+        row_[2 * r] = m;
+        row_[2 * r + 1] = m2;
+      }
+      #pragma omp parallel for
+      for (int c = 0; c < C; ++c) {
+        // merge the rows of the channel, as in the parallel variant of Welford's algorithm
+        double count = 0, m = 0, m2 = 0;
+        for (int n = 0; n < N; ++n) {
+          const real_t* row = &row_[2 * (n * C + c)];
+          const double delta = row[0] - m;
+          const double total = count + S;
+          m += delta * S / total;
+          m2 += row[1] + delta * delta * count * S / total;
+          count = total;
+        }
+        mean[c] = static_cast<real_t>(m);
+        var[c] = static_cast<real_t>(m2 / count);
+        scale_[c] = slope[c] / std::sqrt(var[c] + param_.eps);
+        shift_[c] = bias[c] - mean[c] * scale_[c];
+      }
+    } else {
+      for (int c = 0; c < C; ++c) {
+        scale_[c] = slope[c] / std::sqrt(moving_var[c] + param_.eps);
+        shift_[c] = bias[c] - moving_mean[c] * scale_[c];
+      }
+    }
+    const OpReqType out_req = req[batchnorm::kOut];
+    if (out_req == kNullOp) return;
+    #pragma omp parallel for
+    for (int r = 0; r < N * C; ++r) {
+      const real_t a = scale_[r % C], b = shift_[r % C];
+      const real_t* x = data + r * S;
+      real_t* y = out + r * S;
+      if (out_req == kAddTo) {
+        for (index_t i = 0; i < S; ++i) y[i] += a * x[i] + b;
+      } else {
+        for (index_t i = 0; i < S; ++i) y[i] = a * x[i] + b;
+      }
+    }
+  }
+
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<TBlob> &out_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad,
+                        const std::vector<TBlob> &aux_states) {
+    CHECK_EQ(out_grad.size(), param_.output_mean_var ? 3U : 1U);
+    CHECK_EQ(in_data.size(), 3U);
+    CHECK_EQ(out_data.size(), 3U);
+    CHECK_EQ(in_grad.size(), 3U);
+    this->SetDims(in_data[batchnorm::kData].shape_);
+    const real_t* data = in_data[batchnorm::kData].dptr<real_t>();
+    const real_t* grad = out_grad[batchnorm::kOut].dptr<real_t>();
+    real_t* grad_in = in_grad[batchnorm::kData].dptr<real_t>();
+    real_t* slope = in_data[batchnorm::kGamma].dptr<real_t>();
+    real_t* gslope = in_grad[batchnorm::kGamma].dptr<real_t>();
+    real_t* gbias = in_grad[batchnorm::kBeta].dptr<real_t>();
+    real_t* moving_mean = aux_states[batchnorm::kMovingMean].dptr<real_t>();
+    real_t* moving_var = aux_states[batchnorm::kMovingVar].dptr<real_t>();
+    const int N = num_, C = channels_;
+    const index_t S = spatial_;
+    const real_t M = static_cast<real_t>(N) * S;
+    const bool batch_stats = ctx.is_train && !param_.use_global_stats;
+
+    if (param_.fix_gamma) std::fill(slope, slope + C, 1.0f);
+    const real_t* mean = batch_stats ? out_data[batchnorm::kMean].dptr<real_t>() : moving_mean;
+    const real_t* var = batch_stats ? out_data[batchnorm::kVar].dptr<real_t>() : moving_var;
+    inv_std_.resize(C);
+    for (int c = 0; c < C; ++c) inv_std_[c] = 1.0f / std::sqrt(var[c] + param_.eps);
+    // with the moving statistics the data gradient is known before the sums
+    const OpReqType data_req = req[batchnorm::kData];
+    const bool fused_grad = !batch_stats && data_req != kNullOp;
+
+    // sums of the output gradient and of its product with the centered data, per row
+    row_.resize(static_cast<size_t>(N) * C * 2);
+    #pragma omp parallel for
+    for (int r = 0; r < N * C; ++r) {
+      const int c = r % C;
+      const real_t m = mean[c];
+      const real_t* x = data + r * S;
+      const real_t* dy = grad + r * S;
+      real_t sum_dy = 0, sum_dy_xmu = 0;
+      for (index_t i = 0; i < S; ++i) {
+        sum_dy += dy[i];
+        sum_dy_xmu += dy[i] * (x[i] - m);
+      }
+      row_[2 * r] = sum_dy;
+      row_[2 * r + 1] = sum_dy_xmu;
+      if (fused_grad) {
+        const real_t a = slope[c] * inv_std_[c];
+        real_t* dx = grad_in + r * S;
+        if (data_req == kAddTo) {
+          for (index_t i = 0; i < S; ++i) dx[i] += a * dy[i];
+        } else {
+          for (index_t i = 0; i < S; ++i) dx[i] = a * dy[i];
+        }
+      }
+    }
+    sum_dy_.resize(C);
+    sum_dy_xhat_.resize(C);
+    #pragma omp parallel for
+    for (int c = 0; c < C; ++c) {
+      real_t sum_dy = 0, sum_dy_xmu = 0;
+      for (int n = 0; n < N; ++n) {
+        sum_dy += row_[2 * (n * C + c)];
+        sum_dy_xmu += row_[2 * (n * C + c) + 1];
+      }
+      sum_dy_[c] = sum_dy;
+      sum_dy_xhat_[c] = sum_dy_xmu * inv_std_[c];
+    }
+
+    if (batch_stats) {
+      for (int c = 0; c < C; ++c) {
+        moving_mean[c] = moving_mean[c] * param_.momentum + mean[c] * (1 - param_.momentum);
+        moving_var[c] = moving_var[c] * param_.momentum + var[c] * (1 - param_.momentum);
+      }
+      if (data_req != kNullOp) {
+        // dx = gamma / std * (dy - mean(dy) - xhat * mean(dy * xhat))
+        #pragma omp parallel for
+        for (int r = 0; r < N * C; ++r) {
+          const int c = r % C;
+          const real_t a = slope[c] * inv_std_[c];
+          const real_t m = mean[c], inv_std = inv_std_[c];
+          const real_t mean_dy = sum_dy_[c] / M;
+          const real_t k = sum_dy_xhat_[c] / M * inv_std;
+          const real_t* x = data + r * S;
+          const real_t* dy = grad + r * S;
+          real_t* dx = grad_in + r * S;
+          if (data_req == kAddTo) {
+            for (index_t i = 0; i < S; ++i) dx[i] += a * (dy[i] - mean_dy - (x[i] - m) * k);
+          } else {
+            for (index_t i = 0; i < S; ++i) dx[i] = a * (dy[i] - mean_dy - (x[i] - m) * k);
+          }
+        }
+      }
+    }
+    for (int c = 0; c < C; ++c) {
+      Assign(gslope[c], req[batchnorm::kGamma], param_.fix_gamma ? 0.0f : sum_dy_xhat_[c]);
+      Assign(gbias[c], req[batchnorm::kBeta], sum_dy_[c]);
+    }
+  }
+
+ private:
+  inline void SetDims(const TShape& dshape) {
+    num_ = dshape[0];
+    channels_ = dshape[1];
+    spatial_ = dshape.Size() / (dshape[0] * dshape[1]);
+  }
+
+  BatchNormParam param_;
+  int num_, channels_;
+  index_t spatial_;
+  /*! \brief per channel scale and shift of the normalization */
+  std::vector<real_t> scale_, shift_;
+  /*! \brief per row partial statistics or sums */
+  std::vector<real_t> row_;
+  /*! \brief per channel values of backward */
+  std::vector<real_t> inv_std_, sum_dy_, sum_dy_xhat_;
+};  // class FusedBatchNormOp
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_FUSED_BATCH_NORM_INL_H_
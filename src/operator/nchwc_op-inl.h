@@ -0,0 +1,389 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file nchwc_op-inl.h
+ * \brief CPU kernels on the blocked NCHWc layout.
+ *
+ *  An NCHWc tensor of a NCHW tensor with C channels has shape
+ *  (N, ceil(C / c), H, W, c): channels are split into blocks of c that are
+ *  stored innermost, so that the inner loops of the kernels run over c
+ *  contiguous lanes and vectorize. Lanes past C are padding. The kernels keep
+ *  them finite and the convolution weights of padded input lanes are zero,
+ *  so they never leak into real channels.
+ *
+ *  These operators are created by the executor's layout pass only, and are
+ *  forward only.
+ */
+#ifndef MXNET_OPERATOR_NCHWC_OP_INL_H_
+#define MXNET_OPERATOR_NCHWC_OP_INL_H_
+
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator_util.h>
+#include <mxnet/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "./operator_common.h"
+#include "./convolution-inl.h"
+#include "./pooling-inl.h"
+#include "./batch_norm-inl.h"
+#include "./transpose_cpu.h"
+
+namespace mxnet {
+namespace op {
+
+namespace nchwc {
+/*! \brief channel block used by the layout pass, one vector register of float */
+#if defined(__AVX512F__)
+const int kBlock = 16;
+#else
+const int kBlock = 8;
+#endif
+/*! \brief number of channel blocks of c channels */
+inline index_t NumBlocks(index_t c, index_t block) {
+  return (c + block - 1) / block;
+}
+}  // namespace nchwc
+
+struct NCHWcLayoutParam : public dmlc::Parameter<NCHWcLayoutParam> {
+  int block;
+  int num_channel;
+  DMLC_DECLARE_PARAMETER(NCHWcLayoutParam) {
+    DMLC_DECLARE_FIELD(block).set_default(nchwc::kBlock)
+    .describe("Number of channels in each block.");
+    DMLC_DECLARE_FIELD(num_channel).set_default(0)
+    .describe("Number of channels of the NCHW tensor, used when converting back.");
+  }
+};
+
+/*! \brief parse the parameters of the operator the node replaces */
+template<typename PType>
+inline void NCHWcParamParser(nnvm::NodeAttrs* attrs) {
+  PType param;
+  param.InitAllowUnknown(attrs->dict);
+  attrs->parsed = std::move(param);
+}
+
+inline bool NCHWcType(const nnvm::NodeAttrs& attrs,
+                      std::vector<int> *in_attrs,
+                      std::vector<int> *out_attrs) {
+  for (int& t : *in_attrs) TYPE_ASSIGN_CHECK(&t, 0, mshadow::kFloat32);
+  for (int& t : *out_attrs) TYPE_ASSIGN_CHECK(&t, 0, mshadow::kFloat32);
+  return true;
+}
+
+// convert NCHW to NCHWc, zero filling the padded lanes
+template<typename xpu>
+void ToNCHWcCompute(const nnvm::NodeAttrs& attrs,
+                    const OpContext& ctx,
+                    const std::vector<TBlob>& inputs,
+                    const std::vector<OpReqType>& req,
+                    const std::vector<TBlob>& outputs) {
+  if (req[0] == kNullOp) return;
+  CHECK_EQ(req[0], kWriteTo);
+  const TShape& ishape = inputs[0].shape_;
+  const TShape& oshape = outputs[0].shape_;
+  const index_t N = ishape[0], C = ishape[1], H = ishape[2], W = ishape[3];
+  const index_t Cb = oshape[1], B = oshape[4];
+  const float* in = inputs[0].dptr<float>();
+  float* out = outputs[0].dptr<float>();
+  if (C == Cb * B) {
+    // no padded lanes, (N, Cb, B, HW) to (N, Cb, HW, B)
+    TransposeCPU(in, out, TShape(mshadow::Shape4(N, Cb, B, H * W)),
+                 TShape(mshadow::Shape4(0, 1, 3, 2)), sizeof(float));
+    return;
+  }
+  #pragma omp parallel for
+  for (int t = 0; t < static_cast<int>(N * Cb * H); ++t) {
+    const index_t task = t;
+    const index_t n = task / (Cb * H), cb = task / H % Cb, h = task % H;
+    float* o = out + task * W * B;
+    for (index_t lane = 0; lane < B; ++lane) {
+      const index_t c = cb * B + lane;
+      if (c < C) {
+        const float* i = in + ((n * C + c) * H + h) * W;
+        for (index_t w = 0; w < W; ++w) o[w * B + lane] = i[w];
+      } else {
+        for (index_t w = 0; w < W; ++w) o[w * B + lane] = 0.0f;
+      }
+    }
+  }
+}
+
+// convert NCHWc back to NCHW, dropping the padded lanes
+template<typename xpu>
+void FromNCHWcCompute(const nnvm::NodeAttrs& attrs,
+                      const OpContext& ctx,
+                      const std::vector<TBlob>& inputs,
+                      const std::vector<OpReqType>& req,
+                      const std::vector<TBlob>& outputs) {
+  if (req[0] == kNullOp) return;
+  CHECK_EQ(req[0], kWriteTo);
+  const TShape& ishape = inputs[0].shape_;
+  const TShape& oshape = outputs[0].shape_;
+  const index_t N = oshape[0], C = oshape[1], H = oshape[2], W = oshape[3];
+  const index_t Cb = ishape[1], B = ishape[4];
+  const float* in = inputs[0].dptr<float>();
+  float* out = outputs[0].dptr<float>();
+  if (C == Cb * B) {
+    TransposeCPU(in, out, TShape(mshadow::Shape4(N, Cb, H * W, B)),
+                 TShape(mshadow::Shape4(0, 1, 3, 2)), sizeof(float));
+    return;
+  }
+  #pragma omp parallel for
+  for (int t = 0; t < static_cast<int>(N * C * H); ++t) {
+    const index_t task = t;
+    const index_t n = task / (C * H), c = task / H % C, h = task % H;
+    const float* i = in + (((n * Cb + c / B) * H + h) * W) * B + c % B;
+    float* o = out + task * W;
+    for (index_t w = 0; w < W; ++w) o[w] = i[w * B];
+  }
+}
+
+// stride, dilate and pad of a 2D convolution, with the defaults of Convolution
+inline void ConvGeometry(const ConvolutionParam& param, index_t* stride,
+                         index_t* dilate, index_t* pad) {
+  for (int k = 0; k < 2; ++k) {
+    stride[k] = param.stride.ndim() ? param.stride[k] : 1;
+    dilate[k] = param.dilate.ndim() ? param.dilate[k] : 1;
+    pad[k] = param.pad.ndim() ? param.pad[k] : 0;
+  }
+}
+
+/*! \brief shape and geometry of a 2D convolution on NCHWc data */
+struct NCHWcConvShape {
+  index_t N, Cb, H, W, Fb, OH, OW, KH, KW, B;
+  index_t stride[2], dilate[2], pad[2];
+};
+
+/*!
+ * \brief direct convolution on CPU. The weight is reordered to
+ *  (F/B, C/B, KH, KW, B_in, B_out) and the bias padded to F/B * B. The output
+ *  rows are split over the threads, and a few output pixels of a row are
+ *  accumulated in registers over the input channels and the kernel taps.
+ */
+void NCHWcConvCPU(const NCHWcConvShape& s, const float* in, const float* weight,
+                  const float* bias, float* out);
+
+/*!
+ * \brief the weight and bias of a _nchwc_Convolution node reordered for
+ *  NCHWcConvCPU, with the engine versions of the arrays they were reordered
+ *  from. They are reordered again only when either version changes, or on
+ *  every call when the versions are not known.
+ */
+struct NCHWcWeightCache {
+  std::mutex mutex;
+  size_t weight_version{0}, bias_version{0};
+  // blocked weight followed by the padded bias, replaced instead of updated
+  // so that running convolutions keep reading the old one.
+  std::shared_ptr<const std::vector<float> > blocked;
+};
+
+/*! \brief parsed parameters of _nchwc_Convolution, copies of a node share the cache */
+struct NCHWcConvParam {
+  ConvolutionParam conv;
+  std::shared_ptr<NCHWcWeightCache> cache;
+};
+
+inline void NCHWcConvParamParser(nnvm::NodeAttrs* attrs) {
+  NCHWcConvParam param;
+  param.conv.InitAllowUnknown(attrs->dict);
+  param.cache = std::make_shared<NCHWcWeightCache>();
+  attrs->parsed = std::move(param);
+}
+
+// the blocked weight and bias of s, from the cache when their versions did not change
+inline std::shared_ptr<const std::vector<float> > NCHWcBlockedWeight(
+    NCHWcWeightCache* cache, const NCHWcConvShape& s, index_t F, index_t C,
+    const float* weight, size_t weight_version, const float* bias, size_t bias_version) {
+  const index_t B = s.B, K = s.KH * s.KW;
+  const index_t bsize = bias != nullptr ? F : 0;
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  if (cache->blocked != nullptr && weight_version != 0 &&
+      cache->weight_version == weight_version && cache->bias_version == bias_version) {
+    return cache->blocked;
+  }
+  const index_t blocked_size = s.Fb * s.Cb * K * B * B;
+  std::shared_ptr<std::vector<float> > blocked = std::make_shared<std::vector<float> >(
+      blocked_size + s.Fb * B);
+  float* wt = blocked->data();
+  #pragma omp parallel for
+  for (int t = 0; t < static_cast<int>(s.Fb * s.Cb); ++t) {
+    const index_t task = t;
+    const index_t fb = task / s.Cb, cb = task % s.Cb;
+    for (index_t k = 0; k < K; ++k) {
+      float* w = wt + (task * K + k) * B * B;
+      for (index_t ci = 0; ci < B; ++ci) {
+        for (index_t co = 0; co < B; ++co) {
+          const index_t f = fb * B + co, c = cb * B + ci;
+          w[ci * B + co] = (f < F && c < C) ? weight[(f * C + c) * K + k] : 0.0f;
+        }
+      }
+    }
+  }
+  for (index_t f = 0; f < bsize; ++f) wt[blocked_size + f] = bias[f];
+  cache->weight_version = weight_version;
+  cache->bias_version = bias_version;
+  cache->blocked = blocked;
+  return cache->blocked;
+}
+
+template<typename xpu>
+void NCHWcConvCompute(const nnvm::NodeAttrs& attrs,
+                      const OpContext& ctx,
+                      const std::vector<TBlob>& inputs,
+                      const std::vector<OpReqType>& req,
+                      const std::vector<TBlob>& outputs) {
+  const NCHWcConvParam& nparam = nnvm::get<NCHWcConvParam>(attrs.parsed);
+  const ConvolutionParam& param = nparam.conv;
+  if (req[conv::kOut] == kNullOp) return;
+  CHECK_EQ(req[conv::kOut], kWriteTo);
+  const TShape& dshape = inputs[conv::kData].shape_;
+  const TShape& wshape = inputs[conv::kWeight].shape_;
+  const TShape& oshape = outputs[conv::kOut].shape_;
+  NCHWcConvShape s;
+  s.N = dshape[0]; s.Cb = dshape[1]; s.H = dshape[2]; s.W = dshape[3]; s.B = dshape[4];
+  s.Fb = oshape[1]; s.OH = oshape[2]; s.OW = oshape[3];
+  s.KH = wshape[2]; s.KW = wshape[3];
+  ConvGeometry(param, s.stride, s.dilate, s.pad);
+  // the reordered weight is proportional to the size of the weight only, the
+  // data is never reordered.
+  const std::vector<size_t>& versions = ctx.in_versions;
+  const bool known = versions.size() == inputs.size();
+  std::shared_ptr<const std::vector<float> > blocked = NCHWcBlockedWeight(
+      nparam.cache.get(), s, wshape[0], wshape[1], inputs[conv::kWeight].dptr<float>(),
+      known ? versions[conv::kWeight] : 0,
+      param.no_bias ? nullptr : inputs[conv::kBias].dptr<float>(),
+      known && !param.no_bias ? versions[conv::kBias] : 0);
+  const float* wt = blocked->data();
+  const float* bt = param.no_bias ? nullptr : wt + s.Fb * s.Cb * s.KH * s.KW * s.B * s.B;
+  NCHWcConvCPU(s, inputs[conv::kData].dptr<float>(), wt, bt,
+               outputs[conv::kOut].dptr<float>());
+}
+
+// pooling window over the padded input: max pooling skips the padding, average
+// pooling counts it as zeros and divides by the kernel size, as Pooling does.
+// A window entirely in the padding gives 0.
+template<typename xpu>
+void NCHWcPoolingCompute(const nnvm::NodeAttrs& attrs,
+                         const OpContext& ctx,
+                         const std::vector<TBlob>& inputs,
+                         const std::vector<OpReqType>& req,
+                         const std::vector<TBlob>& outputs) {
+  const PoolingParam& param = nnvm::get<PoolingParam>(attrs.parsed);
+  if (req[pool_enum::kOut] == kNullOp) return;
+  CHECK_EQ(req[pool_enum::kOut], kWriteTo);
+  const TShape& dshape = inputs[pool_enum::kData].shape_;
+  const TShape& oshape = outputs[pool_enum::kOut].shape_;
+  const index_t N = dshape[0], Cb = dshape[1], H = dshape[2], W = dshape[3], B = dshape[4];
+  const index_t OH = oshape[2], OW = oshape[3];
+  const index_t KH = param.global_pool ? H : param.kernel[0];
+  const index_t KW = param.global_pool ? W : param.kernel[1];
+  const index_t SH = param.global_pool ? 1 : param.stride[0];
+  const index_t SW = param.global_pool ? 1 : param.stride[1];
+  const index_t PH = param.pad[0], PW = param.pad[1];
+  const int pool_type = param.pool_type;
+  const float scale = pool_type == pool_enum::kAvgPooling ? 1.0f / (KH * KW) : 1.0f;
+  const float* in = inputs[pool_enum::kData].dptr<float>();
+  float* out = outputs[pool_enum::kOut].dptr<float>();
+  #pragma omp parallel for
+  for (int t = 0; t < static_cast<int>(N * Cb * OH); ++t) {
+    const index_t task = t;
+    const index_t nc = task / OH, oh = task % OH;
+    // the window clipped to the data, in padded coordinates
+    const index_t hstart = std::max(oh * SH, PH), hend = std::min(oh * SH + KH, H + PH);
+    std::vector<float> acc(B);
+    for (index_t ow = 0; ow < OW; ++ow) {
+      const index_t wstart = std::max(ow * SW, PW), wend = std::min(ow * SW + KW, W + PW);
+      const bool empty = hstart >= hend || wstart >= wend;
+      const float init = pool_type == pool_enum::kMaxPooling && !empty ?
+          -std::numeric_limits<float>::infinity() : 0.0f;
+      std::fill(acc.begin(), acc.end(), init);
+      for (index_t ph = hstart; ph < hend; ++ph) {
+        for (index_t pw = wstart; pw < wend; ++pw) {
+          const float* x = in + ((nc * H + (ph - PH)) * W + (pw - PW)) * B;
+          if (pool_type == pool_enum::kMaxPooling) {
+            for (index_t lane = 0; lane < B; ++lane) acc[lane] = std::max(acc[lane], x[lane]);
+          } else {
+            for (index_t lane = 0; lane < B; ++lane) acc[lane] += x[lane];
+          }
+        }
+      }
+      float* o = out + (task * OW + ow) * B;
+      for (index_t lane = 0; lane < B; ++lane) o[lane] = acc[lane] * scale;
+    }
+  }
+}
+
+// scale and shift per channel; in training mode the batch statistics are used,
+// the moving statistics are only updated in backward, which this op has not.
+template<typename xpu>
+void NCHWcBatchNormCompute(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+  const BatchNormParam& param = nnvm::get<BatchNormParam>(attrs.parsed);
+  if (req[batchnorm::kOut] == kNullOp) return;
+  CHECK_EQ(req[batchnorm::kOut], kWriteTo);
+  const TShape& dshape = inputs[batchnorm::kData].shape_;
+  const index_t N = dshape[0], Cb = dshape[1], HW = dshape[2] * dshape[3], B = dshape[4];
+  const index_t C = inputs[batchnorm::kGamma].shape_[0];
+  const float* gamma = inputs[batchnorm::kGamma].dptr<float>();
+  const float* beta = inputs[batchnorm::kBeta].dptr<float>();
+  const float* moving_mean = inputs[3 + batchnorm::kMovingMean].dptr<float>();
+  const float* moving_var = inputs[3 + batchnorm::kMovingVar].dptr<float>();
+  const float* in = inputs[batchnorm::kData].dptr<float>();
+  float* out = outputs[batchnorm::kOut].dptr<float>();
+  const bool batch_stats = ctx.is_train && !param.use_global_stats;
+  #pragma omp parallel for
+  for (int b = 0; b < static_cast<int>(Cb); ++b) {
+    const index_t cb = b;
+    std::vector<float> mean(B, 0.0f), var(B, 0.0f), scale(B, 0.0f), shift(B, 0.0f);
+    if (batch_stats) {
+      for (index_t n = 0; n < N; ++n) {
+        const float* x = in + (n * Cb + cb) * HW * B;
+        for (index_t i = 0; i < HW; ++i) {
+          for (index_t lane = 0; lane < B; ++lane) mean[lane] += x[i * B + lane];
+        }
+      }
+      for (index_t lane = 0; lane < B; ++lane) mean[lane] /= N * HW;
+      for (index_t n = 0; n < N; ++n) {
+        const float* x = in + (n * Cb + cb) * HW * B;
+        for (index_t i = 0; i < HW; ++i) {
+          for (index_t lane = 0; lane < B; ++lane) {
+            const float d = x[i * B + lane] - mean[lane];
+            var[lane] += d * d;
+          }
+        }
+      }
+      for (index_t lane = 0; lane < B; ++lane) var[lane] /= N * HW;
+    }
+    for (index_t lane = 0; lane < B; ++lane) {
+      const index_t c = cb * B + lane;
+      if (c >= C) continue;
+      const float m = batch_stats ? mean[lane] : moving_mean[c];
+      const float v = batch_stats ? var[lane] : moving_var[c];
+      const float g = param.fix_gamma ? 1.0f : gamma[c];
+      scale[lane] = g / std::sqrt(v + param.eps);
+      shift[lane] = beta[c] - scale[lane] * m;
+    }
+    for (index_t n = 0; n < N; ++n) {
+      const float* x = in + (n * Cb + cb) * HW * B;
+      float* o = out + (n * Cb + cb) * HW * B;
+      for (index_t i = 0; i < HW; ++i) {
+        for (index_t lane = 0; lane < B; ++lane) {
+          o[i * B + lane] = x[i * B + lane] * scale[lane] + shift[lane];
+        }
+      }
+    }
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NCHWC_OP_INL_H_
@@ -0,0 +1,276 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file nchwc_op.cc
+ * \brief CPU operators on the blocked NCHWc layout.
+ */
+#include "./nchwc_op-inl.h"
+
+// gcc resolves the clones with an ifunc when the library is loaded
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 && \
+    defined(__x86_64__) && defined(__linux__)
+#define MXNET_NCHWC_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#define MXNET_NCHWC_INLINE inline __attribute__((always_inline))
+#else
+#define MXNET_NCHWC_CLONES
+#define MXNET_NCHWC_INLINE inline
+#endif
+
+namespace mxnet {
+namespace op {
+namespace {
+
+// output pixels of a row computed together, their accumulators stay in registers
+const int kConvTileW = 6;
+
+/*!
+ * \brief acc += the products of RW output pixels with the B x B weights w of
+ *  one kernel tap, x points to the input of the first pixel, x_step apart.
+ */
+template<int B, int RW>
+MXNET_NCHWC_INLINE void ConvTile(const float* x, index_t x_step, const float* w, float* acc) {
+  for (int ci = 0; ci < B; ++ci) {
+    const float* wr = w + ci * B;
+    for (int r = 0; r < RW; ++r) {
+      const float xv = x[r * x_step + ci];
+      #pragma omp simd
+      for (int co = 0; co < B; ++co) acc[r * B + co] += xv * wr[co];
+    }
+  }
+}
+
+/*! \brief output pixels [ow_begin, ow_end) of a row, RW at a time */
+template<int B, int RW>
+MXNET_NCHWC_INLINE void ConvPixels(const NCHWcConvShape& s, const float* in, const float* w_fb,
+                                   const float* bias, float* o, index_t oh,
+                                   index_t ow_begin, index_t ow_end, bool check) {
+  for (index_t ow = ow_begin; ow + RW <= ow_end; ow += RW) {
+    float acc[RW * B];
+    for (int r = 0; r < RW; ++r) {
+      for (int co = 0; co < B; ++co) acc[r * B + co] = bias != nullptr ? bias[co] : 0.0f;
+    }
+    for (index_t cb = 0; cb < s.Cb; ++cb) {
+      for (index_t kh = 0; kh < s.KH; ++kh) {
+        const index_t ih = oh * s.stride[0] + kh * s.dilate[0] - s.pad[0];
+        if (ih >= s.H) continue;  // also catches negative rows, index_t is unsigned
+        const float* x_row = in + (cb * s.H + ih) * s.W * B;
+        const float* w = w_fb + (cb * s.KH + kh) * s.KW * B * B;
+        for (index_t kw = 0; kw < s.KW; ++kw) {
+          const index_t iw = ow * s.stride[1] + kw * s.dilate[1] - s.pad[1];
+          if (check && iw >= s.W) continue;
+          ConvTile<B, RW>(x_row + iw * B, s.stride[1] * B, w + kw * B * B, acc);
+        }
+      }
+    }
+    std::copy(acc, acc + RW * B, o + ow * B);
+  }
+}
+
+/*!
+ * \brief one output row of image n and output channel block fb. The columns
+ *  whose window is inside the input are computed kConvTileW at a time, the
+ *  border and the remainder one at a time with bound checks.
+ */
+template<int B>
+MXNET_NCHWC_INLINE void ConvRow(const NCHWcConvShape& s, const float* in, const float* weight,
+                                const float* bias, float* out, index_t task) {
+  const index_t n = task / (s.Fb * s.OH), fb = task / s.OH % s.Fb, oh = task % s.OH;
+  in += n * s.Cb * s.H * s.W * B;
+  weight += fb * s.Cb * s.KH * s.KW * B * B;
+  if (bias != nullptr) bias += fb * B;
+  float* o = out + task * s.OW * B;
+  const index_t ow_lo = std::min((s.pad[1] + s.stride[1] - 1) / s.stride[1], s.OW);
+  const index_t span = (s.KW - 1) * s.dilate[1];
+  index_t ow_hi = s.W - 1 + s.pad[1] >= span ? (s.W - 1 + s.pad[1] - span) / s.stride[1] + 1 : 0;
+  ow_hi = std::max(ow_lo, std::min(ow_hi, s.OW));
+  const index_t ow_mid = ow_lo + (ow_hi - ow_lo) / kConvTileW * kConvTileW;
+  ConvPixels<B, 1>(s, in, weight, bias, o, oh, 0, ow_lo, true);
+  ConvPixels<B, kConvTileW>(s, in, weight, bias, o, oh, ow_lo, ow_mid, false);
+  ConvPixels<B, 1>(s, in, weight, bias, o, oh, ow_mid, s.OW, true);
+}
+
+// one clone per instruction set. The clones are not inherited by the body of
+// an omp parallel loop, so they are called from it.
+MXNET_NCHWC_CLONES
+void ConvRowClones(const NCHWcConvShape& s, const float* in, const float* weight,
+                   const float* bias, float* out, index_t task) {
+  if (s.B == 16) {
+    ConvRow<16>(s, in, weight, bias, out, task);
+  } else {
+    ConvRow<8>(s, in, weight, bias, out, task);
+  }
+}
+
+}  // namespace
+
+void NCHWcConvCPU(const NCHWcConvShape& s, const float* in, const float* weight,
+                  const float* bias, float* out) {
+  CHECK(s.B == 8 || s.B == 16) << "unsupported channel block " << s.B;
+  const int nrow = static_cast<int>(s.N * s.Fb * s.OH);
+  #pragma omp parallel for
+  for (int t = 0; t < nrow; ++t) {
+    ConvRowClones(s, in, weight, bias, out, t);
+  }
+}
+
+DMLC_REGISTER_PARAMETER(NCHWcLayoutParam);
+
+NNVM_REGISTER_OP(_to_nchwc)
+.MXNET_DESCRIBE("Convert a NCHW tensor to the blocked NCHWc layout.")
+.set_attr_parser(ParamParser<NCHWcLayoutParam>)
+.set_num_inputs(1)
+.set_num_outputs(1)
+.set_attr<nnvm::FInferShape>("FInferShape",
+  [](const NodeAttrs& attrs, std::vector<TShape> *in_attrs, std::vector<TShape> *out_attrs) {
+    const NCHWcLayoutParam& param = nnvm::get<NCHWcLayoutParam>(attrs.parsed);
+    const TShape& dshape = (*in_attrs)[0];
+    if (dshape.ndim() == 0) return false;
+    CHECK_EQ(dshape.ndim(), 4U) << "_to_nchwc expects a NCHW tensor";
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, Shape5(dshape[0], nchwc::NumBlocks(dshape[1], param.block),
+                                             dshape[2], dshape[3], param.block));
+    return true;
+  })
+.set_attr<nnvm::FInferType>("FInferType", NCHWcType)
+.set_attr<FCompute>("FCompute<cpu>", ToNCHWcCompute<cpu>)
+.add_argument("data", "NDArray", "Input data in NCHW layout")
+.add_arguments(NCHWcLayoutParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_from_nchwc)
+.MXNET_DESCRIBE("Convert a tensor in the blocked NCHWc layout back to NCHW.")
+.set_attr_parser(ParamParser<NCHWcLayoutParam>)
+.set_num_inputs(1)
+.set_num_outputs(1)
+.set_attr<nnvm::FInferShape>("FInferShape",
+  [](const NodeAttrs& attrs, std::vector<TShape> *in_attrs, std::vector<TShape> *out_attrs) {
+    const NCHWcLayoutParam& param = nnvm::get<NCHWcLayoutParam>(attrs.parsed);
+    const TShape& dshape = (*in_attrs)[0];
+    if (dshape.ndim() == 0) return false;
+    CHECK_EQ(dshape.ndim(), 5U) << "_from_nchwc expects a NCHWc tensor";
+    CHECK_GE(dshape[1] * dshape[4], static_cast<index_t>(param.num_channel));
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, Shape4(dshape[0], param.num_channel,
+                                             dshape[2], dshape[3]));
+    return true;
+  })
+.set_attr<nnvm::FInferType>("FInferType", NCHWcType)
+.set_attr<FCompute>("FCompute<cpu>", FromNCHWcCompute<cpu>)
+.add_argument("data", "NDArray", "Input data in NCHWc layout")
+.add_arguments(NCHWcLayoutParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_nchwc_Convolution)
+.MXNET_DESCRIBE("2D Convolution on NCHWc data, with the weight in the layout of Convolution.")
+.set_attr_parser(NCHWcConvParamParser)
+.set_num_inputs([](const NodeAttrs& attrs) {
+    return nnvm::get<NCHWcConvParam>(attrs.parsed).conv.no_bias ? 2U : 3U;
+  })
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    if (nnvm::get<NCHWcConvParam>(attrs.parsed).conv.no_bias) {
+      return std::vector<std::string>{"data", "weight"};
+    }
+    return std::vector<std::string>{"data", "weight", "bias"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape",
+  [](const NodeAttrs& attrs, std::vector<TShape> *in_attrs, std::vector<TShape> *out_attrs) {
+    const ConvolutionParam& param = nnvm::get<NCHWcConvParam>(attrs.parsed).conv;
+    const TShape& dshape = (*in_attrs)[conv::kData];
+    const TShape& wshape = (*in_attrs)[conv::kWeight];
+    // the number of channels cannot be recovered from the padded data.
+    if (dshape.ndim() == 0 || wshape.ndim() == 0) return false;
+    CHECK_EQ(dshape.ndim(), 5U) << "_nchwc_Convolution expects NCHWc data";
+    CHECK_EQ(wshape[0], param.num_filter);
+    CHECK_EQ(nchwc::NumBlocks(wshape[1], dshape[4]), dshape[1]);
+    if (!param.no_bias) {
+      SHAPE_ASSIGN_CHECK(*in_attrs, conv::kBias, Shape1(param.num_filter));
+    }
+    index_t stride[2], dilate[2], pad[2];
+    ConvGeometry(param, stride, dilate, pad);
+    const index_t kh = dilate[0] * (param.kernel[0] - 1) + 1;
+    const index_t kw = dilate[1] * (param.kernel[1] - 1) + 1;
+    CHECK(dshape[2] + 2 * pad[0] >= kh && dshape[3] + 2 * pad[1] >= kw)
+        << "kernel size exceed input";
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, Shape5(dshape[0],
+                                             nchwc::NumBlocks(param.num_filter, dshape[4]),
+                                             (dshape[2] + 2 * pad[0] - kh) / stride[0] + 1,
+                                             (dshape[3] + 2 * pad[1] - kw) / stride[1] + 1,
+                                             dshape[4]));
+    return true;
+  })
+.set_attr<nnvm::FInferType>("FInferType", NCHWcType)
+.set_attr<FCompute>("FCompute<cpu>", NCHWcConvCompute<cpu>)
+.add_argument("data", "NDArray", "Input data in NCHWc layout")
+.add_argument("weight", "NDArray", "Weight matrix in the layout of Convolution")
+.add_argument("bias", "NDArray", "Bias parameter")
+.add_arguments(ConvolutionParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_nchwc_Pooling)
+.MXNET_DESCRIBE("2D Pooling on NCHWc data.")
+.set_attr_parser(NCHWcParamParser<PoolingParam>)
+.set_num_inputs(1)
+.set_num_outputs(1)
+.set_attr<nnvm::FInferShape>("FInferShape",
+  [](const NodeAttrs& attrs, std::vector<TShape> *in_attrs, std::vector<TShape> *out_attrs) {
+    const PoolingParam& param = nnvm::get<PoolingParam>(attrs.parsed);
+    const TShape& dshape = (*in_attrs)[0];
+    if (dshape.ndim() == 0) return false;
+    CHECK_EQ(dshape.ndim(), 5U) << "_nchwc_Pooling expects NCHWc data";
+    TShape oshape = dshape;
+    if (param.global_pool) {
+      oshape[2] = 1;
+      oshape[3] = 1;
+    } else {
+      for (int k = 0; k < 2; ++k) {
+        CHECK(dshape[2 + k] + 2 * param.pad[k] >= param.kernel[k])
+            << "kernel size exceed input";
+        const index_t span = dshape[2 + k] + 2 * param.pad[k] - param.kernel[k];
+        oshape[2 + k] = 1 + (param.pooling_convention == pool_enum::kValid ?
+                             span / param.stride[k] :
+                             (span + param.stride[k] - 1) / param.stride[k]);
+      }
+    }
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, oshape);
+    return true;
+  })
+.set_attr<nnvm::FInferType>("FInferType", NCHWcType)
+.set_attr<FCompute>("FCompute<cpu>", NCHWcPoolingCompute<cpu>)
+.add_argument("data", "NDArray", "Input data in NCHWc layout")
+.add_arguments(PoolingParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_nchwc_BatchNorm)
+.MXNET_DESCRIBE("BatchNorm on NCHWc data. The moving statistics are read only, "
+                "but are declared mutable so that they stay auxiliary states.")
+.set_attr_parser(NCHWcParamParser<BatchNormParam>)
+.set_num_inputs(5)
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return std::vector<std::string>{"data", "gamma", "beta", "moving_mean", "moving_var"};
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs",
+  [](const NodeAttrs& attrs) {
+    return std::vector<uint32_t>{3, 4};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape",
+  [](const NodeAttrs& attrs, std::vector<TShape> *in_attrs, std::vector<TShape> *out_attrs) {
+    const TShape& dshape = (*in_attrs)[batchnorm::kData];
+    const TShape& gshape = (*in_attrs)[batchnorm::kGamma];
+    if (dshape.ndim() == 0 || gshape.ndim() == 0) return false;
+    CHECK_EQ(dshape.ndim(), 5U) << "_nchwc_BatchNorm expects NCHWc data";
+    CHECK_EQ(nchwc::NumBlocks(gshape[0], dshape[4]), dshape[1]);
+    for (size_t i = 1; i < in_attrs->size(); ++i) {
+      SHAPE_ASSIGN_CHECK(*in_attrs, i, gshape);
+    }
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, dshape);
+    return true;
+  })
+.set_attr<nnvm::FInferType>("FInferType", NCHWcType)
+.set_attr<FCompute>("FCompute<cpu>", NCHWcBatchNormCompute<cpu>)
+.add_argument("data", "NDArray", "Input data in NCHWc layout")
+.add_argument("gamma", "NDArray", "gamma array")
+.add_argument("beta", "NDArray", "beta array")
+.add_argument("moving_mean", "NDArray", "running mean of input")
+.add_argument("moving_var", "NDArray", "running variance of input")
+.add_arguments(BatchNormParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
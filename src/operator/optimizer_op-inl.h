@@ -13,13 +13,64 @@
 #include <mshadow/base.h>
 #include <nnvm/op.h>
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <vector>
 #include "./operator_common.h"
 #include "./mshadow_op.h"
 #include "./elemwise_op_common.h"
+#include "./tensor/cast_storage-inl.h"
 
 namespace mxnet {
 namespace op {
+/*!
+ * \brief storage types of an update of a dense weight with a row sparse
+ *  gradient, the other inputs being the dense optimizer states
+ */
+inline bool RowSparseGradUpdateStorageType(const nnvm::NodeAttrs& attrs,
+                                           std::vector<int> *in_attrs,
+                                           std::vector<int> *out_attrs) {
+  CHECK_EQ(out_attrs->size(), 1U);
+  for (size_t i = 0; i < in_attrs->size(); ++i) {
+    if ((*in_attrs)[i] != (i == 1 ? kRowSparseStorage : kDefaultStorage)) return false;
+  }
+  if ((*out_attrs)[0] == kUndefinedStorage) (*out_attrs)[0] = kDefaultStorage;
+  return (*out_attrs)[0] == kDefaultStorage;
+}
+
+/*!
+ * \brief call fn(k, row) for the k-th stored row of a row sparse gradient,
+ *  once the weight is copied to the output. The update is lazy: the rows
+ *  without gradient, their weight decay and their states are left unchanged.
+ */
+template<typename DType, typename Fn>
+inline void RowSparseGradUpdate(const NDArray& weight, const NDArray& grad,
+                                OpReqType req, const NDArray& out, Fn fn) {
+  CHECK_EQ(grad.storage_type(), kRowSparseStorage);
+  CHECK_NE(req, kAddTo) << "An update with a row sparse gradient does not support kAddTo";
+  if (req == kNullOp) return;
+  if (out.data().dptr_ != weight.data().dptr_) {
+    std::memcpy(out.data().dptr_, weight.data().dptr_, weight.shape().Size() * sizeof(DType));
+  }
+  const int nnr = static_cast<int>(grad.storage_shape()[0]);
+  const sparse_index_t* rows = grad.aux_data(rowsparse::kIdx).dptr<sparse_index_t>();
+  #pragma omp parallel for
+  for (int k = 0; k < nnr; ++k) {
+    fn(k, static_cast<index_t>(rows[k]));
+  }
+}
+
+/*! \brief the rescaled and clipped gradient */
+template<typename DType>
+inline DType ScaleClipGrad(DType grad, float rescale_grad, float clip_gradient) {
+  DType g = DType(rescale_grad) * grad;
+  if (clip_gradient >= 0.0f) {
+    g = std::max(std::min(g, DType(clip_gradient)), DType(-clip_gradient));
+  }
+  return g;
+}
+
 struct SGDParam : public dmlc::Parameter<SGDParam> {
   float lr;
   float wd;
@@ -71,6 +122,29 @@ inline void SGDUpdate(const nnvm::NodeAttrs& attrs,
   });
 }
 
+template<typename xpu>
+inline void SGDUpdateEx(const nnvm::NodeAttrs& attrs,
+                        const OpContext &ctx,
+                        const std::vector<NDArray> &inputs,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<NDArray> &outputs) {
+  const SGDParam& param = nnvm::get<SGDParam>(attrs.parsed);
+  const index_t row_size = RowSize(inputs[0].shape());
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].dtype(), DType, {
+    const DType* grad = inputs[1].data().dptr<DType>();
+    DType* out = outputs[0].data().dptr<DType>();
+    RowSparseGradUpdate<DType>(inputs[0], inputs[1], req[0], outputs[0],
+      [&](int k, index_t row) {
+        DType* w = out + static_cast<size_t>(row) * row_size;
+        const DType* g = grad + static_cast<size_t>(k) * row_size;
+        for (index_t j = 0; j < row_size; ++j) {
+          w[j] = DType(1.f-param.lr*param.wd) * w[j] - DType(param.lr) *
+              ScaleClipGrad(g[j], param.rescale_grad, param.clip_gradient);
+        }
+      });
+  });
+}
+
 struct SGDMomParam : public dmlc::Parameter<SGDMomParam> {
   float lr;
   float momentum;
@@ -128,6 +202,33 @@ inline void SGDMomUpdate(const nnvm::NodeAttrs& attrs,
   });
 }
 
+template<typename xpu>
+inline void SGDMomUpdateEx(const nnvm::NodeAttrs& attrs,
+                           const OpContext &ctx,
+                           const std::vector<NDArray> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<NDArray> &outputs) {
+  const SGDMomParam& param = nnvm::get<SGDMomParam>(attrs.parsed);
+  const index_t row_size = RowSize(inputs[0].shape());
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].dtype(), DType, {
+    const DType* grad = inputs[1].data().dptr<DType>();
+    DType* mom = inputs[2].data().dptr<DType>();
+    DType* out = outputs[0].data().dptr<DType>();
+    RowSparseGradUpdate<DType>(inputs[0], inputs[1], req[0], outputs[0],
+      [&](int k, index_t row) {
+        const size_t offset = static_cast<size_t>(row) * row_size;
+        DType* w = out + offset;
+        DType* m = mom + offset;
+        const DType* g = grad + static_cast<size_t>(k) * row_size;
+        for (index_t j = 0; j < row_size; ++j) {
+          m[j] = DType(param.momentum) * m[j] - DType(param.lr*param.wd) * w[j]
+              - DType(param.lr) * ScaleClipGrad(g[j], param.rescale_grad, param.clip_gradient);
+          w[j] += m[j];
+        }
+      });
+  });
+}
+
 struct AdamParam : public dmlc::Parameter<AdamParam> {
   float lr;
   float beta1;
@@ -198,6 +299,37 @@ inline void AdamUpdate(const nnvm::NodeAttrs& attrs,
   });
 }
 
+template<typename xpu>
+inline void AdamUpdateEx(const nnvm::NodeAttrs& attrs,
+                         const OpContext &ctx,
+                         const std::vector<NDArray> &inputs,
+                         const std::vector<OpReqType> &req,
+                         const std::vector<NDArray> &outputs) {
+  const AdamParam& param = nnvm::get<AdamParam>(attrs.parsed);
+  const index_t row_size = RowSize(inputs[0].shape());
+  MSHADOW_REAL_TYPE_SWITCH(inputs[0].dtype(), DType, {
+    const DType* grad = inputs[1].data().dptr<DType>();
+    DType* mean = inputs[2].data().dptr<DType>();
+    DType* var = inputs[3].data().dptr<DType>();
+    DType* out = outputs[0].data().dptr<DType>();
+    RowSparseGradUpdate<DType>(inputs[0], inputs[1], req[0], outputs[0],
+      [&](int k, index_t row) {
+        const size_t offset = static_cast<size_t>(row) * row_size;
+        DType* w = out + offset;
+        DType* m = mean + offset;
+        DType* v = var + offset;
+        const DType* g = grad + static_cast<size_t>(k) * row_size;
+        for (index_t j = 0; j < row_size; ++j) {
+          const DType gj = ScaleClipGrad(g[j], param.rescale_grad, param.clip_gradient);
+          m[j] = DType(param.beta1) * m[j] + DType(1.f-param.beta1) * gj;
+          v[j] = DType(param.beta2) * v[j] + DType(1.f-param.beta2) * gj * gj;
+          w[j] = DType(1.f-param.lr*param.wd) * w[j] -
+              DType(param.lr) * m[j] / (DType(std::sqrt(v[j])) + DType(param.epsilon));
+        }
+      });
+  });
+}
+
 // This RMSProp code follows the version in
 // http://arxiv.org/pdf/1308.0850v5.pdf Eq(38) - Eq(45)
 // by Alex Graves, 2013.
@@ -15,17 +15,21 @@ DMLC_REGISTER_PARAMETER(AdamParam);
 DMLC_REGISTER_PARAMETER(RMSPropParam);
 
 NNVM_REGISTER_OP(sgd_update)
-.describe("Updater function for sgd optimizer")
+.describe("Updater function for sgd optimizer. On CPU, a row sparse gradient "
+          "only updates the rows it stores")
 .set_num_inputs(2)
 .set_num_outputs(1)
 .set_attr_parser(ParamParser<SGDParam>)
 .set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<2, 1>)
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
 .set_attr<FCompute>("FCompute<cpu>", SGDUpdate<cpu>)
+.set_attr<FInferStorageType>("FInferStorageType", RowSparseGradUpdateStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", SGDUpdateEx<cpu>)
 .add_arguments(SGDParam::__FIELDS__());
 
 NNVM_REGISTER_OP(sgd_mom_update)
-.describe("Updater function for sgd optimizer")
+.describe("Updater function for sgd optimizer. On CPU, a row sparse gradient "
+          "only updates the rows it stores")
 .set_num_inputs(3)
 .set_num_outputs(1)
 .set_attr_parser(ParamParser<SGDMomParam>)
@@ -36,10 +40,13 @@ NNVM_REGISTER_OP(sgd_mom_update)
     return std::vector<uint32_t>{2};
   })
 .set_attr<FCompute>("FCompute<cpu>", SGDMomUpdate<cpu>)
+.set_attr<FInferStorageType>("FInferStorageType", RowSparseGradUpdateStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", SGDMomUpdateEx<cpu>)
 .add_arguments(SGDMomParam::__FIELDS__());
 
 NNVM_REGISTER_OP(adam_update)
-.describe("Updater function for adam optimizer")
+.describe("Updater function for adam optimizer. On CPU, a row sparse gradient "
+          "only updates the rows it stores and their states")
 .set_num_inputs(4)
 .set_num_outputs(1)
 .set_attr_parser(ParamParser<AdamParam>)
@@ -50,6 +57,8 @@ NNVM_REGISTER_OP(adam_update)
     return std::vector<uint32_t>{2, 3};
   })
 .set_attr<FCompute>("FCompute<cpu>", AdamUpdate<cpu>)
+.set_attr<FInferStorageType>("FInferStorageType", RowSparseGradUpdateStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", AdamUpdateEx<cpu>)
 .add_arguments(AdamParam::__FIELDS__());
 
 NNVM_REGISTER_OP(rmsprop_update)
@@ -0,0 +1,246 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file pooling_cpu-inl.h
+ * \brief 2D and 3D pooling on CPU with direct kernels
+*/
+#ifndef MXNET_OPERATOR_POOLING_CPU_INL_H_
+#define MXNET_OPERATOR_POOLING_CPU_INL_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <vector>
+#include "./pooling-inl.h"
+
+namespace mxnet {
+namespace op {
+
+/*! \brief sizes of a 2D or 3D pooling, a 2D pooling has a depth of 1 */
+struct PoolingGeometry {
+  int num_planes;
+  int in[3], out[3], kernel[3], stride[3], pad[3];
+
+  inline int in_size() const { return in[0] * in[1] * in[2]; }
+  inline int out_size() const { return out[0] * out[1] * out[2]; }
+  // the outputs [lo, hi) along axis whose window contains the input k positions after its start
+  inline void OutputRange(int axis, int k, int* lo, int* hi) const {
+    const int s = stride[axis], p = pad[axis];
+    *lo = p - k > 0 ? (p - k + s - 1) / s : 0;
+    *hi = std::min(out[axis], in[axis] - 1 + p - k >= 0 ? (in[axis] - 1 + p - k) / s + 1 : 0);
+  }
+  // the inputs [lo, hi) along axis in the window of output o
+  inline void InputRange(int axis, int o, int* lo, int* hi) const {
+    const int start = o * stride[axis] - pad[axis];
+    *lo = std::max(start, 0);
+    *hi = std::min(start + kernel[axis], in[axis]);
+  }
+};
+
+/*!
+ * \brief Pooling on CPU. The planes of the batch and the channels are
+ *  pooled in parallel. Every output row is computed by looping over the
+ *  positions of the window and, innermost, over the output columns whose
+ *  window contains that position inside the input, so padding is never
+ *  materialized and the inner loop vectorizes. Max pooling keeps the
+ *  position of the maximum of every output when training, so backward
+ *  scatters the gradient without looking at the data again.
+ */
+template<typename DType>
+class PoolingCPUOp : public Operator {
+ public:
+  explicit PoolingCPUOp(PoolingParam p) : param_(p) {}
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    CHECK_EQ(in_data.size(), 1U);
+    CHECK_EQ(out_data.size(), 1U);
+    const OpReqType out_req = req[pool_enum::kOut];
+    if (out_req == kNullOp) return;
+    const PoolingGeometry g = this->Geometry(in_data[pool_enum::kData].shape_,
+                                             out_data[pool_enum::kOut].shape_);
+    const DType* data = in_data[pool_enum::kData].dptr<DType>();
+    DType* out = out_data[pool_enum::kOut].dptr<DType>();
+    const bool max_pool = param_.pool_type == pool_enum::kMaxPooling;
+    const bool save_argmax = max_pool && ctx.is_train;
+    if (save_argmax) {
+      argmax_.resize(static_cast<size_t>(g.num_planes) * g.out_size());
+    } else {
+      argmax_.clear();
+    }
+    const DType scale = param_.pool_type == pool_enum::kAvgPooling ?
+        DType(1.0f / (g.kernel[0] * g.kernel[1] * g.kernel[2])) : DType(1);
+    const int OW = g.out[2];
+    #pragma omp parallel
+    {
+      std::vector<DType> acc(OW);
+      std::vector<int> idx(OW);
+      #pragma omp for
+      for (int plane = 0; plane < g.num_planes; ++plane) {
+        const DType* src = data + static_cast<size_t>(plane) * g.in_size();
+        DType* dst = out + static_cast<size_t>(plane) * g.out_size();
+        int* arg = save_argmax ? &argmax_[static_cast<size_t>(plane) * g.out_size()] : nullptr;
+        for (int od = 0; od < g.out[0]; ++od) {
+          int d0, d1;
+          g.InputRange(0, od, &d0, &d1);
+          for (int oh = 0; oh < g.out[1]; ++oh) {
+            int h0, h1;
+            g.InputRange(1, oh, &h0, &h1);
+            std::fill(acc.begin(), acc.end(), DType(0));
+            std::fill(idx.begin(), idx.end(), -1);
+            for (int d = d0; d < d1; ++d) {
+              for (int h = h0; h < h1; ++h) {
+                const int row = (d * g.in[1] + h) * g.in[2];
+                for (int kw = 0; kw < g.kernel[2]; ++kw) {
+                  int lo, hi;
+                  g.OutputRange(2, kw, &lo, &hi);
+                  const int offset = kw - g.pad[2];
+                  if (max_pool) {
+                    this->MaxRow(src + row, row, g.stride[2], offset, lo, hi, &acc[0], &idx[0]);
+                  } else {
+                    this->SumRow(src, row, g.stride[2], offset, lo, hi, &acc[0]);
+                  }
+                }
+              }
+            }
+            DType* y = dst + (od * g.out[1] + oh) * OW;
+            for (int ow = 0; ow < OW; ++ow) {
+              // a window entirely in the padding gives 0
+              const DType val = acc[ow] * scale;
+              if (out_req == kAddTo) {
+                y[ow] += val;
+              } else {
+                y[ow] = val;
+              }
+            }
+            if (arg != nullptr) {
+              std::copy(idx.begin(), idx.end(), arg + (od * g.out[1] + oh) * OW);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  virtual void Backward(const OpContext &ctx,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<TBlob> &out_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad,
+                        const std::vector<TBlob> &aux_args) {
+    CHECK_EQ(out_grad.size(), 1U);
+    CHECK_EQ(in_grad.size(), 1U);
+    CHECK_EQ(req.size(), 1U);
+    const OpReqType grad_req = req[pool_enum::kData];
+    if (grad_req == kNullOp) return;
+    const PoolingGeometry g = this->Geometry(in_grad[pool_enum::kData].shape_,
+                                             out_grad[pool_enum::kOut].shape_);
+    const DType* grad = out_grad[pool_enum::kOut].dptr<DType>();
+    // the data may share memory with its gradient, it is not read here
+    DType* grad_in = in_grad[pool_enum::kData].dptr<DType>();
+    const bool max_pool = param_.pool_type == pool_enum::kMaxPooling;
+    if (max_pool) {
+      CHECK_EQ(argmax_.size(), static_cast<size_t>(g.num_planes) * g.out_size())
+        << "Max pooling backward requires a forward pass in training mode";
+    }
+    const DType scale = param_.pool_type == pool_enum::kAvgPooling ?
+        DType(1.0f / (g.kernel[0] * g.kernel[1] * g.kernel[2])) : DType(1);
+    const int OW = g.out[2];
+    #pragma omp parallel
+    {
+      std::vector<DType> dy(OW);
+      #pragma omp for
+      for (int plane = 0; plane < g.num_planes; ++plane) {
+        DType* dst = grad_in + static_cast<size_t>(plane) * g.in_size();
+        const DType* src = grad + static_cast<size_t>(plane) * g.out_size();
+        if (grad_req != kAddTo) std::fill(dst, dst + g.in_size(), DType(0));
+        if (max_pool) {
+          const int* arg = &argmax_[static_cast<size_t>(plane) * g.out_size()];
+          for (int o = 0; o < g.out_size(); ++o) {
+            if (arg[o] >= 0) dst[arg[o]] += src[o];
+          }
+          continue;
+        }
+        for (int od = 0; od < g.out[0]; ++od) {
+          int d0, d1;
+          g.InputRange(0, od, &d0, &d1);
+          for (int oh = 0; oh < g.out[1]; ++oh) {
+            int h0, h1;
+            g.InputRange(1, oh, &h0, &h1);
+            const DType* y = src + (od * g.out[1] + oh) * OW;
+            for (int ow = 0; ow < OW; ++ow) dy[ow] = y[ow] * scale;
+            for (int d = d0; d < d1; ++d) {
+              for (int h = h0; h < h1; ++h) {
+                DType* row = dst + (d * g.in[1] + h) * g.in[2];
+                for (int kw = 0; kw < g.kernel[2]; ++kw) {
+                  int lo, hi;
+                  g.OutputRange(2, kw, &lo, &hi);
+                  const int offset = kw - g.pad[2];
+                  for (int ow = lo; ow < hi; ++ow) row[ow * g.stride[2] + offset] += dy[ow];
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  inline PoolingGeometry Geometry(const TShape& ishape, const TShape& oshape) const {
+    const index_t nd = param_.kernel.ndim();
+    CHECK(nd == 2 || nd == 3) << "Pooling only supports 2D and 3D kernels";
+    CHECK_EQ(ishape.ndim(), nd + 2U);
+    if (!param_.global_pool) {
+      CHECK_EQ(param_.stride.ndim(), nd) << "Pooling: stride must have as many dims as kernel";
+      CHECK_EQ(param_.pad.ndim(), nd) << "Pooling: pad must have as many dims as kernel";
+    }
+    PoolingGeometry g;
+    g.num_planes = ishape[0] * ishape[1];
+    for (int i = 0; i < 3; ++i) {
+      // a 2D pooling is a 3D pooling with a depth of 1
+      const int k = i - (3 - static_cast<int>(nd));
+      if (k < 0) {
+        g.in[i] = g.out[i] = g.kernel[i] = g.stride[i] = 1;
+        g.pad[i] = 0;
+      } else {
+        g.in[i] = ishape[k + 2];
+        g.out[i] = oshape[k + 2];
+        g.kernel[i] = param_.global_pool ? g.in[i] : param_.kernel[k];
+        g.stride[i] = param_.global_pool ? 1 : param_.stride[k];
+        g.pad[i] = param_.global_pool ? 0 : param_.pad[k];
+      }
+    }
+    return g;
+  }
+
+  // max of the input row into the outputs [lo, hi), position ow reads x[ow * stride + offset]
+  inline void MaxRow(const DType* x, int row, int stride, int offset, int lo, int hi,
+                     DType* acc, int* idx) const {
+    for (int ow = lo; ow < hi; ++ow) {
+      const int w = ow * stride + offset;
+      const DType v = x[w];
+      if (idx[ow] < 0 || v > acc[ow]) {
+        acc[ow] = v;
+        idx[ow] = row + w;
+      }
+    }
+  }
+
+  inline void SumRow(const DType* src, int row, int stride, int offset, int lo, int hi,
+                     DType* acc) const {
+    const DType* x = src + row;
+    for (int ow = lo; ow < hi; ++ow) acc[ow] += x[ow * stride + offset];
+  }
+
+  PoolingParam param_;
+  /*! \brief position in its plane of the maximum of every output of the last training forward */
+  std::vector<int> argmax_;
+};  // class PoolingCPUOp
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_POOLING_CPU_INL_H_
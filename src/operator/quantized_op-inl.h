@@ -0,0 +1,278 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file quantized_op-inl.h
+ * \brief 8-bit quantized operators for CPU inference.
+ *
+ *  A quantized tensor stores uint8 values q that represent the real values
+ *  min + q * scale with scale = (max - min) / 255. Ranges always contain
+ *  zero, which is represented exactly, so zero padding stays exact.
+ *  Quantized FullyConnected and Convolution multiply uint8 data with uint8
+ *  weights with int32 accumulation, and requantize the int32 sums to float32
+ *  outputs in the epilogue, where the bias is added. The next quantized layer
+ *  quantizes its input again with its own calibrated range.
+ */
+#ifndef MXNET_OPERATOR_QUANTIZED_OP_INL_H_
+#define MXNET_OPERATOR_QUANTIZED_OP_INL_H_
+
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator_util.h>
+#include <mxnet/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "./operator_common.h"
+#include "./convolution-inl.h"
+#include "./fully_connected-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace quantized {
+/*! \brief affine mapping between uint8 and real values */
+struct QuantRange {
+  float min;
+  float scale;
+  QuantRange(float lo, float hi) {
+    // widen to contain zero and move min so that zero is a quantized value
+    lo = std::min(lo, 0.0f);
+    hi = std::max(hi, 0.0f);
+    scale = hi > lo ? (hi - lo) / 255.0f : 1.0f;
+    min = -std::round(-lo / scale) * scale;
+  }
+  inline uint8_t Quantize(float x) const {
+    const float q = std::round((x - min) / scale);
+    return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, q)));
+  }
+  inline float Dequantize(uint8_t q) const {
+    return min + q * scale;
+  }
+  /*! \brief the quantized value of zero */
+  inline uint8_t zero() const {
+    return Quantize(0.0f);
+  }
+};
+
+/*! \brief largest inner product length whose uint8 sums fit in int32 */
+const index_t kMaxDotLength = 33025;
+
+/*!
+ * \brief out[i][j] = sum_k a[i][k] * b[j][k] for uint8 row major a (M x K)
+ *  and b (N x K), with int32 accumulation. The output is split in blocks of
+ *  rows of a and rows of b that are accumulated over slices of K, so that the
+ *  slice of b of a block stays in cache while every row of a of the block
+ *  reads it. Within a block two rows of a and four rows of b are multiplied
+ *  at a time, so that each byte loaded is used in several sums.
+ */
+void GemmU8(const uint8_t* a, const uint8_t* b, int32_t* out,
+            index_t M, index_t N, index_t K);
+
+/*! \brief sum of each row of a uint8 row major matrix */
+inline void RowSumU8(const uint8_t* a, index_t M, index_t K, int32_t* out) {
+  for (index_t i = 0; i < M; ++i) {
+    int32_t s = 0;
+    for (index_t k = 0; k < K; ++k) s += a[i * K + k];
+    out[i] = s;
+  }
+}
+
+/*!
+ * \brief requantize the int32 products of quantized a and b to real values:
+ *  sum_k (amin + qa sa)(bmin + qb sb) expands into the int32 sum and the
+ *  row sums of qa and qb.
+ */
+inline float Requantize(int32_t acc, int32_t a_sum, int32_t b_sum, index_t K,
+                        const QuantRange& a, const QuantRange& b) {
+  // in double, the terms can be much larger than their sum
+  return static_cast<float>(static_cast<double>(a.scale) * b.scale * acc +
+                            static_cast<double>(a.min) * b.scale * b_sum +
+                            static_cast<double>(b.min) * a.scale * a_sum +
+                            static_cast<double>(K) * a.min * b.min);
+}
+}  // namespace quantized
+
+struct QuantizeParam : public dmlc::Parameter<QuantizeParam> {
+  float min_range;
+  float max_range;
+  DMLC_DECLARE_PARAMETER(QuantizeParam) {
+    DMLC_DECLARE_FIELD(min_range)
+    .describe("Minimum of the real values to represent.");
+    DMLC_DECLARE_FIELD(max_range)
+    .describe("Maximum of the real values to represent.");
+  }
+};
+
+struct QuantizedRangeParam : public dmlc::Parameter<QuantizedRangeParam> {
+  float data_min;
+  float data_max;
+  float weight_min;
+  float weight_max;
+  DMLC_DECLARE_PARAMETER(QuantizedRangeParam) {
+    DMLC_DECLARE_FIELD(data_min).describe("Minimum of the range of the quantized data.");
+    DMLC_DECLARE_FIELD(data_max).describe("Maximum of the range of the quantized data.");
+    DMLC_DECLARE_FIELD(weight_min).describe("Minimum of the range of the quantized weight.");
+    DMLC_DECLARE_FIELD(weight_max).describe("Maximum of the range of the quantized weight.");
+  }
+};
+
+/*! \brief parameters of a quantized layer: the ones of the float layer and the ranges */
+template<typename LayerParam>
+struct QuantizedLayerParam {
+  LayerParam layer;
+  QuantizedRangeParam range;
+};
+
+template<typename LayerParam>
+inline void QuantizedLayerParamParser(nnvm::NodeAttrs* attrs) {
+  QuantizedLayerParam<LayerParam> param;
+  param.layer.InitAllowUnknown(attrs->dict);
+  param.range.InitAllowUnknown(attrs->dict);
+  attrs->parsed = std::move(param);
+}
+
+template<typename xpu>
+void QuantizeCompute(const nnvm::NodeAttrs& attrs,
+                     const OpContext& ctx,
+                     const std::vector<TBlob>& inputs,
+                     const std::vector<OpReqType>& req,
+                     const std::vector<TBlob>& outputs) {
+  const QuantizeParam& param = nnvm::get<QuantizeParam>(attrs.parsed);
+  if (req[0] == kNullOp) return;
+  CHECK_EQ(req[0], kWriteTo);
+  const quantized::QuantRange range(param.min_range, param.max_range);
+  const float* in = inputs[0].dptr<float>();
+  uint8_t* out = outputs[0].dptr<uint8_t>();
+  const int size = static_cast<int>(inputs[0].Size());
+  #pragma omp parallel for
+  for (int i = 0; i < size; ++i) out[i] = range.Quantize(in[i]);
+}
+
+template<typename xpu>
+void DequantizeCompute(const nnvm::NodeAttrs& attrs,
+                       const OpContext& ctx,
+                       const std::vector<TBlob>& inputs,
+                       const std::vector<OpReqType>& req,
+                       const std::vector<TBlob>& outputs) {
+  const QuantizeParam& param = nnvm::get<QuantizeParam>(attrs.parsed);
+  if (req[0] == kNullOp) return;
+  CHECK_EQ(req[0], kWriteTo);
+  const quantized::QuantRange range(param.min_range, param.max_range);
+  const uint8_t* in = inputs[0].dptr<uint8_t>();
+  float* out = outputs[0].dptr<float>();
+  const int size = static_cast<int>(inputs[0].Size());
+  #pragma omp parallel for
+  for (int i = 0; i < size; ++i) out[i] = range.Dequantize(in[i]);
+}
+
+template<typename xpu>
+void QuantizedFullyConnectedCompute(const nnvm::NodeAttrs& attrs,
+                                    const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<OpReqType>& req,
+                                    const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  const auto& param = nnvm::get<QuantizedLayerParam<FullyConnectedParam> >(attrs.parsed);
+  if (req[fullc::kOut] == kNullOp) return;
+  CHECK_EQ(req[fullc::kOut], kWriteTo);
+  const quantized::QuantRange drange(param.range.data_min, param.range.data_max);
+  const quantized::QuantRange wrange(param.range.weight_min, param.range.weight_max);
+  const TShape& dshape = inputs[fullc::kData].shape_;
+  const index_t M = dshape[0], K = dshape.Size() / dshape[0];
+  const index_t N = param.layer.num_hidden;
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  Tensor<xpu, 1, int32_t> workspace = ctx.requested[0]
+      .get_space_typed<xpu, 1, int32_t>(Shape1(M * N + M + N), s);
+  int32_t* acc = workspace.dptr_;
+  int32_t* a_sum = acc + M * N;
+  int32_t* b_sum = a_sum + M;
+  const uint8_t* data = inputs[fullc::kData].dptr<uint8_t>();
+  const uint8_t* weight = inputs[fullc::kWeight].dptr<uint8_t>();
+  quantized::GemmU8(data, weight, acc, M, N, K);
+  quantized::RowSumU8(data, M, K, a_sum);
+  quantized::RowSumU8(weight, N, K, b_sum);
+  const float* bias = param.layer.no_bias ? nullptr : inputs[fullc::kBias].dptr<float>();
+  float* out = outputs[fullc::kOut].dptr<float>();
+  #pragma omp parallel for
+  for (int i = 0; i < static_cast<int>(M); ++i) {
+    for (index_t j = 0; j < N; ++j) {
+      out[i * N + j] = quantized::Requantize(acc[i * N + j], a_sum[i], b_sum[j], K,
+                                             drange, wrange) +
+          (bias != nullptr ? bias[j] : 0.0f);
+    }
+  }
+}
+
+// 2D convolution in NCHW as an int32 GEMM of the uint8 weight with the
+// patches of each image, stored patch major so the inner product is contiguous.
+template<typename xpu>
+void QuantizedConvolutionCompute(const nnvm::NodeAttrs& attrs,
+                                 const OpContext& ctx,
+                                 const std::vector<TBlob>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  const auto& param = nnvm::get<QuantizedLayerParam<ConvolutionParam> >(attrs.parsed);
+  if (req[conv::kOut] == kNullOp) return;
+  CHECK_EQ(req[conv::kOut], kWriteTo);
+  const quantized::QuantRange drange(param.range.data_min, param.range.data_max);
+  const quantized::QuantRange wrange(param.range.weight_min, param.range.weight_max);
+  const TShape& dshape = inputs[conv::kData].shape_;
+  const TShape& oshape = outputs[conv::kOut].shape_;
+  const index_t N = dshape[0], C = dshape[1], H = dshape[2], W = dshape[3];
+  const index_t F = oshape[1], OH = oshape[2], OW = oshape[3];
+  const index_t KH = param.layer.kernel[0], KW = param.layer.kernel[1];
+  const index_t SH = param.layer.stride.ndim() ? param.layer.stride[0] : 1;
+  const index_t SW = param.layer.stride.ndim() ? param.layer.stride[1] : 1;
+  const index_t DH = param.layer.dilate.ndim() ? param.layer.dilate[0] : 1;
+  const index_t DW = param.layer.dilate.ndim() ? param.layer.dilate[1] : 1;
+  const index_t PH = param.layer.pad.ndim() ? param.layer.pad[0] : 0;
+  const index_t PW = param.layer.pad.ndim() ? param.layer.pad[1] : 0;
+  const index_t K = C * KH * KW, P = OH * OW;
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  // col (P x K uint8) followed by acc (P x F), patch sums (P) and filter sums (F)
+  const index_t col_words = (P * K + 3) / 4;
+  Tensor<xpu, 1, int32_t> workspace = ctx.requested[conv::kTempSpace]
+      .get_space_typed<xpu, 1, int32_t>(Shape1(col_words + P * F + P + F), s);
+  uint8_t* col = reinterpret_cast<uint8_t*>(workspace.dptr_);
+  int32_t* acc = workspace.dptr_ + col_words;
+  int32_t* a_sum = acc + P * F;
+  int32_t* b_sum = a_sum + P;
+  const uint8_t zero = drange.zero();
+  const uint8_t* weight = inputs[conv::kWeight].dptr<uint8_t>();
+  quantized::RowSumU8(weight, F, K, b_sum);
+  const float* bias = param.layer.no_bias ? nullptr : inputs[conv::kBias].dptr<float>();
+  for (index_t n = 0; n < N; ++n) {
+    const uint8_t* data = inputs[conv::kData].dptr<uint8_t>() + n * C * H * W;
+    #pragma omp parallel for
+    for (int p = 0; p < static_cast<int>(P); ++p) {
+      const index_t oh = p / OW, ow = p % OW;
+      uint8_t* row = col + p * K;
+      for (index_t c = 0; c < C; ++c) {
+        for (index_t kh = 0; kh < KH; ++kh) {
+          const index_t ih = oh * SH + kh * DH - PH;
+          for (index_t kw = 0; kw < KW; ++kw) {
+            const index_t iw = ow * SW + kw * DW - PW;
+            // index_t is unsigned, so negative positions wrap and fail the check too
+            *row++ = (ih < H && iw < W) ? data[(c * H + ih) * W + iw] : zero;
+          }
+        }
+      }
+    }
+    quantized::GemmU8(col, weight, acc, P, F, K);
+    quantized::RowSumU8(col, P, K, a_sum);
+    float* out = outputs[conv::kOut].dptr<float>() + n * F * P;
+    #pragma omp parallel for
+    for (int f = 0; f < static_cast<int>(F); ++f) {
+      const float b = bias != nullptr ? bias[f] : 0.0f;
+      for (index_t p = 0; p < P; ++p) {
+        out[f * P + p] = quantized::Requantize(acc[p * F + f], a_sum[p], b_sum[f], K,
+                                               drange, wrange) + b;
+      }
+    }
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_QUANTIZED_OP_INL_H_
@@ -0,0 +1,268 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file quantized_op.cc
+ * \brief CPU implementation of the 8-bit quantized operators.
+ */
+#include "./quantized_op-inl.h"
+#include "./elemwise_op_common.h"
+
+// gcc resolves the clones with an ifunc when the library is loaded
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 && \
+    defined(__x86_64__) && defined(__linux__)
+#define MXNET_QUANTIZED_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define MXNET_QUANTIZED_CLONES
+#endif
+
+namespace mxnet {
+namespace op {
+namespace quantized {
+namespace {
+
+// rows of a, rows of b and depth of a block, a slice of b is 32KB
+const index_t kGemmU8BlockM = 16, kGemmU8BlockN = 64, kGemmU8BlockK = 512;
+
+// the block of out at row i0 and column j0, one clone per instruction set
+MXNET_QUANTIZED_CLONES
+void GemmU8Block(const uint8_t* a, const uint8_t* b, int32_t* out, index_t M, index_t N,
+                 index_t K, index_t i0, index_t j0) {
+  const index_t i1 = std::min(i0 + kGemmU8BlockM, M), j1 = std::min(j0 + kGemmU8BlockN, N);
+  for (index_t i = i0; i < i1; ++i) {
+    std::fill(out + i * N + j0, out + i * N + j1, 0);
+  }
+  for (index_t k0 = 0; k0 < K; k0 += kGemmU8BlockK) {
+    const index_t kn = std::min(kGemmU8BlockK, K - k0);
+    index_t i = i0;
+    // two rows of a by four rows of b, eight sums in registers
+    for (; i + 2 <= i1; i += 2) {
+      const uint8_t* x0 = a + i * K + k0;
+      const uint8_t* x1 = x0 + K;
+      int32_t* y0 = out + i * N;
+      int32_t* y1 = y0 + N;
+      index_t j = j0;
+      for (; j + 4 <= j1; j += 4) {
+        const uint8_t* w0 = b + j * K + k0;
+        const uint8_t* w1 = w0 + K;
+        const uint8_t* w2 = w1 + K;
+        const uint8_t* w3 = w2 + K;
+        int32_t s00 = 0, s01 = 0, s02 = 0, s03 = 0, s10 = 0, s11 = 0, s12 = 0, s13 = 0;
+        for (index_t k = 0; k < kn; ++k) {
+          const int32_t u = x0[k], v = x1[k];
+          s00 += u * w0[k];
+          s01 += u * w1[k];
+          s02 += u * w2[k];
+          s03 += u * w3[k];
+          s10 += v * w0[k];
+          s11 += v * w1[k];
+          s12 += v * w2[k];
+          s13 += v * w3[k];
+        }
+        y0[j] += s00; y0[j + 1] += s01; y0[j + 2] += s02; y0[j + 3] += s03;
+        y1[j] += s10; y1[j + 1] += s11; y1[j + 2] += s12; y1[j + 3] += s13;
+      }
+      for (; j < j1; ++j) {
+        const uint8_t* w = b + j * K + k0;
+        int32_t s0 = 0, s1 = 0;
+        for (index_t k = 0; k < kn; ++k) {
+          s0 += static_cast<int32_t>(x0[k]) * w[k];
+          s1 += static_cast<int32_t>(x1[k]) * w[k];
+        }
+        y0[j] += s0;
+        y1[j] += s1;
+      }
+    }
+    if (i < i1) {
+      // the last row, with four rows of b at a time
+      const uint8_t* x = a + i * K + k0;
+      int32_t* y = out + i * N;
+      index_t j = j0;
+      for (; j + 4 <= j1; j += 4) {
+        const uint8_t* w0 = b + j * K + k0;
+        const uint8_t* w1 = w0 + K;
+        const uint8_t* w2 = w1 + K;
+        const uint8_t* w3 = w2 + K;
+        int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (index_t k = 0; k < kn; ++k) {
+          const int32_t u = x[k];
+          s0 += u * w0[k];
+          s1 += u * w1[k];
+          s2 += u * w2[k];
+          s3 += u * w3[k];
+        }
+        y[j] += s0; y[j + 1] += s1; y[j + 2] += s2; y[j + 3] += s3;
+      }
+      for (; j < j1; ++j) {
+        const uint8_t* w = b + j * K + k0;
+        int32_t s = 0;
+        for (index_t k = 0; k < kn; ++k) s += static_cast<int32_t>(x[k]) * w[k];
+        y[j] += s;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void GemmU8(const uint8_t* a, const uint8_t* b, int32_t* out,
+            index_t M, index_t N, index_t K) {
+  const index_t mb = (M + kGemmU8BlockM - 1) / kGemmU8BlockM;
+  const index_t nb = (N + kGemmU8BlockN - 1) / kGemmU8BlockN;
+  // the clones are not inherited by the body of an omp loop
+  #pragma omp parallel for
+  for (int t = 0; t < static_cast<int>(mb * nb); ++t) {
+    GemmU8Block(a, b, out, M, N, K, t / nb * kGemmU8BlockM, t % nb * kGemmU8BlockN);
+  }
+}
+
+}  // namespace quantized
+
+DMLC_REGISTER_PARAMETER(QuantizeParam);
+DMLC_REGISTER_PARAMETER(QuantizedRangeParam);
+
+// assign the dtype of each input and output
+inline bool QuantizedType(const std::vector<int>& in_types, int out_type,
+                          std::vector<int> *in_attrs, std::vector<int> *out_attrs) {
+  for (size_t i = 0; i < in_attrs->size(); ++i) {
+    TYPE_ASSIGN_CHECK(*in_attrs, i, in_types[i]);
+  }
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, out_type);
+  return true;
+}
+
+NNVM_REGISTER_OP(_quantize)
+.MXNET_DESCRIBE("Quantize float32 data to uint8 over the range [min_range, max_range], "
+                "widened to contain 0.")
+.set_attr_parser(ParamParser<QuantizeParam>)
+.set_num_inputs(1)
+.set_num_outputs(1)
+.set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<1, 1>)
+.set_attr<nnvm::FInferType>("FInferType",
+  [](const NodeAttrs& attrs, std::vector<int> *in_attrs, std::vector<int> *out_attrs) {
+    return QuantizedType({mshadow::kFloat32}, mshadow::kUint8, in_attrs, out_attrs);
+  })
+.set_attr<FCompute>("FCompute<cpu>", QuantizeCompute<cpu>)
+.add_argument("data", "NDArray", "float32 input")
+.add_arguments(QuantizeParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_dequantize)
+.MXNET_DESCRIBE("Dequantize uint8 data quantized over [min_range, max_range] to float32.")
+.set_attr_parser(ParamParser<QuantizeParam>)
+.set_num_inputs(1)
+.set_num_outputs(1)
+.set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<1, 1>)
+.set_attr<nnvm::FInferType>("FInferType",
+  [](const NodeAttrs& attrs, std::vector<int> *in_attrs, std::vector<int> *out_attrs) {
+    return QuantizedType({mshadow::kUint8}, mshadow::kFloat32, in_attrs, out_attrs);
+  })
+.set_attr<FCompute>("FCompute<cpu>", DequantizeCompute<cpu>)
+.add_argument("data", "NDArray", "uint8 input")
+.add_arguments(QuantizeParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_quantized_FullyConnected)
+.MXNET_DESCRIBE("FullyConnected of uint8 data and weight with int32 accumulation "
+                "and float32 output.")
+.set_attr_parser(QuantizedLayerParamParser<FullyConnectedParam>)
+.set_num_inputs([](const NodeAttrs& attrs) {
+    const auto& param = nnvm::get<QuantizedLayerParam<FullyConnectedParam> >(attrs.parsed);
+    return param.layer.no_bias ? 2U : 3U;
+  })
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    const auto& param = nnvm::get<QuantizedLayerParam<FullyConnectedParam> >(attrs.parsed);
+    if (param.layer.no_bias) return std::vector<std::string>{"data", "weight"};
+    return std::vector<std::string>{"data", "weight", "bias"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape",
+  [](const NodeAttrs& attrs, std::vector<TShape> *in_attrs, std::vector<TShape> *out_attrs) {
+    const auto& param = nnvm::get<QuantizedLayerParam<FullyConnectedParam> >(attrs.parsed);
+    const TShape& dshape = (*in_attrs)[fullc::kData];
+    if (dshape.ndim() == 0) return false;
+    const index_t num_input = dshape.ProdShape(1, dshape.ndim());
+    CHECK_LE(num_input, quantized::kMaxDotLength) << "input too large for int32 accumulation";
+    SHAPE_ASSIGN_CHECK(*in_attrs, fullc::kWeight, Shape2(param.layer.num_hidden, num_input));
+    if (!param.layer.no_bias) {
+      SHAPE_ASSIGN_CHECK(*in_attrs, fullc::kBias, Shape1(param.layer.num_hidden));
+    }
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, Shape2(dshape[0], param.layer.num_hidden));
+    return true;
+  })
+.set_attr<nnvm::FInferType>("FInferType",
+  [](const NodeAttrs& attrs, std::vector<int> *in_attrs, std::vector<int> *out_attrs) {
+    return QuantizedType({mshadow::kUint8, mshadow::kUint8, mshadow::kFloat32},
+                         mshadow::kFloat32, in_attrs, out_attrs);
+  })
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", QuantizedFullyConnectedCompute<cpu>)
+.add_argument("data", "NDArray", "uint8 input data")
+.add_argument("weight", "NDArray", "uint8 weight")
+.add_argument("bias", "NDArray", "float32 bias")
+.add_arguments(FullyConnectedParam::__FIELDS__())
+.add_arguments(QuantizedRangeParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_quantized_Convolution)
+.MXNET_DESCRIBE("2D Convolution of uint8 NCHW data and weight with int32 accumulation "
+                "and float32 output.")
+.set_attr_parser(QuantizedLayerParamParser<ConvolutionParam>)
+.set_num_inputs([](const NodeAttrs& attrs) {
+    const auto& param = nnvm::get<QuantizedLayerParam<ConvolutionParam> >(attrs.parsed);
+    return param.layer.no_bias ? 2U : 3U;
+  })
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    const auto& param = nnvm::get<QuantizedLayerParam<ConvolutionParam> >(attrs.parsed);
+    if (param.layer.no_bias) return std::vector<std::string>{"data", "weight"};
+    return std::vector<std::string>{"data", "weight", "bias"};
+  })
+.set_attr<nnvm::FInferShape>("FInferShape",
+  [](const NodeAttrs& attrs, std::vector<TShape> *in_attrs, std::vector<TShape> *out_attrs) {
+    const ConvolutionParam& param =
+        nnvm::get<QuantizedLayerParam<ConvolutionParam> >(attrs.parsed).layer;
+    const TShape& dshape = (*in_attrs)[conv::kData];
+    if (dshape.ndim() == 0) return false;
+    CHECK_EQ(dshape.ndim(), 4U) << "_quantized_Convolution expects NCHW data";
+    CHECK_EQ(param.kernel.ndim(), 2U);
+    CHECK_EQ(param.num_group, 1U);
+    CHECK_LE(dshape[1] * param.kernel.Size(), quantized::kMaxDotLength)
+        << "input too large for int32 accumulation";
+    SHAPE_ASSIGN_CHECK(*in_attrs, conv::kWeight,
+                       Shape4(param.num_filter, dshape[1], param.kernel[0], param.kernel[1]));
+    if (!param.no_bias) {
+      SHAPE_ASSIGN_CHECK(*in_attrs, conv::kBias, Shape1(param.num_filter));
+    }
+    TShape oshape = dshape;
+    oshape[1] = param.num_filter;
+    for (int k = 0; k < 2; ++k) {
+      const index_t stride = param.stride.ndim() ? param.stride[k] : 1;
+      const index_t dilate = param.dilate.ndim() ? param.dilate[k] : 1;
+      const index_t pad = param.pad.ndim() ? param.pad[k] : 0;
+      const index_t ksize = dilate * (param.kernel[k] - 1) + 1;
+      CHECK_GE(dshape[2 + k] + 2 * pad, ksize) << "kernel size exceed input";
+      oshape[2 + k] = (dshape[2 + k] + 2 * pad - ksize) / stride + 1;
+    }
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, oshape);
+    return true;
+  })
+.set_attr<nnvm::FInferType>("FInferType",
+  [](const NodeAttrs& attrs, std::vector<int> *in_attrs, std::vector<int> *out_attrs) {
+    return QuantizedType({mshadow::kUint8, mshadow::kUint8, mshadow::kFloat32},
+                         mshadow::kFloat32, in_attrs, out_attrs);
+  })
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", QuantizedConvolutionCompute<cpu>)
+.add_argument("data", "NDArray", "uint8 input data")
+.add_argument("weight", "NDArray", "uint8 weight")
+.add_argument("bias", "NDArray", "float32 bias")
+.add_arguments(ConvolutionParam::__FIELDS__())
+.add_arguments(QuantizedRangeParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
@@ -11,11 +11,15 @@
 #include <dmlc/parameter.h>
 #include <mxnet/operator.h>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <map>
 #include <vector>
 #include <string>
 #include <utility>
 #include "./operator_common.h"
+#include "./mshadow_op.h"
+#include "./vector_math.h"
 
 namespace mxnet {
 namespace op {
@@ -24,7 +28,19 @@ namespace rnn_enum {
   enum RNNOpInputs {kData, kParams, kState, kStateCell};
   enum RNNOpOutputs {kOut, kStateOut, kStateCellOut};
   enum RNNModeType {kRnnRelu, kRnnTanh, kLstm, kGru};
-  enum RNNOpResource {kTempSpace};
+  enum RNNOpResource {kTempSpace, kRandom};
+}
+
+// number of gates of a recurrent cell
+inline int rnn_num_gates(int mode) {
+  switch (mode) {
+    case rnn_enum::kLstm:
+      return 4;
+    case rnn_enum::kGru:
+      return 3;
+    default:
+      return 1;
+  }
 }
 
 // A utility function to calculate input size
@@ -102,10 +118,342 @@ struct RNNParam : public dmlc::Parameter<RNNParam> {
   }
 };
 
+/*!
+ * \brief offsets of the weights and biases of every layer and direction in
+ *  the parameter vector. The layout is the one of cuDNN: the input to hidden
+ *  and hidden to hidden weights of all layers and directions, then their
+ *  biases. The gates of a weight matrix are stacked by rows, in the order
+ *  i, f, c, o for LSTM and r, z, n for GRU.
+ */
+struct RNNParamOffsets {
+  std::vector<size_t> w_i2h, w_h2h, b_i2h, b_h2h;
+  RNNParamOffsets(int num_layers, int num_dirs, int input_size, int hidden, int gates) {
+    size_t p = 0;
+    for (int l = 0; l < num_layers; ++l) {
+      const int in_size = l == 0 ? input_size : num_dirs * hidden;
+      for (int d = 0; d < num_dirs; ++d) {
+        w_i2h.push_back(p);
+        p += static_cast<size_t>(gates) * hidden * in_size;
+        w_h2h.push_back(p);
+        p += static_cast<size_t>(gates) * hidden * hidden;
+      }
+    }
+    for (int l = 0; l < num_layers; ++l) {
+      for (int d = 0; d < num_dirs; ++d) {
+        b_i2h.push_back(p);
+        p += gates * hidden;
+        b_h2h.push_back(p);
+        p += gates * hidden;
+      }
+    }
+  }
+};
+
+// a row-major matrix over existing memory, rows are stride elements apart
+template<typename DType>
+inline mshadow::Tensor<cpu, 2, DType> RNNMatrix(const DType* dptr, index_t rows, index_t cols,
+                                                index_t stride = 0) {
+  return mshadow::Tensor<cpu, 2, DType>(const_cast<DType*>(dptr), mshadow::Shape2(rows, cols),
+                                        stride == 0 ? cols : stride, nullptr);
+}
+
+// the gate nonlinearities, with the vectorizable versions of vmath when they
+// are enabled, which let the loops over the gates vectorize
+template<typename DType, bool use_vmath>
+struct RNNActivation {
+  static inline DType Sigmoid(DType x) {
+    return DType(1) / (DType(1) + std::exp(-x));
+  }
+  static inline DType Tanh(DType x) {
+    return std::tanh(x);
+  }
+};
+
+template<>
+struct RNNActivation<float, true> {
+  static inline float Sigmoid(float x) {
+    return vmath::Sigmoid(x);
+  }
+  static inline float Tanh(float x) {
+    return vmath::Tanh(x);
+  }
+};
+
+/*!
+ * \brief forward of one direction of one layer over the whole sequence.
+ *  The input to hidden product of all the time steps is a single GEMM, the
+ *  gate nonlinearities and the state update are fused in one pass per step.
+ * \param x input (seq_len * batch, in_size)
+ * \param y output, the rows of (seq_len * batch) are ystride elements apart
+ * \param gates (seq_len * batch, gates * hidden) buffer, holds the activated
+ *  gates when save is true
+ * \param saved (seq_len * batch, hidden) values kept for backward when save
+ *  is true: the cell of LSTM, the hidden to hidden part of the n gate of GRU
+ * \param gh (batch, gates * hidden) and c (batch, hidden) temporaries
+ */
+template<typename DType, bool use_vmath>
+void RNNLayerForward(int mode, bool reverse, int seq_len, int batch, int in_size, int hidden,
+                     int ystride, const DType* x, const DType* w_i2h, const DType* w_h2h,
+                     const DType* b_i2h, const DType* b_h2h, const DType* h0, const DType* c0,
+                     DType* y, DType* gates, DType* saved, DType* gh, DType* c,
+                     DType* hT, DType* cT, bool save) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  typedef RNNActivation<DType, use_vmath> Act;
+  const int G = rnn_num_gates(mode);
+  const int H = hidden;
+  const int GH = G * H;
+  const int rows = seq_len * batch;
+  Tensor<cpu, 2, DType> gx = RNNMatrix(gates, rows, GH);
+  gx = dot(RNNMatrix(x, rows, in_size), RNNMatrix(w_i2h, GH, in_size).T());
+  #pragma omp parallel for
+  for (int r = 0; r < rows; ++r) {
+    DType* g = gates + static_cast<size_t>(r) * GH;
+    for (int k = 0; k < GH; ++k) g[k] += b_i2h[k];
+  }
+  if (mode == rnn_enum::kLstm) {
+    std::memcpy(c, c0, sizeof(DType) * batch * H);
+  }
+  Tensor<cpu, 2, DType> ghm = RNNMatrix(gh, batch, GH);
+  const DType* hlast = h0;
+  for (int step = 0; step < seq_len; ++step) {
+    const int t = reverse ? seq_len - 1 - step : step;
+    const DType* hprev = hlast;
+    const int hstride = step == 0 ? H : ystride;
+    ghm = dot(RNNMatrix(hprev, batch, H, hstride), RNNMatrix(w_h2h, GH, H).T());
+    DType* yt = y + static_cast<size_t>(t) * batch * ystride;
+    DType* gt = gates + static_cast<size_t>(t) * batch * GH;
+    DType* st = save && saved != nullptr ? saved + static_cast<size_t>(t) * batch * H : nullptr;
+    #pragma omp parallel for
+    for (int n = 0; n < batch; ++n) {
+      DType* g = gt + static_cast<size_t>(n) * GH;
+      const DType* hg = gh + static_cast<size_t>(n) * GH;
+      const DType* hp = hprev + static_cast<size_t>(n) * hstride;
+      DType* h = yt + static_cast<size_t>(n) * ystride;
+      switch (mode) {
+        case rnn_enum::kLstm: {
+          DType* cn = c + static_cast<size_t>(n) * H;
+          for (int j = 0; j < H; ++j) {
+            const DType i = Act::Sigmoid(g[j] + hg[j] + b_h2h[j]);
+            const DType f = Act::Sigmoid(g[H + j] + hg[H + j] + b_h2h[H + j]);
+            const DType u = Act::Tanh(g[2 * H + j] + hg[2 * H + j] + b_h2h[2 * H + j]);
+            const DType o = Act::Sigmoid(g[3 * H + j] + hg[3 * H + j] + b_h2h[3 * H + j]);
+            cn[j] = f * cn[j] + i * u;
+            h[j] = o * Act::Tanh(cn[j]);
+            if (st != nullptr) {
+              g[j] = i;
+              g[H + j] = f;
+              g[2 * H + j] = u;
+              g[3 * H + j] = o;
+              st[n * H + j] = cn[j];
+            }
+          }
+          break;
+        }
+        case rnn_enum::kGru: {
+          for (int j = 0; j < H; ++j) {
+            const DType r = Act::Sigmoid(g[j] + hg[j] + b_h2h[j]);
+            const DType z = Act::Sigmoid(g[H + j] + hg[H + j] + b_h2h[H + j]);
+            const DType hn = hg[2 * H + j] + b_h2h[2 * H + j];
+            const DType u = Act::Tanh(g[2 * H + j] + r * hn);
+            h[j] = (DType(1) - z) * u + z * hp[j];
+            if (st != nullptr) {
+              g[j] = r;
+              g[H + j] = z;
+              g[2 * H + j] = u;
+              st[n * H + j] = hn;
+            }
+          }
+          break;
+        }
+        case rnn_enum::kRnnTanh: {
+          for (int j = 0; j < H; ++j) h[j] = Act::Tanh(g[j] + hg[j] + b_h2h[j]);
+          break;
+        }
+        default: {
+          for (int j = 0; j < H; ++j) h[j] = std::max(g[j] + hg[j] + b_h2h[j], DType(0));
+          break;
+        }
+      }
+    }
+    hlast = yt;
+  }
+  if (hT != nullptr) {
+    for (int n = 0; n < batch; ++n) {
+      std::memcpy(hT + static_cast<size_t>(n) * H, hlast + static_cast<size_t>(n) * ystride,
+                  sizeof(DType) * H);
+    }
+  }
+  if (cT != nullptr) std::memcpy(cT, c, sizeof(DType) * batch * H);
+}
+
+/*!
+ * \brief backward of one direction of one layer, from the values saved by
+ *  RNNLayerForward. The gradients of the weights and biases are added to
+ *  dw_i2h, dw_h2h, db_i2h and db_h2h. The gradient of the input is written
+ *  to dx, or added when add_dx is true, and skipped when dx is null.
+ * \param dh (batch, hidden) holds the gradient of the initial hidden state on exit
+ * \param dc (batch, hidden) holds the gradient of the initial cell on exit
+ */
+template<typename DType, bool use_vmath>
+void RNNLayerBackward(int mode, bool reverse, int seq_len, int batch, int in_size, int hidden,
+                      int ystride, const DType* x, const DType* w_i2h, const DType* w_h2h,
+                      const DType* h0, const DType* c0, const DType* y, const DType* gates,
+                      const DType* saved, const DType* dy, const DType* dhT, const DType* dcT,
+                      DType* dgx, DType* dgh, DType* hprev_buf, DType* dh, DType* dc,
+                      DType* dh_direct, DType* dw_i2h, DType* dw_h2h, DType* db_i2h,
+                      DType* db_h2h, DType* dx, bool add_dx) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  typedef RNNActivation<DType, use_vmath> Act;
+  const int G = rnn_num_gates(mode);
+  const int H = hidden;
+  const int GH = G * H;
+  const int rows = seq_len * batch;
+  const size_t nh = static_cast<size_t>(batch) * H;
+  // the hidden to hidden gradient only differs for the n gate of GRU
+  if (mode != rnn_enum::kGru) dgh = dgx;
+  if (dhT != nullptr) {
+    std::memcpy(dh, dhT, sizeof(DType) * nh);
+  } else {
+    std::fill(dh, dh + nh, DType(0));
+  }
+  if (mode == rnn_enum::kLstm) {
+    if (dcT != nullptr) {
+      std::memcpy(dc, dcT, sizeof(DType) * nh);
+    } else {
+      std::fill(dc, dc + nh, DType(0));
+    }
+  }
+  Tensor<cpu, 2, DType> dhm = RNNMatrix(dh, batch, H);
+  for (int step = seq_len - 1; step >= 0; --step) {
+    const int t = reverse ? seq_len - 1 - step : step;
+    const int tprev = reverse ? t + 1 : t - 1;
+    const bool first = step == 0;
+    const DType* hprev = first ? h0 : y + static_cast<size_t>(tprev) * batch * ystride;
+    const int hstride = first ? H : ystride;
+    const DType* cprev = mode != rnn_enum::kLstm ? nullptr :
+        (first ? c0 : saved + static_cast<size_t>(tprev) * nh);
+    const DType* yt = y + static_cast<size_t>(t) * batch * ystride;
+    const DType* dyt = dy + static_cast<size_t>(t) * batch * ystride;
+    const DType* gt = gates + static_cast<size_t>(t) * batch * GH;
+    DType* dgxt = dgx + static_cast<size_t>(t) * batch * GH;
+    DType* dght = dgh + static_cast<size_t>(t) * batch * GH;
+    #pragma omp parallel for
+    for (int n = 0; n < batch; ++n) {
+      const DType* hp = hprev + static_cast<size_t>(n) * hstride;
+      std::memcpy(hprev_buf + (static_cast<size_t>(t) * batch + n) * H, hp, sizeof(DType) * H);
+      const DType* g = gt + static_cast<size_t>(n) * GH;
+      const DType* dyn = dyt + static_cast<size_t>(n) * ystride;
+      DType* dgxn = dgxt + static_cast<size_t>(n) * GH;
+      DType* dghn = dght + static_cast<size_t>(n) * GH;
+      DType* dhn = dh + static_cast<size_t>(n) * H;
+      switch (mode) {
+        case rnn_enum::kLstm: {
+          const DType* cn = saved + static_cast<size_t>(t) * nh + static_cast<size_t>(n) * H;
+          const DType* cp = cprev + static_cast<size_t>(n) * H;
+          DType* dcn = dc + static_cast<size_t>(n) * H;
+          for (int j = 0; j < H; ++j) {
+            const DType i = g[j], f = g[H + j], u = g[2 * H + j], o = g[3 * H + j];
+            const DType dht = dyn[j] + dhn[j];
+            const DType tc = Act::Tanh(cn[j]);
+            const DType dct = dcn[j] + dht * o * (DType(1) - tc * tc);
+            dgxn[j] = dct * u * i * (DType(1) - i);
+            dgxn[H + j] = dct * cp[j] * f * (DType(1) - f);
+            dgxn[2 * H + j] = dct * i * (DType(1) - u * u);
+            dgxn[3 * H + j] = dht * tc * o * (DType(1) - o);
+            dcn[j] = dct * f;
+          }
+          break;
+        }
+        case rnn_enum::kGru: {
+          const DType* hn = saved + static_cast<size_t>(t) * nh + static_cast<size_t>(n) * H;
+          DType* dhd = dh_direct + static_cast<size_t>(n) * H;
+          for (int j = 0; j < H; ++j) {
+            const DType r = g[j], z = g[H + j], u = g[2 * H + j];
+            const DType dht = dyn[j] + dhn[j];
+            const DType du = dht * (DType(1) - z) * (DType(1) - u * u);
+            const DType dz = dht * (hp[j] - u) * z * (DType(1) - z);
+            const DType dr = du * hn[j] * r * (DType(1) - r);
+            dgxn[j] = dghn[j] = dr;
+            dgxn[H + j] = dghn[H + j] = dz;
+            dgxn[2 * H + j] = du;
+            dghn[2 * H + j] = du * r;
+            dhd[j] = dht * z;
+          }
+          break;
+        }
+        case rnn_enum::kRnnTanh: {
+          const DType* h = yt + static_cast<size_t>(n) * ystride;
+          for (int j = 0; j < H; ++j) dgxn[j] = (dyn[j] + dhn[j]) * (DType(1) - h[j] * h[j]);
+          break;
+        }
+        default: {
+          const DType* h = yt + static_cast<size_t>(n) * ystride;
+          for (int j = 0; j < H; ++j) {
+            dgxn[j] = h[j] > DType(0) ? dyn[j] + dhn[j] : DType(0);
+          }
+          break;
+        }
+      }
+    }
+    dhm = dot(RNNMatrix(dght, batch, GH), RNNMatrix(w_h2h, GH, H));
+    if (mode == rnn_enum::kGru) {
+      for (size_t k = 0; k < nh; ++k) dh[k] += dh_direct[k];
+    }
+  }
+  // the weight gradients of all the time steps are single GEMMs
+  Tensor<cpu, 2, DType> dwh = RNNMatrix(dw_h2h, GH, H);
+  dwh += dot(RNNMatrix(dgh, rows, GH).T(), RNNMatrix(hprev_buf, rows, H));
+  Tensor<cpu, 2, DType> dwi = RNNMatrix(dw_i2h, GH, in_size);
+  dwi += dot(RNNMatrix(dgx, rows, GH).T(), RNNMatrix(x, rows, in_size));
+  #pragma omp parallel for
+  for (int k = 0; k < GH; ++k) {
+    DType bi = 0, bh = 0;
+    for (int r = 0; r < rows; ++r) {
+      bi += dgx[static_cast<size_t>(r) * GH + k];
+      bh += dgh[static_cast<size_t>(r) * GH + k];
+    }
+    db_i2h[k] += bi;
+    db_h2h[k] += bh;
+  }
+  if (dx != nullptr) {
+    Tensor<cpu, 2, DType> dxm = RNNMatrix(dx, rows, in_size);
+    if (add_dx) {
+      dxm += dot(RNNMatrix(dgx, rows, GH), RNNMatrix(w_i2h, GH, in_size));
+    } else {
+      dxm = dot(RNNMatrix(dgx, rows, GH), RNNMatrix(w_i2h, GH, in_size));
+    }
+  }
+}
+
+// write or add n values according to req
+template<typename DType>
+inline void RNNAssign(DType* dst, const DType* src, size_t n, OpReqType req) {
+  switch (req) {
+    case kNullOp:
+      break;
+    case kWriteTo:
+    case kWriteInplace:
+      if (dst != src) std::memcpy(dst, src, sizeof(DType) * n);
+      break;
+    case kAddTo:
+      for (size_t i = 0; i < n; ++i) dst[i] += src[i];
+      break;
+  }
+}
+
+/*!
+ * \brief CPU implementation of the fused recurrent layer. A training forward
+ *  keeps the activated gates, the cells and the layer outputs for backward,
+ *  an inference forward only uses temporary space.
+ */
 template<typename xpu, typename DType>
 class RNNOp : public Operator {
  public:
-  explicit RNNOp(RNNParam p) {
+  explicit RNNOp(RNNParam p) : param_(p) {
+    gates_ = rnn_num_gates(param_.mode);
+    dirs_ = param_.bidirectional ? 2 : 1;
   }
 
   virtual void Forward(const OpContext &ctx,
@@ -115,7 +463,79 @@ class RNNOp : public Operator {
                        const std::vector<TBlob> &aux_args) {
     using namespace mshadow;
     using namespace mshadow::expr;
-    // TODO(sbodenstein): add MShadow implementation
+    const bool lstm = param_.mode == rnn_enum::kLstm;
+    CHECK_EQ(in_data.size(), lstm ? 4U : 3U);
+    CHECK_EQ(req[rnn_enum::kOut], kWriteTo);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    SetDims(in_data[rnn_enum::kData].shape_);
+    const int L = param_.num_layers, D = dirs_, H = param_.state_size;
+    const size_t tnd = static_cast<size_t>(seq_len_) * batch_ * D * H;
+    const size_t tng = static_cast<size_t>(seq_len_) * batch_ * gates_ * H;
+    const size_t nh = static_cast<size_t>(batch_) * H;
+    const bool train = ctx.is_train;
+    const bool dropout = train && param_.p > 0 && L > 1;
+
+    const DType* data = in_data[rnn_enum::kData].dptr<DType>();
+    const DType* w = in_data[rnn_enum::kParams].dptr<DType>();
+    const DType* hx = in_data[rnn_enum::kState].dptr<DType>();
+    const DType* cx = lstm ? in_data[rnn_enum::kStateCell].dptr<DType>() : nullptr;
+    DType* out = out_data[rnn_enum::kOut].dptr<DType>();
+    DType* hy = param_.state_outputs ? out_data[rnn_enum::kStateOut].dptr<DType>() : nullptr;
+    DType* cy = param_.state_outputs && lstm ?
+        out_data[rnn_enum::kStateCellOut].dptr<DType>() : nullptr;
+    RNNParamOffsets off(L, D, input_size_, H, gates_);
+
+    // inference only keeps the outputs of two layers and the gates of one
+    const size_t infer_size = train ? 0 : (L > 1 ? 2 * tnd : 0) + tng;
+    Tensor<cpu, 1, DType> space = ctx.requested[rnn_enum::kTempSpace]
+        .get_space_typed<cpu, 1, DType>(Shape1(batch_ * gates_ * H + nh + infer_size), s);
+    DType* gh = space.dptr_;
+    DType* c = gh + batch_ * gates_ * H;
+    DType* infer_buf = c + nh;
+    DType* infer_gates = infer_buf + (L > 1 ? 2 * tnd : 0);
+    if (train) {
+      reserve_.resize(ReserveSize(dropout));
+    }
+    has_reserve_ = train;
+    DType* ys = reserve_.data();
+    DType* xs = ys + (L - 1) * tnd;
+    DType* masks = xs + (dropout ? (L - 1) * tnd : 0);
+    DType* gates = masks + (dropout ? (L - 1) * tnd : 0);
+    DType* saved = gates + L * D * tng;
+    if (dropout) {
+      const real_t pkeep = 1.0f - param_.p;
+      Tensor<cpu, 1, DType> mask(masks, Shape1((L - 1) * tnd), s);
+      Random<cpu> *prnd = ctx.requested[rnn_enum::kRandom].get_random<cpu, real_t>(s);
+      mask = tcast<DType>(F<mshadow_op::threshold>(
+          prnd->uniform(mask.shape_), pkeep) * (1.0f / pkeep));
+    }
+
+    const auto layer_forward = vmath::Enabled() ?
+        RNNLayerForward<DType, true> : RNNLayerForward<DType, false>;
+    const DType* x = data;
+    for (int l = 0; l < L; ++l) {
+      const int in_size = l == 0 ? input_size_ : D * H;
+      DType* y = l == L - 1 ? out : (train ? ys + l * tnd : infer_buf + (l % 2) * tnd);
+      for (int d = 0; d < D; ++d) {
+        const int k = l * D + d;
+        layer_forward(param_.mode, d == 1, seq_len_, batch_, in_size, H, D * H, x,
+                      w + off.w_i2h[k], w + off.w_h2h[k], w + off.b_i2h[k],
+                      w + off.b_h2h[k], hx + k * nh, lstm ? cx + k * nh : nullptr,
+                      y + d * H, train ? gates + k * tng : infer_gates,
+                      train ? saved + k * seq_len_ * nh : nullptr, gh, c,
+                      hy != nullptr ? hy + k * nh : nullptr,
+                      cy != nullptr ? cy + k * nh : nullptr, train);
+      }
+      if (dropout && l < L - 1) {
+        DType* xl = xs + l * tnd;
+        const DType* ml = masks + l * tnd;
+        #pragma omp parallel for
+        for (int i = 0; i < static_cast<int>(tnd); ++i) xl[i] = y[i] * ml[i];
+        x = xl;
+      } else {
+        x = y;
+      }
+    }
   }
 
   virtual void Backward(const OpContext &ctx,
@@ -127,11 +547,114 @@ class RNNOp : public Operator {
                         const std::vector<TBlob> &aux_args) {
     using namespace mshadow;
     using namespace mshadow::expr;
-    // TODO(sbodenstein): add MShadow implementation
+    CHECK(has_reserve_) << "RNN backward requires a forward pass in training mode";
+    const bool lstm = param_.mode == rnn_enum::kLstm;
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    const int L = param_.num_layers, D = dirs_, H = param_.state_size;
+    const size_t tnd = static_cast<size_t>(seq_len_) * batch_ * D * H;
+    const size_t tng = static_cast<size_t>(seq_len_) * batch_ * gates_ * H;
+    const size_t tnh = static_cast<size_t>(seq_len_) * batch_ * H;
+    const size_t nh = static_cast<size_t>(batch_) * H;
+    const bool dropout = param_.p > 0 && L > 1;
+    CHECK_EQ(reserve_.size(), ReserveSize(dropout));
+
+    const DType* data = in_data[rnn_enum::kData].dptr<DType>();
+    const DType* w = in_data[rnn_enum::kParams].dptr<DType>();
+    const DType* hx = in_data[rnn_enum::kState].dptr<DType>();
+    const DType* cx = lstm ? in_data[rnn_enum::kStateCell].dptr<DType>() : nullptr;
+    const DType* out = out_data[rnn_enum::kOut].dptr<DType>();
+    const DType* dout = out_grad[rnn_enum::kOut].dptr<DType>();
+    const DType* dhy = param_.state_outputs ? out_grad[rnn_enum::kStateOut].dptr<DType>() : nullptr;
+    const DType* dcy = param_.state_outputs && lstm ?
+        out_grad[rnn_enum::kStateCellOut].dptr<DType>() : nullptr;
+    const size_t param_size = in_grad[rnn_enum::kParams].Size();
+    const size_t data_size = in_grad[rnn_enum::kData].Size();
+    RNNParamOffsets off(L, D, input_size_, H, gates_);
+
+    const bool gru = param_.mode == rnn_enum::kGru;
+    const bool param_tmp = req[rnn_enum::kParams] == kNullOp;
+    const size_t space_size = tng * (gru ? 2 : 1) + tnh + 3 * nh + (L > 1 ? 2 * tnd : 0) +
+        data_size + (param_tmp ? param_size : 0);
+    Tensor<cpu, 1, DType> space = ctx.requested[rnn_enum::kTempSpace]
+        .get_space_typed<cpu, 1, DType>(Shape1(space_size), s);
+    DType* dgx = space.dptr_;
+    DType* dgh = dgx + tng;
+    DType* hprev = dgh + (gru ? tng : 0);
+    DType* dh = hprev + tnh;
+    DType* dc = dh + nh;
+    DType* dh_direct = dc + nh;
+    DType* dy_buf[2] = {dh_direct + nh, dh_direct + nh + tnd};
+    DType* dx_data = dh_direct + nh + (L > 1 ? 2 * tnd : 0);
+    DType* dw = param_tmp ? dx_data + data_size : in_grad[rnn_enum::kParams].dptr<DType>();
+    if (req[rnn_enum::kParams] != kAddTo) std::fill(dw, dw + param_size, DType(0));
+
+    const DType* ys = reserve_.data();
+    const DType* xs = ys + (L - 1) * tnd;
+    const DType* masks = xs + (dropout ? (L - 1) * tnd : 0);
+    const DType* gates = masks + (dropout ? (L - 1) * tnd : 0);
+    const DType* saved = gates + L * D * tng;
+
+    const auto layer_backward = vmath::Enabled() ?
+        RNNLayerBackward<DType, true> : RNNLayerBackward<DType, false>;
+    const DType* dy = dout;
+    for (int l = L - 1; l >= 0; --l) {
+      const int in_size = l == 0 ? input_size_ : D * H;
+      const DType* x = l == 0 ? data : (dropout ? xs : ys) + (l - 1) * tnd;
+      const DType* y = l == L - 1 ? out : ys + l * tnd;
+      DType* dx = l == 0 ? (req[rnn_enum::kData] == kNullOp ? nullptr : dx_data) :
+          (dy == dy_buf[0] ? dy_buf[1] : dy_buf[0]);
+      for (int d = 0; d < D; ++d) {
+        const int k = l * D + d;
+        layer_backward(param_.mode, d == 1, seq_len_, batch_, in_size, H, D * H, x,
+                       w + off.w_i2h[k], w + off.w_h2h[k], hx + k * nh,
+                       lstm ? cx + k * nh : nullptr, y + d * H, gates + k * tng,
+                       saved + k * tnh, dy + d * H,
+                       dhy != nullptr ? dhy + k * nh : nullptr,
+                       dcy != nullptr ? dcy + k * nh : nullptr,
+                       dgx, dgh, hprev, dh, dc, dh_direct,
+                       dw + off.w_i2h[k], dw + off.w_h2h[k],
+                       dw + off.b_i2h[k], dw + off.b_h2h[k], dx, d > 0);
+        RNNAssign(in_grad[rnn_enum::kState].dptr<DType>() + k * nh, dh, nh,
+                  req[rnn_enum::kState]);
+        if (lstm) {
+          RNNAssign(in_grad[rnn_enum::kStateCell].dptr<DType>() + k * nh, dc, nh,
+                    req[rnn_enum::kStateCell]);
+        }
+      }
+      if (l > 0 && dropout) {
+        const DType* ml = masks + (l - 1) * tnd;
+        #pragma omp parallel for
+        for (int i = 0; i < static_cast<int>(tnd); ++i) dx[i] *= ml[i];
+      }
+      dy = dx;
+    }
+    if (req[rnn_enum::kData] != kNullOp) {
+      RNNAssign(in_grad[rnn_enum::kData].dptr<DType>(), dx_data, data_size, req[rnn_enum::kData]);
+    }
   }
 
  private:
+  inline void SetDims(const TShape& dshape) {
+    seq_len_ = dshape[0];
+    batch_ = dshape[1];
+    input_size_ = dshape[2];
+  }
+  // the outputs of the layers below the last one and, with dropout, their
+  // masked values and masks, then the gates and the saved values of every
+  // layer and direction
+  inline size_t ReserveSize(bool dropout) const {
+    const int L = param_.num_layers, D = dirs_, H = param_.state_size;
+    const size_t tnh = static_cast<size_t>(seq_len_) * batch_ * H;
+    const size_t saved = param_.mode == rnn_enum::kLstm || param_.mode == rnn_enum::kGru ? tnh : 0;
+    return (L - 1) * D * tnh * (dropout ? 3 : 1) + L * D * (gates_ * tnh + saved);
+  }
+
   RNNParam param_;
+  int gates_, dirs_;
+  int seq_len_, batch_, input_size_;
+  /*! \brief values saved by the last training forward */
+  std::vector<DType> reserve_;
+  bool has_reserve_{false};
 };  // class RNNOp
 
 template<typename xpu>
@@ -290,6 +813,9 @@ class RNNProp : public OperatorProperty {
 
   std::vector<ResourceRequest> ForwardResource(
       const std::vector<TShape> &in_shape) const override {
+    if (param_.p > 0 && param_.num_layers > 1) {
+      return {ResourceRequest::kTempSpace, ResourceRequest::kRandom};
+    }
     return {ResourceRequest::kTempSpace};
   }
 
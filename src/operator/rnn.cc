@@ -11,11 +11,17 @@ namespace mxnet {
 namespace op {
 template<>
 Operator *CreateOp<cpu>(RNNParam param, int dtype) {
-  LOG(FATAL) << "RNN is only available for gpu at the moment.";
   Operator *op = NULL;
-  MSHADOW_REAL_TYPE_SWITCH(dtype, DType, {
-    op = new RNNOp<cpu, DType>(param);
-  });
+  switch (dtype) {
+    case mshadow::kFloat32:
+      op = new RNNOp<cpu, float>(param);
+      break;
+    case mshadow::kFloat64:
+      op = new RNNOp<cpu, double>(param);
+      break;
+    default:
+      LOG(FATAL) << "RNN only supports float32 and float64 on CPU";
+  }
   return op;
 }
 
@@ -32,7 +38,11 @@ Operator *RNNProp::CreateOperatorEx(Context ctx,
 DMLC_REGISTER_PARAMETER(RNNParam);
 
 MXNET_REGISTER_OP_PROPERTY(RNN, RNNProp)
-.describe("Apply a recurrent layer to input.")
+.describe("Apply a recurrent layer to input.\n\n"
+          "The parameters of all layers and directions are concatenated in the "
+          "layout of cuDNN. On CPU the input to hidden products of all the time "
+          "steps are computed with one GEMM per layer and the gate nonlinearities "
+          "are fused with the state update.")
 .add_argument("data", "Symbol", "Input data to RNN")
 .add_argument("parameters", "Symbol", "Vector of all RNN trainable parameters concatenated")
 .add_argument("state", "Symbol", "initial hidden state of the RNN")
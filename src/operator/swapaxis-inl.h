@@ -16,6 +16,7 @@
 #include <string>
 #include <utility>
 #include "./operator_common.h"
+#include "./transpose_cpu.h"
 
 namespace mxnet {
 namespace op {
@@ -95,6 +96,11 @@ class SwapAxisOp : public Operator {
     TShape shape_in = data_in.shape_;
     TShape shape_out = data_out.shape_;
 
+    TShape axes(shape_in.ndim());
+    for (index_t i = 0; i < axes.ndim(); ++i) axes[i] = i;
+    std::swap(axes[dim1], axes[dim2]);
+    if (TransposeBlob(s, data_in, data_out, axes)) return;
+
     Shape<5> inter_shape;
 
     Reshape2Five(&inter_shape, shape_in, dim1, dim2);
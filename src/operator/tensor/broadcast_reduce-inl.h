@@ -7,6 +7,7 @@
 #define MXNET_OPERATOR_TENSOR_BROADCAST_REDUCE_INL_H_
 
 #include <mxnet/operator_util.h>
+#include <dmlc/omp.h>
 #include <algorithm>
 #include <vector>
 #include <string>
@@ -154,12 +155,97 @@ MSHADOW_XINLINE void seq_reduce_assign(const int idx, const int M, const bool ad
 template<typename DType>
 using CTensor = Tensor<cpu, MAX_DIM, DType>;
 
+/*! \brief number of elements a CPU thread processes at least */
+const size_t kCPUGrain = 1 << 15;
+/*! \brief independent accumulators of a contiguous reduction */
+const int kReduceLanes = 8;
+/*! \brief number of outputs accumulated together when the reduced axis is not the last */
+const int kReduceBlock = 256;
+
+inline int cpu_num_threads(const size_t work) {
+  return std::max(1, std::min(omp_get_max_threads(), static_cast<int>(work / kCPUGrain)));
+}
+
+// the shape padded with leading axes of size 1
+inline CShape to_cshape(const TShape& shape) {
+  CHECK_LE(shape.ndim(), MAX_DIM);
+  CShape ret;
+  const int pad = MAX_DIM - shape.ndim();
+  for (int i = 0; i < MAX_DIM; ++i) ret[i] = i < pad ? 1 : shape[i - pad];
+  return ret;
+}
+
+/*!
+ * \brief Reduce without volatile arguments, so that the loops accumulating
+ *  into registers vectorize. Only sum is specialized.
+ */
+template<typename Reducer>
+struct cpu_reducer {
+  template<typename DType>
+  MSHADOW_XINLINE static void Reduce(DType& dst, const DType src) {  // NOLINT(*)
+    Reducer::Reduce(dst, src);
+  }
+};
+
+template<>
+struct cpu_reducer<red::sum> {
+  template<typename DType>
+  MSHADOW_XINLINE static void Reduce(DType& dst, const DType src) {  // NOLINT(*)
+    dst += src;
+  }
+};
+
+// out[i] = OP(lhs[i * lstep], rhs[i * rstep]) for a row of the output
+template<typename DType, typename OP>
+inline void binary_broadcast_row(const int n, const bool addto,
+                                 const DType* lhs, const int lstep,
+                                 const DType* rhs, const int rstep, DType* out) {
+  if (lstep == 1 && rstep == 1) {
+    if (addto) {
+      for (int i = 0; i < n; ++i) out[i] += OP::Map(lhs[i], rhs[i]);
+    } else {
+      for (int i = 0; i < n; ++i) out[i] = OP::Map(lhs[i], rhs[i]);
+    }
+  } else if (lstep == 1) {
+    const DType r = rhs[0];
+    if (addto) {
+      for (int i = 0; i < n; ++i) out[i] += OP::Map(lhs[i], r);
+    } else {
+      for (int i = 0; i < n; ++i) out[i] = OP::Map(lhs[i], r);
+    }
+  } else if (rstep == 1) {
+    const DType l = lhs[0];
+    if (addto) {
+      for (int i = 0; i < n; ++i) out[i] += OP::Map(l, rhs[i]);
+    } else {
+      for (int i = 0; i < n; ++i) out[i] = OP::Map(l, rhs[i]);
+    }
+  } else {
+    const DType val = OP::Map(lhs[0], rhs[0]);
+    for (int i = 0; i < n; ++i) assign(&out[i], addto, val);
+  }
+}
+
+/*!
+ * \brief broadcast binary operation on CPU. The output is processed by rows
+ *  of its innermost axis, in parallel, so that the coordinates are only
+ *  computed once per row and the row loops vectorize.
+ */
 template<typename DType, typename OP>
 void binary_broadcast_compute(const int N, const bool addto, const DType *lhs,
                               const DType *rhs, DType *out, const CShape lshape,
                               const CShape rshape, const CShape oshape) {
-  for (int idx = 0; idx < N; ++idx) {
-    binary_broadcast_assign<DType, OP>(idx, addto, lhs, rhs, out, lshape, rshape, oshape);
+  if (N == 0) return;
+  int axis = MAX_DIM - 1;
+  while (axis > 0 && oshape[axis] == 1) --axis;
+  const int inner = oshape[axis];
+  const int rows = N / inner;
+  const int lstep = lshape[axis] > 1, rstep = rshape[axis] > 1;
+  #pragma omp parallel for num_threads(cpu_num_threads(N))
+  for (int r = 0; r < rows; ++r) {
+    const CShape coord = unravel(r * inner, oshape);
+    binary_broadcast_row<DType, OP>(inner, addto, lhs + ravel(coord, lshape), lstep,
+                                    rhs + ravel(coord, rshape), rstep, out + r * inner);
   }
 }
 
@@ -173,26 +259,146 @@ void BinaryBroadcastComputeImpl(Stream<cpu> *s, const OpReqType req,
                            out.shape_.get<MAX_DIM>());
 }
 
+/*! \brief broadcast small to the shape of big on CPU */
+template<typename DType>
+void Broadcast(Stream<cpu> *s, const TBlob& small, const OpReqType req, const TBlob& big) {
+  if (req == kNullOp) return;
+  const CShape sshape = to_cshape(small.shape_);
+  binary_broadcast_compute<DType, mshadow::op::right>(
+    big.shape_.Size(), req == kAddTo, small.dptr<DType>(), small.dptr<DType>(),
+    big.dptr<DType>(), sshape, sshape, to_cshape(big.shape_));
+}
+
 template<typename Reducer, typename DType, typename OP>
 void seq_reduce_compute(const int N, const int M, const bool addto,
                         const DType *big, DType *small, const CShape bshape, const CShape sshape,
                         const CShape rshape, const CShape rstride) {
+  #pragma omp parallel for num_threads(cpu_num_threads(static_cast<size_t>(N) * M))
   for (int idx = 0; idx < N; ++idx) {
     seq_reduce_assign<Reducer, DType, OP>(idx, M, addto, big, small, bshape, sshape, rshape,
       rstride);
   }
 }
 
+/*!
+ * \brief collapse a reduction into the sizes of the leading kept axes, the
+ *  reduced axes and the trailing kept axes.
+ * \return false if the reduced axes are not adjacent once axes of size 1 are left out
+ */
+inline bool collapse_reduce(const CShape& sshape, const CShape& bshape,
+                            int* outer, int* red, int* inner) {
+  *outer = *red = *inner = 1;
+  // 0: leading kept axes, 1: reduced axes, 2: trailing kept axes
+  int stage = 0;
+  for (int i = 0; i < MAX_DIM; ++i) {
+    if (bshape[i] == 1) continue;
+    if (sshape[i] != bshape[i]) {
+      if (stage == 2) return false;
+      stage = 1;
+      *red *= bshape[i];
+    } else if (stage == 0) {
+      *outer *= bshape[i];
+    } else {
+      stage = 2;
+      *inner *= bshape[i];
+    }
+  }
+  return true;
+}
+
+// reduces n contiguous elements with independent accumulators
+template<typename Reducer, typename DType, typename OP>
+inline DType reduce_contiguous(const DType* p, const int n) {
+  DType acc[kReduceLanes];
+  for (int l = 0; l < kReduceLanes; ++l) Reducer::SetInitValue(acc[l]);
+  int i = 0;
+  for (; i + kReduceLanes <= n; i += kReduceLanes) {
+    for (int l = 0; l < kReduceLanes; ++l) {
+      cpu_reducer<Reducer>::Reduce(acc[l], OP::Map(p[i + l]));
+    }
+  }
+  for (; i < n; ++i) cpu_reducer<Reducer>::Reduce(acc[0], OP::Map(p[i]));
+  for (int l = 1; l < kReduceLanes; ++l) cpu_reducer<Reducer>::Reduce(acc[0], acc[l]);
+  return acc[0];
+}
+
+// reduces the rows [rbegin, rend) of a (red, inner) slab into acc, for the columns [jbegin, jend)
+template<typename Reducer, typename DType, typename OP>
+inline void reduce_slab(const DType* slab, const int inner, const int rbegin, const int rend,
+                        const int jbegin, const int jend, DType* acc) {
+  if (inner == 1) {
+    acc[0] = reduce_contiguous<Reducer, DType, OP>(slab + rbegin, rend - rbegin);
+    return;
+  }
+  const int n = jend - jbegin;
+  for (int j = 0; j < n; ++j) Reducer::SetInitValue(acc[j]);
+  for (int r = rbegin; r < rend; ++r) {
+    const DType* row = slab + static_cast<size_t>(r) * inner + jbegin;
+    for (int j = 0; j < n; ++j) cpu_reducer<Reducer>::Reduce(acc[j], OP::Map(row[j]));
+  }
+}
+
+/*!
+ * \brief reduction of a (outer, red, inner) array to (outer, inner). The
+ *  outputs are split in blocks computed by different threads. When there are
+ *  fewer blocks than threads, the reduced axis is split instead and the
+ *  partial results are combined.
+ */
+template<typename Reducer, typename DType, typename OP>
+void reduce_collapsed(const int outer, const int red, const int inner, const bool addto,
+                      const DType* big, DType* small) {
+  const size_t slab = static_cast<size_t>(red) * inner;
+  const int nthread = cpu_num_threads(outer * slab);
+  const int nblock = (inner + kReduceBlock - 1) / kReduceBlock;
+  const int ntask = outer * nblock;
+  if (ntask >= nthread) {
+    #pragma omp parallel for num_threads(nthread)
+    for (int task = 0; task < ntask; ++task) {
+      const int o = task / nblock;
+      const int jbegin = (task % nblock) * kReduceBlock;
+      const int jend = std::min(inner, jbegin + kReduceBlock);
+      DType acc[kReduceBlock];
+      reduce_slab<Reducer, DType, OP>(big + o * slab, inner, 0, red, jbegin, jend, acc);
+      DType* dst = small + static_cast<size_t>(o) * inner;
+      for (int j = jbegin; j < jend; ++j) assign(&dst[j], addto, acc[j - jbegin]);
+    }
+  } else {
+    const size_t nout = static_cast<size_t>(outer) * inner;
+    std::vector<DType> part(nthread * nout);
+    #pragma omp parallel for num_threads(nthread)
+    for (int t = 0; t < nthread; ++t) {
+      const int rbegin = static_cast<int>(static_cast<int64_t>(red) * t / nthread);
+      const int rend = static_cast<int>(static_cast<int64_t>(red) * (t + 1) / nthread);
+      for (int o = 0; o < outer; ++o) {
+        reduce_slab<Reducer, DType, OP>(big + o * slab, inner, rbegin, rend, 0, inner,
+                                        &part[t * nout + o * inner]);
+      }
+    }
+    for (size_t i = 0; i < nout; ++i) {
+      DType val = part[i];
+      for (int t = 1; t < nthread; ++t) cpu_reducer<Reducer>::Reduce(val, part[t * nout + i]);
+      assign(&small[i], addto, val);
+    }
+  }
+}
+
 template<typename Reducer, typename DType, typename OP>
 void Reduce(Stream<cpu> *s, const TBlob& small, const OpReqType req,
             const TBlob& big, const Tensor<cpu, 1, char>& workspace) {
   if (req == kNullOp) return;
+  const CShape sshape = to_cshape(small.shape_), bshape = to_cshape(big.shape_);
+  int outer, red, inner;
+  if (collapse_reduce(sshape, bshape, &outer, &red, &inner)) {
+    reduce_collapsed<Reducer, DType, OP>(outer, red, inner, req == kAddTo,
+                                         big.dptr<DType>(), small.dptr<DType>());
+    return;
+  }
   CShape rshape, rstride;
-  int mdim = diff(small.shape_.get<MAX_DIM>(), big.shape_.get<MAX_DIM>(), &rshape, &rstride);
+  diff(sshape, bshape, &rshape, &rstride);
   int N = small.shape_.Size(), M = rshape.Size();
   seq_reduce_compute<Reducer, DType, OP>(
-    N, M, req == kAddTo, big.dptr<DType>(), small.dptr<DType>(), big.shape_.get<MAX_DIM>(),
-    small.shape_.get<MAX_DIM>(), rshape, rstride);
+    N, M, req == kAddTo, big.dptr<DType>(), small.dptr<DType>(), bshape, sshape,
+    rshape, rstride);
 }
 
 template<typename Reducer, typename DType, typename OP>
@@ -248,6 +248,32 @@ void SearchAxisCompute(const nnvm::NodeAttrs& attrs,
   }
 }
 
+template<typename reducer, typename DType, typename xpu>
+inline void ReduceAxesAssign(mshadow::Stream<xpu> *s, const OpReqType req,
+                             const TBlob& out, const TBlob& in,
+                             const TShape& dst_shape, const TShape& src_shape) {
+  using namespace mshadow;
+  if (dst_shape.ndim() == 2) {
+    Tensor<xpu, 2, DType> dst = out.get_with_shape<xpu, 2, DType>(dst_shape.get<2>(), s);
+    Tensor<xpu, 2, DType> src = in.get_with_shape<xpu, 2, DType>(src_shape.get<2>(), s);
+    ReduceToAssign<reducer>(dst, req, src);
+  } else {
+    const int ndim = MXNET_SPECIAL_MAX_NDIM;
+    Tensor<xpu, ndim, DType> dst = out.get_with_shape<xpu, ndim, DType>(dst_shape.get<ndim>(), s);
+    Tensor<xpu, ndim, DType> src = in.get_with_shape<xpu, ndim, DType>(src_shape.get<ndim>(), s);
+    ReduceToAssign<reducer>(dst, req, src);
+  }
+}
+
+// CPU reductions use the multithreaded kernels of broadcast_reduce-inl.h
+template<typename reducer, typename DType>
+inline void ReduceAxesAssign(mshadow::Stream<cpu> *s, const OpReqType req,
+                             const TBlob& out, const TBlob& in,
+                             const TShape& dst_shape, const TShape& src_shape) {
+  broadcast::Reduce<reducer, DType, mshadow::op::identity>(
+    s, out.reshape(dst_shape), req, in.reshape(src_shape), mshadow::Tensor<cpu, 1, char>());
+}
+
 template<typename xpu, typename reducer, bool normalize = false>
 void ReduceAxesComputeImpl(const nnvm::NodeAttrs& attrs,
                            const OpContext& ctx,
@@ -262,21 +288,10 @@ void ReduceAxesComputeImpl(const nnvm::NodeAttrs& attrs,
   BroadcastReduceShapeCompact(inputs[0].shape_, small, &src_shape, &dst_shape);
   Stream<xpu> *s = ctx.get_stream<xpu>();
   MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    if (dst_shape.ndim() == 2) {
-      Tensor<xpu, 2, DType> out =
-        outputs[0].get_with_shape<xpu, 2, DType>(dst_shape.get<2>(), s);
-      Tensor<xpu, 2, DType> data =
-        inputs[0].get_with_shape<xpu, 2, DType>(src_shape.get<2>(), s);
-      ReduceToAssign<reducer>(out, req[0], data);
-      if (normalize) out /= scalar<DType>(src_shape.Size()/dst_shape.Size());
-    } else {
-      const int ndim = MXNET_SPECIAL_MAX_NDIM;
-      Tensor<xpu, ndim, DType> out =
-        outputs[0].get_with_shape<xpu, ndim, DType>(dst_shape.get<ndim>(), s);
-      Tensor<xpu, ndim, DType> data =
-        inputs[0].get_with_shape<xpu, ndim, DType>(src_shape.get<ndim>(), s);
-      ReduceToAssign<reducer>(out, req[0], data);
-      if (normalize) out /= scalar<DType>(src_shape.Size()/dst_shape.Size());
+    ReduceAxesAssign<reducer, DType>(s, req[0], outputs[0], inputs[0], dst_shape, src_shape);
+    if (normalize) {
+      Tensor<xpu, 1, DType> out = outputs[0].FlatTo1D<xpu, DType>(s);
+      out /= scalar<DType>(src_shape.Size()/dst_shape.Size());
     }
   });
 }
@@ -358,6 +373,32 @@ void ReduceAxesBackwardUseInOut(const nnvm::NodeAttrs& attrs,
   });
 }
 
+template<typename DType, typename xpu>
+inline void BroadcastToAssign(mshadow::Stream<xpu> *s, const OpReqType req,
+                              const TBlob& out, const TBlob& in,
+                              const TShape& dst_shape, const TShape& src_shape) {
+  using namespace mshadow;
+  using namespace mshadow::expr;
+  if (dst_shape.ndim() == 2) {
+    Tensor<xpu, 2, DType> dst = out.get_with_shape<xpu, 2, DType>(dst_shape.get<2>(), s);
+    Tensor<xpu, 2, DType> src = in.get_with_shape<xpu, 2, DType>(src_shape.get<2>(), s);
+    ASSIGN_DISPATCH(dst, req, broadcast_to(src, dst_shape));
+  } else {
+    const int ndim = MXNET_SPECIAL_MAX_NDIM;
+    Tensor<xpu, ndim, DType> dst = out.get_with_shape<xpu, ndim, DType>(dst_shape.get<ndim>(), s);
+    Tensor<xpu, ndim, DType> src = in.get_with_shape<xpu, ndim, DType>(src_shape.get<ndim>(), s);
+    ASSIGN_DISPATCH(dst, req, broadcast_to(src, dst_shape));
+  }
+}
+
+// CPU broadcasts use the multithreaded kernel of broadcast_reduce-inl.h
+template<typename DType>
+inline void BroadcastToAssign(mshadow::Stream<cpu> *s, const OpReqType req,
+                              const TBlob& out, const TBlob& in,
+                              const TShape& dst_shape, const TShape& src_shape) {
+  broadcast::Broadcast<DType>(s, in.reshape(src_shape), req, out.reshape(dst_shape));
+}
+
 template<typename xpu>
 inline void BroadcastComputeImpl(const nnvm::NodeAttrs& attrs,
                                  const OpContext& ctx,
@@ -371,20 +412,7 @@ inline void BroadcastComputeImpl(const nnvm::NodeAttrs& attrs,
   BroadcastReduceShapeCompact(outputs[0].shape_, small, &dst_shape, &src_shape);
   Stream<xpu> *s = ctx.get_stream<xpu>();
   MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    if (dst_shape.ndim() == 2) {
-      Tensor<xpu, 2, DType> out =
-        outputs[0].get_with_shape<xpu, 2, DType>(dst_shape.get<2>(), s);
-      Tensor<xpu, 2, DType> data =
-        inputs[0].get_with_shape<xpu, 2, DType>(src_shape.get<2>(), s);
-      ASSIGN_DISPATCH(out, req[0], broadcast_to(data, dst_shape));
-    } else {
-      const int ndim = MXNET_SPECIAL_MAX_NDIM;
-      Tensor<xpu, ndim, DType> out =
-        outputs[0].get_with_shape<xpu, ndim, DType>(dst_shape.get<ndim>(), s);
-      Tensor<xpu, ndim, DType> data =
-        inputs[0].get_with_shape<xpu, ndim, DType>(src_shape.get<ndim>(), s);
-      ASSIGN_DISPATCH(out, req[0], broadcast_to(data, dst_shape));
-    }
+    BroadcastToAssign<DType>(s, req[0], outputs[0], inputs[0], dst_shape, src_shape);
   });
 }
 
@@ -443,19 +471,39 @@ struct ReduceGrad {
   }
 };
 
+template<typename DType, typename xpu>
+inline void L2NormAssign(mshadow::Stream<xpu> *s, const OpReqType req,
+                         const TBlob& out_data, const TBlob& in_data) {
+  mshadow::Tensor<xpu, 1, DType> out = out_data.get<xpu, 1, DType>(s);
+  mshadow::Tensor<xpu, 1, DType> in = in_data.get_with_shape<xpu, 1, DType>(
+    mshadow::Shape1(in_data.shape_.Size()), s);
+  mshadow::VectorDot(out, in, in);
+  ASSIGN_DISPATCH(out, req, mshadow::expr::F<mxnet::op::mshadow_op::square_root>(out));
+}
+
+// the sum of squares on CPU is a multithreaded reduction
+template<typename DType>
+inline void L2NormAssign(mshadow::Stream<cpu> *s, const OpReqType req,
+                         const TBlob& out_data, const TBlob& in_data) {
+  DType sum_sq;
+  const TBlob sum_blob(&sum_sq, mshadow::Shape1(1), cpu::kDevMask);
+  broadcast::Reduce<mshadow::red::sum, DType, mshadow_op::square>(
+    s, sum_blob, kWriteTo, in_data.reshape(mshadow::Shape1(in_data.shape_.Size())),
+    mshadow::Tensor<cpu, 1, char>());
+  broadcast::assign(out_data.dptr<DType>(), req == kAddTo,
+                    mshadow_op::square_root::Map(sum_sq));
+}
+
 template<typename xpu>
 void L2NormCompute(const nnvm::NodeAttrs& attrs,
                    const OpContext& ctx,
                    const std::vector<TBlob>& inputs,
                    const std::vector<OpReqType>& req,
                    const std::vector<TBlob>& outputs) {
+  if (req[0] == kNullOp) return;
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
   MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-    mshadow::Tensor<xpu, 1, DType> out = outputs[0].get<xpu, 1, DType>(s);
-    mshadow::Tensor<xpu, 1, DType> in = inputs[0].get_with_shape<xpu, 1, DType>(
-      mshadow::Shape1(inputs[0].shape_.Size()), s);
-    mshadow::VectorDot(out, in, in);
-    ASSIGN_DISPATCH(out, req[0], mshadow::expr::F<mxnet::op::mshadow_op::square_root>(out));
+    L2NormAssign<DType>(s, req[0], outputs[0], inputs[0]);
   });
 }
 
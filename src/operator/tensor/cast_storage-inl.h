@@ -0,0 +1,287 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file cast_storage-inl.h
+ * \brief conversions between the storage types of NDArray
+ */
+#ifndef MXNET_OPERATOR_TENSOR_CAST_STORAGE_INL_H_
+#define MXNET_OPERATOR_TENSOR_CAST_STORAGE_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/ndarray.h>
+#include <mxnet/op_attr_types.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "../operator_common.h"
+#include "../elemwise_op_common.h"
+
+namespace mxnet {
+namespace op {
+
+/*! \brief number of elements in a row of an array */
+inline index_t RowSize(const TShape& shape) {
+  return shape.ndim() == 0 ? 0 : shape.ProdShape(1, shape.ndim());
+}
+
+/*! \brief allocate a row sparse array for num_rows stored rows */
+inline void AllocRowSparse(const NDArray& rsp, index_t num_rows) {
+  TShape storage_shape = rsp.shape();
+  storage_shape[0] = num_rows;
+  rsp.CheckAndAlloc(storage_shape, {TShape(mshadow::Shape1(num_rows))});
+}
+
+/*! \brief allocate a csr matrix for nnz non-zeros */
+inline void AllocCSR(const NDArray& csr, index_t nnz) {
+  csr.CheckAndAlloc(TShape(mshadow::Shape1(nnz)),
+                    {TShape(mshadow::Shape1(csr.shape()[0] + 1)), TShape(mshadow::Shape1(nnz))});
+}
+
+/*! \brief store the rows of a dense array which have a non-zero element */
+template<typename DType>
+void CastDenseToRowSparse(const TBlob& dns, const NDArray& rsp) {
+  const index_t num_rows = dns.shape_[0];
+  const index_t row_size = RowSize(dns.shape_);
+  const DType* src = dns.dptr<DType>();
+  std::vector<uint8_t> nonzero(num_rows);
+  #pragma omp parallel for
+  for (int i = 0; i < static_cast<int>(num_rows); ++i) {
+    const DType* row = src + static_cast<size_t>(i) * row_size;
+    nonzero[i] = std::any_of(row, row + row_size, [](DType v) { return v != DType(0); });
+  }
+  index_t nnr = 0;
+  for (index_t i = 0; i < num_rows; ++i) nnr += nonzero[i];
+  AllocRowSparse(rsp, nnr);
+  sparse_index_t* idx = rsp.aux_data(rowsparse::kIdx).dptr<sparse_index_t>();
+  for (index_t i = 0, k = 0; i < num_rows; ++i) {
+    if (nonzero[i]) idx[k++] = i;
+  }
+  DType* dst = rsp.data().dptr<DType>();
+  #pragma omp parallel for
+  for (int k = 0; k < static_cast<int>(nnr); ++k) {
+    std::memcpy(dst + static_cast<size_t>(k) * row_size,
+                src + static_cast<size_t>(idx[k]) * row_size, row_size * sizeof(DType));
+  }
+}
+
+/*! \brief scatter the stored rows into a dense array */
+template<typename DType>
+void CastRowSparseToDense(const NDArray& rsp, const TBlob& dns) {
+  const index_t row_size = RowSize(dns.shape_);
+  const index_t nnr = rsp.storage_shape()[0];
+  DType* dst = dns.dptr<DType>();
+  std::memset(dst, 0, dns.Size() * sizeof(DType));
+  if (nnr == 0) return;
+  const DType* src = rsp.data().dptr<DType>();
+  const sparse_index_t* idx = rsp.aux_data(rowsparse::kIdx).dptr<sparse_index_t>();
+  #pragma omp parallel for
+  for (int k = 0; k < static_cast<int>(nnr); ++k) {
+    std::memcpy(dst + static_cast<size_t>(idx[k]) * row_size,
+                src + static_cast<size_t>(k) * row_size, row_size * sizeof(DType));
+  }
+}
+
+/*! \brief store the non-zeros of a dense matrix */
+template<typename DType>
+void CastDenseToCSR(const TBlob& dns, const NDArray& csr) {
+  CHECK_EQ(dns.shape_.ndim(), 2U) << "CSR storage is only supported for matrices";
+  const index_t num_rows = dns.shape_[0];
+  const index_t num_cols = dns.shape_[1];
+  const DType* src = dns.dptr<DType>();
+  std::vector<sparse_index_t> indptr(num_rows + 1, 0);
+  #pragma omp parallel for
+  for (int i = 0; i < static_cast<int>(num_rows); ++i) {
+    const DType* row = src + static_cast<size_t>(i) * num_cols;
+    indptr[i + 1] = std::count_if(row, row + num_cols, [](DType v) { return v != DType(0); });
+  }
+  for (index_t i = 0; i < num_rows; ++i) indptr[i + 1] += indptr[i];
+  AllocCSR(csr, indptr[num_rows]);
+  std::copy(indptr.begin(), indptr.end(), csr.aux_data(csr::kIndPtr).dptr<sparse_index_t>());
+  sparse_index_t* col = csr.aux_data(csr::kIdx).dptr<sparse_index_t>();
+  DType* val = csr.data().dptr<DType>();
+  #pragma omp parallel for
+  for (int i = 0; i < static_cast<int>(num_rows); ++i) {
+    const DType* row = src + static_cast<size_t>(i) * num_cols;
+    sparse_index_t k = indptr[i];
+    for (index_t j = 0; j < num_cols; ++j) {
+      if (row[j] != DType(0)) {
+        col[k] = j;
+        val[k++] = row[j];
+      }
+    }
+  }
+}
+
+/*! \brief scatter the non-zeros of a csr matrix into a dense matrix */
+template<typename DType>
+void CastCSRToDense(const NDArray& csr, const TBlob& dns) {
+  const index_t num_rows = dns.shape_[0];
+  const index_t num_cols = dns.shape_[1];
+  DType* dst = dns.dptr<DType>();
+  std::memset(dst, 0, dns.Size() * sizeof(DType));
+  const sparse_index_t* indptr = csr.aux_data(csr::kIndPtr).dptr<sparse_index_t>();
+  const sparse_index_t* col = csr.aux_data(csr::kIdx).dptr<sparse_index_t>();
+  const DType* val = csr.data().dptr<DType>();
+  #pragma omp parallel for
+  for (int i = 0; i < static_cast<int>(num_rows); ++i) {
+    DType* row = dst + static_cast<size_t>(i) * num_cols;
+    for (sparse_index_t k = indptr[i]; k < indptr[i + 1]; ++k) {
+      row[col[k]] = val[k];
+    }
+  }
+}
+
+/*! \brief copy the stored values and indices between arrays of the same storage type */
+inline void CopySparse(const NDArray& src, const NDArray& dst) {
+  std::vector<TShape> aux_shapes;
+  for (size_t i = 0; i < src.num_aux(); ++i) aux_shapes.push_back(src.aux_shape(i));
+  dst.CheckAndAlloc(src.storage_shape(), aux_shapes);
+  std::memcpy(dst.data().dptr_, src.data().dptr_,
+              src.storage_shape().Size() * mshadow::mshadow_sizeof(src.dtype()));
+  for (size_t i = 0; i < src.num_aux(); ++i) {
+    std::memcpy(dst.aux_data(i).dptr_, src.aux_data(i).dptr_,
+                aux_shapes[i].Size() * sizeof(sparse_index_t));
+  }
+}
+
+/*!
+ * \brief convert the content of an array to the storage type of another one.
+ *  Both arrays are on CPU and have the same shape and data type.
+ */
+inline void CastStorageComputeImpl(const NDArray& input, const NDArray& output) {
+  const NDArrayStorageType src_type = input.storage_type();
+  const NDArrayStorageType dst_type = output.storage_type();
+  CHECK_EQ(input.shape(), output.shape()) << "cast_storage: shape mismatch";
+  CHECK_EQ(input.dtype(), output.dtype()) << "cast_storage: data type mismatch";
+  CHECK(input.ctx().dev_mask() == cpu::kDevMask && output.ctx().dev_mask() == cpu::kDevMask)
+    << "Sparse storage is only supported on CPU";
+  MSHADOW_TYPE_SWITCH(input.dtype(), DType, {
+    if (src_type == dst_type) {
+      if (src_type == kDefaultStorage) {
+        output.CheckAndAlloc();
+        std::memcpy(output.data().dptr_, input.data().dptr_,
+                    input.shape().Size() * sizeof(DType));
+      } else {
+        CopySparse(input, output);
+      }
+    } else if (src_type == kDefaultStorage) {
+      if (dst_type == kRowSparseStorage) {
+        CastDenseToRowSparse<DType>(input.data(), output);
+      } else {
+        CastDenseToCSR<DType>(input.data(), output);
+      }
+    } else if (dst_type == kDefaultStorage) {
+      output.CheckAndAlloc();
+      if (src_type == kRowSparseStorage) {
+        CastRowSparseToDense<DType>(input, output.data());
+      } else {
+        CastCSRToDense<DType>(input, output.data());
+      }
+    } else {
+      // between the sparse types, through a dense buffer
+      std::vector<DType> buf(input.shape().Size());
+      TBlob dns(buf.data(), input.shape(), cpu::kDevMask);
+      if (src_type == kRowSparseStorage) {
+        CastRowSparseToDense<DType>(input, dns);
+        CastDenseToCSR<DType>(dns, output);
+      } else {
+        CastCSRToDense<DType>(input, dns);
+        CastDenseToRowSparse<DType>(dns, output);
+      }
+    }
+  });
+}
+
+/*!
+ * \brief store the given rows of a dense or row sparse array into a row
+ *  sparse array. The rows missing in a row sparse source are stored as zeros.
+ * \param src the source array
+ * \param row_ids the rows, in any order and possibly repeated
+ * \param out the row sparse output
+ */
+inline void RetainRows(const NDArray& src, const TBlob& row_ids, const NDArray& out) {
+  CHECK_EQ(out.storage_type(), kRowSparseStorage);
+  CHECK_EQ(src.dtype(), out.dtype());
+  const index_t num_rows = src.shape()[0];
+  const index_t row_size = RowSize(src.shape());
+  std::vector<sparse_index_t> rows(row_ids.Size());
+  MSHADOW_TYPE_SWITCH(row_ids.type_flag_, IType, {
+    const IType* ids = row_ids.dptr<IType>();
+    for (size_t i = 0; i < rows.size(); ++i) {
+      rows[i] = static_cast<sparse_index_t>(ids[i]);
+      CHECK(rows[i] >= 0 && static_cast<index_t>(rows[i]) < num_rows)
+        << "Row index " << rows[i] << " out of range [0, " << num_rows << ")";
+    }
+  });
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+  AllocRowSparse(out, rows.size());
+  std::copy(rows.begin(), rows.end(), out.aux_data(rowsparse::kIdx).dptr<sparse_index_t>());
+  MSHADOW_TYPE_SWITCH(src.dtype(), DType, {
+    DType* dst = out.data().dptr<DType>();
+    const DType* val = src.data().dptr<DType>();
+    const bool dense = src.storage_type() == kDefaultStorage;
+    const sparse_index_t* src_idx = nullptr;
+    index_t src_nnr = 0;
+    if (!dense) {
+      CHECK_EQ(src.storage_type(), kRowSparseStorage);
+      src_idx = src.aux_data(rowsparse::kIdx).dptr<sparse_index_t>();
+      src_nnr = src.storage_shape()[0];
+    }
+    #pragma omp parallel for
+    for (int k = 0; k < static_cast<int>(rows.size()); ++k) {
+      DType* row = dst + static_cast<size_t>(k) * row_size;
+      index_t pos = rows[k];
+      if (!dense) {
+        const sparse_index_t* it = std::lower_bound(src_idx, src_idx + src_nnr, rows[k]);
+        if (it == src_idx + src_nnr || *it != rows[k]) {
+          std::fill(row, row + row_size, DType(0));
+          continue;
+        }
+        pos = it - src_idx;
+      }
+      std::memcpy(row, val + static_cast<size_t>(pos) * row_size, row_size * sizeof(DType));
+    }
+  });
+}
+
+struct CastStorageParam : public dmlc::Parameter<CastStorageParam> {
+  int stype;
+  DMLC_DECLARE_PARAMETER(CastStorageParam) {
+    DMLC_DECLARE_FIELD(stype)
+    .add_enum("default", kDefaultStorage)
+    .add_enum("row_sparse", kRowSparseStorage)
+    .add_enum("csr", kCSRStorage)
+    .describe("Storage type of the output.");
+  }
+};
+
+inline bool CastStorageInferStorageType(const nnvm::NodeAttrs& attrs,
+                                        std::vector<int> *in_attrs,
+                                        std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 1U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  const CastStorageParam& param = nnvm::get<CastStorageParam>(attrs.parsed);
+  CHECK((*out_attrs)[0] == kUndefinedStorage || (*out_attrs)[0] == param.stype)
+    << "cast_storage: the output must have the storage type " << param.stype;
+  (*out_attrs)[0] = param.stype;
+  return true;
+}
+
+template<typename xpu>
+void CastStorageComputeEx(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<NDArray>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<NDArray>& outputs) {
+  CHECK_EQ(inputs.size(), 1U);
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kAddTo) << "cast_storage does not support kAddTo";
+  CastStorageComputeImpl(inputs[0], outputs[0]);
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_TENSOR_CAST_STORAGE_INL_H_
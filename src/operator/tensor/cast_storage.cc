@@ -0,0 +1,32 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file cast_storage.cc
+ * \brief CPU implementation of cast_storage operator
+ */
+#include "./cast_storage-inl.h"
+#include "./elemwise_unary_op.h"
+
+namespace mxnet {
+namespace op {
+
+DMLC_REGISTER_PARAMETER(CastStorageParam);
+
+NNVM_REGISTER_OP(cast_storage)
+.MXNET_DESCRIBE("Convert the storage type of the input: "
+                "default (dense), row_sparse (the non-zero rows and their indices) "
+                "or csr (compressed sparse rows of a matrix). "
+                "Sparse storage is only supported on CPU.")
+.set_num_inputs(1)
+.set_num_outputs(1)
+.set_attr_parser(ParamParser<CastStorageParam>)
+.set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<1, 1>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
+.set_attr<FInferStorageType>("FInferStorageType", CastStorageInferStorageType)
+.set_attr<FCompute>("FCompute<cpu>", IdentityCompute<cpu>)
+.set_attr<FComputeEx>("FComputeEx<cpu>", CastStorageComputeEx<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseNone{"_copy"})
+.add_argument("data", "NDArray", "Input array")
+.add_arguments(CastStorageParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
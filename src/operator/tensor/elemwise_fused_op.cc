@@ -0,0 +1,67 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file elemwise_fused_op.cc
+ * \brief CPU Implementation of fused elementwise operator.
+ */
+#include "./elemwise_fused_op.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(FusedElemwiseParam);
+
+NNVM_REGISTER_OP(_FusedElemwise)
+.MXNET_DESCRIBE("Evaluate a chain of elementwise operators in a single pass. "
+                "Created by the executor's elementwise fusion pass.")
+.set_attr_parser(FusedElemwiseParamParser)
+.set_num_inputs([](const NodeAttrs& attrs) {
+    return static_cast<uint32_t>(
+        nnvm::get<fused::FusedProgram>(attrs.parsed).num_inputs);
+  })
+.set_num_outputs(1)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    int num_inputs = nnvm::get<fused::FusedProgram>(attrs.parsed).num_inputs;
+    std::vector<std::string> ret;
+    for (int i = 0; i < num_inputs; ++i) {
+      ret.push_back(std::string("arg") + std::to_string(i));
+    }
+    return ret;
+  })
+.set_attr<nnvm::FInferShape>("FInferShape",
+  [](const NodeAttrs& attrs,
+     std::vector<TShape> *in_attrs,
+     std::vector<TShape> *out_attrs) {
+    return ElemwiseAttr<TShape, shape_is_none, shape_assign, true>(
+        attrs, in_attrs, out_attrs, TShape());
+  })
+.set_attr<nnvm::FInferType>("FInferType",
+  [](const NodeAttrs& attrs,
+     std::vector<int> *in_attrs,
+     std::vector<int> *out_attrs) {
+    return ElemwiseAttr<int, type_is_none, type_assign, true>(
+        attrs, in_attrs, out_attrs, -1);
+  })
+.set_attr<nnvm::FInplaceOption>("FInplaceOption",
+  [](const NodeAttrs& attrs){
+    return std::vector<std::pair<int, int> >{{0, 0}};
+  })
+.set_attr<FCompute>("FCompute<cpu>", FusedElemwiseCompute<cpu>)
+.set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{"_backward_FusedElemwise"})
+.add_argument("args", "NDArray[]", "Inputs of the fused program")
+.add_arguments(FusedElemwiseParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_FusedElemwise)
+.set_attr_parser(FusedElemwiseParamParser)
+.set_num_inputs([](const NodeAttrs& attrs) {
+    return static_cast<uint32_t>(
+        nnvm::get<fused::FusedProgram>(attrs.parsed).num_inputs + 1);
+  })
+.set_num_outputs([](const NodeAttrs& attrs) {
+    return static_cast<uint32_t>(
+        nnvm::get<fused::FusedProgram>(attrs.parsed).num_inputs);
+  })
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<FCompute>("FCompute<cpu>", FusedElemwiseBackward<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,475 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file elemwise_fused_op.h
+ * \brief Function definition of fused elementwise operator.
+ *  A fused node evaluates a small straight-line program of elementwise
+ *  instructions in a single pass over memory, instead of materializing
+ *  every intermediate result.
+ */
+#ifndef MXNET_OPERATOR_TENSOR_ELEMWISE_FUSED_OP_H_
+#define MXNET_OPERATOR_TENSOR_ELEMWISE_FUSED_OP_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/operator_util.h>
+#include <cmath>
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "../mshadow_op.h"
+#include "../elemwise_op_common.h"
+#include "../vector_math.h"
+
+namespace mxnet {
+namespace op {
+namespace fused {
+/*! \brief instruction set of the fused elementwise program */
+enum FusedOpCode {
+  // binary ops on two registers
+  kAdd, kSub, kMul, kDiv, kMaximum, kMinimum,
+  // ops on one register and a scalar
+  kPlusScalar, kMinusScalar, kRMinusScalar, kMulScalar, kDivScalar,
+  kRDivScalar, kMaximumScalar, kMinimumScalar, kPowerScalar,
+  // unary ops on one register
+  kIdentity, kNegative, kAbs, kSquare, kSqrt, kRsqrt, kExp, kLog,
+  kTanh, kSigmoid, kRelu, kSoftrelu,
+  kNumOpCode
+};
+
+/*! \brief maximum number of instructions fused into a single node */
+const int kMaxFusedInstr = 32;
+/*! \brief number of elements each instruction processes at a time */
+const int kBlockSize = 256;
+
+/*!
+ * \brief get the opcode of an operator in the fusable set.
+ * \param op_name name of the nnvm operator.
+ * \param dict attribute dictionary of the node, used by Activation.
+ * \return opcode, or -1 if the operator cannot be fused.
+ */
+inline int GetOpCode(const std::string& op_name,
+                     const std::unordered_map<std::string, std::string>& dict) {
+  static const std::unordered_map<std::string, int> table = {
+    {"elemwise_add", kAdd}, {"_sub", kSub}, {"_mul", kMul}, {"_div", kDiv},
+    {"_maximum", kMaximum}, {"_minimum", kMinimum},
+    {"_plus_scalar", kPlusScalar}, {"_minus_scalar", kMinusScalar},
+    {"_rminus_scalar", kRMinusScalar}, {"_mul_scalar", kMulScalar},
+    {"_div_scalar", kDivScalar}, {"_rdiv_scalar", kRDivScalar},
+    {"_maximum_scalar", kMaximumScalar}, {"_minimum_scalar", kMinimumScalar},
+    {"_power_scalar", kPowerScalar},
+    {"_copy", kIdentity}, {"negative", kNegative}, {"abs", kAbs},
+    {"square", kSquare}, {"sqrt", kSqrt}, {"rsqrt", kRsqrt},
+    {"exp", kExp}, {"log", kLog}, {"tanh", kTanh},
+    {"sigmoid", kSigmoid}, {"relu", kRelu}, {"softrelu", kSoftrelu}
+  };
+  if (op_name == "Activation") {
+    auto it = dict.find("act_type");
+    if (it == dict.end()) return -1;
+    auto jt = table.find(it->second);
+    return jt == table.end() ? -1 : jt->second;
+  }
+  auto it = table.find(op_name);
+  return it == table.end() ? -1 : it->second;
+}
+
+/*! \return number of register operands taken by opcode */
+inline int NumOperands(int opcode) {
+  if (opcode <= kMinimum) return 2;
+  return 1;
+}
+
+/*! \return whether opcode reads its scalar field */
+inline bool HasScalar(int opcode) {
+  return opcode >= kPlusScalar && opcode <= kPowerScalar;
+}
+
+/*!
+ * \brief one instruction of the fused program.
+ *  Registers [0, num_inputs) hold the inputs, instruction k writes
+ *  register num_inputs + k. The last instruction produces the output.
+ */
+struct FusedInstr {
+  int opcode;
+  int lhs;
+  int rhs;
+  double scalar;
+};
+
+/*! \brief parsed fused program, stored in NodeAttrs::parsed */
+struct FusedProgram {
+  int num_inputs;
+  std::vector<FusedInstr> instrs;
+  /*! \return total number of registers used by the program */
+  inline int num_regs() const {
+    return num_inputs + static_cast<int>(instrs.size());
+  }
+};
+
+/*!
+ * \brief serialize instructions into the textual form kept in attrs.dict.
+ *  Each instruction is written as "opcode,lhs,rhs,scalar" and separated by ';'.
+ */
+inline std::string SerializeProgram(const std::vector<FusedInstr>& instrs) {
+  std::ostringstream os;
+  os.precision(17);
+  for (size_t i = 0; i < instrs.size(); ++i) {
+    if (i != 0) os << ';';
+    os << instrs[i].opcode << ',' << instrs[i].lhs << ','
+       << instrs[i].rhs << ',' << instrs[i].scalar;
+  }
+  return os.str();
+}
+
+/*! \brief inverse of SerializeProgram, checks the program is well formed */
+inline FusedProgram ParseProgram(int num_inputs, const std::string& text) {
+  FusedProgram prog;
+  prog.num_inputs = num_inputs;
+  std::istringstream is(text);
+  std::string item;
+  while (std::getline(is, item, ';')) {
+    FusedInstr instr;
+    char c1, c2, c3;
+    std::istringstream ss(item);
+    ss >> instr.opcode >> c1 >> instr.lhs >> c2 >> instr.rhs >> c3 >> instr.scalar;
+    CHECK(!ss.fail() && c1 == ',' && c2 == ',' && c3 == ',')
+        << "Invalid fused instruction " << item;
+    int dst = num_inputs + static_cast<int>(prog.instrs.size());
+    CHECK(instr.opcode >= 0 && instr.opcode < kNumOpCode)
+        << "Invalid fused opcode " << instr.opcode;
+    CHECK(instr.lhs >= 0 && instr.lhs < dst);
+    if (NumOperands(instr.opcode) == 2) {
+      CHECK(instr.rhs >= 0 && instr.rhs < dst);
+    }
+    prog.instrs.push_back(instr);
+  }
+  CHECK_GT(prog.instrs.size(), 0) << "Empty fused program";
+  return prog;
+}
+}  // namespace fused
+
+struct FusedElemwiseParam : public dmlc::Parameter<FusedElemwiseParam> {
+  int num_inputs;
+  std::string program;
+  DMLC_DECLARE_PARAMETER(FusedElemwiseParam) {
+    DMLC_DECLARE_FIELD(num_inputs).set_lower_bound(1)
+      .describe("Number of inputs of the fused program.");
+    DMLC_DECLARE_FIELD(program)
+      .describe("Serialized instructions of the fused program.");
+  }
+};
+
+inline void FusedElemwiseParamParser(nnvm::NodeAttrs* attrs) {
+  FusedElemwiseParam param;
+  param.Init(attrs->dict);
+  attrs->parsed = fused::ParseProgram(param.num_inputs, param.program);
+}
+
+/*!
+ * \brief accumulation type used inside the fused program. Integer types keep
+ *  their own arithmetic, so that _div and the scalar ops truncate as they do
+ *  unfused, only float16 is widened.
+ */
+template<typename DType>
+struct FusedAccType {
+  typedef DType type;
+};
+template<>
+struct FusedAccType<mshadow::half_t> {
+  typedef float type;
+};
+
+/*! \brief transcendental instructions on float with the vectorized functions */
+inline bool FusedVectorMath(int opcode, int n, const float* a, float* out) {
+  using namespace fused;
+  if (!vmath::Enabled()) return false;
+  switch (opcode) {
+    case kExp: vmath::Exp(n, a, out); return true;
+    case kLog: vmath::Log(n, a, out); return true;
+    case kTanh: vmath::Tanh(n, a, out); return true;
+    case kSigmoid: vmath::Sigmoid(n, a, out); return true;
+    case kSoftrelu: vmath::Softrelu(n, a, out); return true;
+    default: return false;
+  }
+}
+
+template<typename AType>
+inline bool FusedVectorMath(int opcode, int n, const AType* a, AType* out) {
+  return false;
+}
+
+/*!
+ * \brief evaluate one instruction over a block of n elements.
+ *  Loops are kept trivially simple so that the compiler can vectorize them.
+ */
+template<typename AType>
+inline void FusedForwardInstr(const fused::FusedInstr& ins, int n,
+                              const AType* a, const AType* b, AType* out) {
+  using namespace fused;
+  const AType s = static_cast<AType>(ins.scalar);
+  if (FusedVectorMath(ins.opcode, n, a, out)) return;
+  switch (ins.opcode) {
+    case kAdd: for (int j = 0; j < n; ++j) out[j] = a[j] + b[j]; break;
+    case kSub: for (int j = 0; j < n; ++j) out[j] = a[j] - b[j]; break;
+    case kMul: for (int j = 0; j < n; ++j) out[j] = a[j] * b[j]; break;
+    case kDiv: for (int j = 0; j < n; ++j) out[j] = a[j] / b[j]; break;
+    case kMaximum: for (int j = 0; j < n; ++j) out[j] = a[j] > b[j] ? a[j] : b[j]; break;
+    case kMinimum: for (int j = 0; j < n; ++j) out[j] = a[j] < b[j] ? a[j] : b[j]; break;
+    case kPlusScalar: for (int j = 0; j < n; ++j) out[j] = a[j] + s; break;
+    case kMinusScalar: for (int j = 0; j < n; ++j) out[j] = a[j] - s; break;
+    case kRMinusScalar: for (int j = 0; j < n; ++j) out[j] = s - a[j]; break;
+    case kMulScalar: for (int j = 0; j < n; ++j) out[j] = a[j] * s; break;
+    case kDivScalar: for (int j = 0; j < n; ++j) out[j] = a[j] / s; break;
+    case kRDivScalar: for (int j = 0; j < n; ++j) out[j] = s / a[j]; break;
+    case kMaximumScalar: for (int j = 0; j < n; ++j) out[j] = a[j] > s ? a[j] : s; break;
+    case kMinimumScalar: for (int j = 0; j < n; ++j) out[j] = a[j] < s ? a[j] : s; break;
+    case kPowerScalar: for (int j = 0; j < n; ++j) out[j] = std::pow(a[j], s); break;
+    case kIdentity: for (int j = 0; j < n; ++j) out[j] = a[j]; break;
+    case kNegative: for (int j = 0; j < n; ++j) out[j] = -a[j]; break;
+    case kAbs: for (int j = 0; j < n; ++j) out[j] = std::abs(a[j]); break;
+    case kSquare: for (int j = 0; j < n; ++j) out[j] = a[j] * a[j]; break;
+    case kSqrt: for (int j = 0; j < n; ++j) out[j] = std::sqrt(a[j]); break;
+    case kRsqrt: for (int j = 0; j < n; ++j) out[j] = AType(1) / std::sqrt(a[j]); break;
+    case kExp: for (int j = 0; j < n; ++j) out[j] = std::exp(a[j]); break;
+    case kLog: for (int j = 0; j < n; ++j) out[j] = std::log(a[j]); break;
+    case kTanh: for (int j = 0; j < n; ++j) out[j] = std::tanh(a[j]); break;
+    case kSigmoid:
+      for (int j = 0; j < n; ++j) out[j] = AType(1) / (AType(1) + std::exp(-a[j]));
+      break;
+    case kRelu: for (int j = 0; j < n; ++j) out[j] = a[j] > AType(0) ? a[j] : AType(0); break;
+    case kSoftrelu: for (int j = 0; j < n; ++j) out[j] = std::log1p(std::exp(a[j])); break;
+    default: LOG(FATAL) << "Unknown fused opcode " << ins.opcode;
+  }
+}
+
+/*!
+ * \brief propagate the adjoint gout of one instruction back to its operands.
+ *  a, b are operand values and y is the value the instruction produced.
+ */
+template<typename AType>
+inline void FusedBackwardInstr(const fused::FusedInstr& ins, int n,
+                               const AType* a, const AType* b, const AType* y,
+                               const AType* gout, AType* ga, AType* gb) {
+  using namespace fused;
+  const AType s = static_cast<AType>(ins.scalar);
+  switch (ins.opcode) {
+    case kAdd:
+      for (int j = 0; j < n; ++j) { ga[j] += gout[j]; gb[j] += gout[j]; }
+      break;
+    case kSub:
+      for (int j = 0; j < n; ++j) { ga[j] += gout[j]; gb[j] -= gout[j]; }
+      break;
+    case kMul:
+      for (int j = 0; j < n; ++j) { ga[j] += gout[j] * b[j]; gb[j] += gout[j] * a[j]; }
+      break;
+    case kDiv:
+      for (int j = 0; j < n; ++j) {
+        ga[j] += gout[j] / b[j];
+        gb[j] -= gout[j] * a[j] / (b[j] * b[j]);
+      }
+      break;
+    case kMaximum:
+      for (int j = 0; j < n; ++j) {
+        ga[j] += a[j] >= b[j] ? gout[j] : AType(0);
+        gb[j] += a[j] < b[j] ? gout[j] : AType(0);
+      }
+      break;
+    case kMinimum:
+      for (int j = 0; j < n; ++j) {
+        ga[j] += a[j] <= b[j] ? gout[j] : AType(0);
+        gb[j] += a[j] > b[j] ? gout[j] : AType(0);
+      }
+      break;
+    case kPlusScalar: case kMinusScalar: case kIdentity:
+      for (int j = 0; j < n; ++j) ga[j] += gout[j];
+      break;
+    case kRMinusScalar: case kNegative:
+      for (int j = 0; j < n; ++j) ga[j] -= gout[j];
+      break;
+    case kMulScalar: for (int j = 0; j < n; ++j) ga[j] += gout[j] * s; break;
+    case kDivScalar: for (int j = 0; j < n; ++j) ga[j] += gout[j] / s; break;
+    case kRDivScalar: for (int j = 0; j < n; ++j) ga[j] -= gout[j] * y[j] / a[j]; break;
+    case kMaximumScalar:
+      for (int j = 0; j < n; ++j) ga[j] += a[j] >= s ? gout[j] : AType(0);
+      break;
+    case kMinimumScalar:
+      for (int j = 0; j < n; ++j) ga[j] += a[j] <= s ? gout[j] : AType(0);
+      break;
+    case kPowerScalar:
+      for (int j = 0; j < n; ++j) ga[j] += gout[j] * s * std::pow(a[j], s - AType(1));
+      break;
+    case kAbs:
+      for (int j = 0; j < n; ++j) {
+        ga[j] += a[j] > AType(0) ? gout[j] : (a[j] < AType(0) ? -gout[j] : AType(0));
+      }
+      break;
+    case kSquare: for (int j = 0; j < n; ++j) ga[j] += AType(2) * a[j] * gout[j]; break;
+    case kSqrt: for (int j = 0; j < n; ++j) ga[j] += AType(0.5) * gout[j] / y[j]; break;
+    case kRsqrt:
+      for (int j = 0; j < n; ++j) ga[j] -= AType(0.5) * gout[j] * y[j] * y[j] * y[j];
+      break;
+    case kExp: for (int j = 0; j < n; ++j) ga[j] += gout[j] * y[j]; break;
+    case kLog: for (int j = 0; j < n; ++j) ga[j] += gout[j] / a[j]; break;
+    case kTanh:
+      for (int j = 0; j < n; ++j) ga[j] += gout[j] * (AType(1) - y[j] * y[j]);
+      break;
+    case kSigmoid:
+      for (int j = 0; j < n; ++j) ga[j] += gout[j] * y[j] * (AType(1) - y[j]);
+      break;
+    case kRelu:
+      for (int j = 0; j < n; ++j) ga[j] += a[j] > AType(0) ? gout[j] : AType(0);
+      break;
+    case kSoftrelu:
+      for (int j = 0; j < n; ++j) ga[j] += gout[j] * (AType(1) - std::exp(-y[j]));
+      break;
+    default: LOG(FATAL) << "Unknown fused opcode " << ins.opcode;
+  }
+}
+
+template<typename DType, typename AType>
+inline void FusedLoadBlock(const DType* src, int n, AType* dst) {
+  for (int j = 0; j < n; ++j) dst[j] = static_cast<AType>(src[j]);
+}
+
+template<typename DType, typename AType>
+inline void FusedStoreBlock(const AType* src, int n, OpReqType req, DType* dst) {
+  if (req == kAddTo) {
+    for (int j = 0; j < n; ++j) dst[j] += static_cast<DType>(src[j]);
+  } else if (req != kNullOp) {
+    for (int j = 0; j < n; ++j) dst[j] = static_cast<DType>(src[j]);
+  }
+}
+
+/*!
+ * \brief run the forward program over one block of [begin, begin + n).
+ *  regs must hold num_regs() * kBlockSize elements.
+ */
+template<typename DType, typename AType>
+inline void FusedForwardBlock(const fused::FusedProgram& prog,
+                              const std::vector<const DType*>& in,
+                              index_t begin, int n, AType* regs) {
+  using fused::kBlockSize;
+  for (int i = 0; i < prog.num_inputs; ++i) {
+    FusedLoadBlock(in[i] + begin, n, regs + i * kBlockSize);
+  }
+  for (size_t k = 0; k < prog.instrs.size(); ++k) {
+    const fused::FusedInstr& ins = prog.instrs[k];
+    const AType* b = fused::NumOperands(ins.opcode) == 2 ?
+        regs + ins.rhs * kBlockSize : nullptr;
+    FusedForwardInstr(ins, n, regs + ins.lhs * kBlockSize, b,
+                      regs + (prog.num_inputs + k) * kBlockSize);
+  }
+}
+
+template<typename DType>
+inline void FusedElemwiseForwardCPU(const fused::FusedProgram& prog,
+                                    const std::vector<const DType*>& in,
+                                    index_t size, OpReqType req, DType* out) {
+  typedef typename FusedAccType<DType>::type AType;
+  using fused::kBlockSize;
+  const index_t nblock = (size + kBlockSize - 1) / kBlockSize;
+  const int out_reg = prog.num_regs() - 1;
+  #pragma omp parallel
+  {
+    std::vector<AType> regs(prog.num_regs() * kBlockSize);
+    #pragma omp for schedule(static)
+    for (index_t blk = 0; blk < nblock; ++blk) {
+      const index_t begin = blk * kBlockSize;
+      const int n = static_cast<int>(std::min<index_t>(kBlockSize, size - begin));
+      FusedForwardBlock(prog, in, begin, n, regs.data());
+      FusedStoreBlock(regs.data() + out_reg * kBlockSize, n, req, out + begin);
+    }
+  }
+}
+
+template<typename DType>
+inline void FusedElemwiseBackwardCPU(const fused::FusedProgram& prog,
+                                     const DType* ograd,
+                                     const std::vector<const DType*>& in,
+                                     index_t size,
+                                     const std::vector<OpReqType>& req,
+                                     const std::vector<DType*>& igrad) {
+  typedef typename FusedAccType<DType>::type AType;
+  using fused::kBlockSize;
+  const index_t nblock = (size + kBlockSize - 1) / kBlockSize;
+  const int nreg = prog.num_regs();
+  #pragma omp parallel
+  {
+    std::vector<AType> regs(nreg * kBlockSize);
+    std::vector<AType> grads(nreg * kBlockSize);
+    #pragma omp for schedule(static)
+    for (index_t blk = 0; blk < nblock; ++blk) {
+      const index_t begin = blk * kBlockSize;
+      const int n = static_cast<int>(std::min<index_t>(kBlockSize, size - begin));
+      FusedForwardBlock(prog, in, begin, n, regs.data());
+      std::fill(grads.begin(), grads.end() - kBlockSize, AType(0));
+      FusedLoadBlock(ograd + begin, n, grads.data() + (nreg - 1) * kBlockSize);
+      for (int k = static_cast<int>(prog.instrs.size()) - 1; k >= 0; --k) {
+        const fused::FusedInstr& ins = prog.instrs[k];
+        const int dst = prog.num_inputs + k;
+        const bool binary = fused::NumOperands(ins.opcode) == 2;
+        FusedBackwardInstr(ins, n, regs.data() + ins.lhs * kBlockSize,
+                           binary ? regs.data() + ins.rhs * kBlockSize : nullptr,
+                           regs.data() + dst * kBlockSize,
+                           grads.data() + dst * kBlockSize,
+                           grads.data() + ins.lhs * kBlockSize,
+                           binary ? grads.data() + ins.rhs * kBlockSize : nullptr);
+      }
+      for (int i = 0; i < prog.num_inputs; ++i) {
+        FusedStoreBlock(grads.data() + i * kBlockSize, n, req[i], igrad[i] + begin);
+      }
+    }
+  }
+}
+
+template<typename xpu>
+void FusedElemwiseCompute(const nnvm::NodeAttrs& attrs,
+                          const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+  const fused::FusedProgram& prog = nnvm::get<fused::FusedProgram>(attrs.parsed);
+  CHECK_EQ(inputs.size(), static_cast<size_t>(prog.num_inputs));
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    std::vector<const DType*> in(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      in[i] = inputs[i].dptr<DType>();
+    }
+    FusedElemwiseForwardCPU(prog, in, outputs[0].Size(), req[0],
+                            outputs[0].dptr<DType>());
+  });
+}
+
+/*!
+ * \brief backward of the fused program.
+ *  inputs are [out_grad, in_0, ..., in_{n-1}], outputs are the gradients of
+ *  each input. Intermediate values are recomputed per block in registers,
+ *  so the forward pass does not need to keep them.
+ */
+template<typename xpu>
+void FusedElemwiseBackward(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+  const fused::FusedProgram& prog = nnvm::get<fused::FusedProgram>(attrs.parsed);
+  CHECK_EQ(inputs.size(), static_cast<size_t>(prog.num_inputs + 1));
+  CHECK_EQ(outputs.size(), static_cast<size_t>(prog.num_inputs));
+  MSHADOW_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+    std::vector<const DType*> in(prog.num_inputs);
+    std::vector<DType*> igrad(prog.num_inputs);
+    for (int i = 0; i < prog.num_inputs; ++i) {
+      in[i] = inputs[i + 1].dptr<DType>();
+      igrad[i] = outputs[i].dptr<DType>();
+    }
+    FusedElemwiseBackwardCPU(prog, inputs[0].dptr<DType>(), in,
+                             inputs[0].Size(), req, igrad);
+  });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_TENSOR_ELEMWISE_FUSED_OP_H_
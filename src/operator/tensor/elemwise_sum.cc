@@ -70,6 +70,8 @@ NNVM_REGISTER_OP(ElementWiseSum)
   })
 .set_attr<std::string>("key_var_num_args", "num_args")
 .set_attr<FCompute>("FCompute<cpu>", ElementWiseSumCompute<cpu>)
+.set_attr<FInferStorageType>("FInferStorageType", ElementWiseSumStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", ElementWiseSumComputeEx<cpu>)
 .set_attr<nnvm::FInplaceOption>(
     "FInplaceOption", [](const NodeAttrs& attrs) {
       return std::vector<std::pair<int, int> >{{0, 0}};
@@ -8,11 +8,13 @@
 #define MXNET_OPERATOR_TENSOR_ELEMWISE_SUM_H_
 
 #include <dmlc/logging.h>
+#include <algorithm>
 #include <cstring>
 #include <vector>
 #include "../operator_common.h"
 #include "../elemwise_op_common.h"
 #include "../mshadow_op.h"
+#include "./cast_storage-inl.h"
 
 namespace mxnet {
 namespace op {
@@ -62,6 +64,136 @@ void ElementWiseSumCompute_(const nnvm::NodeAttrs& attrs,
   }
 }
 
+/*! \brief accumulation type of the CPU sum, half precision is summed in float */
+template<typename DType>
+struct ElementWiseSumAcc {
+  typedef DType type;
+};
+template<>
+struct ElementWiseSumAcc<mshadow::half::half_t> {
+  typedef float type;
+};
+
+/*!
+ * \brief n-ary sum on CPU. The output is split in blocks that threads compute
+ *  independently: a block of every input is added to an accumulator that stays
+ *  in L1, four inputs at a time, and written once. The output may be one of
+ *  the inputs.
+ */
+template<typename DType>
+void ElementWiseSumCPU(const std::vector<TBlob>& in_data,
+                       OpReqType req,
+                       const TBlob& out_data) {
+  typedef typename ElementWiseSumAcc<DType>::type AType;
+  const index_t kBlock = 1024;
+  if (req == kNullOp) return;
+  const int num = static_cast<int>(in_data.size());
+  const index_t size = out_data.Size();
+  std::vector<const DType*> in(num);
+  for (int i = 0; i < num; ++i) {
+    CHECK_EQ(in_data[i].type_flag_, out_data.type_flag_)
+      << "Only support input/output with the same data type";
+    CHECK(in_data[i].CheckContiguous());
+    in[i] = in_data[i].dptr<DType>();
+  }
+  DType* out = out_data.dptr<DType>();
+  const int nblock = static_cast<int>((size + kBlock - 1) / kBlock);
+  #pragma omp parallel for if (nblock > 16)
+  for (int b = 0; b < nblock; ++b) {
+    const index_t begin = b * kBlock;
+    const index_t len = std::min(kBlock, size - begin);
+    AType acc[kBlock];
+    const DType* x0 = in[0] + begin;
+    if (req == kAddTo) {
+      for (index_t j = 0; j < len; ++j) acc[j] = AType(out[begin + j]) + AType(x0[j]);
+    } else {
+      for (index_t j = 0; j < len; ++j) acc[j] = AType(x0[j]);
+    }
+    int i = 1;
+    for (; i + 4 <= num; i += 4) {
+      const DType* x1 = in[i] + begin;
+      const DType* x2 = in[i + 1] + begin;
+      const DType* x3 = in[i + 2] + begin;
+      const DType* x4 = in[i + 3] + begin;
+      for (index_t j = 0; j < len; ++j) {
+        acc[j] += (AType(x1[j]) + AType(x2[j])) + (AType(x3[j]) + AType(x4[j]));
+      }
+    }
+    for (; i < num; ++i) {
+      const DType* x = in[i] + begin;
+      for (index_t j = 0; j < len; ++j) acc[j] += AType(x[j]);
+    }
+    DType* o = out + begin;
+    for (index_t j = 0; j < len; ++j) o[j] = DType(acc[j]);
+  }
+}
+
+/*!
+ * \brief sum of row sparse arrays on CPU, which stores the union of their rows.
+ *  Every input is added in turn, its rows in parallel, so the result does not
+ *  depend on the number of threads. The output may be one of the inputs.
+ */
+inline void ElementWiseSumRowSparse(const std::vector<NDArray>& in_data, const NDArray& out) {
+  CHECK_EQ(out.storage_type(), kRowSparseStorage);
+  std::vector<sparse_index_t> rows;
+  for (const NDArray& in : in_data) {
+    CHECK_EQ(in.storage_type(), kRowSparseStorage);
+    CHECK_EQ(in.dtype(), out.dtype())
+      << "Only support input/output with the same data type";
+    const sparse_index_t* idx = in.aux_data(rowsparse::kIdx).dptr<sparse_index_t>();
+    rows.insert(rows.end(), idx, idx + in.storage_shape()[0]);
+  }
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+  const index_t row_size = RowSize(out.shape());
+  MSHADOW_TYPE_SWITCH(out.dtype(), DType, {
+    typedef typename ElementWiseSumAcc<DType>::type AType;
+    std::vector<AType> acc(rows.size() * row_size, AType(0));
+    for (const NDArray& in : in_data) {
+      const int nnr = static_cast<int>(in.storage_shape()[0]);
+      if (nnr == 0) continue;
+      const sparse_index_t* idx = in.aux_data(rowsparse::kIdx).dptr<sparse_index_t>();
+      const DType* val = in.data().dptr<DType>();
+      #pragma omp parallel for
+      for (int k = 0; k < nnr; ++k) {
+        const size_t pos = std::lower_bound(rows.begin(), rows.end(), idx[k]) - rows.begin();
+        AType* dst = acc.data() + pos * row_size;
+        const DType* src = val + static_cast<size_t>(k) * row_size;
+        for (index_t j = 0; j < row_size; ++j) dst[j] += AType(src[j]);
+      }
+    }
+    // the inputs are read, the output can be reallocated
+    AllocRowSparse(out, rows.size());
+    std::copy(rows.begin(), rows.end(), out.aux_data(rowsparse::kIdx).dptr<sparse_index_t>());
+    DType* dst = out.data().dptr<DType>();
+    for (size_t j = 0; j < acc.size(); ++j) dst[j] = DType(acc[j]);
+  });
+}
+
+inline bool ElementWiseSumStorageType(const nnvm::NodeAttrs& attrs,
+                                      std::vector<int> *in_attrs,
+                                      std::vector<int> *out_attrs) {
+  CHECK_EQ(out_attrs->size(), 1U);
+  for (int stype : *in_attrs) {
+    if (stype != kRowSparseStorage) return false;
+  }
+  if ((*out_attrs)[0] != kUndefinedStorage && (*out_attrs)[0] != kRowSparseStorage) return false;
+  (*out_attrs)[0] = kRowSparseStorage;
+  return true;
+}
+
+template<typename xpu>
+void ElementWiseSumComputeEx(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<NDArray>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<NDArray>& outputs) {
+  CHECK_EQ(outputs.size(), 1U);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kAddTo) << "The sum of row sparse arrays does not support kAddTo";
+  ElementWiseSumRowSparse(inputs, outputs[0]);
+}
+
 template<typename xpu>
 void ElementWiseSumCompute(const nnvm::NodeAttrs& attrs,
                            const OpContext& ctx,
@@ -74,6 +206,18 @@ void ElementWiseSumCompute(const nnvm::NodeAttrs& attrs,
     });
 }
 
+template<>
+inline void ElementWiseSumCompute<cpu>(const nnvm::NodeAttrs& attrs,
+                                       const OpContext& ctx,
+                                       const std::vector<TBlob>& inputs,
+                                       const std::vector<OpReqType>& req,
+                                       const std::vector<TBlob>& outputs) {
+  CHECK_EQ(outputs.size(), 1);
+  MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+      ElementWiseSumCPU<DType>(inputs, req[0], outputs[0]);
+    });
+}
+
 }  // namespace op
 }  // namespace mxnet
 #endif  // MXNET_OPERATOR_TENSOR_ELEMWISE_SUM_H_
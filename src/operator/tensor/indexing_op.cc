@@ -49,7 +49,9 @@ NNVM_REGISTER_OP(_backward_Embedding)
     return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
   })
 .set_attr<nnvm::TIsBackward>("TIsBackward", true)
-.set_attr<FCompute>("FCompute<cpu>", EmbeddingOpBackward<cpu>);
+.set_attr<FCompute>("FCompute<cpu>", EmbeddingOpBackward<cpu>)
+.set_attr<FInferStorageType>("FInferStorageType", EmbeddingOpBackwardStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", EmbeddingOpBackwardEx<cpu>);
 
 
 NNVM_REGISTER_OP(take)
@@ -8,6 +8,7 @@
 #define MXNET_OPERATOR_TENSOR_INDEXING_OP_H_
 
 #include <dmlc/logging.h>
+#include <dmlc/omp.h>
 #include <dmlc/parameter.h>
 #include <mxnet/operator.h>
 #include <mxnet/operator_util.h>
@@ -22,6 +23,7 @@
 #include "../elemwise_op_common.h"
 #include "../mxnet_op.h"
 #include "./sort_op.h"
+#include "./cast_storage-inl.h"
 
 namespace mxnet {
 namespace op {
@@ -214,6 +216,107 @@ void AddTakeGradLargeBatchCaller(const OpContext& ctx, mshadow::Tensor<xpu, 2, D
   mxnet::op::AddTakeGradLargeBatch(dst, sorted_data, original_index, src, &temp_storage);
 }
 
+/*! \brief number of row ranges per thread of AddTakeGradPartitioned, for skewed indices */
+const int kTakeGradPartsPerThread = 8;
+
+/*!
+ * \brief CPU/GPU: dst[index[i]] += src[i] for every i, starting from zero
+ *  when req is kWriteTo. Returns false, doing nothing, where there is no
+ *  partitioned implementation.
+ */
+template<typename xpu, typename DType>
+inline bool AddTakeGradPartitioned(const OpContext& ctx, mshadow::Tensor<xpu, 2, DType> dst,
+                                   const mshadow::Tensor<xpu, 1, DType>& index,
+                                   const mshadow::Tensor<xpu, 2, DType>& src, OpReqType req) {
+  return false;
+}
+
+/*!
+ * \brief CPU: the rows of dst are split in ranges, the positions are
+ *  partitioned by the range of their clipped index with a stable counting
+ *  pass, then every range is accumulated by a single thread in the order of
+ *  the positions. No atomics are needed and the sums are those of the serial
+ *  loop whatever the number of threads. With kAddTo the rows that no index
+ *  refers to are not touched.
+ */
+template<typename DType>
+inline bool AddTakeGradPartitioned(const OpContext& ctx, mshadow::Tensor<cpu, 2, DType> dst,
+                                   const mshadow::Tensor<cpu, 1, DType>& index,
+                                   const mshadow::Tensor<cpu, 2, DType>& src, OpReqType req) {
+  using namespace mshadow;
+  CHECK(req == kWriteTo || req == kAddTo);
+  const int num_rows = static_cast<int>(dst.size(0));
+  const index_t row_size = dst.size(1);
+  const int n = static_cast<int>(index.size(0));
+  CHECK_EQ(src.size(0), index.size(0));
+  CHECK_EQ(src.size(1), row_size);
+  const int nthreads = std::max(1, omp_get_max_threads());
+  const int nparts = nthreads == 1 ? 1 : std::min(num_rows, kTakeGradPartsPerThread * nthreads);
+  // the row and position of every index, then per thread and range counts and the range starts
+  Tensor<cpu, 1, int> workspace =
+    ctx.requested[embedding::kTempSpace].get_space_typed<cpu, 1, int>(
+      Shape1(2 * n + nthreads * nparts + nparts + 1), ctx.get_stream<cpu>());
+  int* rows = workspace.dptr_;
+  int* order = rows + n;
+  int* count = order + n;
+  int* start = count + nthreads * nparts;
+  std::fill(count, count + nthreads * nparts, 0);
+  auto part_of = [=](int row) {
+    return static_cast<int>(static_cast<int64_t>(row) * nparts / num_rows);
+  };
+  auto part_begin = [=](int p) {
+    return static_cast<int>((static_cast<int64_t>(p) * num_rows + nparts - 1) / nparts);
+  };
+  #pragma omp parallel for num_threads(nthreads)
+  for (int t = 0; t < nthreads; ++t) {
+    const int begin = static_cast<int>(static_cast<int64_t>(n) * t / nthreads);
+    const int end = static_cast<int>(static_cast<int64_t>(n) * (t + 1) / nthreads);
+    int* c = count + t * nparts;
+    for (int i = begin; i < end; ++i) {
+      // out of range indices are clipped as in the forward pass
+      const DType v = index[i];
+      const int row = !(v > DType(0)) ? 0 :
+          (v >= DType(num_rows - 1) ? num_rows - 1 : static_cast<int>(v));
+      rows[i] = row;
+      ++c[part_of(row)];
+    }
+  }
+  // ranges in order, and inside a range the chunks of the threads in order
+  int offset = 0;
+  for (int p = 0; p < nparts; ++p) {
+    start[p] = offset;
+    for (int t = 0; t < nthreads; ++t) {
+      const int c = count[t * nparts + p];
+      count[t * nparts + p] = offset;
+      offset += c;
+    }
+  }
+  start[nparts] = offset;
+  #pragma omp parallel for num_threads(nthreads)
+  for (int t = 0; t < nthreads; ++t) {
+    const int begin = static_cast<int>(static_cast<int64_t>(n) * t / nthreads);
+    const int end = static_cast<int>(static_cast<int64_t>(n) * (t + 1) / nthreads);
+    int* c = count + t * nparts;
+    for (int i = begin; i < end; ++i) order[c[part_of(rows[i])]++] = i;
+  }
+  #pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+  for (int p = 0; p < nparts; ++p) {
+    if (req == kWriteTo) {
+      for (int r = part_begin(p); r < part_begin(p + 1); ++r) {
+        DType* row = dst.dptr_ + static_cast<size_t>(r) * dst.stride_;
+        std::fill(row, row + row_size, DType(0));
+      }
+    }
+    for (int k = start[p]; k < start[p + 1]; ++k) {
+      const int i = order[k];
+      DType* row = dst.dptr_ + static_cast<size_t>(rows[i]) * dst.stride_;
+      const DType* g = src.dptr_ + static_cast<size_t>(i) * src.stride_;
+      for (index_t j = 0; j < row_size; ++j) row[j] += g[j];
+    }
+  }
+  return true;
+}
+
 template<typename xpu>
 void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
                          const OpContext& ctx,
@@ -240,6 +343,7 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
 
 
     if (req[embedding::kWeight] == kWriteTo || req[embedding::kWeight] == kAddTo) {
+      if (AddTakeGradPartitioned(ctx, grad_in, data, grad_out, req[embedding::kWeight])) return;
       if (req[embedding::kWeight] == kWriteTo) {
         grad_in = scalar<DType>(0.0f);
       }
@@ -264,6 +368,79 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
   });
 }
 
+/*!
+ * \brief the weight gradient is row sparse when the bound gradient array is,
+ *  it then only stores the rows of the looked up indices
+ */
+inline bool EmbeddingOpBackwardStorageType(const nnvm::NodeAttrs& attrs,
+                                           std::vector<int> *in_attrs,
+                                           std::vector<int> *out_attrs) {
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  for (int stype : *in_attrs) {
+    if (stype != kDefaultStorage) return false;
+  }
+  if ((*out_attrs)[embedding::kWeight] != kRowSparseStorage) return false;
+  if ((*out_attrs)[embedding::kData] == kUndefinedStorage) {
+    (*out_attrs)[embedding::kData] = kDefaultStorage;
+  }
+  return true;
+}
+
+template<typename xpu>
+void EmbeddingOpBackwardEx(const nnvm::NodeAttrs& attrs,
+                           const OpContext& ctx,
+                           const std::vector<NDArray>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<NDArray>& outputs) {
+  CHECK_EQ(inputs.size(), 2);
+  CHECK_EQ(outputs.size(), 2);
+  CHECK_EQ(req[embedding::kData], kNullOp)
+          << "Embedding layer doesn't support calculate data gradient";
+  if (req[embedding::kWeight] == kNullOp) return;
+  CHECK_NE(req[embedding::kWeight], kAddTo)
+          << "A row sparse Embedding weight gradient does not support kAddTo";
+  const NDArray& grad_in = outputs[embedding::kWeight];
+  const TBlob data = inputs[1].data();
+  const TBlob grad_out = inputs[0].data();
+  const index_t num_rows = grad_in.shape()[0];
+  const index_t row_size = RowSize(grad_in.shape());
+  const size_t num_items = data.Size();
+  CHECK_EQ(grad_out.type_flag_, grad_in.dtype());
+  MSHADOW_TYPE_SWITCH(grad_in.dtype(), DType, {
+    // sort the positions by index, every row is then a segment summed in order
+    std::vector<std::pair<sparse_index_t, sparse_index_t> > items(num_items);
+    const DType* idx = data.dptr<DType>();
+    for (size_t i = 0; i < num_items; ++i) {
+      // out of range indices are clipped as in the forward pass
+      const index_t row = std::min(num_rows - 1,
+          static_cast<index_t>(std::max(DType(0), idx[i])));
+      items[i] = std::make_pair(static_cast<sparse_index_t>(row), static_cast<sparse_index_t>(i));
+    }
+    std::sort(items.begin(), items.end());
+    std::vector<size_t> segments;
+    for (size_t i = 0; i < num_items; ++i) {
+      if (i == 0 || items[i].first != items[i - 1].first) segments.push_back(i);
+    }
+    const int nnr = static_cast<int>(segments.size());
+    segments.push_back(num_items);
+    AllocRowSparse(grad_in, nnr);
+    sparse_index_t* rows = grad_in.aux_data(rowsparse::kIdx).dptr<sparse_index_t>();
+    DType* dst = grad_in.data().dptr<DType>();
+    const DType* src = grad_out.dptr<DType>();
+    #pragma omp parallel for
+    for (int k = 0; k < nnr; ++k) {
+      rows[k] = items[segments[k]].first;
+      DType* row = dst + static_cast<size_t>(k) * row_size;
+      std::fill(row, row + row_size, DType(0));
+      for (size_t i = segments[k]; i < segments[k + 1]; ++i) {
+        const DType* g = src + static_cast<size_t>(items[i].second) * row_size;
+        for (index_t j = 0; j < row_size; ++j) row[j] += g[j];
+      }
+    }
+  });
+}
+
 namespace take_ {  // to avoid name conflict
 enum TakeOpInputs {kArr, kIdx};
 enum TakeOpOutputs {kOut};
@@ -411,6 +588,7 @@ void TakeOpBackward(const nnvm::NodeAttrs& attrs,
             Shape2(arrshape[0], arrshape.ProdShape(1, arrshape.ndim())), s);
 
         if (req[take_::kArr] == kWriteTo || req[take_::kArr] == kAddTo) {
+            if (AddTakeGradPartitioned(ctx, grad_in, idx, grad_out, req[take_::kArr])) return;
             if (req[take_::kArr] == kWriteTo) {
                 grad_in = scalar<DType>(0.0f);
             }
@@ -14,6 +14,9 @@
 #include "../elemwise_op_common.h"
 #include "../mxnet_op.h"
 #include "broadcast_reduce_op.h"
+#include "./cast_storage-inl.h"
+#include "../transpose_cpu.h"
+#include "../batch_gemm_cpu.h"
 
 namespace mxnet {
 namespace op {
@@ -217,6 +220,7 @@ void TransposeImpl(RunContext ctx,
   using namespace mshadow::expr;
   CHECK_EQ(src.type_flag_, ret.type_flag_);
   Stream<xpu> *s = ctx.get_stream<xpu>();
+  if (axes.ndim() > 0 && TransposeBlob(s, src, ret, axes)) return;
   MSHADOW_TYPE_SWITCH(ret.type_flag_, DType, {
     switch (axes.ndim()) {
      case 0:
@@ -533,6 +537,202 @@ inline bool DotShape(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
+/*!
+ * \brief out = dot(lhs, rhs), or dot(lhs.T, rhs) when trans_lhs is true, for
+ *  a csr lhs and a dense rhs. The output is dense, or row sparse with the
+ *  rows of the columns of lhs holding a non-zero for the transposed product.
+ */
+inline void DotCsrDnsImpl(const NDArray& lhs, const TBlob& rhs, bool trans_lhs,
+                          OpReqType req, const NDArray& out) {
+  if (req == kNullOp) return;
+  CHECK_EQ(lhs.storage_type(), kCSRStorage);
+  CHECK_EQ(lhs.shape().ndim(), 2U) << "dot: the csr lhs must be a matrix";
+  const index_t num_rows = lhs.shape()[0];
+  const index_t k = trans_lhs ? num_rows : lhs.shape()[1];
+  const index_t out_rows = trans_lhs ? lhs.shape()[1] : num_rows;
+  CHECK_EQ(rhs.shape_[0], k) << "dot shape error: " << lhs.shape() << " X " << rhs.shape_;
+  const index_t n = k == 0 ? 0 : rhs.Size() / k;
+  const bool rsp_out = out.storage_type() == kRowSparseStorage;
+  if (rsp_out) {
+    CHECK(trans_lhs) << "dot: only the transposed product of a csr lhs is row sparse";
+    CHECK_NE(req, kAddTo) << "dot: a row sparse output does not support kAddTo";
+  } else {
+    CHECK_EQ(out.storage_type(), kDefaultStorage);
+  }
+  CHECK_EQ(lhs.dtype(), out.dtype())
+      << "Binary function only support input/output with the same type";
+  CHECK_EQ(rhs.type_flag_, out.dtype())
+      << "Binary function only support input/output with the same type";
+  MSHADOW_REAL_TYPE_SWITCH(out.dtype(), DType, {
+    const sparse_index_t* indptr = lhs.aux_data(csr::kIndPtr).dptr<sparse_index_t>();
+    const sparse_index_t* col = lhs.aux_data(csr::kIdx).dptr<sparse_index_t>();
+    const DType* val = lhs.data().dptr<DType>();
+    const DType* r = rhs.dptr<DType>();
+    if (!trans_lhs) {
+      DType* o = out.data().dptr<DType>();
+      #pragma omp parallel for
+      for (int i = 0; i < static_cast<int>(num_rows); ++i) {
+        DType* orow = o + static_cast<size_t>(i) * n;
+        if (req != kAddTo) std::fill(orow, orow + n, DType(0));
+        for (sparse_index_t p = indptr[i]; p < indptr[i + 1]; ++p) {
+          const DType v = val[p];
+          const DType* rrow = r + static_cast<size_t>(col[p]) * n;
+          for (index_t j = 0; j < n; ++j) orow[j] += v * rrow[j];
+        }
+      }
+    } else {
+      // output row of every column of lhs
+      std::vector<index_t> pos(out_rows);
+      DType* o;
+      if (rsp_out) {
+        std::vector<uint8_t> used(out_rows, 0);
+        for (sparse_index_t p = 0; p < indptr[num_rows]; ++p) used[col[p]] = 1;
+        index_t nnr = 0;
+        for (index_t c = 0; c < out_rows; ++c) nnr += used[c];
+        AllocRowSparse(out, nnr);
+        sparse_index_t* idx = out.aux_data(rowsparse::kIdx).dptr<sparse_index_t>();
+        for (index_t c = 0, m = 0; c < out_rows; ++c) {
+          if (used[c]) {
+            idx[m] = c;
+            pos[c] = m++;
+          }
+        }
+        o = out.data().dptr<DType>();
+        std::fill(o, o + static_cast<size_t>(nnr) * n, DType(0));
+      } else {
+        for (index_t c = 0; c < out_rows; ++c) pos[c] = c;
+        o = out.data().dptr<DType>();
+        if (req != kAddTo) std::fill(o, o + static_cast<size_t>(out_rows) * n, DType(0));
+      }
+      // the rows of lhs scatter into the same output rows, so the threads
+      // split the columns and every element is summed in a fixed order
+      const index_t kBlock = 64;
+      const int num_blocks = static_cast<int>((n + kBlock - 1) / kBlock);
+      #pragma omp parallel for
+      for (int b = 0; b < num_blocks; ++b) {
+        const index_t begin = b * kBlock;
+        const index_t end = std::min(n, begin + kBlock);
+        for (index_t i = 0; i < num_rows; ++i) {
+          const DType* rrow = r + static_cast<size_t>(i) * n;
+          for (sparse_index_t p = indptr[i]; p < indptr[i + 1]; ++p) {
+            const DType v = val[p];
+            DType* orow = o + static_cast<size_t>(pos[col[p]]) * n;
+            for (index_t j = begin; j < end; ++j) orow[j] += v * rrow[j];
+          }
+        }
+      }
+    }
+  });
+}
+
+inline bool DotInferStorageType(const nnvm::NodeAttrs& attrs,
+                                std::vector<int> *in_attrs,
+                                std::vector<int> *out_attrs) {
+  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 2U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  if ((*in_attrs)[0] != kCSRStorage || (*in_attrs)[1] != kDefaultStorage ||
+      param.transpose_b) {
+    return false;
+  }
+  int& out = (*out_attrs)[0];
+  if (out == kUndefinedStorage) {
+    out = param.transpose_a ? kRowSparseStorage : kDefaultStorage;
+  }
+  return out == kDefaultStorage || (param.transpose_a && out == kRowSparseStorage);
+}
+
+template<typename xpu>
+void DotForwardEx(const nnvm::NodeAttrs& attrs,
+                  const OpContext& ctx,
+                  const std::vector<NDArray>& inputs,
+                  const std::vector<OpReqType>& req,
+                  const std::vector<NDArray>& outputs) {
+  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 2U);
+  CHECK_EQ(outputs.size(), 1U);
+  CHECK(!param.transpose_b) << "dot: transpose_b is not supported with a csr lhs";
+  DotCsrDnsImpl(inputs[0], inputs[1].data(), param.transpose_a, req[0], outputs[0]);
+}
+
+inline bool DotBackwardInferStorageType(const nnvm::NodeAttrs& attrs,
+                                        std::vector<int> *in_attrs,
+                                        std::vector<int> *out_attrs) {
+  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), 3U);
+  CHECK_EQ(out_attrs->size(), 2U);
+  if ((*in_attrs)[0] != kDefaultStorage || (*in_attrs)[1] != kCSRStorage ||
+      (*in_attrs)[2] != kDefaultStorage || param.transpose_b) {
+    return false;
+  }
+  // the gradient of the csr lhs is not computed
+  if ((*out_attrs)[0] == kUndefinedStorage) (*out_attrs)[0] = kDefaultStorage;
+  int& rhs_grad = (*out_attrs)[1];
+  if (rhs_grad == kUndefinedStorage) {
+    rhs_grad = param.transpose_a ? kDefaultStorage : kRowSparseStorage;
+  }
+  return rhs_grad == kDefaultStorage || (!param.transpose_a && rhs_grad == kRowSparseStorage);
+}
+
+template<typename xpu>
+void DotBackwardEx(const nnvm::NodeAttrs& attrs,
+                   const OpContext& ctx,
+                   const std::vector<NDArray>& inputs,
+                   const std::vector<OpReqType>& req,
+                   const std::vector<NDArray>& outputs) {
+  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 3U);
+  CHECK_EQ(outputs.size(), 2U);
+  CHECK_EQ(req[0], kNullOp)
+      << "dot: the gradient of a csr lhs is not supported, set its grad_req to null";
+  // dy = dot(x.T, dz), or dot(x, dz) for z = dot(x.T, y)
+  DotCsrDnsImpl(inputs[1], inputs[0].data(), !param.transpose_a, req[1], outputs[1]);
+}
+
+struct BatchDotParam : public dmlc::Parameter<BatchDotParam> {
+  bool transpose_a;
+  bool transpose_b;
+  float alpha;
+  DMLC_DECLARE_PARAMETER(BatchDotParam) {
+    DMLC_DECLARE_FIELD(transpose_a)
+      .describe("True if the first matrix is transposed.")
+      .set_default(false);
+    DMLC_DECLARE_FIELD(transpose_b)
+      .describe("True if the second matrix is tranposed.")
+      .set_default(false);
+    DMLC_DECLARE_FIELD(alpha)
+      .describe("Scale of the products.")
+      .set_default(1.0f);
+  }
+};
+
+/*! \brief out = alpha * op(lhs) op(rhs) + beta * out for every matrix of the batch */
+template<bool transpose_a, bool transpose_b, typename xpu>
+inline void BatchDotGEMM(mshadow::Stream<xpu> *s, mshadow::Tensor<xpu, 3, real_t> out,
+                         const mshadow::Tensor<xpu, 3, real_t>& lhs,
+                         const mshadow::Tensor<xpu, 3, real_t>& rhs,
+                         real_t alpha, real_t beta,
+                         mshadow::Tensor<xpu, 1, real_t*> workspace) {
+  mshadow::BatchGEMM<transpose_a, transpose_b>(out, lhs, rhs, alpha, beta, workspace);
+}
+
+/*! \brief on CPU small products are computed together, in parallel over the batch */
+template<bool transpose_a, bool transpose_b>
+inline void BatchDotGEMM(mshadow::Stream<cpu> *s, mshadow::Tensor<cpu, 3, real_t> out,
+                         const mshadow::Tensor<cpu, 3, real_t>& lhs,
+                         const mshadow::Tensor<cpu, 3, real_t>& rhs,
+                         real_t alpha, real_t beta,
+                         mshadow::Tensor<cpu, 1, real_t*> workspace) {
+  const index_t m = out.size(1), n = out.size(2);
+  const index_t k = transpose_a ? lhs.size(1) : lhs.size(2);
+  if (static_cast<size_t>(m) * n * k > kBatchGemmMaxSize) {
+    mshadow::BatchGEMM<transpose_a, transpose_b>(out, lhs, rhs, alpha, beta, workspace);
+    return;
+  }
+  BatchGemmCPU(out.size(0), m, n, k, alpha, lhs.dptr_, transpose_a, rhs.dptr_, transpose_b,
+               beta, out.dptr_);
+}
+
 template<typename xpu>
 void BatchDotForward_(const nnvm::NodeAttrs& attrs,
                       const OpContext& ctx,
@@ -541,7 +741,7 @@ void BatchDotForward_(const nnvm::NodeAttrs& attrs,
                       const std::vector<TBlob>& outputs) {
   using namespace mshadow::expr;
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
-  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  const BatchDotParam& param = nnvm::get<BatchDotParam>(attrs.parsed);
   CHECK_EQ(outputs[0].type_flag_, inputs[0].type_flag_)
       << "Binary function only support input/output with the same type";
   CHECK_EQ(outputs[0].type_flag_, inputs[1].type_flag_)
@@ -556,21 +756,21 @@ void BatchDotForward_(const nnvm::NodeAttrs& attrs,
     ctx.requested[0].get_space_typed<xpu, 1, real_t*>(mshadow::Shape1(3 * out.size(0)), s);
   if (kNullOp != req[0]) {
     if (param.transpose_a && param.transpose_b) {
-      mshadow::BatchGEMM<true, true>(out, mlhs, mrhs, 1.0f,
-                                     (kAddTo == req[0]) ? 1.0f : 0.0f,
-                                     workspace);
+      BatchDotGEMM<true, true>(s, out, mlhs, mrhs, param.alpha,
+                               (kAddTo == req[0]) ? 1.0f : 0.0f,
+                               workspace);
     } else if (!param.transpose_a && param.transpose_b) {
-      mshadow::BatchGEMM<false, true>(out, mlhs, mrhs, 1.0f,
-                                     (kAddTo == req[0]) ? 1.0f : 0.0f,
-                                     workspace);
+      BatchDotGEMM<false, true>(s, out, mlhs, mrhs, param.alpha,
+                                (kAddTo == req[0]) ? 1.0f : 0.0f,
+                                workspace);
     } else if (param.transpose_a && !param.transpose_b) {
-      mshadow::BatchGEMM<true, false>(out, mlhs, mrhs, 1.0f,
-                                     (kAddTo == req[0]) ? 1.0f : 0.0f,
-                                     workspace);
+      BatchDotGEMM<true, false>(s, out, mlhs, mrhs, param.alpha,
+                                (kAddTo == req[0]) ? 1.0f : 0.0f,
+                                workspace);
     } else {
-      mshadow::BatchGEMM<false, false>(out, mlhs, mrhs, 1.0f,
-                                     (kAddTo == req[0]) ? 1.0f : 0.0f,
-                                     workspace);
+      BatchDotGEMM<false, false>(s, out, mlhs, mrhs, param.alpha,
+                                 (kAddTo == req[0]) ? 1.0f : 0.0f,
+                                 workspace);
     }
   }
 }
@@ -583,7 +783,7 @@ void BatchDotBackward_(const nnvm::NodeAttrs& attrs,
                        const std::vector<TBlob>& outputs) {
   using namespace mshadow::expr;
   mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
-  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  const BatchDotParam& param = nnvm::get<BatchDotParam>(attrs.parsed);
   CHECK_NE(req[1], kWriteInplace);
   CHECK_NE(req[0], kWriteInplace);
 
@@ -602,56 +802,56 @@ void BatchDotBackward_(const nnvm::NodeAttrs& attrs,
     // dy = dot(x, dz).T = dot(dz.T, x.T)
     // dx = dot(dz, y).T = dot(y.T, dz.T)
     if (kNullOp != req[1]) {
-      mshadow::BatchGEMM<true, true>(mrhs_grad, mout_grad, mlhs_data, 1.0f,
-                                      (kAddTo == req[1]) ? 1.0f : 0.0f,
-                                      rhs_workspace);
+      BatchDotGEMM<true, true>(s, mrhs_grad, mout_grad, mlhs_data, param.alpha,
+                               (kAddTo == req[1]) ? 1.0f : 0.0f,
+                               rhs_workspace);
     }
     if (kNullOp != req[0]) {
-      mshadow::BatchGEMM<true, true>(mlhs_grad, mrhs_data, mout_grad, 1.0f,
-                                      (kAddTo == req[0]) ? 1.0f : 0.0f,
-                                      lhs_workspace);
+      BatchDotGEMM<true, true>(s, mlhs_grad, mrhs_data, mout_grad, param.alpha,
+                               (kAddTo == req[0]) ? 1.0f : 0.0f,
+                               lhs_workspace);
     }
   } else if (!param.transpose_a && param.transpose_b) {
     // Gradient of z = dot(x, y.T)
     // dy = dot(x.T, dz).T = dot(dz.T, x)
     // dx = dot(dz, y)
     if (kNullOp != req[1]) {
-      mshadow::BatchGEMM<true, false>(mrhs_grad, mout_grad, mlhs_data, 1.0f,
-                                      (kAddTo == req[1]) ? 1.0f : 0.0f,
-                                      rhs_workspace);
+      BatchDotGEMM<true, false>(s, mrhs_grad, mout_grad, mlhs_data, param.alpha,
+                                (kAddTo == req[1]) ? 1.0f : 0.0f,
+                                rhs_workspace);
     }
     if (kNullOp != req[0]) {
-      mshadow::BatchGEMM<false, false>(mlhs_grad, mout_grad, mrhs_data, 1.0f,
-                                      (kAddTo == req[0]) ? 1.0f : 0.0f,
-                                      lhs_workspace);
+      BatchDotGEMM<false, false>(s, mlhs_grad, mout_grad, mrhs_data, param.alpha,
+                                 (kAddTo == req[0]) ? 1.0f : 0.0f,
+                                 lhs_workspace);
     }
   } else if (param.transpose_a && !param.transpose_b) {
     // Gradient of z = dot(x.T, y)
     // dy = dot(x, dz)
     // dx = dot(dz, y.T).T = dot(y, dz.T)
     if (kNullOp != req[1]) {
-      mshadow::BatchGEMM<false, false>(mrhs_grad, mlhs_data, mout_grad, 1.0f,
-                                      (kAddTo == req[1]) ? 1.0f : 0.0f,
-                                      rhs_workspace);
+      BatchDotGEMM<false, false>(s, mrhs_grad, mlhs_data, mout_grad, param.alpha,
+                                 (kAddTo == req[1]) ? 1.0f : 0.0f,
+                                 rhs_workspace);
     }
     if (kNullOp != req[0]) {
-      mshadow::BatchGEMM<false, true>(mlhs_grad, mrhs_data, mout_grad, 1.0f,
-                                      (kAddTo == req[0]) ? 1.0f : 0.0f,
-                                      lhs_workspace);
+      BatchDotGEMM<false, true>(s, mlhs_grad, mrhs_data, mout_grad, param.alpha,
+                                (kAddTo == req[0]) ? 1.0f : 0.0f,
+                                lhs_workspace);
     }
   } else {
     // Gradient of z = dot(x, y)
     // dy = dot(x.T, dz)
     // dx = dot(dz, y.T)
     if (kNullOp != req[1]) {
-      mshadow::BatchGEMM<true, false>(mrhs_grad, mlhs_data, mout_grad, 1.0f,
-                                      (kAddTo == req[1]) ? 1.0f : 0.0f,
-                                      rhs_workspace);
+      BatchDotGEMM<true, false>(s, mrhs_grad, mlhs_data, mout_grad, param.alpha,
+                                (kAddTo == req[1]) ? 1.0f : 0.0f,
+                                rhs_workspace);
     }
     if (kNullOp != req[0]) {
-      mshadow::BatchGEMM<false, true>(mlhs_grad, mout_grad, mrhs_data, 1.0f,
-                                      (kAddTo == req[0]) ? 1.0f : 0.0f,
-                                      lhs_workspace);
+      BatchDotGEMM<false, true>(s, mlhs_grad, mout_grad, mrhs_data, param.alpha,
+                                (kAddTo == req[0]) ? 1.0f : 0.0f,
+                                lhs_workspace);
     }
   }
 }
@@ -661,7 +861,7 @@ inline bool BatchDotShape(const nnvm::NodeAttrs& attrs,
                           std::vector<TShape> *out_attrs) {
   CHECK_EQ(in_attrs->size(), 2);
   CHECK_EQ(out_attrs->size(), 1);
-  const DotParam& param = nnvm::get<DotParam>(attrs.parsed);
+  const BatchDotParam& param = nnvm::get<BatchDotParam>(attrs.parsed);
   TShape& lshape = (*in_attrs)[0];
   TShape& rshape = (*in_attrs)[1];
   if (lshape.ndim() == 3 && rshape.ndim() == 3) {
@@ -18,6 +18,7 @@ DMLC_REGISTER_PARAMETER(SliceParam);
 DMLC_REGISTER_PARAMETER(SliceAxisParam);
 DMLC_REGISTER_PARAMETER(FlipParam);
 DMLC_REGISTER_PARAMETER(DotParam);
+DMLC_REGISTER_PARAMETER(BatchDotParam);
 DMLC_REGISTER_PARAMETER(RepeatParam);
 DMLC_REGISTER_PARAMETER(TileParam);
 
@@ -240,7 +241,8 @@ NNVM_REGISTER_OP(dot)
   "over the last (or first if transpose_a is true) axis of lhs "
   "and the first (or last if transpose_b is true) axis of rhs. "
   "Shape of result array will be the rest of lhs and rhs's axes "
-  "concatenated.")
+  "concatenated. On CPU, lhs can be a csr matrix and rhs dense without "
+  "transpose_b; the output of the transposed product is then row sparse.")
 .set_num_inputs(2)
 .set_num_outputs(1)
 .set_attr_parser(ParamParser<DotParam>)
@@ -251,6 +253,8 @@ NNVM_REGISTER_OP(dot)
 .set_attr<nnvm::FInferShape>("FInferShape", DotShape)
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
 .set_attr<FCompute>("FCompute<cpu>", DotForward_<cpu>)
+.set_attr<FInferStorageType>("FInferStorageType", DotInferStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", DotForwardEx<cpu>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{"_backward_dot"})
 .add_argument("lhs", "NDArray", "Left input")
 .add_argument("rhs", "NDArray", "Right input")
@@ -262,6 +266,8 @@ NNVM_REGISTER_OP(_backward_dot)
 .set_attr_parser(ParamParser<DotParam>)
 .set_attr<nnvm::TIsBackward>("TIsBackward", true)
 .set_attr<FCompute>("FCompute<cpu>", DotBackward_<cpu>)
+.set_attr<FInferStorageType>("FInferStorageType", DotBackwardInferStorageType)
+.set_attr<FComputeEx>("FComputeEx<cpu>", DotBackwardEx<cpu>)
 .add_arguments(DotParam::__FIELDS__());
 
 NNVM_REGISTER_OP(batch_dot)
@@ -269,7 +275,7 @@ NNVM_REGISTER_OP(batch_dot)
                 " (batch, M, K) X (batch, K, N) --> (batch, M, N).")
 .set_num_inputs(2)
 .set_num_outputs(1)
-.set_attr_parser(ParamParser<DotParam>)
+.set_attr_parser(ParamParser<BatchDotParam>)
 .set_attr<nnvm::FListInputNames>("FListInputNames",
   [](const NodeAttrs& attrs) {
     return std::vector<std::string>{"lhs", "rhs"};
@@ -284,12 +290,12 @@ NNVM_REGISTER_OP(batch_dot)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseIn{"_backward_batch_dot"})
 .add_argument("lhs", "NDArray", "Left input")
 .add_argument("rhs", "NDArray", "Right input")
-.add_arguments(DotParam::__FIELDS__());
+.add_arguments(BatchDotParam::__FIELDS__());
 
 NNVM_REGISTER_OP(_backward_batch_dot)
 .set_num_inputs(3)
 .set_num_outputs(2)
-.set_attr_parser(ParamParser<DotParam>)
+.set_attr_parser(ParamParser<BatchDotParam>)
 .set_attr<FResourceRequest>("FResourceRequest",
   [](const NodeAttrs& attrs) {
     return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
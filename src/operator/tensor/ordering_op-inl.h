@@ -7,8 +7,11 @@
 #define MXNET_OPERATOR_TENSOR_ORDERING_OP_INL_H_
 
 #include <mxnet/operator_util.h>
+#include <dmlc/omp.h>
 #include <dmlc/optional.h>
 #include <mshadow/tensor.h>
+#include <algorithm>
+#include <utility>
 #include <vector>
 #include <type_traits>
 #include "../mshadow_op.h"
@@ -274,6 +277,159 @@ void TopKImpl(RunContext ctx,
   }
 }
 
+/*! \brief a candidate of top k, its value and its index along the axis */
+typedef std::pair<real_t, int> TopKCandidate;
+
+/*!
+ * \brief whether a comes before b in the result. Equal values keep the order
+ *  of their indices, like the stable sort of the other devices, and NaN is
+ *  larger than any number.
+ */
+struct TopKBefore {
+  bool is_ascend;
+  inline bool operator()(const TopKCandidate& a, const TopKCandidate& b) const {
+    const bool a_nan = a.first != a.first, b_nan = b.first != b.first;
+    if (a_nan || b_nan) {
+      if (a_nan && b_nan) return a.second < b.second;
+      return is_ascend ? b_nan : a_nan;
+    }
+    if (a.first != b.first) return is_ascend ? a.first < b.first : a.first > b.first;
+    return a.second < b.second;
+  }
+};
+
+/*! \brief a single row at least this long is split between threads */
+const int kTopKSplitRow = 1 << 16;
+
+/*!
+ * \brief the first k of the elements begin to end of a row in the order of
+ *  before, sorted. The row has a stride of stride. Small k keep the best
+ *  elements seen so far in a heap, so most elements only cost a comparison
+ *  with its top, larger k select with nth_element.
+ */
+inline void TopKSelect(const real_t* row, index_t stride, int begin, int end, int k,
+                       const TopKBefore& before, std::vector<TopKCandidate>* top) {
+  const int n = end - begin;
+  k = std::min(k, n);
+  top->clear();
+  if (static_cast<int64_t>(k) * 16 <= n) {
+    top->reserve(k);
+    for (int j = begin; j < begin + k; ++j) {
+      top->emplace_back(row[static_cast<size_t>(j) * stride], j);
+    }
+    // the top of the heap is the last of the k best
+    std::make_heap(top->begin(), top->end(), before);
+    for (int j = begin + k; j < end; ++j) {
+      const TopKCandidate c(row[static_cast<size_t>(j) * stride], j);
+      if (before(c, top->front())) {
+        std::pop_heap(top->begin(), top->end(), before);
+        top->back() = c;
+        std::push_heap(top->begin(), top->end(), before);
+      }
+    }
+    std::sort_heap(top->begin(), top->end(), before);
+  } else {
+    top->reserve(n);
+    for (int j = begin; j < end; ++j) {
+      top->emplace_back(row[static_cast<size_t>(j) * stride], j);
+    }
+    if (k < n) {
+      std::nth_element(top->begin(), top->begin() + k, top->end(), before);
+      top->resize(k);
+    }
+    std::sort(top->begin(), top->end(), before);
+  }
+}
+
+/*!
+ * \brief TopK on CPU. Every row selects its k first elements and only sorts
+ *  those. Rows are processed in parallel, and a long row is split between
+ *  the threads when there are fewer rows than threads, the k first of every
+ *  part being merged at the end.
+ */
+template<>
+inline void TopKImpl<cpu>(RunContext ctx,
+                          Resource resource,
+                          const TBlob& src,
+                          const std::vector<TBlob>& ret,
+                          const TopKParam& param) {
+  for (auto ret_ele : ret) {
+    CHECK_EQ(ret_ele.type_flag_, src.type_flag_);
+  }
+  int batch_size, element_num;
+  int axis = 0;
+  bool do_transpose = false;
+  bool is_ascend = false;
+  int k = 0;
+  TShape target_shape;
+  ParseTopKParam(src.shape_, param,
+                 &target_shape, &batch_size, &element_num, &axis, &k, &do_transpose, &is_ascend);
+  // row r = o * inner + i holds the elements o * n * inner + j * inner + i
+  const index_t inner = static_cast<bool>(param.axis) ? src.shape_.FlatTo3D(axis)[2] : 1;
+  const int n = element_num;
+  const real_t* dat = src.dptr<real_t>();
+  const TopKBefore before{is_ascend};
+  const bool mask = param.ret_typ == topk_enum::kReturnMask;
+  real_t* values = nullptr;
+  real_t* indices = nullptr;
+  if (mask) {
+    std::fill(ret[0].dptr<real_t>(), ret[0].dptr<real_t>() + ret[0].Size(), real_t(0));
+  } else if (param.ret_typ == topk_enum::kReturnIndices) {
+    indices = ret[0].dptr<real_t>();
+  } else {
+    values = ret[0].dptr<real_t>();
+    if (param.ret_typ == topk_enum::kReturnBoth) indices = ret[1].dptr<real_t>();
+  }
+  auto row_of = [&](int r) {
+    return dat + static_cast<size_t>(r / inner) * n * inner + r % inner;
+  };
+  auto write = [&](int r, const std::vector<TopKCandidate>& top) {
+    const size_t o = r / inner, i = r % inner;
+    if (mask) {
+      real_t* m = ret[0].dptr<real_t>() + o * n * inner + i;
+      for (const TopKCandidate& c : top) m[static_cast<size_t>(c.second) * inner] = 1;
+      return;
+    }
+    const size_t base = o * k * inner + i;
+    for (int j = 0; j < k; ++j) {
+      if (values != nullptr) values[base + j * inner] = top[j].first;
+      if (indices != nullptr) indices[base + j * inner] = static_cast<real_t>(top[j].second);
+    }
+  };
+
+  const int nthreads = omp_get_max_threads();
+  if (batch_size >= nthreads || n < kTopKSplitRow) {
+    #pragma omp parallel
+    {
+      std::vector<TopKCandidate> top;
+      #pragma omp for
+      for (int r = 0; r < batch_size; ++r) {
+        TopKSelect(row_of(r), inner, 0, n, k, before, &top);
+        write(r, top);
+      }
+    }
+    return;
+  }
+  std::vector<std::vector<TopKCandidate> > parts(nthreads);
+  std::vector<TopKCandidate> top;
+  for (int r = 0; r < batch_size; ++r) {
+    const real_t* row = row_of(r);
+    #pragma omp parallel for
+    for (int t = 0; t < nthreads; ++t) {
+      const int begin = static_cast<int>(static_cast<int64_t>(n) * t / nthreads);
+      const int end = static_cast<int>(static_cast<int64_t>(n) * (t + 1) / nthreads);
+      TopKSelect(row, inner, begin, end, k, before, &parts[t]);
+    }
+    // the k first of the row are among the k first of the parts
+    top.clear();
+    for (const auto& part : parts) top.insert(top.end(), part.begin(), part.end());
+    std::nth_element(top.begin(), top.begin() + (k - 1), top.end(), before);
+    top.resize(k);
+    std::sort(top.begin(), top.end(), before);
+    write(r, top);
+  }
+}
+
 template<typename xpu>
 void TopK(const nnvm::NodeAttrs& attrs,
           const OpContext& ctx,
@@ -0,0 +1,168 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file transpose_cpu.cc
+ * \brief Cache blocked transpose of contiguous arrays on CPU.
+ */
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "./transpose_cpu.h"
+
+namespace mxnet {
+namespace op {
+namespace {
+
+/*!
+ * \brief the permutation after dropping the axes of size 1 and merging the
+ *  runs of axes that stay in order, as the sizes of the axes of dst and the
+ *  stride in src of each of them
+ */
+struct TransposePlan {
+  std::vector<size_t> size, stride;
+  size_t total;
+};
+
+TransposePlan MakePlan(const TShape& shape, const TShape& axes) {
+  const index_t ndim = shape.ndim();
+  CHECK_EQ(axes.ndim(), ndim) << "transpose: axes must have as many dims as the array";
+  std::vector<bool> seen(ndim, false);
+  for (index_t i = 0; i < ndim; ++i) {
+    CHECK_LT(axes[i], ndim) << "transpose: axis " << axes[i] << " out of range";
+    CHECK(!seen[axes[i]]) << "transpose: axis " << axes[i] << " is repeated";
+    seen[axes[i]] = true;
+  }
+  std::vector<size_t> src_stride(ndim);
+  size_t stride = 1;
+  for (index_t i = ndim; i-- > 0;) {
+    src_stride[i] = stride;
+    stride *= shape[i];
+  }
+  TransposePlan plan;
+  plan.total = stride;
+  index_t last = ndim;  // the src axis of the innermost kept axis of dst so far
+  for (index_t i = 0; i < ndim; ++i) {
+    const index_t a = axes[i];
+    if (shape[a] == 1) continue;
+    // a continues the run of last when the axes between them have size 1
+    bool follows = last != ndim && a > last;
+    for (index_t k = last + 1; follows && k < a; ++k) follows = shape[k] == 1;
+    if (follows) {
+      plan.size.back() *= shape[a];
+      plan.stride.back() = src_stride[a];
+    } else {
+      plan.size.push_back(shape[a]);
+      plan.stride.push_back(src_stride[a]);
+    }
+    last = a;
+  }
+  return plan;
+}
+
+// copy contiguous rows of the last axis of dst
+template<typename DType>
+void TransposeRows(const DType* src, DType* dst, const TransposePlan& plan) {
+  const int ndim = static_cast<int>(plan.size.size());
+  const size_t len = plan.size[ndim - 1];
+  const int64_t nrows = static_cast<int64_t>(plan.total / len);
+  #pragma omp parallel for if (nrows > 1 && plan.total >= 4096)
+  for (int64_t r = 0; r < nrows; ++r) {
+    size_t rest = r, offset = 0;
+    for (int d = ndim - 2; d >= 0; --d) {
+      offset += rest % plan.size[d] * plan.stride[d];
+      rest /= plan.size[d];
+    }
+    std::memcpy(dst + r * len, src + offset, len * sizeof(DType));
+  }
+}
+
+/*!
+ * \brief transpose through square tiles of the axis contiguous in src, a,
+ *  and the innermost axis of dst, b, which are both in L1
+ */
+template<typename DType>
+void TransposeTiles(const DType* src, DType* dst, const TransposePlan& plan) {
+  const int kTile = sizeof(DType) >= 4 ? 32 : 64;
+  const int ndim = static_cast<int>(plan.size.size());
+  const int b = ndim - 1;
+  int a = 0;
+  while (plan.stride[a] != 1) ++a;
+  std::vector<size_t> dst_stride(ndim);
+  size_t stride = 1;
+  for (int d = ndim; d-- > 0;) {
+    dst_stride[d] = stride;
+    stride *= plan.size[d];
+  }
+  const size_t na = plan.size[a], nb = plan.size[b];
+  const size_t src_b = plan.stride[b], dst_a = dst_stride[a];
+  const size_t tiles_a = (na + kTile - 1) / kTile, tiles_b = (nb + kTile - 1) / kTile;
+  const int64_t ntask = static_cast<int64_t>(plan.total / (na * nb) * tiles_a * tiles_b);
+  #pragma omp parallel for if (ntask > 1 && plan.total >= 4096)
+  for (int64_t t = 0; t < ntask; ++t) {
+    const size_t tb = t % tiles_b, ta = t / tiles_b % tiles_a;
+    size_t rest = t / tiles_b / tiles_a, src_offset = 0, dst_offset = 0;
+    for (int d = ndim - 1; d >= 0; --d) {
+      if (d == a || d == b) continue;
+      const size_t i = rest % plan.size[d];
+      rest /= plan.size[d];
+      src_offset += i * plan.stride[d];
+      dst_offset += i * dst_stride[d];
+    }
+    const size_t a0 = ta * kTile, b0 = tb * kTile;
+    const DType* s = src + src_offset + a0 + b0 * src_b;
+    DType* o = dst + dst_offset + a0 * dst_a + b0;
+    if (a0 + kTile <= na && b0 + kTile <= nb) {
+      // constant bounds for full tiles, so that the compiler unrolls them
+      for (int i = 0; i < kTile; ++i) {
+        for (int j = 0; j < kTile; ++j) o[i * dst_a + j] = s[i + j * src_b];
+      }
+    } else {
+      const size_t ma = std::min<size_t>(kTile, na - a0), mb = std::min<size_t>(kTile, nb - b0);
+      for (size_t i = 0; i < ma; ++i) {
+        for (size_t j = 0; j < mb; ++j) o[i * dst_a + j] = s[i + j * src_b];
+      }
+    }
+  }
+}
+
+template<typename DType>
+void Transpose(const void* src, void* dst, const TShape& shape, const TShape& axes) {
+  const TransposePlan plan = MakePlan(shape, axes);
+  const DType* in = static_cast<const DType*>(src);
+  DType* out = static_cast<DType*>(dst);
+  if (plan.total == 0) return;
+  if (plan.size.empty()) {
+    out[0] = in[0];
+  } else if (plan.stride.back() == 1) {
+    TransposeRows(in, out, plan);
+  } else {
+    TransposeTiles(in, out, plan);
+  }
+}
+
+}  // namespace
+
+void TransposeCPU(const void* src, void* dst, const TShape& shape, const TShape& axes,
+                  size_t type_size) {
+  switch (type_size) {
+   case 1:
+    Transpose<uint8_t>(src, dst, shape, axes);
+    break;
+   case 2:
+    Transpose<uint16_t>(src, dst, shape, axes);
+    break;
+   case 4:
+    Transpose<uint32_t>(src, dst, shape, axes);
+    break;
+   case 8:
+    Transpose<uint64_t>(src, dst, shape, axes);
+    break;
+   default:
+    LOG(FATAL) << "transpose: elements of " << type_size << " bytes are not supported";
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
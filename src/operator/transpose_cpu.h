@@ -0,0 +1,53 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file transpose_cpu.h
+ * \brief Cache blocked transpose of contiguous arrays on CPU, shared by
+ *  transpose, SwapAxis and the layout conversions.
+ */
+#ifndef MXNET_OPERATOR_TRANSPOSE_CPU_H_
+#define MXNET_OPERATOR_TRANSPOSE_CPU_H_
+
+#include <mxnet/base.h>
+#include <mxnet/tensor_blob.h>
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief dst = src with its axes permuted, axis i of dst is axis axes[i] of
+ *  src, on CPU. Both arrays are contiguous, shape is the shape of src and
+ *  the elements are type_size bytes of 1, 2, 4 or 8. Axes of size 1 are
+ *  dropped and adjacent axes that stay in order are merged first. When the
+ *  innermost axis moves the copy goes through square tiles that fit in the
+ *  L1 cache, in parallel over the tiles, otherwise contiguous rows are
+ *  copied in parallel.
+ */
+void TransposeCPU(const void* src, void* dst, const TShape& shape, const TShape& axes,
+                  size_t type_size);
+
+/*!
+ * \brief dst = src with its axes permuted, with TransposeCPU on CPU. Returns
+ *  false, doing nothing, on other devices or for arrays that are not contiguous.
+ */
+template<typename xpu>
+inline bool TransposeBlob(mshadow::Stream<xpu> *s, const TBlob& src, const TBlob& dst,
+                          const TShape& axes) {
+  return false;
+}
+
+inline bool TransposeBlob(mshadow::Stream<cpu> *s, const TBlob& src, const TBlob& dst,
+                          const TShape& axes) {
+  CHECK_EQ(src.type_flag_, dst.type_flag_);
+  CHECK_EQ(src.shape_.Size(), dst.shape_.Size());
+  if (!src.CheckContiguous() || !dst.CheckContiguous()) return false;
+  size_t type_size = 0;
+  MSHADOW_TYPE_SWITCH(src.type_flag_, DType, {
+    type_size = sizeof(DType);
+  });
+  TransposeCPU(src.dptr_, dst.dptr_, src.shape_, axes, type_size);
+  return true;
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_TRANSPOSE_CPU_H_
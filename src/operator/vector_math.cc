@@ -0,0 +1,43 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file vector_math.cc
+ * \brief Array functions of vector_math.h, one clone per instruction set.
+ */
+#include <dmlc/parameter.h>
+#include "./vector_math.h"
+
+// gcc resolves the clones with an ifunc when the library is loaded
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 && \
+    defined(__x86_64__) && defined(__linux__)
+#define MXNET_VMATH_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define MXNET_VMATH_CLONES
+#endif
+
+#define MXNET_VMATH_ARRAY_FUNC(Name)                                  \
+  MXNET_VMATH_CLONES                                                  \
+  void Name(index_t n, const float* x, float* y, bool add) {          \
+    if (add) {                                                        \
+      for (index_t i = 0; i < n; ++i) y[i] += Name(x[i]);             \
+    } else {                                                          \
+      for (index_t i = 0; i < n; ++i) y[i] = Name(x[i]);              \
+    }                                                                 \
+  }
+
+namespace mxnet {
+namespace op {
+namespace vmath {
+bool Enabled() {
+  static const bool enabled = dmlc::GetEnv("MXNET_CPU_VECTOR_MATH", true);
+  return enabled;
+}
+
+MXNET_VMATH_ARRAY_FUNC(Exp)
+MXNET_VMATH_ARRAY_FUNC(Log)
+MXNET_VMATH_ARRAY_FUNC(Tanh)
+MXNET_VMATH_ARRAY_FUNC(Sigmoid)
+MXNET_VMATH_ARRAY_FUNC(Softrelu)
+}  // namespace vmath
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,214 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file vector_math.h
+ * \brief Vectorizable single precision exp, log, tanh, sigmoid and softrelu
+ *  for CPU.
+ *
+ *  The scalar functions are branch free polynomial approximations, with the
+ *  argument reductions of Cephes, so that loops calling them vectorize. Their
+ *  error is within 2 ulp of the correctly rounded result for exp, log and
+ *  tanh, and within 3 ulp for sigmoid and softrelu. Infinities, NaN and
+ *  denormals are handled like libm does. The array functions are compiled for
+ *  AVX-512, AVX2 and the baseline instruction set, and the widest one the CPU
+ *  supports is picked at load time.
+ */
+#ifndef MXNET_OPERATOR_VECTOR_MATH_H_
+#define MXNET_OPERATOR_VECTOR_MATH_H_
+
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include "./mshadow_op.h"
+
+namespace mxnet {
+namespace op {
+namespace vmath {
+
+// the clones of the array functions for every instruction set must inline them
+#ifdef __GNUC__
+#define MXNET_VMATH_INLINE inline __attribute__((always_inline))
+#else
+#define MXNET_VMATH_INLINE inline
+#endif
+
+MXNET_VMATH_INLINE float AsFloat(int32_t i) {
+  float f;
+  std::memcpy(&f, &i, sizeof(f));
+  return f;
+}
+
+MXNET_VMATH_INLINE int32_t AsInt(float f) {
+  int32_t i;
+  std::memcpy(&i, &f, sizeof(i));
+  return i;
+}
+
+/*!
+ * \brief c ? a : b with bit masks. Both sides are computed anyway, the
+ *  compiler would not if-convert a select on arithmetic that may trap.
+ */
+MXNET_VMATH_INLINE float Select(bool c, float a, float b) {
+  const int32_t mask = -static_cast<int32_t>(c);
+  return AsFloat((AsInt(a) & mask) | (AsInt(b) & ~mask));
+}
+
+/*! \brief e^x */
+MXNET_VMATH_INLINE float Exp(float x) {
+  // ln(FLT_MAX) and ln of the smallest denormal
+  const float kMax = 88.7228393f, kMin = -103.972084f;
+  // NaN is replaced first, so that n below always converts to an int
+  float t = Select(x != x, 0.0f, x);
+  t = Select(t > kMax, kMax, t);
+  t = Select(t < kMin, kMin, t);
+  // x = n ln2 + r with |r| <= ln2 / 2, n rounded with the 1.5 * 2^23 trick
+  const float n = (t * 1.44269504f + 12582912.0f) - 12582912.0f;
+  const float r = t - n * 0.693359375f + n * 2.12194440e-4f;
+  float p = 1.9875691500e-4f;
+  p = p * r + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  p = p * r * r + r + 1.0f;
+  // 2^n in two factors, so that neither overflows nor is denormal
+  const int32_t i = static_cast<int32_t>(n);
+  const int32_t i1 = i >> 1, i2 = i - i1;
+  float y = p * AsFloat((i1 + 127) << 23) * AsFloat((i2 + 127) << 23);
+  y = Select(x > kMax, std::numeric_limits<float>::infinity(), y);
+  y = Select(x < kMin, 0.0f, y);
+  return Select(x != x, x, y);
+}
+
+/*! \brief natural logarithm */
+MXNET_VMATH_INLINE float Log(float x) {
+  // denormals are scaled by 2^23 first
+  const bool tiny = x < std::numeric_limits<float>::min();
+  const int32_t bits = AsInt(Select(tiny, x * 8388608.0f, x));
+  // x = m 2^e with m in [0.5, 1), then m in [sqrt(0.5), sqrt(2))
+  float e = static_cast<float>(((bits >> 23) & 0xff) - 126) - Select(tiny, 23.0f, 0.0f);
+  const float m = AsFloat((bits & 0x007fffff) | 0x3f000000);
+  const bool low = m < 0.707106781f;
+  e = Select(low, e - 1.0f, e);
+  const float f = Select(low, m + m - 1.0f, m - 1.0f);
+  const float z = f * f;
+  float p = 7.0376836292e-2f;
+  p = p * f - 1.1514610310e-1f;
+  p = p * f + 1.1676998740e-1f;
+  p = p * f - 1.2420140846e-1f;
+  p = p * f + 1.4249322787e-1f;
+  p = p * f - 1.6668057665e-1f;
+  p = p * f + 2.0000714765e-1f;
+  p = p * f - 2.4999993993e-1f;
+  p = p * f + 3.3333331174e-1f;
+  float y = p * f * z - e * 2.12194440e-4f - 0.5f * z;
+  y = f + y + e * 0.693359375f;
+  y = Select(x == std::numeric_limits<float>::infinity(), x, y);
+  y = Select(x == 0.0f, -std::numeric_limits<float>::infinity(), y);
+  y = Select(x < 0.0f, std::numeric_limits<float>::quiet_NaN(), y);
+  return Select(x != x, x, y);
+}
+
+/*! \brief hyperbolic tangent */
+MXNET_VMATH_INLINE float Tanh(float x) {
+  const float a = std::abs(x);
+  // odd polynomial near 0, where 1 - 2 / (e^2x + 1) cancels
+  const float z = x * x;
+  float p = -5.70498872745e-3f;
+  p = p * z + 2.06390887954e-2f;
+  p = p * z - 5.37397155531e-2f;
+  p = p * z + 1.33314422036e-1f;
+  p = p * z - 3.33332819422e-1f;
+  p = p * z * x + x;
+  float q = 1.0f - 2.0f / (Exp(2.0f * a) + 1.0f);
+  q = Select(x < 0.0f, -q, q);
+  return Select(a < 0.625f, p, q);
+}
+
+/*! \brief 1 / (1 + e^-x), as e^x / (1 + e^x) for negative x so that it does not underflow early */
+MXNET_VMATH_INLINE float Sigmoid(float x) {
+  const float t = Exp(-std::abs(x));
+  const float s = 1.0f / (1.0f + t);
+  return Select(x < 0.0f, t * s, s);
+}
+
+/*! \brief log(1 + e^x), as max(x, 0) + log1p(e^-|x|) */
+MXNET_VMATH_INLINE float Softrelu(float x) {
+  const float t = Exp(-std::abs(x));
+  const float u = 1.0f + t;
+  // log1p(t) = log(u) t / (u - 1) corrects the rounding of u
+  const float l = Select(u == 1.0f, t, Log(u) * t / (u - 1.0f));
+  return Select(x > 0.0f, x, 0.0f) + l;
+}
+
+/*!
+ * \brief y = f(x), or y += f(x) if add, over n elements. x and y may be the
+ *  same array. These do not start threads.
+ */
+void Exp(index_t n, const float* x, float* y, bool add = false);
+void Log(index_t n, const float* x, float* y, bool add = false);
+void Tanh(index_t n, const float* x, float* y, bool add = false);
+void Sigmoid(index_t n, const float* x, float* y, bool add = false);
+void Softrelu(index_t n, const float* x, float* y, bool add = false);
+
+/*! \brief whether the array functions are used by operators, MXNET_CPU_VECTOR_MATH */
+bool Enabled();
+
+/*! \brief the array function of a mshadow_op functor, nullptr if there is none */
+typedef void (*ArrayFunc)(index_t, const float*, float*, bool);
+template<typename OP>
+inline ArrayFunc GetArrayFunc() { return nullptr; }
+template<>
+inline ArrayFunc GetArrayFunc<mshadow_op::exp>() { return Exp; }
+template<>
+inline ArrayFunc GetArrayFunc<mshadow_op::log>() { return Log; }
+template<>
+inline ArrayFunc GetArrayFunc<mshadow_op::tanh>() { return Tanh; }
+template<>
+inline ArrayFunc GetArrayFunc<mshadow_op::sigmoid>() { return Sigmoid; }
+template<>
+inline ArrayFunc GetArrayFunc<mshadow_op::softrelu>() { return Softrelu; }
+
+/*! \brief elements per call of an array function in VectorMap */
+const index_t kVectorBlock = 4096;
+}  // namespace vmath
+
+/*!
+ * \brief out = OP(in) according to req, with the vectorized array function
+ *  of OP on CPU. Returns false, doing nothing, where there is none.
+ */
+template<typename OP, typename xpu>
+inline bool VectorMap(mshadow::Stream<xpu> *s, const TBlob& in,
+                      OpReqType req, const TBlob& out) {
+  return false;
+}
+
+template<typename OP>
+inline bool VectorMap(mshadow::Stream<cpu> *s, const TBlob& in,
+                      OpReqType req, const TBlob& out) {
+  const vmath::ArrayFunc f = vmath::GetArrayFunc<OP>();
+  if (f == nullptr || !vmath::Enabled() || in.type_flag_ != mshadow::kFloat32 ||
+      out.type_flag_ != mshadow::kFloat32 ||
+      !in.CheckContiguous() || !out.CheckContiguous()) {
+    return false;
+  }
+  if (req == kNullOp) return true;
+  const float* x = in.dptr<float>();
+  float* y = out.dptr<float>();
+  const index_t n = out.Size();
+  const bool add = req == kAddTo;
+  const int nblock = static_cast<int>((n + vmath::kVectorBlock - 1) / vmath::kVectorBlock);
+  #pragma omp parallel for if (nblock > 1)
+  for (int b = 0; b < nblock; ++b) {
+    const index_t begin = b * vmath::kVectorBlock;
+    f(std::min(vmath::kVectorBlock, n - begin), x + begin, y + begin, add);
+  }
+  return true;
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_VECTOR_MATH_H_
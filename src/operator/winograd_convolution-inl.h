@@ -0,0 +1,233 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file winograd_convolution-inl.h
+ * \brief Winograd F(2x2,3x3) and F(4x4,3x3) convolution on CPU
+*/
+#ifndef MXNET_OPERATOR_WINOGRAD_CONVOLUTION_INL_H_
+#define MXNET_OPERATOR_WINOGRAD_CONVOLUTION_INL_H_
+
+#include <dmlc/logging.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <vector>
+#include "./convolution-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace winograd {
+// B^T, G and A^T of F(2x2,3x3)
+const float kBT2[4 * 4] = {
+  1,  0, -1,  0,
+  0,  1,  1,  0,
+  0, -1,  1,  0,
+  0,  1,  0, -1};
+const float kG2[4 * 3] = {
+  1,     0,    0,
+  0.5,  0.5, 0.5,
+  0.5, -0.5, 0.5,
+  0,     0,    1};
+const float kAT2[2 * 4] = {
+  1, 1,  1,  0,
+  0, 1, -1, -1};
+// B^T, G and A^T of F(4x4,3x3)
+const float kBT4[6 * 6] = {
+  4,  0, -5,  0, 1, 0,
+  0, -4, -4,  1, 1, 0,
+  0,  4, -4, -1, 1, 0,
+  0, -2, -1,  2, 1, 0,
+  0,  2, -1, -2, 1, 0,
+  0,  4,  0, -5, 0, 1};
+const float kG4[6 * 3] = {
+  1.0f / 4,         0,         0,
+  -1.0f / 6, -1.0f / 6, -1.0f / 6,
+  -1.0f / 6,  1.0f / 6, -1.0f / 6,
+  1.0f / 24, 1.0f / 12,  1.0f / 6,
+  1.0f / 24, -1.0f / 12, 1.0f / 6,
+  0,                 0,         1};
+const float kAT4[4 * 6] = {
+  1, 1,  1, 1,  1, 0,
+  0, 1, -1, 2, -2, 0,
+  0, 1,  1, 4,  4, 0,
+  0, 1, -1, 8, -8, 1};
+/*! \brief number of tiles transformed and multiplied together */
+const int kTileBlock = 256;
+}  // namespace winograd
+
+/*!
+ * \brief out = L * in * L^T, where L is rows x cols and in is cols x cols
+ *  with a row stride of ldin
+ */
+template<typename DType>
+inline void WinogradSandwich(const float* L, int rows, int cols,
+                             const DType* in, int ldin, DType* out) {
+  DType tmp[6 * 6];
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      DType sum = 0;
+      for (int k = 0; k < cols; ++k) sum += L[i * cols + k] * in[k * ldin + j];
+      tmp[i * cols + j] = sum;
+    }
+  }
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < rows; ++j) {
+      DType sum = 0;
+      for (int k = 0; k < cols; ++k) sum += tmp[i * cols + k] * L[j * cols + k];
+      out[i * rows + j] = sum;
+    }
+  }
+}
+
+/*! \brief whether the Winograd path applies to a convolution */
+inline bool WinogradConvolutionSupported(const ConvolutionParam& param,
+                                         const std::vector<TShape>& in_shape) {
+  return param.kernel.ndim() == 2 && param.kernel[0] == 3 && param.kernel[1] == 3 &&
+      param.stride[0] == 1 && param.stride[1] == 1 &&
+      param.dilate[0] == 1 && param.dilate[1] == 1 &&
+      param.num_group == 1 && param.layout.value() == mshadow::kNCHW &&
+      in_shape[conv::kData].ndim() == 4;
+}
+
+/*! \brief output tile size: F(4x4,3x3) unless the output is too small to fill its tiles */
+inline int WinogradTileSize(const TShape& oshape) {
+  return oshape[2] >= 8 && oshape[3] >= 8 ? 4 : 2;
+}
+
+/*!
+ * \brief 3x3 stride 1 convolution with the Winograd minimal filtering
+ *  algorithm. The input is split in overlapping tiles that are transformed,
+ *  multiplied with the transformed weights in one GEMM per point of the
+ *  transformed tile, and transformed back. The transformed weights are kept
+ *  until the weights change. Backward uses im2col.
+ */
+template<typename DType>
+class WinogradConvolutionOp : public ConvolutionOp<cpu, DType> {
+ public:
+  WinogradConvolutionOp(ConvolutionParam p, int tile)
+      : ConvolutionOp<cpu, DType>(p), param_(p), m_(tile), alpha_(tile + 2) {
+    CHECK(m_ == 2 || m_ == 4) << "Winograd convolution supports output tiles of 2 or 4";
+    // convert MBytes first to Bytes and then to elements.
+    param_.workspace = (param_.workspace << 20) / sizeof(DType);
+  }
+
+  virtual void Forward(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data,
+                       const std::vector<TBlob> &aux_args) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    CHECK_EQ(req[conv::kOut], kWriteTo);
+    CHECK_EQ(in_data.size(), param_.no_bias ? 2U : 3U);
+    CHECK_EQ(out_data.size(), 1U);
+    Stream<cpu> *s = ctx.get_stream<cpu>();
+    Tensor<cpu, 4, DType> data = in_data[conv::kData].get<cpu, 4, DType>(s);
+    Tensor<cpu, 4, DType> out = out_data[conv::kOut].get<cpu, 4, DType>(s);
+    CHECK_EQ(in_data[conv::kWeight].CheckContiguous(), true);
+    const int C = data.size(1), H = data.size(2), W = data.size(3);
+    const int K = out.size(1), OH = out.size(2), OW = out.size(3);
+    const int m = m_, alpha = alpha_, aa = alpha * alpha;
+    const size_t version = ctx.in_versions.size() == in_data.size() ?
+        ctx.in_versions[conv::kWeight] : 0;
+    this->TransformWeight(in_data[conv::kWeight].dptr<DType>(), version, K, C);
+    const DType* bias = param_.no_bias ? nullptr : in_data[conv::kBias].dptr<DType>();
+
+    const int tiles_h = (OH + m - 1) / m, tiles_w = (OW + m - 1) / m;
+    const int tiles_per_image = tiles_h * tiles_w;
+    const int num_tiles = data.size(0) * tiles_per_image;
+    // param_.workspace is in elements of sizeof(DType)
+    const size_t max_block = param_.workspace / (static_cast<size_t>(aa) * (C + K));
+    const int block = static_cast<int>(std::max<size_t>(1, std::min<size_t>(
+        {static_cast<size_t>(winograd::kTileBlock), static_cast<size_t>(num_tiles), max_block})));
+    Tensor<cpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
+        .get_space_typed<cpu, 1, DType>(Shape1(aa * (C + K) * block), s);
+    const float* BT = m == 2 ? winograd::kBT2 : winograd::kBT4;
+    const float* AT = m == 2 ? winograd::kAT2 : winograd::kAT4;
+    const int pad_y = param_.pad[0], pad_x = param_.pad[1];
+
+    for (int p0 = 0; p0 < num_tiles; p0 += block) {
+      const int nb = std::min(block, num_tiles - p0);
+      // V[e] is C x nb and M[e] is K x nb for every point e of the transformed tile
+      DType* V = workspace.dptr_;
+      DType* M = V + static_cast<size_t>(aa) * C * nb;
+      #pragma omp parallel for
+      for (int ct = 0; ct < C * nb; ++ct) {
+        const int c = ct / nb, j = ct % nb;
+        const int p = p0 + j;
+        const int n = p / tiles_per_image, t = p % tiles_per_image;
+        const int y0 = (t / tiles_w) * m - pad_y, x0 = (t % tiles_w) * m - pad_x;
+        const DType* img = data.dptr_ + (static_cast<size_t>(n) * C + c) * H * W;
+        DType d[6 * 6], v[6 * 6];
+        for (int y = 0; y < alpha; ++y) {
+          for (int x = 0; x < alpha; ++x) {
+            const int iy = y0 + y, ix = x0 + x;
+            d[y * alpha + x] = iy >= 0 && iy < H && ix >= 0 && ix < W ?
+                img[iy * W + ix] : DType(0);
+          }
+        }
+        WinogradSandwich(BT, alpha, alpha, d, alpha, v);
+        for (int e = 0; e < aa; ++e) {
+          V[(static_cast<size_t>(e) * C + c) * nb + j] = v[e];
+        }
+      }
+      for (int e = 0; e < aa; ++e) {
+        Tensor<cpu, 2, DType> Me(M + static_cast<size_t>(e) * K * nb, Shape2(K, nb), nb, s);
+        Tensor<cpu, 2, DType> Ue(uweight_.data() + static_cast<size_t>(e) * K * C,
+                                 Shape2(K, C), C, s);
+        Tensor<cpu, 2, DType> Ve(V + static_cast<size_t>(e) * C * nb, Shape2(C, nb), nb, s);
+        Me = dot(Ue, Ve);
+      }
+      #pragma omp parallel for
+      for (int kt = 0; kt < K * nb; ++kt) {
+        const int k = kt / nb, j = kt % nb;
+        const int p = p0 + j;
+        const int n = p / tiles_per_image, t = p % tiles_per_image;
+        const int y0 = (t / tiles_w) * m, x0 = (t % tiles_w) * m;
+        DType mt[6 * 6], y[4 * 4];
+        for (int e = 0; e < aa; ++e) {
+          mt[e] = M[(static_cast<size_t>(e) * K + k) * nb + j];
+        }
+        WinogradSandwich(AT, m, alpha, mt, alpha, y);
+        const DType b = bias != nullptr ? bias[k] : DType(0);
+        DType* dst = out.dptr_ + (static_cast<size_t>(n) * K + k) * OH * OW;
+        for (int oy = 0; oy < m && y0 + oy < OH; ++oy) {
+          for (int ox = 0; ox < m && x0 + ox < OW; ++ox) {
+            dst[(y0 + oy) * OW + x0 + ox] = y[oy * m + ox] + b;
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  // computes G g G^T of every filter unless the engine version of the weights
+  // did not change, on every call when the version is not known
+  inline void TransformWeight(const DType* weight, size_t version, int K, int C) {
+    const size_t size = static_cast<size_t>(K) * C * alpha_ * alpha_;
+    if (version != 0 && version == weight_version_ && uweight_.size() == size) return;
+    weight_version_ = version;
+    const int alpha = alpha_, aa = alpha * alpha;
+    const float* G = m_ == 2 ? winograd::kG2 : winograd::kG4;
+    uweight_.resize(static_cast<size_t>(aa) * K * C);
+    #pragma omp parallel for
+    for (int kc = 0; kc < K * C; ++kc) {
+      DType u[6 * 6];
+      WinogradSandwich(G, alpha, 3, weight + static_cast<size_t>(kc) * 9, 3, u);
+      for (int e = 0; e < aa; ++e) {
+        uweight_[static_cast<size_t>(e) * K * C + kc] = u[e];
+      }
+    }
+  }
+
+  ConvolutionParam param_;
+  /*! \brief output tile size and transformed tile size */
+  int m_, alpha_;
+  /*! \brief engine version of the weights the transformed weights come from */
+  size_t weight_version_{0};
+  /*! \brief transformed weights, (alpha * alpha, num_filter, channels) */
+  std::vector<DType> uweight_;
+};  // class WinogradConvolutionOp
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_WINOGRAD_CONVOLUTION_INL_H_
@@ -1,7 +1,24 @@
+import os
+import re
+from contextlib import contextmanager
 import numpy as np
 import mxnet as mx
 
 
+@contextmanager
+def environment(name, value):
+    """Set an environment variable, restoring its previous state on exit"""
+    old = os.environ.get(name)
+    os.environ[name] = value
+    try:
+        yield
+    finally:
+        if old is None:
+            del os.environ[name]
+        else:
+            os.environ[name] = old
+
+
 def reldiff(a, b):
     diff = np.sum(np.abs(a - b))
     norm = np.sum(np.abs(a))
@@ -129,6 +146,321 @@ def test_reshape():
     exe.forward(is_train=False)
     assert np.all(exe.outputs[0].asnumpy() == 4)
 
+def test_fuse_elemwise():
+    data = mx.sym.Variable('data')
+    weight = mx.sym.Variable('weight')
+    x = mx.sym.tanh(data * 2 + weight)
+    y = mx.sym.Activation(x * weight - 0.5, act_type='sigmoid')
+    net = mx.sym.exp(y) / (x + 3)
+    shape = (7, 300)
+    args = {'data': mx.nd.array(np.random.uniform(-1, 1, shape)),
+            'weight': mx.nd.array(np.random.uniform(-1, 1, shape))}
+    head_grad = mx.nd.array(np.random.uniform(-1, 1, shape))
+    results = []
+    for fuse in ['0', '1']:
+        with environment('MXNET_EXEC_FUSE_ELEMWISE', fuse):
+            grads = {k: mx.nd.zeros(shape) for k in args}
+            exe = net.bind(mx.cpu(), args=args, args_grad=grads)
+            exe.forward(is_train=True)
+            exe.backward([head_grad])
+            results.append([exe.outputs[0].asnumpy()] +
+                           [grads[k].asnumpy() for k in sorted(grads)])
+    for a, b in zip(results[0], results[1]):
+        assert reldiff(a, b) < 1e-5
+
+def test_fuse_elemwise_int():
+    # integer division inside a fused group truncates as it does unfused
+    x = mx.sym.Variable('x')
+    y = mx.sym.Variable('y')
+    net = (x / y + 1) * 3 - x
+    args = {'x': mx.nd.array(np.random.randint(-50, 50, (100,)), dtype='int32'),
+            'y': mx.nd.array(np.random.randint(1, 7, (100,)), dtype='int32')}
+    results = []
+    for fuse in ['0', '1']:
+        with environment('MXNET_EXEC_FUSE_ELEMWISE', fuse):
+            exe = net.bind(mx.cpu(), args=args)
+            exe.forward(is_train=False)
+            results.append(exe.outputs[0].asnumpy())
+    assert results[1].dtype == np.int32
+    assert np.array_equal(results[0], results[1])
+
+def test_fuse_batch_dot_scale():
+    # the scale of the attention scores is folded into the batch_dot
+    q = mx.sym.Variable('q')
+    k = mx.sym.Variable('k')
+    v = mx.sym.Variable('v')
+    scores = mx.sym.batch_dot(q, k, transpose_b=True) / 8.0
+    att = mx.sym.tanh(scores)
+    net = mx.sym.batch_dot(att, v) * 0.5
+    shape = (16, 40, 64)
+    args = {name: mx.nd.array(np.random.uniform(-1, 1, shape)) for name in ['q', 'k', 'v']}
+    head_grad = mx.nd.array(np.random.uniform(-1, 1, shape))
+    results = []
+    for fuse in ['0', '1']:
+        with environment('MXNET_EXEC_FUSE_ELEMWISE', fuse):
+            grads = {name: mx.nd.zeros(shape) for name in args}
+            exe = net.bind(mx.cpu(), args=args, args_grad=grads)
+            exe.forward(is_train=True)
+            exe.backward([head_grad])
+            results.append([exe.outputs[0].asnumpy()] +
+                           [grads[name].asnumpy() for name in sorted(grads)])
+            graph = exe.debug_str()
+        if fuse == '1':
+            # both scales are gone, the batch_dots carry them as alpha
+            assert 'alpha=0.125' in graph and 'alpha=0.5' in graph
+            assert 'Op:_div_scalar,' not in graph and 'Op:_mul_scalar,' not in graph
+        else:
+            assert 'alpha=0.125' not in graph and 'Op:_div_scalar,' in graph
+    for a, b in zip(results[0], results[1]):
+        assert reldiff(a, b) < 1e-5
+
+def test_mirror_budget():
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=1024, name='fc1')
+    net = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.FullyConnected(net, num_hidden=1024, name='fc2')
+    net = mx.sym.Activation(net, act_type='tanh')
+    net = mx.sym.FullyConnected(net, num_hidden=10, name='fc3')
+    # about 8MB of activations, so that a 1MB budget forces recomputation
+    shape = (512, 100)
+    arg_shapes, out_shapes, _ = net.infer_shape(data=shape)
+    args = {k: mx.nd.array(np.random.uniform(-1, 1, s))
+            for k, s in zip(net.list_arguments(), arg_shapes)}
+    head_grad = mx.nd.array(np.random.uniform(-1, 1, out_shapes[0]))
+    results = []
+    kept = []
+    for budget in ['0', '64', '1']:
+        with environment('MXNET_BACKWARD_MIRROR_BUDGET_MB', budget):
+            grads = {k: mx.nd.zeros(v.shape) for k, v in args.items()}
+            exe = net.bind(mx.cpu(), args=args, args_grad=grads)
+            exe.forward(is_train=True)
+            exe.backward([head_grad])
+            results.append([grads[k].asnumpy() for k in sorted(grads)])
+        debug = exe.debug_str()
+        match = re.search(r'Total (\d+) MB of activations kept for backward', debug)
+        kept.append((int(match.group(1)) if match else None, '_mirror' in debug))
+    # 64MB holds every activation, 1MB needs the chains of both layers mirrored
+    assert kept[0] == (None, False)
+    assert kept[1][0] >= 4 and not kept[1][1]
+    assert kept[2][0] <= 1 and kept[2][1]
+    for res in results[1:]:
+        for a, b in zip(results[0], res):
+            assert reldiff(a, b) < 1e-5
+
+def test_grad_ready_callback():
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=16, name='fc1')
+    net = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.FullyConnected(net, num_hidden=4, name='fc2')
+    arg_shapes, out_shapes, _ = net.infer_shape(data=(8, 10))
+    args = [mx.nd.array(np.random.uniform(-1, 1, s)) for s in arg_shapes]
+    grads = [mx.nd.zeros(s) for s in arg_shapes]
+    grad_req = ['null'] + ['write'] * (len(args) - 1)
+    exe = net.bind(mx.cpu(), args=args, args_grad=grads, grad_req=grad_req)
+    ready = []
+    def on_ready(index, grad):
+        ready.append((index, grad))
+    exe.set_grad_ready_callback(on_ready)
+    for _ in range(2):
+        exe.forward(is_train=True)
+        mx.nd.waitall()
+        assert len(ready) == 0
+        exe.backward([mx.nd.ones(out_shapes[0])])
+        mx.nd.waitall()
+        # exactly once per gradient and backward
+        assert sorted(index for index, _ in ready) == list(range(1, len(args)))
+        for index, grad in ready:
+            assert reldiff(grad.asnumpy(), grads[index].asnumpy()) < 1e-6
+        del ready[:]
+
+def test_monitor_stats():
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=16, name='fc')
+    net = mx.sym.log(net, name='log')
+    arg_shapes, _, _ = net.infer_shape(data=(8, 10))
+    args = [mx.nd.array(np.random.uniform(-1, 1, s)) for s in arg_shapes]
+    exe = net.bind(mx.cpu(), args=args)
+    exe.set_monitor_stats(['l2_norm', 'min', 'max', 'nan_count', 'mean_abs'], interval=2)
+    for _ in range(3):
+        exe.forward()
+    records = exe.get_monitor_stats()
+    assert sorted(set(r[0] for r in records)) == [0, 2]
+    out = exe.outputs[0].asnumpy()
+    finite = out[np.isfinite(out)]
+    stat = [r[2] for r in records if r[0] == 2 and r[1] == 'log_output'][0]
+    assert stat['nan_count'] == np.isnan(out).sum()
+    assert abs(stat['min'] - finite.min()) < 1e-5
+    assert abs(stat['max'] - finite.max()) < 1e-5
+    # the mean is over the finite elements only
+    assert abs(stat['mean_abs'] - np.abs(finite).mean()) < 1e-5
+    assert exe.get_monitor_stats() == []
+
+def test_node_profile():
+    data = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(data, num_hidden=32, name='fc1')
+    net = mx.sym.Activation(net, act_type='relu', name='relu1')
+    net = mx.sym.FullyConnected(net, num_hidden=8, name='fc2')
+    arg_shapes, _, _ = net.infer_shape(data=(4, 16))
+    args = [mx.nd.array(np.random.uniform(-1, 1, s)) for s in arg_shapes]
+    exe = net.bind(mx.cpu(), args=args)
+    exe.set_node_profiling(True)
+    for _ in range(3):
+        exe.forward()
+    profile = exe.get_node_profile(reset=True)
+    assert sorted(node['name'] for node in profile) == ['fc1', 'fc2', 'relu1']
+    fc1 = [node for node in profile if node['name'] == 'fc1'][0]
+    assert fc1['op'] == 'FullyConnected' and fc1['count'] == 3
+    assert fc1['in_shapes'] == [[4, 16], [32, 16], [32]] and fc1['out_shapes'] == [[4, 32]]
+    assert fc1['out_bytes'] == 4 * 32 * 4 and fc1['flops'] > 0
+    assert all(a['total_us'] >= b['total_us'] for a, b in zip(profile, profile[1:]))
+    assert all(node['count'] == 0 for node in exe.get_node_profile())
+    exe.set_node_profiling(False)
+    exe.forward()
+    assert 'fc1' in exe.node_profile_str()
+
+def test_nchwc_layout():
+    data = mx.sym.Variable('data')
+    net = mx.sym.Convolution(data, kernel=(3, 3), pad=(1, 1), num_filter=12, name='conv1')
+    net = mx.sym.BatchNorm(net, fix_gamma=False, name='bn1')
+    net = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.Pooling(net, kernel=(2, 2), stride=(2, 2), pool_type='max')
+    net = mx.sym.Convolution(net, kernel=(3, 3), stride=(2, 2), num_filter=5, name='conv2')
+    net = mx.sym.Pooling(net, kernel=(2, 2), global_pool=True, pool_type='avg')
+    net = mx.sym.Flatten(net)
+    shape = (2, 3, 16, 16)
+    arg_shapes, _, aux_shapes = net.infer_shape(data=shape)
+    args = [mx.nd.array(np.random.uniform(-1, 1, s)) for s in arg_shapes]
+    aux = [mx.nd.array(np.random.uniform(0.5, 1, s)) for s in aux_shapes]
+    results = []
+    for layout in ['0', '1']:
+        with environment('MXNET_EXEC_NCHWC_LAYOUT', layout):
+            exe = net.bind(mx.cpu(), args=args, aux_states=aux)
+            exe.forward(is_train=False)
+            results.append(exe.outputs[0].asnumpy())
+    assert reldiff(results[0], results[1]) < 1e-5
+    # max pooling skips the padding, the pooled values are all negative
+    net = mx.sym.Convolution(data, kernel=(1, 1), num_filter=16, no_bias=True, name='conv')
+    net = mx.sym.Pooling(net, kernel=(3, 3), stride=(2, 2), pad=(1, 1), pool_type='max')
+    x = np.random.uniform(-1, -0.1, (2, 3, 7, 7))
+    w = np.random.uniform(0.1, 1, (16, 3, 1, 1))
+    conv = np.einsum('nchw,fc->nfhw', x, w[:, :, 0, 0])
+    padded = np.pad(conv, ((0, 0), (0, 0), (1, 1), (1, 1)), 'constant',
+                    constant_values=-np.inf)
+    expected = np.zeros((2, 16, 4, 4))
+    for i in range(4):
+        for j in range(4):
+            expected[:, :, i, j] = padded[:, :, 2 * i:2 * i + 3, 2 * j:2 * j + 3].max(axis=(2, 3))
+    with environment('MXNET_EXEC_NCHWC_LAYOUT', '1'):
+        exe = net.bind(mx.cpu(), args={'data': mx.nd.array(x), 'conv_weight': mx.nd.array(w)})
+        exe.forward(is_train=False)
+    assert reldiff(exe.outputs[0].asnumpy(), expected) < 1e-5
+
+def test_optimize_for_inference():
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data, kernel=(3, 3), num_filter=4, name='conv')
+    bn = mx.sym.BatchNorm(conv, fix_gamma=False, name='bn')
+    drop = mx.sym.Dropout(mx.sym.Activation(bn, act_type='relu'), p=0.5)
+    scale = mx.sym.exp(mx.sym.Variable('alpha') * 2)
+    fc = mx.sym.FullyConnected(mx.sym.Flatten(drop), num_hidden=5, name='fc')
+    net = mx.sym.broadcast_mul(fc, scale)
+    arg_shapes, _, aux_shapes = net.infer_shape(data=(2, 3, 8, 8), alpha=(1, 5))
+    params = {}
+    for name, shape in zip(net.list_arguments(), arg_shapes):
+        params[name] = mx.nd.array(np.random.uniform(-1, 1, shape))
+    for name, shape in zip(net.list_auxiliary_states(), aux_shapes):
+        params[name] = mx.nd.array(np.random.uniform(0.5, 1, shape))
+    exe = net.bind(mx.cpu(), args={k: params[k] for k in net.list_arguments()},
+                   aux_states={k: params[k] for k in net.list_auxiliary_states()})
+    exe.forward(is_train=False)
+    opt_net, opt_params = net.optimize_for_inference(['data'], params)
+    assert 'bn_moving_mean' not in opt_net.list_auxiliary_states()
+    assert 'alpha' not in opt_net.list_arguments()
+    opt_exe = opt_net.bind(mx.cpu(),
+                           args={k: opt_params[k] for k in opt_net.list_arguments()},
+                           aux_states={k: opt_params[k]
+                                       for k in opt_net.list_auxiliary_states()})
+    opt_exe.forward(is_train=False)
+    assert reldiff(exe.outputs[0].asnumpy(), opt_exe.outputs[0].asnumpy()) < 1e-5
+
+def test_bind_inference_rewrite():
+    data = mx.sym.Variable('data')
+    fc = mx.sym.FullyConnected(mx.sym.Dropout(data, p=0.5, name='drop'),
+                               num_hidden=4, name='fc')
+    net = mx.sym.BlockGrad(fc, name='stop')
+    arg_shapes, _, _ = net.infer_shape(data=(3, 5))
+    args = [mx.nd.array(np.random.uniform(-1, 1, shape)) for shape in arg_shapes]
+    weight, bias = args[1].asnumpy(), args[2].asnumpy()
+    expect = np.dot(args[0].asnumpy(), weight.T) + bias
+    with environment('MXNET_EXEC_INFERENCE_OPTIMIZE', '1'):
+        exe = net.bind(mx.cpu(), args=args)
+        assert 'drop' not in exe.debug_str()
+        assert 'stop' not in exe.debug_str()
+        exe.forward(is_train=True)
+        assert reldiff(exe.outputs[0].asnumpy(), expect) < 1e-5
+        # executors that take gradients keep the graph
+        grads = [mx.nd.zeros(shape) for shape in arg_shapes]
+        assert 'drop' in net.bind(mx.cpu(), args=args, args_grad=grads).debug_str()
+    # by default an executor without gradients keeps applying dropout in training
+    exe = net.bind(mx.cpu(), args=args)
+    assert 'drop' in exe.debug_str()
+    exe.forward(is_train=True)
+    assert reldiff(exe.outputs[0].asnumpy(), expect) > 1e-3
+    exe.forward(is_train=False)
+    assert reldiff(exe.outputs[0].asnumpy(), expect) < 1e-5
+
+def test_quantization():
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data, kernel=(3, 3), pad=(1, 1), num_filter=8, name='conv')
+    act = mx.sym.Activation(conv, act_type='relu')
+    net = mx.sym.FullyConnected(mx.sym.Flatten(act), num_hidden=10, name='fc')
+    arg_shapes, _, _ = net.infer_shape(data=(4, 3, 6, 6))
+    params = {name: mx.nd.array(np.random.uniform(-1, 1, shape))
+              for name, shape in zip(net.list_arguments(), arg_shapes) if name != 'data'}
+    calib_iter = mx.io.NDArrayIter(np.random.uniform(-1, 1, (16, 3, 6, 6)), batch_size=4)
+    calib = mx.quantization.calibrate(net, params, {}, calib_iter)
+    assert 'data' in calib and 'conv_output' in calib
+    qnet, qparams, _ = mx.quantization.quantize_model(net, params, {}, calib)
+    assert qparams['conv_weight_quantized'].dtype == np.uint8
+    assert qparams['fc_weight_quantized'].dtype == np.uint8
+    assert 'conv_weight' not in qparams
+    x = mx.nd.array(np.random.uniform(-1, 1, (4, 3, 6, 6)))
+    exe = net.bind(mx.cpu(), args=dict(params, data=x))
+    qexe = qnet.bind(mx.cpu(), args=dict(qparams, data=x))
+    exe.forward(is_train=False)
+    qexe.forward(is_train=False)
+    assert reldiff(exe.outputs[0].asnumpy(), qexe.outputs[0].asnumpy()) < 0.05
+
+def test_sparse_grad():
+    data = mx.sym.Variable('data')
+    net = mx.sym.Embedding(data, input_dim=10, output_dim=4, name='embed')
+    weight = np.random.uniform(-1, 1, (10, 4)).astype(np.float32)
+    idx = np.array([[1, 7], [7, 3]], dtype=np.float32)
+    grad = mx.nd.zeros((10, 4), stype='row_sparse')
+    exe = net.bind(mx.cpu(), args={'data': mx.nd.array(idx), 'embed_weight': mx.nd.array(weight)},
+                   args_grad={'embed_weight': grad},
+                   grad_req={'data': 'null', 'embed_weight': 'write'})
+    exe.forward(is_train=True)
+    ograd = np.random.uniform(-1, 1, (2, 2, 4)).astype(np.float32)
+    exe.backward([mx.nd.array(ograd)])
+    # the gradient only stores the rows of the looked up indices
+    assert grad.stype == 'row_sparse'
+    assert (grad.indices.asnumpy() == [1, 3, 7]).all()
+    expected = np.zeros((10, 4), dtype=np.float32)
+    for i, row in enumerate(idx.flatten().astype(int)):
+        expected[row] += ograd.reshape(-1, 4)[i]
+    assert reldiff(expected, grad.asnumpy()) < 1e-5
+
 if __name__ == "__main__":
     test_bind()
     test_reshape()
+    test_fuse_elemwise()
+    test_fuse_batch_dot_scale()
+    test_mirror_budget()
+    test_grad_ready_callback()
+    test_monitor_stats()
+    test_node_profile()
+    test_nchwc_layout()
+    test_optimize_for_inference()
+    test_bind_inference_rewrite()
+    test_quantization()
+    test_sparse_grad()
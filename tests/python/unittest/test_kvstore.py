@@ -116,6 +116,24 @@ def test_get_type():
     kv = mx.kv.create(kvtype)
     assert kv.type == kvtype
 
+def test_row_sparse():
+    kv = mx.kv.create()
+    kv.init(3, mx.nd.ones(shape))
+    grad = mx.nd.row_sparse_array((np.ones((2, 4)), [1, 2]), shape)
+    # the pushed values are summed over their stored rows
+    kv.push(3, [grad, grad])
+    val = mx.nd.zeros(shape)
+    kv.pull(3, out=val)
+    expected = np.zeros(shape)
+    expected[[1, 2]] = 2
+    assert (val.asnumpy() == expected).all()
+    # only the requested rows are pulled
+    out = mx.nd.zeros(shape, stype='row_sparse')
+    kv.row_sparse_pull(3, out=out, row_ids=mx.nd.array([2, 0, 2]))
+    assert (out.indices.asnumpy() == [0, 2]).all()
+    expected[1] = 0
+    assert (out.asnumpy() == expected).all()
+
 if __name__ == '__main__':
     test_init()
     test_get_type()
@@ -123,3 +141,4 @@ if __name__ == '__main__':
     test_list_kv_pair()
     test_aggregator()
     test_updater()
+    test_row_sparse()
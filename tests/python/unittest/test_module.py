@@ -82,8 +82,37 @@ def test_module_reshape():
     assert mod.get_outputs()[0].shape == dshape
     assert (mod.get_params()[0]['fc_bias'].asnumpy() == -3).all()
 
+def test_module_push_in_backward():
+    data = mx.sym.Variable('data')
+    sym = mx.sym.FullyConnected(data, num_hidden=20, name='fc')
+
+    dshape = (8, 20)
+    kv = mx.kv.create('local')
+    pushed = []
+    push = kv.push
+    def record_push(key, value, priority=0):
+        pushed.append(key)
+        push(key, value, priority=priority)
+    kv.push = record_push
+    mod = mx.mod.Module(sym, ('data',), None, context=[mx.cpu(0), mx.cpu(1)])
+    mod.bind(data_shapes=[('data', dshape)])
+    mod.init_params()
+    mod.init_optimizer(kvstore=kv, optimizer_params={'learning_rate': 1})
+
+    for i in range(2):
+        mod.forward(mx.io.DataBatch(data=[mx.nd.ones(dshape)], label=None))
+        mod.backward([mx.nd.ones(dshape)])
+        # every gradient is pushed by backward, and update only pulls
+        mx.nd.waitall()
+        assert sorted(pushed) == [0, 1]
+        mod.update()
+        assert sorted(pushed) == [0, 1]
+        del pushed[:]
+        assert (mod.get_params()[0]['fc_bias'].asnumpy() == -(i + 1)).all()
+
 
 if __name__ == '__main__':
+    test_module_push_in_backward()
     test_module_reshape()
     test_save_load()
     test_module_layout()
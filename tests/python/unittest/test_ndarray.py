@@ -104,6 +104,20 @@ def test_ndarray_elementwisesum():
     ones = mx.nd.ones((10,), dtype=np.int32)
     res = mx.nd.ElementWiseSum(ones, ones*2, ones*4, ones*8)
     assert same(res.asnumpy(), ones.asnumpy()*15)
+    # sizes around the block size, numbers of inputs around the unrolling
+    for dtype, rtol in [(np.float32, 1e-5), (np.float64, 1e-10), (np.float16, 1e-2)]:
+        for size in [1, 1023, 1025, 40000]:
+            for num in [1, 2, 5, 9]:
+                data = [np.random.uniform(-1, 1, (size,)).astype(dtype) for _ in range(num)]
+                res = mx.nd.ElementWiseSum(*[mx.nd.array(x, dtype=dtype) for x in data])
+                assert res.dtype == dtype
+                assert_almost_equal(res.asnumpy().astype(np.float64),
+                                    np.sum([x.astype(np.float64) for x in data], axis=0),
+                                    rtol=rtol, atol=rtol)
+    # the output may be the first input
+    a = mx.nd.ones((3000,))
+    mx.nd.ElementWiseSum(a, a * 2, a * 3, out=a)
+    assert (a.asnumpy() == 6).all()
 
 def test_ndarray_negate():
     npy = np.random.uniform(-10, 10, (2,3,4))
@@ -216,6 +230,54 @@ def test_ndarray_saveload():
     os.remove(fname)
 
 
+def test_ndarray_save_async():
+    np.random.seed(0)
+    fname = 'tmp_params.bin'
+    data = [random_ndarray(np.random.randint(1, 5)) for _ in range(10)]
+    data.append(mx.nd.ones((3, 5), dtype=np.int32))
+    data.append(mx.nd.array(np.arange(20))[5:15])
+    expected = [x.asnumpy() for x in data]
+    pending = mx.nd.save_async(fname, data)
+    # the arrays are snapshotted, updating them does not change the file
+    for x in data:
+        x[:] = 0
+    pending.wait()
+    # the file is written next to the target and renamed
+    assert not os.path.exists(fname + '.tmp')
+    data2 = mx.nd.load(fname)
+    assert len(data2) == len(expected)
+    for x, y in zip(expected, data2):
+        assert x.dtype == y.dtype and same(x, y.asnumpy())
+    assert mx.nd.ParamFile(fname).keys() == []
+
+    dmap = {'ndarray xx %s' % i : x for i, x in enumerate(expected)}
+    mx.nd.save_async(fname, {k: mx.nd.array(v, dtype=v.dtype) for k, v in dmap.items()}).wait()
+    dmap2 = mx.nd.load(fname)
+    assert sorted(dmap2.keys()) == sorted(dmap.keys())
+    for k, x in dmap.items():
+        assert same(x, dmap2[k].asnumpy())
+    params = mx.nd.ParamFile(fname)
+    assert 'ndarray xx 3' in params
+    assert same(params['ndarray xx 3'].asnumpy(), dmap['ndarray xx 3'])
+    subset = params.load(['ndarray xx 10', 'ndarray xx 1'], ctx=mx.cpu())
+    assert same(subset['ndarray xx 10'].asnumpy(), dmap['ndarray xx 10'])
+    assert same(subset['ndarray xx 1'].asnumpy(), dmap['ndarray xx 1'])
+    del params
+
+    # corrupt the last payload byte
+    with open(fname, 'r+b') as fout:
+        fout.seek(-1, os.SEEK_END)
+        last = fout.read(1)
+        fout.seek(-1, os.SEEK_END)
+        fout.write(bytes(bytearray([ord(last) ^ 0xFF])))
+    try:
+        mx.nd.load(fname)
+        assert False
+    except mx.base.MXNetError:
+        pass
+    os.remove(fname)
+
+
 def test_ndarray_slice():
     shape = (10,)
     A = mx.nd.array(np.random.uniform(-10, 10, shape))
@@ -579,6 +641,185 @@ def test_take():
             result = mx.nd.take(data_real_mx, idx_real_mx)
             assert_almost_equal(result.asnumpy(), data_real[idx_real])
 
+def test_lazy_mode():
+    a_np = np.random.uniform(-1, 1, (4, 5)).astype(np.float32)
+    b_np = np.random.uniform(-1, 1, (4, 5)).astype(np.float32)
+    a = mx.nd.array(a_np)
+    b = mx.nd.array(b_np)
+    with mx.nd.LazyMode():
+        for _ in range(3):
+            c = mx.nd.exp(a * b) + 1
+            d = mx.nd.sum(c, axis=1)
+            a += 1
+            e = a.copy()
+            # views are executed eagerly, after the recorded operations
+            e[1:2] = 0
+        assert_almost_equal(d.asnumpy(), np.sum(np.exp((a_np + 2) * b_np) + 1, axis=1),
+                            rtol=1e-5)
+        assert_almost_equal(e.asnumpy()[0], a_np[0] + 3)
+        assert (e.asnumpy()[1] == 0).all()
+        # an executor reads an argument written lazily
+        a[:] = 2
+        exe = (mx.sym.Variable('x') * 3).bind(mx.cpu(), {'x': a})
+        assert (exe.forward()[0].asnumpy() == 6).all()
+        # the value of an array before the segment is read before it is
+        # overwritten, also when the cached executor is bound again
+        x = mx.nd.array(a_np)
+        expected = a_np
+        for _ in range(3):
+            y = x * 2
+            mx.nd.abs(b, out=x)
+            z = y + x
+            assert_almost_equal(y.asnumpy(), expected * 2)
+            assert_almost_equal(z.asnumpy(), expected * 2 + np.abs(b_np))
+            expected = np.abs(b_np)
+    assert_almost_equal(a.asnumpy(), np.full((4, 5), 2, dtype=np.float32))
+
+def test_imperative_dispatch_cache():
+    # repeated calls with the same and with different parameters and shapes
+    for _ in range(2):
+        for shape in [(3, 4), (5, 4), (3, 6)]:
+            x_np = np.random.uniform(-1, 1, shape).astype(np.float32)
+            w_np = np.random.uniform(-1, 1, (2, shape[1])).astype(np.float32)
+            b_np = np.random.uniform(-1, 1, (2,)).astype(np.float32)
+            x, w, b = mx.nd.array(x_np), mx.nd.array(w_np), mx.nd.array(b_np)
+            fc = mx.nd.FullyConnected(x, w, b, num_hidden=2)
+            assert_almost_equal(fc.asnumpy(), np.dot(x_np, w_np.T) + b_np, rtol=1e-5)
+            mx.nd.FullyConnected(x, w, b, num_hidden=2, no_bias=False, out=fc)
+            assert_almost_equal(fc.asnumpy(), np.dot(x_np, w_np.T) + b_np, rtol=1e-5)
+            for axis in [0, 1]:
+                assert_almost_equal(mx.nd.sum(x, axis=axis).asnumpy(), x_np.sum(axis=axis),
+                                    rtol=1e-5)
+            out = mx.nd.empty((2,))
+            mx.nd.sum(w, axis=1, out=out)
+            assert_almost_equal(out.asnumpy(), w_np.sum(axis=1), rtol=1e-5)
+    x = mx.nd.ones((2, 3), dtype=np.float64)
+    assert (mx.nd.sum(x, axis=1).asnumpy() == 3).all()
+    assert mx.nd.sum(x, axis=1).dtype == np.float64
+
+def test_ndarray_zero_copy():
+    src = np.arange(12, dtype=np.float32).reshape(3, 4)
+    a = mx.nd.from_numpy(src)
+    assert a.shape == (3, 4) and a.dtype == np.float32
+    b = a * 2
+    a += 1
+    # the operations write the numpy memory directly
+    assert_almost_equal(b.asnumpy(), np.arange(12).reshape(3, 4) * 2)
+    a.wait_to_read()
+    assert_almost_equal(src, np.arange(12).reshape(3, 4) + 1)
+    # the numpy array is kept alive by the NDArray
+    del src
+    view = a.asnumpy_view()
+    assert_almost_equal(view, np.arange(12).reshape(3, 4) + 1)
+    view[:] = 5
+    assert (a.asnumpy() == 5).all()
+    # views keep the numpy array alive after the array is freed
+    src = np.ones((3, 4), dtype=np.float32)
+    row = mx.nd.from_numpy(src)[1]
+    del src
+    row += 1
+    assert (row.asnumpy() == 2).all()
+    # the view keeps the memory alive
+    c = mx.nd.ones((2, 3), dtype=np.int32)
+    view = c.asnumpy_view()
+    del c
+    assert view.dtype == np.int32 and (view == 1).all()
+    try:
+        mx.nd.from_numpy(np.ones((4, 4))[:, 1])
+        assert False
+    except ValueError:
+        pass
+    # operations may write the memory, read-only arrays are not shared
+    readonly = np.ones((2, 2), dtype=np.float32)
+    readonly.flags.writeable = False
+    try:
+        mx.nd.from_numpy(readonly)
+        assert False
+    except ValueError:
+        pass
+
+def test_ndarray_strided_view():
+    src = np.arange(24, dtype=np.float32).reshape(2, 3, 4)
+    a = mx.nd.array(src)
+    assert a.is_contiguous
+    # views share the memory of the array
+    s = a.slice_axis_view(2, 1, 3)
+    assert s.shape == (2, 3, 2) and not s.is_contiguous
+    assert_almost_equal(s.asnumpy(), src[:, :, 1:3])
+    t = a.transpose_view((2, 0, 1))
+    assert t.shape == (4, 2, 3) and not t.is_contiguous
+    assert_almost_equal(t.asnumpy(), src.transpose(2, 0, 1))
+    assert_almost_equal(a.transpose_view().asnumpy(), src.T)
+    # operators and copies read the views
+    assert_almost_equal((s * 2).asnumpy(), src[:, :, 1:3] * 2)
+    assert_almost_equal(mx.nd.sum(t, axis=0).asnumpy(), src.transpose(2, 0, 1).sum(axis=0))
+    assert_almost_equal(t.copyto(mx.cpu()).asnumpy(), src.transpose(2, 0, 1))
+    assert t.compact().is_contiguous
+    # writes through a view reach the array
+    s[:] = 0
+    src[:, :, 1:3] = 0
+    assert_almost_equal(a.asnumpy(), src)
+    t[:] = np.ones((4, 2, 3))
+    assert (a.asnumpy() == 1).all()
+    mx.nd.elemwise_add(t, t, out=t)
+    assert (a.asnumpy() == 2).all()
+    # broadcast views repeat the axes of size 1 and are read only
+    b = mx.nd.array(np.arange(3).reshape(3, 1))
+    v = b.broadcast_view((3, 4))
+    assert not v.is_contiguous and not v.writable
+    assert_almost_equal(v.asnumpy(), np.broadcast_to(np.arange(3).reshape(3, 1), (3, 4)))
+    assert_almost_equal((v + 1).asnumpy(), np.arange(3).reshape(3, 1) + np.ones((3, 4)))
+    # executors compact the views bound as arguments before every forward
+    exe = (mx.sym.Variable('x') * 2).bind(mx.cpu(), {'x': t})
+    assert_almost_equal(exe.forward()[0].asnumpy(), np.full((4, 2, 3), 4))
+    a[:] = 3
+    assert_almost_equal(exe.forward()[0].asnumpy(), np.full((4, 2, 3), 6))
+
+def test_sparse_ndarray():
+    ctx = mx.cpu()
+    dense = np.zeros((5, 3), dtype=np.float32)
+    dense[1] = [1, 2, 3]
+    dense[3] = [0, 4, 0]
+    # row sparse and csr arrays, their components and conversions
+    rsp = mx.nd.row_sparse_array((dense[[1, 3]], [1, 3]), (5, 3), ctx=ctx)
+    assert rsp.stype == 'row_sparse'
+    assert_almost_equal(rsp.asnumpy(), dense)
+    assert (rsp.indices.asnumpy() == [1, 3]).all()
+    csr = mx.nd.csr_matrix(([1, 2, 3, 4], [0, 1, 2, 1], [0, 0, 3, 3, 4, 4]), (5, 3), ctx=ctx)
+    assert csr.stype == 'csr'
+    assert_almost_equal(csr.asnumpy(), dense)
+    assert (csr.indptr.asnumpy() == [0, 0, 3, 3, 4, 4]).all()
+    x = mx.nd.array(dense, ctx=ctx)
+    for stype in ['row_sparse', 'csr']:
+        y = x.tostype(stype)
+        assert y.stype == stype
+        assert_almost_equal(y.asnumpy(), dense)
+        assert_almost_equal(y.tostype('default').asnumpy(), dense)
+        assert y.copy().stype == stype
+    assert (x.tostype('row_sparse').indices.asnumpy() == [1, 3]).all()
+    assert mx.nd.zeros((5, 3), ctx=ctx, stype='row_sparse').asnumpy().sum() == 0
+    # operators without sparse support see dense arrays
+    assert_almost_equal((rsp + 1).asnumpy(), dense + 1)
+    # dot of a csr matrix
+    rhs = np.random.uniform(size=(3, 4)).astype(np.float32)
+    assert_almost_equal(mx.nd.dot(csr, mx.nd.array(rhs, ctx=ctx)).asnumpy(),
+                        np.dot(dense, rhs), rtol=1e-5, atol=1e-5)
+    rhs_t = np.random.uniform(size=(5, 4)).astype(np.float32)
+    out = mx.nd.dot(csr, mx.nd.array(rhs_t, ctx=ctx), transpose_a=True)
+    assert out.stype == 'row_sparse'
+    assert_almost_equal(out.asnumpy(), np.dot(dense.T, rhs_t), rtol=1e-5, atol=1e-5)
+    # sum of row sparse arrays
+    rsp2 = mx.nd.row_sparse_array((np.ones((2, 3)), [0, 3]), (5, 3), ctx=ctx)
+    total = mx.nd.add_n(rsp, rsp2)
+    assert total.stype == 'row_sparse'
+    assert_almost_equal(total.asnumpy(), dense + rsp2.asnumpy())
+    # the update with a row sparse gradient only changes the stored rows
+    weight = mx.nd.ones((5, 3), ctx=ctx)
+    mx.nd.sgd_update(weight, rsp, lr=0.1, wd=0.1, out=weight)
+    expected = np.ones((5, 3), dtype=np.float32)
+    expected[[1, 3]] = 0.99 - 0.1 * dense[[1, 3]]
+    assert_almost_equal(weight.asnumpy(), expected, rtol=1e-5, atol=1e-5)
+
 if __name__ == '__main__':
     test_broadcast_binary()
     test_ndarray_setitem()
@@ -603,3 +844,9 @@ if __name__ == '__main__':
     test_order()
     test_ndarray_equal()
     test_take()
+    test_lazy_mode()
+    test_imperative_dispatch_cache()
+    test_ndarray_zero_copy()
+    test_ndarray_strided_view()
+    test_sparse_ndarray()
+    test_ndarray_save_async()
@@ -433,6 +433,38 @@ def test_embedding():
     exe_test.backward([grad])
     assert_almost_equal(grad_map["embed_weight"].asnumpy(), np.dot(np_onehot.T, np_grad))
 
+def test_embedding_large_batch():
+    # many repeated ids, with write and add to the weight gradient
+    in_dim = 1000
+    out_dim = 16
+    batch = (64, 40)
+    data = mx.sym.Variable("data")
+    embed = mx.sym.Embedding(data=data, input_dim=in_dim, output_dim=out_dim, name="embed")
+    np_data = np.random.randint(low=0, high=in_dim // 4, size=batch)
+    np_grad = np.random.uniform(-1, 1, batch + (out_dim,)).astype('float32')
+    rows = np_data.reshape(-1)
+    expected = np.zeros((in_dim, out_dim), dtype='float32')
+    np.add.at(expected, rows, np_grad.reshape(-1, out_dim))
+    for req in ['write', 'add']:
+        exe = embed.simple_bind(default_context(), grad_req={'data': 'null', 'embed_weight': req},
+                                data=batch)
+        init = np.random.uniform(-1, 1, (in_dim, out_dim)).astype('float32')
+        exe.grad_dict["embed_weight"][:] = init
+        exe.arg_dict["data"][:] = np_data
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.array(np_grad)])
+        first = exe.grad_dict["embed_weight"].asnumpy()
+        if req == 'add':
+            assert_almost_equal(first, init + expected, rtol=1e-4, atol=1e-5)
+            # rows no id refers to are left as they were
+            untouched = np.setdiff1d(np.arange(in_dim), rows)
+            assert (first[untouched] == init[untouched]).all()
+        else:
+            assert_almost_equal(first, expected, rtol=1e-4, atol=1e-5)
+            # the accumulation order does not depend on the run
+            exe.backward([mx.nd.array(np_grad)])
+            assert (exe.grad_dict["embed_weight"].asnumpy() == first).all()
+
 # check ops handle duplicate input correctly.
 def test_binary_op_duplicate_input():
     data = mx.symbol.Variable('data')
@@ -513,6 +545,35 @@ def test_rsqrt_cos_sin():
     exe_test.backward(out_grad)
     assert_almost_equal(arr_grad.asnumpy(), npout_grad)
 
+def test_transcendental_float32():
+    x = np.concatenate([np.random.uniform(-100, 100, 5000), np.random.uniform(-2, 2, 5000),
+                        [0, -0.0, 1e-40, -1e-40, 88.7, -88.7, 103, -103, 200, -200,
+                         np.inf, -np.inf, np.nan]]).astype(np.float32)
+    xd = x.astype(np.float64)
+    positive = np.abs(x)
+    with np.errstate(all='ignore'):
+        checks = [(mx.nd.exp(mx.nd.array(x)), np.exp(xd)),
+                  (mx.nd.log(mx.nd.array(positive)), np.log(positive.astype(np.float64))),
+                  (mx.nd.tanh(mx.nd.array(x)), np.tanh(xd)),
+                  (mx.nd.Activation(mx.nd.array(x), act_type='sigmoid'), 1 / (1 + np.exp(-xd))),
+                  (mx.nd.Activation(mx.nd.array(x), act_type='softrelu'),
+                   np.maximum(xd, 0) + np.log1p(np.exp(-np.abs(xd))))]
+    for out, expected in checks:
+        out = out.asnumpy()
+        expected = expected.astype(np.float32)
+        assert out.dtype == np.float32
+        assert np.array_equal(np.isnan(out), np.isnan(expected))
+        finite = np.isfinite(expected)
+        assert np.array_equal(out[~finite & ~np.isnan(expected)],
+                              expected[~finite & ~np.isnan(expected)])
+        # within a few ulp, denormal results within a few of the smallest denormal
+        ulp = np.spacing(np.abs(expected[finite]))
+        assert np.all(np.abs(out[finite] - expected[finite]) <= 4 * ulp)
+    data = mx.sym.Variable('data')
+    for act_type in ['sigmoid', 'tanh', 'softrelu']:
+        check_numeric_gradient(mx.sym.Activation(data, act_type=act_type),
+                               [np.random.normal(size=(3, 4))])
+
 def test_maximum_minimum():
     data1 = mx.symbol.Variable('data')
     data2 = mx.symbol.Variable('data')
@@ -810,6 +871,110 @@ def test_batchnorm_training():
         test = mx.symbol.BatchNorm(data, fix_gamma=False, use_global_stats=True)
         check_numeric_gradient(test, [data_tmp, gamma, beta], [rolling_mean, rolling_std], numeric_eps=1e-2, rtol=0.16)
 
+def test_batchnorm_reference():
+    eps, momentum = 1e-3, 0.9
+    for shape in [(4, 3), (2, 5, 7, 6), (3, 4, 1, 33)]:
+        axes = tuple(i for i in range(len(shape)) if i != 1)
+        bshape = tuple(shape[1] if i == 1 else 1 for i in range(len(shape)))
+        x = np.random.normal(1.0, 2.0, shape)
+        gamma = np.random.uniform(0.5, 1.5, (shape[1],))
+        beta = np.random.uniform(-1, 1, (shape[1],))
+        moving_mean = np.random.uniform(-1, 1, (shape[1],))
+        moving_var = np.random.uniform(0.5, 1.5, (shape[1],))
+        dy = np.random.normal(size=shape)
+        data = mx.sym.Variable('data')
+        bn = mx.sym.BatchNorm(data, fix_gamma=False, eps=eps, momentum=momentum,
+                              name='bn')
+        exe = bn.simple_bind(default_context(), data=shape)
+        exe.arg_dict['data'][:] = x
+        exe.arg_dict['bn_gamma'][:] = gamma
+        exe.arg_dict['bn_beta'][:] = beta
+        exe.aux_dict['bn_moving_mean'][:] = moving_mean
+        exe.aux_dict['bn_moving_var'][:] = moving_var
+
+        # training: batch statistics
+        exe.forward(is_train=True)
+        exe.backward([mx.nd.array(dy)])
+        mean = x.mean(axis=axes)
+        var = x.var(axis=axes)
+        xhat = (x - mean.reshape(bshape)) / np.sqrt(var.reshape(bshape) + eps)
+        assert_almost_equal(exe.outputs[0].asnumpy(),
+                            gamma.reshape(bshape) * xhat + beta.reshape(bshape),
+                            rtol=1e-3, atol=1e-4)
+        m = x.size / shape[1]
+        dgamma = (dy * xhat).sum(axis=axes)
+        dbeta = dy.sum(axis=axes)
+        dx = (gamma / np.sqrt(var + eps)).reshape(bshape) * \
+            (dy - (dbeta / m).reshape(bshape) - xhat * (dgamma / m).reshape(bshape))
+        assert_almost_equal(exe.grad_dict['data'].asnumpy(), dx, rtol=1e-3, atol=1e-4)
+        assert_almost_equal(exe.grad_dict['bn_gamma'].asnumpy(), dgamma, rtol=1e-3, atol=1e-4)
+        assert_almost_equal(exe.grad_dict['bn_beta'].asnumpy(), dbeta, rtol=1e-3, atol=1e-4)
+        moving_mean = moving_mean * momentum + mean * (1 - momentum)
+        moving_var = moving_var * momentum + var * (1 - momentum)
+        assert_almost_equal(exe.aux_dict['bn_moving_mean'].asnumpy(), moving_mean,
+                            rtol=1e-3, atol=1e-4)
+        assert_almost_equal(exe.aux_dict['bn_moving_var'].asnumpy(), moving_var,
+                            rtol=1e-3, atol=1e-4)
+
+        # inference: moving statistics
+        exe.forward(is_train=False)
+        expected = (x - moving_mean.reshape(bshape)) / np.sqrt(moving_var.reshape(bshape) + eps) * \
+            gamma.reshape(bshape) + beta.reshape(bshape)
+        assert_almost_equal(exe.outputs[0].asnumpy(), expected, rtol=1e-3, atol=1e-4)
+
+def _pooling_reference(x, pool_type, kernel, stride, pad, oshape):
+    nd = len(kernel)
+    # the windows of the last outputs may extend past the padded input
+    extra = [max(0, (o - 1) * s + k - (n + 2 * p))
+             for o, s, k, n, p in zip(oshape[2:], stride, kernel, x.shape[2:], pad)]
+    fill = -np.inf if pool_type == 'max' else 0
+    xp = np.pad(x, [(0, 0), (0, 0)] + [(p, p + e) for p, e in zip(pad, extra)],
+                'constant', constant_values=fill)
+    y = np.zeros(oshape)
+    for o in np.ndindex(*oshape[2:]):
+        window = xp[(Ellipsis,) + tuple(slice(i * s, i * s + k)
+                                        for i, s, k in zip(o, stride, kernel))]
+        window = window.reshape(x.shape[:2] + (-1,))
+        if pool_type == 'max':
+            v = window.max(axis=2)
+            y[(Ellipsis,) + o] = np.where(np.isinf(v), 0, v)
+        elif pool_type == 'avg':
+            y[(Ellipsis,) + o] = window.sum(axis=2) / np.prod(kernel)
+        else:
+            y[(Ellipsis,) + o] = window.sum(axis=2)
+    return y
+
+def test_pooling_reference():
+    configs = [((2, 3, 9, 10), (3, 3), (2, 2), (1, 1), 'valid'),
+               ((2, 3, 9, 10), (2, 3), (2, 1), (0, 1), 'full'),
+               ((1, 4, 7, 8), (3, 2), (1, 3), (1, 0), 'full'),
+               ((2, 2, 5, 6, 7), (2, 3, 2), (1, 2, 2), (1, 1, 0), 'valid'),
+               ((1, 3, 4, 6, 5), (2, 2, 3), (2, 2, 1), (0, 1, 1), 'full')]
+    for shape, kernel, stride, pad, convention in configs:
+        for pool_type in ['max', 'avg', 'sum']:
+            x = np.random.normal(size=shape)
+            data = mx.sym.Variable('data')
+            pool = mx.sym.Pooling(data, kernel=kernel, stride=stride, pad=pad,
+                                  pool_type=pool_type, pooling_convention=convention)
+            exe = pool.simple_bind(default_context(), data=shape)
+            exe.arg_dict['data'][:] = x
+            exe.forward(is_train=True)
+            out = exe.outputs[0].asnumpy()
+            expected = _pooling_reference(x, pool_type, kernel, stride, pad, out.shape)
+            assert_almost_equal(out, expected, rtol=1e-4, atol=1e-5)
+            check_numeric_gradient(pool, [x], numeric_eps=1e-3, rtol=1e-2, atol=1e-3)
+    # global pooling
+    for shape in [(2, 3, 5, 6), (2, 3, 3, 4, 5)]:
+        x = np.random.normal(size=shape)
+        axes = tuple(range(2, len(shape)))
+        kernel, pad, stride = (1,) * len(axes), (0,) * len(axes), (1,) * len(axes)
+        for pool_type, reference in [('max', x.max(axis=axes)), ('avg', x.mean(axis=axes)),
+                                     ('sum', x.sum(axis=axes))]:
+            y = mx.nd.Pooling(mx.nd.array(x), kernel=kernel, pad=pad, stride=stride,
+                              global_pool=True, pool_type=pool_type)
+            assert_almost_equal(y.asnumpy().reshape(shape[:2]), reference,
+                                rtol=1e-4, atol=1e-5)
+
 def test_convolution_grouping():
     num_filter = 4
     num_group = 2
@@ -840,6 +1005,39 @@ def test_convolution_grouping():
     for arr1, arr2 in zip(exe1.outputs + exe1.grad_arrays, exe2.outputs + exe2.grad_arrays):
         np.testing.assert_allclose(arr1.asnumpy(), arr2.asnumpy(), rtol=1e-3)
 
+def test_convolution_winograd():
+    # 3x3 stride 1 convolutions use the Winograd algorithm on CPU
+    def conv_reference(data, weight, bias, pad):
+        n, c, h, w = data.shape
+        padded = np.zeros((n, c, h + 2 * pad, w + 2 * pad))
+        padded[:, :, pad:pad + h, pad:pad + w] = data
+        oh, ow = h + 2 * pad - 2, w + 2 * pad - 2
+        out = np.zeros((n, weight.shape[0], oh, ow))
+        for y in range(3):
+            for x in range(3):
+                out += np.einsum('nchw,kc->nkhw', padded[:, :, y:y + oh, x:x + ow],
+                                 weight[:, :, y, x])
+        return out + bias.reshape((1, -1, 1, 1))
+
+    # F(4x4,3x3) with partial tiles, F(2x2,3x3), and several blocks of tiles
+    for shape, num_filter, pad in [((2, 3, 9, 11), 5, 1), ((1, 4, 6, 5), 3, 0),
+                                   ((3, 8, 23, 21), 16, 1)]:
+        data = mx.sym.Variable('data')
+        conv = mx.sym.Convolution(data=data, num_filter=num_filter, kernel=(3, 3),
+                                  pad=(pad, pad), name='conv')
+        exe = conv.simple_bind(default_context(), data=shape)
+        for arr in exe.arg_arrays:
+            arr[:] = np.random.uniform(-1, 1, arr.shape)
+        args = dict((k, v.asnumpy()) for k, v in exe.arg_dict.items())
+        exe.forward(is_train=False)
+        expected = conv_reference(args['data'], args['conv_weight'], args['conv_bias'], pad)
+        assert_almost_equal(exe.outputs[0].asnumpy(), expected, rtol=1e-3, atol=1e-4)
+        # the cached transformed weights follow updates of the weights
+        exe.arg_dict['conv_weight'][:] = -exe.arg_dict['conv_weight']
+        exe.forward(is_train=False)
+        expected = conv_reference(args['data'], -args['conv_weight'], args['conv_bias'], pad)
+        assert_almost_equal(exe.outputs[0].asnumpy(), expected, rtol=1e-3, atol=1e-4)
+
 def gen_broadcast_data():
     # Generate random data that has ndim between 1-7 and all the shape dims between 1-5
     ndim = np.random.randint(1, 6)
@@ -1236,6 +1434,32 @@ def test_broadcast():
         test_broadcasting_ele(sym_bcast_axis)
         test_broadcasting_ele(sym_bcast_to)
 
+def test_reduce_broadcast_large():
+    # shapes large enough to run on several threads, with the reduced axes
+    # leading, trailing, in the middle, not adjacent, and with few outputs
+    for shape, axis in [((64, 4096), 1), ((4096, 64), 0), ((16, 512, 32), 1),
+                        ((8, 64, 8, 64), (1, 3)), ((3, 100000), 1), ((100000, 3), 0),
+                        ((300000,), 0)]:
+        x = np.random.uniform(-1, 1, shape).astype(np.float32)
+        a = mx.nd.array(x)
+        assert_almost_equal(mx.nd.sum(a, axis=axis).asnumpy(), np.sum(x, axis=axis),
+                            rtol=1e-4, atol=1e-3)
+        assert_almost_equal(mx.nd.mean(a, axis=axis).asnumpy(), np.mean(x, axis=axis),
+                            rtol=1e-4, atol=1e-5)
+        assert_almost_equal(mx.nd.max(a, axis=axis).asnumpy(), np.max(x, axis=axis))
+        assert_almost_equal(mx.nd.min(a, axis=axis).asnumpy(), np.min(x, axis=axis))
+    x = np.random.uniform(-1, 1, (1000, 300)).astype(np.float32)
+    assert_almost_equal(mx.nd.norm(mx.nd.array(x)).asnumpy(), np.array([np.linalg.norm(x)]),
+                        rtol=1e-4)
+    for lshape, rshape in [((256, 512), (1, 512)), ((256, 512), (256, 1)),
+                           ((1, 64, 1024), (32, 64, 1)), ((32, 1, 1024), (1, 64, 1))]:
+        lhs = np.random.uniform(-1, 1, lshape).astype(np.float32)
+        rhs = np.random.uniform(-1, 1, rshape).astype(np.float32)
+        out = mx.nd.broadcast_mul(mx.nd.array(lhs), mx.nd.array(rhs))
+        assert_almost_equal(out.asnumpy(), lhs * rhs)
+        out = mx.nd.broadcast_to(mx.nd.array(rhs), shape=out.shape)
+        assert_almost_equal(out.asnumpy(), np.broadcast_to(rhs, out.shape))
+
 def test_transpose():
     for ndim in range(1, 6):
         for t in range(5):
@@ -1251,6 +1475,29 @@ def test_transpose():
             assert_allclose(np.transpose(x.asnumpy()), y.asnumpy())
 
 
+def test_transpose_large():
+    # whole and partial tiles, axes of size 1 and axes that are merged
+    cases = [((67, 131), (1, 0)),
+             ((4, 33, 9, 70), (0, 2, 3, 1)),
+             ((4, 70, 9, 33), (0, 3, 1, 2)),
+             ((5, 1, 40, 3, 36), (2, 4, 1, 0, 3)),
+             ((6, 7, 8, 9), (2, 3, 0, 1)),
+             ((3, 40, 50), (1, 0, 2))]
+    for dtype in ['float32', 'float64', 'uint8', 'int32']:
+        for shape, axes in cases:
+            x = np.random.randint(0, 100, size=shape).astype(dtype)
+            y = mx.nd.transpose(mx.nd.array(x, dtype=dtype), axes=axes)
+            assert y.dtype == np.dtype(dtype)
+            assert (y.asnumpy() == np.transpose(x, axes)).all()
+    x = np.random.normal(size=(4, 35, 6, 70))
+    data = mx.sym.Variable('data')
+    for dim1, dim2 in [(1, 3), (0, 2), (2, 3)]:
+        exe = mx.sym.SwapAxis(data=data, dim1=dim1, dim2=dim2).bind(
+            default_context(), args=[mx.nd.array(x)])
+        exe.forward()
+        assert_almost_equal(exe.outputs[0].asnumpy(), np.swapaxes(x, dim1, dim2))
+
+
 def test_expand_dims():
     for ndim in range(1, 6):
         for t in range(5):
@@ -1486,6 +1733,34 @@ def test_batch_dot():
                     assert_almost_equal(exe_add.grad_dict['b'].asnumpy(),
                                    bgrad_npy + b_init_grad_npy, rtol=1e-3, atol=1e-4)
 
+def test_batch_dot_large():
+    # attention sized products, with a scale and transposed operands
+    batch_size, m, k, n = 48, 64, 40, 70
+    alpha = 0.125
+    for transpose_a in [False, True]:
+        for transpose_b in [False, True]:
+            a_npy = np.random.normal(0, 1, (batch_size, m, k))
+            b_npy = np.random.normal(0, 1, (batch_size, k, n))
+            ograd_npy = np.random.normal(0, 1, (batch_size, m, n))
+            c_npy = alpha * np.einsum('bmk,bkn->bmn', a_npy, b_npy)
+            agrad_npy = alpha * np.einsum('bmn,bkn->bmk', ograd_npy, b_npy)
+            bgrad_npy = alpha * np.einsum('bmk,bmn->bkn', a_npy, ograd_npy)
+            if transpose_a:
+                a_npy = np.transpose(a_npy, axes=(0, 2, 1))
+                agrad_npy = np.transpose(agrad_npy, axes=(0, 2, 1))
+            if transpose_b:
+                b_npy = np.transpose(b_npy, axes=(0, 2, 1))
+                bgrad_npy = np.transpose(bgrad_npy, axes=(0, 2, 1))
+            c = mx.sym.batch_dot(mx.sym.Variable('a'), mx.sym.Variable('b'), alpha=alpha,
+                                 transpose_a=transpose_a, transpose_b=transpose_b)
+            exe = c.simple_bind(ctx=default_context(), a=a_npy.shape, b=b_npy.shape,
+                                grad_req='write')
+            outputs = exe.forward(is_train=True, a=a_npy, b=b_npy)
+            assert_almost_equal(outputs[0].asnumpy(), c_npy, rtol=1e-3, atol=1e-4)
+            exe.backward(out_grads=[mx.nd.array(ograd_npy, ctx=exe._ctx)])
+            assert_almost_equal(exe.grad_dict['a'].asnumpy(), agrad_npy, rtol=1e-3, atol=1e-4)
+            assert_almost_equal(exe.grad_dict['b'].asnumpy(), bgrad_npy, rtol=1e-3, atol=1e-4)
+
 def get_correlation(data1,data2,kernel_size,max_displacement,stride1,stride2,pad_size,is_multiply):
 
     img1 = mx.sym.Variable('img1')
@@ -2191,6 +2466,35 @@ def test_order():
                                              is_ascend=True)])
 
 
+def test_topk_large():
+    # long rows with many ties, equal values keep the order of their indices
+    for shape, axis in [((3, 100000), 1), ((1, 200000), -1), ((70000, 3), 0), ((2, 50, 7), 1)]:
+        x = np.random.randint(0, 1000, shape).astype(np.float32)
+        n = shape[axis]
+        rows = np.moveaxis(x, axis, -1).reshape(-1, n)
+        for is_ascend in [True, False]:
+            order = np.argsort(rows if is_ascend else -rows, axis=1, kind='mergesort')
+            for k in [1, 5, 40]:
+                k = min(k, n)
+                top = order[:, :k]
+                values, indices = mx.nd.topk(mx.nd.array(x), axis=axis, k=k, ret_typ='both',
+                                             is_ascend=is_ascend)
+                top_shape = np.moveaxis(x, axis, -1).shape[:-1] + (k,)
+                assert_almost_equal(indices.asnumpy(),
+                                    np.moveaxis(top.reshape(top_shape), -1, axis))
+                top_values = rows[np.arange(rows.shape[0])[:, None], top]
+                assert_almost_equal(values.asnumpy(),
+                                    np.moveaxis(top_values.reshape(top_shape), -1, axis))
+                mask = np.zeros(rows.shape, dtype=np.float32)
+                mask[np.arange(rows.shape[0])[:, None], top] = 1
+                out = mx.nd.topk(mx.nd.array(x), axis=axis, k=k, ret_typ='mask',
+                                 is_ascend=is_ascend)
+                assert_almost_equal(out.asnumpy(), np.moveaxis(
+                    mask.reshape(np.moveaxis(x, axis, -1).shape), -1, axis))
+            # a full sort of the flattened array
+            out = mx.nd.sort(mx.nd.array(x), axis=None, is_ascend=is_ascend).asnumpy()
+            assert_almost_equal(out, np.sort(x, axis=None)[::1 if is_ascend else -1])
+
 def test_blockgrad():
     a = mx.sym.Variable('a')
     b = mx.sym.BlockGrad(a)
@@ -2846,12 +3150,98 @@ def test_where():
     test_where_numeric_gradient((5, 7, 9), True)
     test_where_numeric_gradient((5, 7, 9), False)
 
+def _rnn_reference(mode, data, params, state, state_cell, num_hidden, num_layers, bidirectional):
+    """numpy forward of the RNN operator with the parameter layout of cuDNN"""
+    sigmoid = lambda x: 1.0 / (1.0 + np.exp(-x))
+    gates = {'lstm': 4, 'gru': 3, 'rnn_tanh': 1, 'rnn_relu': 1}[mode]
+    dirs = 2 if bidirectional else 1
+    seq_len, batch, _ = data.shape
+    GH = gates * num_hidden
+    weights = []
+    p = 0
+    for l in range(num_layers):
+        in_size = data.shape[2] if l == 0 else dirs * num_hidden
+        for d in range(dirs):
+            w_i2h = params[p:p + GH * in_size].reshape(GH, in_size)
+            p += GH * in_size
+            w_h2h = params[p:p + GH * num_hidden].reshape(GH, num_hidden)
+            p += GH * num_hidden
+            weights.append([w_i2h, w_h2h])
+    for k in range(num_layers * dirs):
+        weights[k].append(params[p:p + GH])
+        weights[k].append(params[p + GH:p + 2 * GH])
+        p += 2 * GH
+    assert p == params.size
+    x = data
+    for l in range(num_layers):
+        y = np.zeros((seq_len, batch, dirs * num_hidden))
+        for d in range(dirs):
+            w_i2h, w_h2h, b_i2h, b_h2h = weights[l * dirs + d]
+            h = state[l * dirs + d]
+            c = state_cell[l * dirs + d] if mode == 'lstm' else None
+            steps = range(seq_len - 1, -1, -1) if d == 1 else range(seq_len)
+            for t in steps:
+                gx = x[t].dot(w_i2h.T) + b_i2h
+                gh = h.dot(w_h2h.T) + b_h2h
+                H = num_hidden
+                if mode == 'lstm':
+                    g = gx + gh
+                    i, f = sigmoid(g[:, :H]), sigmoid(g[:, H:2*H])
+                    u, o = np.tanh(g[:, 2*H:3*H]), sigmoid(g[:, 3*H:])
+                    c = f * c + i * u
+                    h = o * np.tanh(c)
+                elif mode == 'gru':
+                    r = sigmoid(gx[:, :H] + gh[:, :H])
+                    z = sigmoid(gx[:, H:2*H] + gh[:, H:2*H])
+                    n = np.tanh(gx[:, 2*H:] + r * gh[:, 2*H:])
+                    h = (1 - z) * n + z * h
+                elif mode == 'rnn_tanh':
+                    h = np.tanh(gx + gh)
+                else:
+                    h = np.maximum(gx + gh, 0)
+                y[t, :, d * H:(d + 1) * H] = h
+        x = y
+    return x
+
+
+def test_rnn():
+    seq_len, batch, input_size, num_hidden = 5, 3, 4, 6
+    for mode in ['lstm', 'gru', 'rnn_tanh', 'rnn_relu']:
+        for num_layers, bidirectional in [(1, False), (2, False), (1, True), (2, True)]:
+            gates = {'lstm': 4, 'gru': 3, 'rnn_tanh': 1, 'rnn_relu': 1}[mode]
+            dirs = 2 if bidirectional else 1
+            num_params = 0
+            for l in range(num_layers):
+                in_size = input_size if l == 0 else dirs * num_hidden
+                num_params += dirs * gates * num_hidden * (in_size + num_hidden + 2)
+            data = np.random.uniform(-1, 1, (seq_len, batch, input_size))
+            params = np.random.uniform(-0.5, 0.5, (num_params,))
+            state = np.random.uniform(-1, 1, (num_layers * dirs, batch, num_hidden))
+            state_cell = np.random.uniform(-1, 1, (num_layers * dirs, batch, num_hidden))
+            args = {'data': data, 'parameters': params, 'state': state}
+            sym_args = [mx.sym.Variable('data'), mx.sym.Variable('parameters'),
+                        mx.sym.Variable('state')]
+            if mode == 'lstm':
+                args['state_cell'] = state_cell
+                sym_args.append(mx.sym.Variable('state_cell'))
+            rnn = mx.sym.RNN(*sym_args, state_size=num_hidden, num_layers=num_layers,
+                             bidirectional=bidirectional, mode=mode)
+            expected = _rnn_reference(mode, data, params, state, state_cell,
+                                      num_hidden, num_layers, bidirectional)
+            check_symbolic_forward(rnn, args, [expected], rtol=1e-4, atol=1e-5)
+            if mode != 'rnn_relu':
+                check_numeric_gradient(rnn, args, numeric_eps=1e-3, rtol=1e-2, atol=1e-3)
+
+
 if __name__ == '__main__':
     test_l2_normalization()
     test_sequence_mask()
     test_roipooling()
     test_batchnorm_training()
+    test_batchnorm_reference()
+    test_pooling_reference()
     test_order()
+    test_topk_large()
     test_grid_generator()
     test_dot()
     test_cast()
@@ -2867,7 +3257,9 @@ if __name__ == '__main__':
     test_flip()
     test_crop()
     test_transpose()
+    test_transpose_large()
     test_convolution_grouping()
+    test_convolution_winograd()
     test_nearest_upsampling()
     test_binary_op_duplicate_input()
     test_elementwise_sum()
@@ -2880,7 +3272,9 @@ if __name__ == '__main__':
     test_symbol_pow()
     test_pow_fn()
     test_embedding()
+    test_embedding_large_batch()
     test_rsqrt_cos_sin()
+    test_transcendental_float32()
     test_maximum_minimum()
     test_maximum_minimum_scalar()
     test_abs()
@@ -2890,8 +3284,10 @@ if __name__ == '__main__':
     test_convolution_dilated_impulse_response()
     test_reshape()
     test_broadcast()
+    test_reduce_broadcast_large()
     test_stn()
     test_batch_dot()
+    test_batch_dot_large()
     test_correlation()
     test_support_vector_machine_l1_svm()
     test_support_vector_machine_l2_svm()
@@ -2907,3 +3303,4 @@ if __name__ == '__main__':
     test_tile()
     test_one_hot()
     test_where()
+    test_rnn()
@@ -0,0 +1,60 @@
+"""Measure the speed of the CPU n-ary sum used to reduce gradients.
+
+For every number of inputs and tensor size, the inputs are summed with
+mx.nd.ElementWiseSum and with a chain of binary additions. The reported
+bandwidth counts every input read and the output written once.
+"""
+import os, sys
+curr_path = os.path.abspath(os.path.dirname(__file__))
+sys.path.insert(0, os.path.join(curr_path, "../../python"))
+import mxnet as mx
+import argparse
+import time
+import numpy as np
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="benchmark the CPU elementwise sum")
+    parser.add_argument('--num-inputs', type=str, default='2,4,8,16',
+                        help='the numbers of inputs to sum')
+    parser.add_argument('--sizes', type=str, default='10000,1000000,10000000',
+                        help='the numbers of elements of each input')
+    parser.add_argument('--dtypes', type=str, default='float32,float16',
+                        help='the data types to test')
+    parser.add_argument('--repeat', type=int, default=20,
+                        help='number of sums to time')
+    return parser.parse_args()
+
+def timeit(fn, repeat):
+    fn().wait_to_read()
+    tic = time.time()
+    for _ in range(repeat):
+        out = fn()
+    out.wait_to_read()
+    return (time.time() - tic) / repeat
+
+def run(num, size, dtype, repeat):
+    inputs = [mx.nd.array(np.random.uniform(-1, 1, (size,)), dtype=dtype) for _ in range(num)]
+    out = mx.nd.empty((size,), dtype=dtype)
+    def nary():
+        return mx.nd.ElementWiseSum(*inputs, out=out)
+    def chain():
+        ret = inputs[0] + inputs[1]
+        for x in inputs[2:]:
+            ret += x
+        return ret
+    expected = np.sum([x.asnumpy().astype(np.float64) for x in inputs], axis=0)
+    error = np.max(np.abs(nary().asnumpy() - expected))
+    nbytes = (num + 1) * size * np.dtype(dtype).itemsize
+    t_nary = timeit(nary, repeat)
+    t_chain = timeit(chain, repeat)
+    print('%-8s inputs %3d size %9d: sum %8.3f ms %6.2f GB/sec, binary chain %8.3f ms, '
+          'speedup %5.2fx, max error %g'
+          % (dtype, num, size, t_nary * 1e3, nbytes / t_nary / 1e9, t_chain * 1e3,
+             t_chain / t_nary, error))
+
+if __name__ == '__main__':
+    args = parse_args()
+    for dtype in args.dtypes.split(','):
+        for size in [int(s) for s in args.sizes.split(',')]:
+            for num in [int(n) for n in args.num_inputs.split(',')]:
+                run(num, size, dtype, args.repeat)
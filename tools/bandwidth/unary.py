@@ -0,0 +1,74 @@
+"""Measure the throughput of exp, log, tanh, sigmoid and softrelu on CPU.
+
+Every operator is timed on float32 arrays with the vectorized implementations
+(MXNET_CPU_VECTOR_MATH=1) and with the C math library (MXNET_CPU_VECTOR_MATH=0).
+The variable is read once per process, so each setting runs in a child process.
+"""
+import os, sys
+curr_path = os.path.abspath(os.path.dirname(__file__))
+sys.path.insert(0, os.path.join(curr_path, "../../python"))
+import argparse
+import subprocess
+import time
+
+OPS = ['exp', 'log', 'tanh', 'sigmoid', 'softrelu']
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="benchmark transcendental operators on CPU")
+    parser.add_argument('--ops', type=str, default=','.join(OPS),
+                        help='the operators to measure')
+    parser.add_argument('--sizes', type=str, default='10000,1000000,10000000',
+                        help='the numbers of elements')
+    parser.add_argument('--repeat', type=int, default=20,
+                        help='number of calls to time')
+    parser.add_argument('--child', type=int, default=-1, help=argparse.SUPPRESS)
+    return parser.parse_args()
+
+def apply(op, x):
+    import mxnet as mx
+    if op in ['sigmoid', 'softrelu']:
+        return mx.nd.Activation(x, act_type=op)
+    return getattr(mx.nd, op)(x)
+
+def measure(args):
+    """time every operator and size in this process, one line per measurement"""
+    import mxnet as mx
+    import numpy as np
+    for op in args.ops.split(','):
+        for size in [int(s) for s in args.sizes.split(',')]:
+            low = 1e-3 if op == 'log' else -10
+            x = mx.nd.array(np.random.uniform(low, 10, (size,)), dtype='float32')
+            y = apply(op, x)
+            y.wait_to_read()
+            tic = time.time()
+            for _ in range(args.repeat):
+                y = apply(op, x)
+            y.wait_to_read()
+            elapsed = (time.time() - tic) / args.repeat
+            print('%s %d %g' % (op, size, elapsed))
+
+def run_child(args, vector_math):
+    env = dict(os.environ, MXNET_CPU_VECTOR_MATH=str(vector_math))
+    cmd = [sys.executable, __file__, '--ops', args.ops, '--sizes', args.sizes,
+           '--repeat', str(args.repeat), '--child', str(vector_math)]
+    out = subprocess.check_output(cmd, env=env).decode()
+    res = {}
+    for line in out.strip().split('\n'):
+        op, size, elapsed = line.split()
+        res[(op, int(size))] = float(elapsed)
+    return res
+
+if __name__ == '__main__':
+    args = parse_args()
+    if args.child >= 0:
+        measure(args)
+        sys.exit(0)
+    vector = run_child(args, 1)
+    libm = run_child(args, 0)
+    for op in args.ops.split(','):
+        for size in [int(s) for s in args.sizes.split(',')]:
+            t_vector, t_libm = vector[(op, size)], libm[(op, size)]
+            print('%-8s %9d elements: vector %8.3f ms %7.3f Gelem/s, '
+                  'libm %8.3f ms %7.3f Gelem/s, speedup %5.2fx'
+                  % (op, size, t_vector * 1e3, size / t_vector / 1e9,
+                     t_libm * 1e3, size / t_libm / 1e9, t_libm / t_vector))